@@ -89,6 +89,8 @@ typedef struct LCUI_DisplayDriverRec_ {
 	void (*hide)(LCUI_Surface);
 	void (*update)(LCUI_Surface);
 	void (*present)(LCUI_Surface);
+	/** optional, present the given rects only and return the bytes */
+	size_t (*presentRects)(LCUI_Surface, const LCUI_Rect *, size_t);
 	LCUI_BOOL (*isReady)(LCUI_Surface);
 	LCUI_PaintContext (*beginPaint)(LCUI_Surface, LCUI_Rect *);
 	void (*endPaint)(LCUI_Surface, LCUI_PaintContext);
@@ -113,8 +115,11 @@ LCUI_API void LCUIDisplay_Update(void);
 /** 渲染内容 */
 LCUI_API size_t LCUIDisplay_Render(void);
 
-/** 呈现渲染后的内容 */
-LCUI_API void LCUIDisplay_Present(void);
+/**
+ * 呈现渲染后的内容，仅呈现上次呈现后重绘过的区域
+ * @return 呈现的字节数
+ */
+LCUI_API size_t LCUIDisplay_Present(void);
 
 LCUI_API void LCUIDisplay_EnablePaintFlashing(LCUI_BOOL enable);
 
@@ -130,6 +135,9 @@ LCUI_API int LCUIDisplay_GetHeight(void);
 /** 添加无效区域 */
 LCUI_API void LCUIDisplay_InvalidateArea(LCUI_Rect *rect);
 
+/** 是否有待绘制或待呈现的区域 */
+LCUI_API LCUI_BOOL LCUIDisplay_HasPendingPaint(void);
+
 /** 获取当前部件所属的 surface */
 LCUI_API LCUI_Surface LCUIDisplay_GetSurfaceOwner(LCUI_Widget w);
 
@@ -146,6 +154,41 @@ LCUI_API int LCUI_InitDisplay(LCUI_DisplayDriver driver);
 /** 停用图形输出模块 */
 LCUI_API int LCUI_FreeDisplay(void);
 
+/**
+ * 创建无头显示驱动
+ * 它将 surface 的内容绘制到内存中，不依赖屏幕，也不等待垂直同步，可用于基准测试
+ * 和像素比对测试。在调用 LCUI_Init() 之前将其传给 LCUI_InitDisplay()，或者设置
+ * 环境变量 LCUI_DISPLAY_DRIVER=headless 即可使用它。
+ */
+LCUI_API LCUI_DisplayDriver LCUI_CreateHeadlessDisplayDriver(void);
+
+LCUI_API void LCUI_DestroyHeadlessDisplayDriver(LCUI_DisplayDriver driver);
+
+/** 当前是否在使用无头显示驱动 */
+LCUI_API LCUI_BOOL LCUIDisplay_IsHeadless(void);
+
+/**
+ * 获取第一个 surface 最近一次呈现的画面
+ * @param[out] out 画面的副本，需要用 Graph_Free() 释放
+ * @return 成功返回 0，没有可用的画面时返回 -1
+ */
+LCUI_API int LCUIHeadlessDisplay_CaptureFrame(LCUI_Graph *out);
+
+/**
+ * 获取自上次清除以来呈现过的区域
+ * @param[out] rects 用于保存区域的数组，可以为 NULL
+ * @param[in] max_rects 数组的容量
+ * @return 区域的总数，可能大于 max_rects
+ */
+LCUI_API size_t LCUIHeadlessDisplay_GetDamage(LCUI_Rect *rects,
+					      size_t max_rects);
+
+/** 清除已记录的呈现区域 */
+LCUI_API void LCUIHeadlessDisplay_ClearDamage(void);
+
+/** 获取呈现的总次数 */
+LCUI_API size_t LCUIHeadlessDisplay_GetPresentCount(void);
+
 LCUI_END_HEADER
 
 #endif
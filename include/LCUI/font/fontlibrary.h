@@ -77,6 +77,7 @@ typedef struct LCUI_FontRec_ {
 	LCUI_FontStyle style;		/**< 风格 */
 	LCUI_FontWeight weight;		/**< 粗细程度 */
 	LCUI_FontEngine *engine;	/**< 所属的字体引擎 */
+	uint64_t file_key;		/**< 字体文件的标识，用于查找缓存文件中的位图 */
 } LCUI_FontRec, *LCUI_Font;
 
 struct LCUI_FontEngine {
@@ -138,6 +139,17 @@ LCUI_API int FontBitmap_Print(LCUI_FontBitmap *fontbmp);
 LCUI_API int FontBitmap_Mix(LCUI_Graph *graph, LCUI_Pos pos,
 			    const LCUI_FontBitmap *bmp, LCUI_Color color);
 
+/**
+ * 将一组相同颜色的字体位图绘制到目标图像上，例如一行文字，结果与逐个调用
+ * FontBitmap_Mix() 相同，但目标图像和混合函数只需确定一次
+ * @param[in] pos 各个字体位图的绘制坐标
+ * @param[in] bmps 字体位图列表
+ * @param[in] n 字体位图的数量
+ */
+LCUI_API int FontBitmap_MixRow(LCUI_Graph *graph, const LCUI_Pos *pos,
+			       const LCUI_FontBitmap **bmps, size_t n,
+			       LCUI_Color color);
+
 /** 载入字体位图 */
 LCUI_API int LCUIFont_RenderBitmap(LCUI_FontBitmap *buff, wchar_t ch,
 				   int font_id, int pixel_size);
@@ -203,8 +215,8 @@ LCUI_API void LCUIFont_SetDefault(int id);
  * @param[in] font_id 使用的字体ID
  * @param[in] size 字体大小（单位为像素）
  * @param[out] bmp 要添加的字体位图
- * @warning 此函数仅仅是将 bmp 复制进缓存中，并未重新分配新的空间储存位图数
- * 据，因此，请勿在调用此函数后手动释放 bmp。
+ * @warning 位图数据会被复制进缓存中，bmp 的位图数据由此函数释放，因此，请
+ * 勿在调用此函数后再使用或手动释放 bmp 的位图数据。
  */
 LCUI_API LCUI_FontBitmap* LCUIFont_AddBitmap(wchar_t ch, int font_id,
 					     int size, const LCUI_FontBitmap *bmp);
@@ -221,6 +233,31 @@ LCUI_API LCUI_FontBitmap* LCUIFont_AddBitmap(wchar_t ch, int font_id,
 LCUI_API int LCUIFont_GetBitmap(wchar_t ch, int font_id, int size,
 				const LCUI_FontBitmap **bmp);
 
+/**
+ * 载入字体位图的像素数据
+ * 缓存中的位图的像素数据可能已被清除，在绘制前需调用此函数确保其可用，像素数据
+ * 在 LCUIFont_EndFrame() 被调用前不会被清除。可在多个线程中同时调用。
+ * @param[in] bmp 由 LCUIFont_GetBitmap() 获取的字体位图
+ * @returns 像素数据可用的字体位图，失败时返回 NULL
+ */
+LCUI_API const LCUI_FontBitmap *LCUIFont_LoadBitmap(const LCUI_FontBitmap *bmp);
+
+/** 结束一帧的绘制，之后已绘制的字体位图的像素数据可被清除 */
+LCUI_API void LCUIFont_EndFrame(void);
+
+/** 获取字体位图缓存的统计数据，命中、未命中和清除次数会被重置 */
+LCUI_API void LCUIFont_GetBitmapCacheProfile(LCUI_GlyphCacheProfile profile);
+
+/**
+ * 打开字体位图缓存文件
+ * 文件中的字体位图会被映射到内存中直接使用，之后渲染的字体位图会追加到文件中，
+ * 下次启动时便无需重新渲染。字体库初始化时会打开环境变量
+ * LCUI_GLYPH_CACHE_FILE 指定的文件。只能打开一个缓存文件，它在字体库停用时关闭。
+ * @param[in] path 缓存文件的路径，文件不存在时会被创建
+ * @returns 成功返回 0，失败返回负数
+ */
+LCUI_API int LCUIFont_OpenCacheFile(const char *path);
+
 /** 载入字体至数据库中 */
 LCUI_API int LCUIFont_LoadFile(const char *filepath);
 
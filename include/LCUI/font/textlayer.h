@@ -33,11 +33,11 @@
 
 LCUI_BEGIN_HEADER
 
-typedef struct LCUI_TextCharRec_ {
-	wchar_t code;                  /**< 字符码 */
-	LCUI_TextStyle style;          /**< 该字符使用的样式数据 */
-	const LCUI_FontBitmap *bitmap; /**< 字体位图数据(只读) */
-} LCUI_TextCharRec, *LCUI_TextChar;
+/** 文本样式段，从起始列开始到下一段之前的文字都使用该样式 */
+typedef struct LCUI_TextStyleRunRec_ {
+	int start;            /**< 起始列 */
+	LCUI_TextStyle style; /**< 样式数据，为 NULL 时使用全局样式 */
+} LCUI_TextStyleRunRec, *LCUI_TextStyleRun;
 
 /** End Of Line character */
 typedef enum LCUI_EOLChar {
@@ -47,20 +47,43 @@ typedef enum LCUI_EOLChar {
 	LCUI_EOL_CR_LF /**< Windows 格式换行： \r\n */
 } LCUI_EOLChar;
 
-/* 文本行 */
+/**
+ * 文本行
+ * 文字的字符码和字体位图分别存放在连续的数组中，样式则按段记录，
+ * 以减少每个文字占用的内存，并让排版和绘制时能够顺序访问文字数据
+ */
 typedef struct TextRowRec_ {
-	int width;             /**< 宽度 */
-	int height;            /**< 高度 */
-	int text_height;       /**< 当前行中最大字体的高度 */
-	int length;            /**< 该行文本长度 */
-	LCUI_TextChar *string; /**< 该行文本的数据 */
-	LCUI_EOLChar eol;      /**< 行尾结束类型 */
+	int width;       /**< 宽度 */
+	int height;      /**< 高度 */
+	int text_height; /**< 当前行中最大字体的高度 */
+	int length;      /**< 该行文本长度 */
+	int capacity;    /**< 字符数组的容量 */
+	wchar_t *codes;  /**< 各个文字的字符码 */
+	const LCUI_FontBitmap **bitmaps; /**< 各个文字的字体位图(只读) */
+
+	/** 按起始列排序的样式段，数量为 0 时全部文字都使用全局样式 */
+	LCUI_TextStyleRun styles;
+	int styles_length;
+
+	LCUI_EOLChar eol; /**< 行尾结束类型 */
 } LCUI_TextRowRec, *LCUI_TextRow;
 
 /* 文本行列表 */
 typedef struct LCUI_TextRowListRec_ {
 	int length;         /**< 当前总行数 */
 	LCUI_TextRow *rows; /**< 每一行文本的数据 */
+
+	/**
+	 * 行高的树状数组（Fenwick tree），用于在 O(log n) 时间内计算文本行的
+	 * Y 轴坐标，以及查找指定坐标处的文本行。插入和删除文本行后，其后面的
+	 * 节点会失效，在下次查询时重建
+	 */
+	int *height_tree;
+	int height_tree_size;   /**< 树状数组的容量 */
+	int height_tree_length; /**< 有效的节点数量 */
+
+	int max_width;       /**< 最大行宽 */
+	int max_width_count; /**< 宽度等于最大行宽的行数，为 0 时需重新统计 */
 } LCUI_TextRowListRec, *LCUI_TextRowList;
 
 /**
@@ -110,6 +133,7 @@ typedef struct LCUI_TextLayerRec_ {
 		LCUI_BOOL update_bitmap;  /**< 更新文本的字体位图 */
 		LCUI_BOOL update_typeset; /**< 重新对文本进行排版 */
 		int typeset_start_row;    /**< 排版处理的起始行 */
+		int typeset_end_row;      /**< 排版处理的结束行，-1 表示最后一行 */
 		LCUI_BOOL redraw_all;     /**< 重绘所有字体位图 */
 	} task;                           /**< 待处理的任务 */
 } LCUI_TextLayerRec, *LCUI_TextLayer;
@@ -93,8 +93,16 @@ LCUI_BEGIN_HEADER
 
 #define Graph_GetQuote(g) ((g)->quote.is_valid ? (g)->quote.source : (g))
 
+/** 判断色彩模式是否为 32 位的 ARGB 格式（包括预乘 Alpha 的格式） */
+#define LCUI_IsARGBColorType(T) \
+	((T) == LCUI_COLOR_TYPE_ARGB || (T) == LCUI_COLOR_TYPE_PARGB)
+
+/**
+ * 设置像素颜色
+ * 对于预乘 Alpha 的图像，颜色值会被原样写入，需要由调用者预乘
+ */
 #define Graph_SetPixel(G, X, Y, C)                                        \
-	if ((G)->color_type == LCUI_COLOR_TYPE_ARGB) {                    \
+	if (LCUI_IsARGBColorType((G)->color_type)) {                      \
 		(G)->argb[(G)->width * (Y) + (X)] = (C);                  \
 	} else {                                                          \
 		(G)->bytes[(G)->bytes_per_row * (Y) + (X)*3] = (C).b;     \
@@ -106,7 +114,7 @@ LCUI_BEGIN_HEADER
 	(G)->argb[(G)->width * (Y) + (X)].alpha = (A)
 
 #define Graph_GetPixel(G, X, Y, C)                                            \
-	if ((G)->color_type == LCUI_COLOR_TYPE_ARGB) {                        \
+	if (LCUI_IsARGBColorType((G)->color_type)) {                          \
 		(C) = (G)->argb[(G)->width * ((Y) % (G)->height) +            \
 				((X) % (G)->width)];                          \
 	} else {                                                              \
@@ -126,10 +134,10 @@ LCUI_BEGIN_HEADER
 #define Graph_GetPixelPointer(G, X, Y) ((G)->argb + (G)->width * (Y) + (X))
 
 /** 判断图像是否有Alpha通道 */
-#define Graph_HasAlpha(G)                                              \
-	((G)->quote.is_valid                                           \
-	     ? ((G)->quote.source->color_type == LCUI_COLOR_TYPE_ARGB) \
-	     : ((G)->color_type == LCUI_COLOR_TYPE_ARGB))
+#define Graph_HasAlpha(G)                                            \
+	((G)->quote.is_valid                                         \
+	     ? LCUI_IsARGBColorType((G)->quote.source->color_type) \
+	     : LCUI_IsARGBColorType((G)->color_type))
 
 #define Graph_IsWritable(G)  \
 	(Graph_IsValid(G) && \
@@ -183,6 +191,22 @@ INLINE void LCUI_OverPixel(LCUI_ARGB *dst, const LCUI_ARGB *src)
 	*/
 }
 
+/** 像素混合所使用的指令集 */
+typedef enum LCUI_PixelMixerType {
+	LCUI_PIXEL_MIXER_SCALAR,
+	LCUI_PIXEL_MIXER_SSE2,
+	LCUI_PIXEL_MIXER_AVX2,
+	LCUI_PIXEL_MIXER_NEON
+} LCUI_PixelMixerType;
+
+/**
+ * 设置像素混合所使用的指令集
+ * 默认会根据 CPU 特性自动选择，若当前 CPU 不支持指定的指令集，则返回 -1
+ */
+LCUI_API int Graph_SetMixerType(LCUI_PixelMixerType type);
+
+LCUI_API LCUI_PixelMixerType Graph_GetMixerType(void);
+
 LCUI_API void Graph_PrintInfo(LCUI_Graph *graph);
 
 LCUI_API void Graph_Init(LCUI_Graph *graph);
@@ -200,6 +224,13 @@ LCUI_API int Graph_SetColorType(LCUI_Graph *graph, int color_type);
 
 LCUI_API int Graph_Create(LCUI_Graph *graph, unsigned width, unsigned height);
 
+/**
+ * 创建临时图像，像素数据从当前线程的帧内存池中分配，在当前帧渲染结束后失效
+ * 如果帧内存池未初始化，则与 Graph_Create() 相同
+ */
+LCUI_API int Graph_CreateScratch(LCUI_Graph *graph, unsigned width,
+				 unsigned height);
+
 LCUI_API void Graph_Copy(LCUI_Graph *des, const LCUI_Graph *src);
 
 LCUI_API void Graph_Free(LCUI_Graph *graph);
@@ -240,6 +271,13 @@ LCUI_API int Graph_Zoom(const LCUI_Graph *graph, LCUI_Graph *buff,
 LCUI_API int Graph_ZoomBilinear(const LCUI_Graph *graph, LCUI_Graph *buff,
 				LCUI_BOOL keep_scale, int width, int height);
 
+/**
+ * 缩放图像，在缩小到原来的一半以下时，先逐级缩小一半再进行双线性插值，避免
+ * 跳过的像素导致的锯齿和闪烁
+ */
+LCUI_API int Graph_ZoomMipmap(const LCUI_Graph *graph, LCUI_Graph *buff,
+			      LCUI_BOOL keep_scale, int width, int height);
+
 LCUI_API int Graph_Cut(const LCUI_Graph *graph, LCUI_Rect rect,
 		       LCUI_Graph *buff);
 
@@ -136,6 +136,7 @@ enum LCUI_StyleKeyName {
 
 	key_pointer_events,
 	key_focusable,
+	key_will_change,
 	STYLE_KEY_TOTAL
 };
 
@@ -262,6 +263,16 @@ LCUI_API LCUI_BOOL SelectorNode_Match(LCUI_SelectorNode sn1,
 LCUI_API int LCUI_PutStyleSheet(LCUI_Selector selector, LCUI_StyleSheet in_ss,
 				const char *space);
 
+/**
+ * 开始批量添加样式表
+ * 在调用 LCUI_EndStyleSheetBatch() 前，添加样式表不会更新样式表缓存，结束时
+ * 再一次性移除受影响的缓存。可嵌套调用。
+ */
+LCUI_API void LCUI_BeginStyleSheetBatch(void);
+
+/** 结束批量添加样式表 */
+LCUI_API void LCUI_EndStyleSheetBatch(void);
+
 /**
  * 从指定组中查找样式表
  * @param[in] group 组号
@@ -272,6 +283,27 @@ LCUI_API int LCUI_PutStyleSheet(LCUI_Selector selector, LCUI_StyleSheet in_ss,
 LCUI_API int LCUI_FindStyleSheetFromGroup(int group, const char *name,
 					  LCUI_Selector s, LinkedList *list);
 
+/**
+ * 获取样式可能受到名称变化影响的子级结点
+ * 当匹配 sn 的部件的 ID、类名或状态名发生变化时，只有匹配这些结点的子级部件
+ * 的样式才会受到影响
+ * @param[in] sn 发生变化的部件的选择器结点
+ * @param[in] name 带前缀的名称，例如：#main、.active、:hover
+ * @param[out] targets 受影响的结点列表，已有的结点不会被重复添加，结点需要用
+ *  SelectorNode_Delete() 释放
+ * @returns 新添加的结点数量
+ */
+LCUI_API size_t LCUI_GetStyleInvalidationTargets(LCUI_SelectorNode sn,
+						 const char *name,
+						 LinkedList *targets);
+
+/**
+ * 根据选择器的哈希值获取已缓存的样式表
+ * @returns 如果样式表未被缓存，则返回 NULL
+ */
+LCUI_API LCUI_CachedStyleSheet LCUI_FindCachedStyleSheet(unsigned hash);
+
+/** 获取选择器匹配的样式表，该函数是线程安全的 */
 LCUI_API LCUI_CachedStyleSheet LCUI_GetCachedStyleSheet(LCUI_Selector s);
 
 LCUI_API void LCUI_GetStyleSheet(LCUI_Selector s, LCUI_StyleSheet out_ss);
@@ -63,6 +63,7 @@ typedef struct LCUI_WidgetStyle {
 	LCUI_BackgroundStyle background;
 	LCUI_FlexBoxLayoutStyle flex;
 	int pointer_events;
+	int will_change;
 } LCUI_WidgetStyle;
 
 typedef struct LCUI_WidgetActualStyleRec_ {
@@ -121,6 +122,16 @@ typedef struct LCUI_WidgetTaskRec_ {
 
 	/** States of tasks */
 	LCUI_BOOL states[LCUI_WTASK_TOTAL_NUM];
+
+	/**
+	 * Results of the parallel style phase, they are only valid in the
+	 * update pass with the same generation
+	 */
+	unsigned selector_hash;
+	unsigned selector_generation;
+
+	/** Index of the job that computed the style in the parallel phase */
+	size_t style_job;
 } LCUI_WidgetTaskRec;
 
 /** 部件状态 */
@@ -134,6 +145,8 @@ typedef enum LCUI_WidgetState {
 } LCUI_WidgetState;
 
 typedef struct LCUI_WidgetRec_* LCUI_Widget;
+typedef struct LCUI_WidgetLayerRec_ *LCUI_WidgetLayer;
+typedef struct LCUI_WidgetHitIndexRec_ *LCUI_WidgetHitIndex;
 typedef struct LCUI_WidgetPrototypeRec_ *LCUI_WidgetPrototype;
 typedef const struct LCUI_WidgetPrototypeRec_ *LCUI_WidgetPrototypeC;
 
@@ -309,6 +322,9 @@ typedef struct LCUI_WidgetRec_ {
 	LCUI_RectF invalid_area;
 	LCUI_InvalidAreaType invalid_area_type;
 	LCUI_BOOL has_child_invalid_area;
+
+	/** Retained layer, the rasterized content of this widget */
+	LCUI_WidgetLayer layer;
 	
 	/** Parent widget */
 	LCUI_Widget parent;
@@ -318,6 +334,9 @@ typedef struct LCUI_WidgetRec_ {
 
 	/** List of child widgets in descending order by z-index */
 	LinkedList children_show;
+
+	/** Spatial index of the border boxes of children_show for hit-testing */
+	LCUI_WidgetHitIndex hit_index;
 	
 	/**
 	 * Position in the parent->children
@@ -429,6 +448,9 @@ LCUI_API void Widget_UpdateBoxSize(LCUI_Widget w);
 
 LCUI_API size_t LCUIWidget_ClearTrash(void);
 
+/** 是否有待更新或待删除的部件 */
+LCUI_API LCUI_BOOL LCUIWidget_HasPendingTasks(void);
+
 LCUI_API void LCUIWidget_InitBase(void);
 
 LCUI_API void LCUIWidget_FreeRoot(void);
@@ -46,10 +46,10 @@ LCUI_API LCUI_BOOL Widget_InvalidateArea(LCUI_Widget widget,
 /**
  * 取出部件中的无效区域
  * @param[in] w		部件
- * @param[out] rects	输出的区域列表
- * @return 无效区域的数量
+ * @param[out] region	输出的脏区域，无效区域会与其中已有的矩形合并
+ * @return 脏区域中的矩形数量
  */
-LCUI_API size_t Widget_GetInvalidArea(LCUI_Widget w, LinkedList *rects);
+LCUI_API size_t Widget_GetInvalidArea(LCUI_Widget w, LCUI_DirtyRegion region);
 
 /**
  * 将部件中的矩形区域转换成指定范围框内有效的矩形区域
@@ -75,6 +75,29 @@ LCUI_API void RectToInvalidArea(const LCUI_Rect *rect, LCUI_Rect *area);
  */
 LCUI_API size_t Widget_Render(LCUI_Widget w, LCUI_PaintContext paint);
 
+/** 释放部件的图层缓存 */
+LCUI_API void Widget_DestroyLayer(LCUI_Widget w);
+
+/**
+ * 获取图层缓存的统计数据，命中和未命中次数在获取后会被清零
+ * @param[out] profile 统计数据
+ */
+LCUI_API void LCUIWidget_GetLayersProfile(LCUI_WidgetLayersProfile profile);
+
+/**
+ * 获取缩放后的背景图缓存的统计数据，命中、未命中和移除次数在获取后会被清零
+ * @param[out] profile 统计数据
+ */
+LCUI_API void
+LCUIWidget_GetScaledImageCacheProfile(LCUI_ImageCacheProfile profile);
+
+/**
+ * 获取已解码的背景图缓存的统计数据，命中、未命中和移除次数在获取后会被清零
+ * 未命中次数为需要解码图像的次数
+ * @param[out] profile 统计数据
+ */
+LCUI_API void LCUIWidget_GetImageCacheProfile(LCUI_ImageCacheProfile profile);
+
 LCUI_API void LCUIWidget_InitRenderer(void);
 
 LCUI_API void LCUIWidget_FreeRenderer(void);
@@ -100,4 +100,21 @@ LCUI_API LCUI_Selector Widget_GetSelector(LCUI_Widget w);
 LCUI_API size_t Widget_GetChildrenStyleChanges(LCUI_Widget w, int type,
 					       const char *name);
 
+/**
+ * 标记样式受到类名或状态名变化影响的子级部件
+ * 只有匹配样式失效规则中的目标结点的子级部件才会被标记为需要刷新样式
+ * @param[in] type 名称类型，0 为类名，1 为状态名
+ * @param[in] name 发生变化的名称，多个名称用空格分隔
+ * @returns 被标记的子级部件数量
+ */
+LCUI_API size_t Widget_RefreshChildrenStyleByChanges(LCUI_Widget w, int type,
+						     const char *name);
+
+/**
+ * 获取类名和状态名变化的统计数据，获取后会被清零
+ * @param[out] profile 统计数据
+ */
+LCUI_API void
+LCUIWidget_GetStyleChangesProfile(LCUI_WidgetStyleChangesProfile profile);
+
 #endif
@@ -64,6 +64,19 @@ LCUI_API size_t Widget_Each(LCUI_Widget w,
 /** 获取当前点命中的最上层可见部件 */
 LCUI_API LCUI_Widget Widget_At(LCUI_Widget widget, int x, int y);
 
+/**
+ * 获取边框区域包含指定坐标点的下一个子部件
+ * 按照 children_show 中的顺序查找，子部件较多时会用空间索引筛选
+ * @param[in] prev 上一次找到的子部件，为 NULL 时从第一个子部件开始查找
+ */
+LCUI_API LCUI_Widget Widget_GetNextChildAt(LCUI_Widget w, LCUI_Widget prev,
+					   float x, float y);
+
+/** 标记子部件的空间索引为无效，它会在下次命中测试时重建 */
+LCUI_API void Widget_InvalidateHitIndex(LCUI_Widget w);
+
+LCUI_API void Widget_DestroyHitIndex(LCUI_Widget w);
+
 LCUI_API void Widget_DestroyChildren(LCUI_Widget w);
 
 LCUI_API void Widget_PrintTree(LCUI_Widget w);
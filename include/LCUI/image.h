@@ -75,6 +75,7 @@ typedef struct LCUI_ImageReaderRec_ {
 	LCUI_ImageSkipFunc fn_skip;		/**< 游标移动函数，用于跳过一段数据 */
 	LCUI_ImageProgressFunc fn_prog;		/**< 用于接收图像读取进度的函数 */
 	void *prog_arg;				/**< 接收图像读取进度时的附加参数 */
+	int scale_denom;			/**< 解码时的缩小倍数（2、4 或 8） */
 
 	int type;				/**< 图片读取器类型 */
 	void *data;				/**< 私有数据 */
@@ -122,6 +123,14 @@ LCUI_API int LCUI_WritePNGFile(const char *file_name, const LCUI_Graph *graph);
 /** 载入指定图片文件的图像数据 */
 LCUI_API int LCUI_ReadImageFile(const char *filepath, LCUI_Graph *out);
 
+/**
+ * 载入指定图片文件的图像数据，并按 1/scale_denom 的比例缩小
+ * 缩小后的尺寸为原尺寸除以 scale_denom 后向上取整，JPEG 图像由 libjpeg 在解码
+ * 时缩小，PNG 图像在逐行读取时取像素块的平均值，其它图像按原尺寸解码后再缩小
+ */
+LCUI_API int LCUI_ReadImageFileWithScale(const char *filepath, int scale_denom,
+					 LCUI_Graph *out);
+
 /** 从文件中获取图像尺寸 */
 LCUI_API int LCUI_GetImageSize(const char *filepath, int *width, int *height);
 
@@ -138,6 +138,15 @@ typedef struct LCUI_AppDriverRec_ {
 	int (*UnbindSysEvent)(int, LCUI_EventFunc);
 	int (*UnbindSysEvent2)(int);
 	void *(*GetData)(void);
+
+	/**
+	 * 等待事件，直到有新的事件、调用了 Wakeup() 或者超时（单位：毫秒，小于
+	 * 0 时不限时长）。为 NULL 时表示事件源无法唤醒空闲等待的主循环
+	 */
+	LCUI_BOOL (*WaitEvent)(long int);
+
+	/** 唤醒正在 WaitEvent() 中等待的主循环，可在任意线程中调用 */
+	void (*Wakeup)(void);
 } LCUI_AppDriverRec, *LCUI_AppDriver;
 
 #ifndef LCUI_MAIN_C
@@ -178,7 +187,8 @@ LCUI_API LCUI_BOOL LCUI_PostTask(LCUI_Task task);
 
 /**
  * 添加异步任务
- * 该任务将会添加至指定 id 的工作线程中执行
+ * 该任务将会添加至指定 id 的工作线程中执行，不会被其它线程窃取，添加到同一
+ * 线程的任务会按顺序逐个执行
  * @param[in] task 任务数据
  * @param[in] target_worker_id 目标工作线程的编号
  */
@@ -187,9 +197,40 @@ LCUI_API void LCUI_PostAsyncTaskTo(LCUI_Task task, int target_worker_id);
 /**
  * 添加异步任务
  * 该任务将会添加至工作线程中执行
+ * @returns 接收该任务的队列所属的工作线程编号，该任务仍可能被
+ * 其它工作线程窃取执行
  */
 LCUI_API int LCUI_PostAsyncTask(LCUI_Task task);
 
+/**
+ * 添加异步任务
+ * 该任务将会添加至工作线程中执行，空闲的工作线程会优先执行优先级高的任务
+ * @param[in] task 任务数据
+ * @param[in] priority 任务的优先级
+ * @param[in] callback 任务完成后添加至主线程中执行的任务，可以为 NULL
+ * @returns 接收该任务的队列所属的工作线程编号，该任务仍可能被
+ * 其它工作线程窃取执行
+ */
+LCUI_API int LCUI_PostAsyncTaskEx(LCUI_Task task, LCUI_TaskPriority priority,
+				  LCUI_Task callback);
+
+/**
+ * 添加输入任务
+ * 输入数据会被复制到一个无锁队列中，不需要分配内存，也不会等待锁，主循环在处理
+ * 事件时会批量执行队列中的任务。适合在读取输入设备的线程中调用。
+ * @param[in] func 任务处理函数，它的第一个参数是输入数据的副本
+ * @param[in] data 输入数据，不能超过 LCUI_TASK_RING_DATA_SIZE 个字节
+ * @returns 成功返回 0，队列已满时返回 -EAGAIN
+ */
+LCUI_API int LCUI_PostInputTask(LCUI_TaskFunc func, const void *data,
+				size_t size);
+
+/** 获取输入任务从添加到执行的延迟分布，单位为微秒 */
+LCUI_API void LCUI_GetInputLatency(LCUI_LatencyHistogram hist);
+
+/** 清空输入任务的延迟记录 */
+LCUI_API void LCUI_ResetInputLatency(void);
+
 /** LCUI_PostTask 的简化版本 */
 #define LCUI_PostSimpleTask(FUNC, ARG1, ARG2)             \
 	do {                                              \
@@ -200,6 +241,18 @@ LCUI_API int LCUI_PostAsyncTask(LCUI_Task task);
 		LCUI_PostTask(&_ui_task);                 \
 	} while (0);
 
+/**
+ * 唤醒处于空闲等待中的主循环
+ * 在其它线程中产生需要主循环处理的工作后，应调用该函数，LCUI_PostTask() 等函数
+ * 会自动调用它。
+ * 只有 Linux 帧缓冲驱动下主循环才会一直空闲等待，其它驱动的事件需要轮询，空闲
+ * 等待最长只有一帧。
+ */
+LCUI_API void LCUI_Wakeup(void);
+
+/** 获取主循环从空闲等待中被唤醒的总次数 */
+LCUI_API size_t LCUI_GetIdleWakeupCount(void);
+
 LCUI_API void LCUI_RunFrame(void);
 
 LCUI_API void LCUI_RunFrameWithProfile(LCUI_FrameProfile profile);
@@ -44,6 +44,9 @@ typedef struct LCUI_X11AppDriverRec_ {
 	Atom wm_delete;
 	Colormap cmap;
 	LCUI_EventTrigger trigger;
+
+	/* 用于唤醒空闲等待的管道，写入端在 LCUI_Wakeup() 中写入 */
+	int wakeup_fds[2];
 } LCUI_X11AppDriverRec, *LCUI_X11AppDriver;
 
 void LCUI_SetLinuxX11MainWindow( Window win );
@@ -33,12 +33,73 @@
 
 LCUI_BEGIN_HEADER
 
+/* How the dirty area is divided between rendering threads. */
+typedef enum LCUI_ParallelRenderingMode {
+	/* Horizontal strips, one per thread. */
+	LCUI_PARALLEL_RENDERING_STRIPS,
+
+	/* 64x64 tiles, shared by threads through work stealing. */
+	LCUI_PARALLEL_RENDERING_TILES
+} LCUI_ParallelRenderingMode;
+
 typedef struct LCUI_SettingsRec_ {
 	int frame_rate_cap;
 	int parallel_rendering_threads;
+	LCUI_ParallelRenderingMode parallel_rendering_mode;
 	LCUI_BOOL record_profile;
 	LCUI_BOOL fps_meter;
 	LCUI_BOOL paint_flashing;
+
+	/* Composite widget layers in premultiplied alpha format. */
+	LCUI_BOOL premultiplied_alpha;
+
+	/*
+	 * Match the style sheets of widgets on parallel_rendering_threads
+	 * threads before updating them, layout is still computed serially.
+	 */
+	LCUI_BOOL parallel_style_computation;
+
+	/* Record frame timelines, they can be dumped by LCUITrace_DumpFile(). */
+	LCUI_BOOL trace_frames;
+
+	/*
+	 * Dump the timelines to lcui-trace.json when a frame takes longer than
+	 * this many milliseconds, 0 to disable.
+	 */
+	int trace_frame_threshold;
+
+	/*
+	 * Memory budget of glyph bitmaps in kilobytes, the glyphs drawn least
+	 * recently are evicted and rendered again when they are drawn.
+	 */
+	int glyph_cache_size;
+
+	/*
+	 * Memory budget of resampled background images in kilobytes, the
+	 * images painted least recently are evicted and resampled again when
+	 * they are painted, 0 to resample them on every paint.
+	 */
+	int scaled_image_cache_size;
+
+	/*
+	 * Memory budget of decoded background images in kilobytes, the images
+	 * least recently painted are evicted when no widget using them is
+	 * displayed, and decoded again when they are painted.
+	 */
+	int image_cache_size;
+
+	/*
+	 * Keep translucent widgets in retained layers like widgets with
+	 * will-change, so changing their opacity does not repaint them.
+	 */
+	LCUI_BOOL retain_translucent_layers;
+
+	/*
+	 * Memory budget of retained widget layers in kilobytes, the layers
+	 * mixed least recently are destroyed and repainted when they are
+	 * mixed again, a layer larger than it is never retained.
+	 */
+	int widget_layer_cache_size;
 } LCUI_SettingsRec, *LCUI_Settings;
 
 /* Initialize settings with the current global settings. */
@@ -93,6 +93,17 @@ LCUI_API void Surface_EndPaint(LCUI_Surface surface, LCUI_PaintContext paint);
 /** 将帧缓存中的数据呈现至Surface的窗口内 */
 LCUI_API void Surface_Present(LCUI_Surface surface);
 
+/**
+ * 仅将帧缓存中指定区域内的数据呈现至 Surface 的窗口内
+ * 如果驱动不支持局部呈现，则呈现整个 Surface
+ * @param[in] surface	目标 surface
+ * @param[in] rects	已重绘的区域列表
+ * @param[in] n_rects	区域数量
+ * @return		呈现的字节数
+ */
+LCUI_API size_t Surface_PresentRects(LCUI_Surface surface,
+				     const LCUI_Rect *rects, size_t n_rects);
+
 LCUI_END_HEADER
 
 #endif
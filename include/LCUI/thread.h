@@ -103,6 +103,9 @@ LCUI_API void LCUIThread_Cancel(LCUI_Thread thread);
 /* 记录指针作为返回值，并退出线程 */
 LCUI_API void LCUIThread_Exit(void* retval);
 
+/* 获取处理器核心数量，获取失败时返回 1 */
+LCUI_API int LCUIThread_GetProcessorCount(void);
+
 /*------------------------------ Thread <END> -------------------------------*/
 
 LCUI_END_HEADER
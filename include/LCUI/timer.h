@@ -85,7 +85,8 @@ LCUI_API int LCUITimer_Pause(int timer_id);
  * @param timer_id
  *	目标定时器的标识符
  * @return
- *	正常返回0，指定ID的定时器不存在则返回-1.
+ *	正常返回0，指定ID的定时器不存在则返回-1，内存不足时返回 -ENOMEM，
+ *	定时器保持暂停状态
  * */
 LCUI_API int LCUITimer_Continue(int timer_id);
 
@@ -100,6 +101,12 @@ LCUI_API int LCUITimer_Continue(int timer_id);
  * */
 LCUI_API int LCUITimer_Reset(int timer_id, long int n_ms);
 
+/**
+ * 获取距离下一个定时器到期的时长
+ * @return 单位为毫秒，已到期时返回 0，没有正在计时的定时器时返回 -1
+ */
+LCUI_API long int LCUI_GetNextTimerDelay(void);
+
 /* Process all active timers */
 LCUI_API size_t LCUI_ProcessTimers(void);
 
@@ -66,11 +66,13 @@ typedef enum LCUI_ColorType {
 	LCUI_COLOR_TYPE_RGB555,   /**< RGB555 */
 	LCUI_COLOR_TYPE_RGB565,   /**< RGB565 */
 	LCUI_COLOR_TYPE_RGB888,   /**< RGB888 */
-	LCUI_COLOR_TYPE_ARGB8888  /**< RGB8888 */
+	LCUI_COLOR_TYPE_ARGB8888, /**< RGB8888 */
+	LCUI_COLOR_TYPE_PARGB8888 /**< 预乘 Alpha 的 ARGB8888 */
 } LCUI_ColorType;
 
 #define LCUI_COLOR_TYPE_RGB LCUI_COLOR_TYPE_RGB888
 #define LCUI_COLOR_TYPE_ARGB LCUI_COLOR_TYPE_ARGB8888
+#define LCUI_COLOR_TYPE_PARGB LCUI_COLOR_TYPE_PARGB8888
 
 typedef union LCUI_RGB565_ {
 	short unsigned int value;
@@ -178,7 +180,9 @@ typedef enum LCUI_StyleValue {
 	SV_WRAP,
 	SV_NOWRAP,
 	SV_ROW,
-	SV_COLUMN
+	SV_COLUMN,
+	SV_SCROLL_POSITION,
+	SV_OPACITY
 } LCUI_StyleValue;
 
 /** 样式变量类型 */
@@ -286,6 +290,9 @@ struct LCUI_Graph_ {
 	float opacity;
 	size_t mem_size;
 	uchar_t *palette;
+
+	/** whether the pixel buffer is allocated from the frame arena */
+	LCUI_BOOL is_scratch;
 };
 
 typedef struct LCUI_StyleRec_ {
@@ -449,6 +456,62 @@ typedef struct LCUI_WidgetTasksRec_ {
 	size_t destroy_time;
 } LCUI_WidgetTasksProfileRec, *LCUI_WidgetTasksProfile;
 
+typedef struct LCUI_WidgetLayersProfileRec_ {
+	size_t hit_count;
+	size_t miss_count;
+	size_t eviction_count;
+
+	/* number of pixels repainted into layers */
+	size_t paint_area;
+
+	size_t count;
+	size_t memory_usage;
+} LCUI_WidgetLayersProfileRec, *LCUI_WidgetLayersProfile;
+
+typedef struct LCUI_WidgetStyleChangesProfileRec_ {
+	/** number of class and status changes which affect the children */
+	size_t changes_count;
+
+	/** number of children whose style is marked to refresh */
+	size_t refresh_count;
+
+	/** number of children which are not affected by the changes */
+	size_t skip_count;
+} LCUI_WidgetStyleChangesProfileRec, *LCUI_WidgetStyleChangesProfile;
+
+typedef struct LCUI_GlyphCacheProfileRec_ {
+	size_t hit_count;
+	size_t miss_count;
+	size_t eviction_count;
+
+	/** number of glyphs which are loaded from the cache file */
+	size_t file_hit_count;
+
+	/** number of glyphs whose pixels are cached */
+	size_t count;
+
+	/** bytes of atlas pages */
+	size_t memory_usage;
+} LCUI_GlyphCacheProfileRec, *LCUI_GlyphCacheProfile;
+
+typedef struct LCUI_ImageCacheProfileRec_ {
+	size_t hit_count;
+	size_t miss_count;
+	size_t eviction_count;
+
+	/** number of cached images */
+	size_t count;
+
+	/** bytes of cached pixels */
+	size_t memory_usage;
+} LCUI_ImageCacheProfileRec, *LCUI_ImageCacheProfile;
+
+typedef struct LCUI_FrameArenaProfileRec_ {
+	size_t alloc_count;
+	size_t alloc_bytes;
+	size_t memory_usage;
+} LCUI_FrameArenaProfileRec, *LCUI_FrameArenaProfile;
+
 typedef struct LCUI_FrameProfileRec_ {
 	size_t timers_count;
 	clock_t timers_time;
@@ -459,14 +522,28 @@ typedef struct LCUI_FrameProfileRec_ {
 	size_t render_count;
 	clock_t render_time;
 	clock_t present_time;
+	size_t present_bytes;
 
 	LCUI_WidgetTasksProfileRec widget_tasks;
+	LCUI_WidgetLayersProfileRec widget_layers;
+	LCUI_WidgetStyleChangesProfileRec widget_style_changes;
+	LCUI_FrameArenaProfileRec frame_arena;
+	LCUI_GlyphCacheProfileRec glyph_cache;
+	LCUI_ImageCacheProfileRec scaled_image_cache;
+	LCUI_ImageCacheProfileRec image_cache;
 } LCUI_FrameProfileRec, *LCUI_FrameProfile;
 
 typedef struct LCUI_ProfileRec_ {
 	clock_t start_time;
 	clock_t end_time;
 	unsigned frames_count;
+
+	/** 主循环从空闲等待中被唤醒的次数 */
+	unsigned idle_wakeups;
+
+	/** 主循环处于空闲等待的时长（单位：毫秒） */
+	int64_t idle_time;
+
 	LCUI_FrameProfileRec frames[LCUI_MAX_FRAMES_PER_SEC];
 } LCUI_ProfileRec, *LCUI_Profile;
 
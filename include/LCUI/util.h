@@ -48,4 +48,8 @@
 #include <LCUI/util/task.h>
 #include <LCUI/util/uri.h>
 #include <LCUI/util/charset.h>
+#include <LCUI/util/arena.h>
+#include <LCUI/util/trace.h>
+#include <LCUI/util/dirtyregion.h>
+#include <LCUI/util/taskring.h>
 #endif
@@ -0,0 +1,101 @@
+/* arena.h -- bump allocator for short-lived memory
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LCUI_UTIL_ARENA_H
+#define LCUI_UTIL_ARENA_H
+
+LCUI_BEGIN_HEADER
+
+typedef struct LCUI_ArenaBlockRec_ LCUI_ArenaBlockRec, *LCUI_ArenaBlock;
+
+/**
+ * Bump allocator, memory is taken from large blocks and only given back all
+ * at once by Arena_Reset(), or in stack order by Arena_Rewind().
+ */
+typedef struct LCUI_ArenaRec_ {
+	LCUI_ArenaBlock head;
+	LCUI_ArenaBlock current;
+	size_t block_size;
+
+	/* statistics since the last reset */
+	size_t alloc_count;
+	size_t alloc_bytes;
+
+	/* total size of blocks */
+	size_t memory_usage;
+	LinkedListNode node;
+} LCUI_ArenaRec, *LCUI_Arena;
+
+typedef struct LCUI_ArenaMarkRec_ {
+	LCUI_ArenaBlock block;
+	size_t used;
+} LCUI_ArenaMarkRec, *LCUI_ArenaMark;
+
+LCUI_API void Arena_Init(LCUI_Arena arena, size_t block_size);
+
+LCUI_API void Arena_Destroy(LCUI_Arena arena);
+
+/** Allocate uninitialized memory, it is aligned to 16 bytes */
+LCUI_API void *Arena_Alloc(LCUI_Arena arena, size_t size);
+
+/** Get the current position of the arena */
+LCUI_API void Arena_GetMark(LCUI_Arena arena, LCUI_ArenaMark mark);
+
+/** Free all memory allocated after the mark was taken */
+LCUI_API void Arena_Rewind(LCUI_Arena arena, LCUI_ArenaMark mark);
+
+/**
+ * Free all allocated memory. Blocks used since the last reset are kept for
+ * reuse, others are released to the system.
+ */
+LCUI_API void Arena_Reset(LCUI_Arena arena);
+
+/**
+ * Get the frame arena of the current thread. Memory allocated from it is
+ * valid until the end of the current frame.
+ * @returns NULL if frame arenas are not initialized
+ */
+LCUI_API LCUI_Arena LCUIFrameArena_Get(void);
+
+/**
+ * Reset the frame arenas of all threads, it should be called when no thread
+ * is using them, usually at the end of rendering a frame.
+ */
+LCUI_API void LCUIFrameArena_Reset(void);
+
+/** Get the statistics of the frame arenas in the last frame */
+LCUI_API void LCUIFrameArena_GetProfile(LCUI_FrameArenaProfile profile);
+
+LCUI_API void LCUI_InitFrameArena(void);
+
+LCUI_API void LCUI_FreeFrameArena(void);
+
+LCUI_END_HEADER
+
+#endif
@@ -0,0 +1,104 @@
+/* dirtyregion.h -- dirty region of a frame
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LCUI_UTIL_DIRTY_REGION_H
+#define LCUI_UTIL_DIRTY_REGION_H
+
+LCUI_BEGIN_HEADER
+
+/** Width and height of the cells of the spatial index */
+#define LCUI_DIRTY_REGION_CELL_SIZE 128
+
+/** Number of buckets which the cells are hashed into */
+#define LCUI_DIRTY_REGION_BUCKETS 256
+
+/**
+ * Default cost of a rectangle, in pixels. Two rectangles are merged when the
+ * area painted in addition by their bounding rectangle is not greater than it.
+ */
+#define LCUI_DIRTY_REGION_RECT_COST 1024
+
+/** Default maximum number of rectangles */
+#define LCUI_DIRTY_REGION_MAX_RECTS 256
+
+typedef struct LCUI_DirtyRegionBucketRec_ {
+	unsigned *items;
+	size_t length;
+	size_t size;
+} LCUI_DirtyRegionBucketRec, *LCUI_DirtyRegionBucket;
+
+/**
+ * A set of rectangles to be repainted. Rectangles may overlap but none of
+ * them contains another, so the painted area is never larger than needed by
+ * more than the cost of merging. Memory is kept after clearing, so a region
+ * reused for each frame does not allocate once it has grown.
+ */
+typedef struct LCUI_DirtyRegionRec_ {
+	/** read-only, rects[0 .. length - 1] are the dirty rectangles */
+	LCUI_Rect *rects;
+	size_t length;
+	size_t size;
+
+	/** rects are indexed by the cells they intersect, large rects which
+	 * intersect too many cells are kept in a separate list */
+	LCUI_DirtyRegionBucketRec buckets[LCUI_DIRTY_REGION_BUCKETS];
+	LCUI_DirtyRegionBucketRec large_rects;
+
+	/** used to visit each rect once when it is found in several cells */
+	unsigned *marks;
+	unsigned mark;
+
+	int rect_cost;
+	size_t max_rects;
+} LCUI_DirtyRegionRec, *LCUI_DirtyRegion;
+
+LCUI_API void DirtyRegion_Init(LCUI_DirtyRegion region);
+
+LCUI_API void DirtyRegion_Destroy(LCUI_DirtyRegion region);
+
+/** Remove all rectangles, memory is kept for reuse */
+LCUI_API void DirtyRegion_Clear(LCUI_DirtyRegion region);
+
+/**
+ * Add a rectangle to the region. It is dropped if it is empty or covered by
+ * the region, otherwise it may be merged with the rectangles nearby.
+ * @returns TRUE if the region has been changed
+ */
+LCUI_API LCUI_BOOL DirtyRegion_Add(LCUI_DirtyRegion region,
+				   const LCUI_Rect *rect);
+
+/** Move the rectangles of src into dst, src is cleared */
+LCUI_API void DirtyRegion_Concat(LCUI_DirtyRegion dst, LCUI_DirtyRegion src);
+
+/** Get the total area of the rectangles, overlaps are counted repeatedly */
+LCUI_API size_t DirtyRegion_GetArea(LCUI_DirtyRegion region);
+
+LCUI_END_HEADER
+
+#endif
@@ -39,6 +39,13 @@ typedef struct LCUI_TaskRec_ {
 	void(*destroy_arg[2])(void*);	/**< 参数的销毁函数 */
 } LCUI_TaskRec, *LCUI_Task;
 
+/** 异步任务的优先级，工作线程会优先执行优先级高的任务 */
+typedef enum LCUI_TaskPriority {
+	LCUI_TASK_PRIORITY_LOW,
+	LCUI_TASK_PRIORITY_NORMAL,
+	LCUI_TASK_PRIORITY_HIGH
+} LCUI_TaskPriority;
+
 LCUI_API void LCUITask_Destroy(LCUI_Task task);
 
 LCUI_API int LCUITask_Run(LCUI_Task task);
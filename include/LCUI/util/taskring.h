@@ -0,0 +1,101 @@
+/* taskring.h -- bounded lock-free task queue with inline data
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LCUI_UTIL_TASK_RING_H
+#define LCUI_UTIL_TASK_RING_H
+
+LCUI_BEGIN_HEADER
+
+/** Maximum size of the data copied into the ring with each task */
+#define LCUI_TASK_RING_DATA_SIZE 32
+
+/**
+ * Number of latency buckets. Bucket 0 counts latencies under 1us, bucket i
+ * counts latencies in [2^(i-1), 2^i) us and the last bucket counts the rest.
+ */
+#define LCUI_LATENCY_BUCKETS 24
+
+typedef struct LCUI_LatencyHistogramRec_ {
+	size_t count;
+	int64_t total;
+	int64_t max;
+	size_t buckets[LCUI_LATENCY_BUCKETS];
+} LCUI_LatencyHistogramRec, *LCUI_LatencyHistogram;
+
+/**
+ * A bounded queue of tasks which any thread can push to and one thread runs.
+ * The data of each task is copied into the ring, so pushing never allocates
+ * and never takes a lock.
+ */
+typedef struct LCUI_TaskRingRec_ *LCUI_TaskRing;
+
+/** Create a ring, the capacity is rounded up to a power of two */
+LCUI_API LCUI_TaskRing TaskRing_New(size_t capacity);
+
+/** Destroy the ring, the tasks which are not run are dropped */
+LCUI_API void TaskRing_Destroy(LCUI_TaskRing ring);
+
+/**
+ * Push a task, it can be called from any thread.
+ * @param[in] func called as func(copy of data, NULL) when the task is run
+ * @param[in] data copied into the ring, it may be NULL if size is 0
+ * @returns 0 on success, -EAGAIN if the ring is full, -EINVAL if the data is
+ * larger than LCUI_TASK_RING_DATA_SIZE
+ */
+LCUI_API int TaskRing_Push(LCUI_TaskRing ring, LCUI_TaskFunc func,
+			   const void *data, size_t size);
+
+/**
+ * Run the tasks pushed so far, at most max_tasks of them. Only one thread
+ * may run the tasks of a ring. The time from push to run of each task is
+ * added to the latency histogram of the ring.
+ * @returns the number of tasks run
+ */
+LCUI_API size_t TaskRing_Run(LCUI_TaskRing ring, size_t max_tasks);
+
+/** Copy the latency histogram, it should be called by the running thread */
+LCUI_API void TaskRing_GetLatency(LCUI_TaskRing ring,
+				  LCUI_LatencyHistogram hist);
+
+LCUI_API void TaskRing_ResetLatency(LCUI_TaskRing ring);
+
+LCUI_API void LatencyHistogram_Add(LCUI_LatencyHistogram hist,
+				   int64_t latency);
+
+/**
+ * Get the upper bound of the bucket where the given percentile falls in
+ * @param[in] percentile 0 to 100
+ * @returns the latency in microseconds, 0 if the histogram is empty
+ */
+LCUI_API int64_t LatencyHistogram_GetPercentile(LCUI_LatencyHistogram hist,
+						double percentile);
+
+LCUI_END_HEADER
+
+#endif
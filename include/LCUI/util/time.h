@@ -39,6 +39,9 @@ LCUI_API int64_t LCUI_GetTime(void);
 
 LCUI_API int64_t LCUI_GetTimeDelta(int64_t start);
 
+/** 获取以微秒为单位的时间，只用于计算时间间隔 */
+LCUI_API int64_t LCUI_GetTimeUs(void);
+
 LCUI_API void LCUI_Sleep(unsigned int s);
 
 LCUI_API void LCUI_MSleep(unsigned int ms);
@@ -0,0 +1,96 @@
+/* trace.h -- frame timeline tracing
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LCUI_UTIL_TRACE_H
+#define LCUI_UTIL_TRACE_H
+
+#include <stdio.h>
+
+LCUI_BEGIN_HEADER
+
+/** Number of spans kept for each thread, older spans are overwritten */
+#define LCUI_TRACE_BUFFER_SIZE 8192
+
+#define LCUI_TRACE_DETAIL_LEN 32
+
+typedef struct LCUI_TraceSpanRec_ {
+	/* static strings, they are not copied */
+	const char *category;
+	const char *name;
+
+	/* optional detail, such as the widget type or the rectangle */
+	char detail[LCUI_TRACE_DETAIL_LEN];
+
+	/* in microseconds */
+	int64_t begin;
+	int64_t duration;
+} LCUI_TraceSpanRec, *LCUI_TraceSpan;
+
+/**
+ * Enable or disable tracing. Spans are recorded into a ring buffer of the
+ * calling thread, and the functions return immediately when it is disabled.
+ */
+LCUI_API void LCUITrace_Enable(LCUI_BOOL enable);
+
+LCUI_API LCUI_BOOL LCUITrace_IsEnabled(void);
+
+/** Set the name of the current thread shown in the timeline */
+LCUI_API void LCUITrace_SetThreadName(const char *name);
+
+/**
+ * Begin a span on the current thread, spans must be ended in reverse order.
+ * @param[in] category static string, such as "frame" or "widget"
+ * @param[in] name static string
+ * @param[in] detail optional string, it is copied and may be truncated
+ */
+LCUI_API void LCUITrace_Begin(const char *category, const char *name,
+			      const char *detail);
+
+/** End the last span begun on the current thread */
+LCUI_API void LCUITrace_End(void);
+
+/**
+ * Write recorded spans of all threads in the Chrome trace event format, it
+ * can be opened with chrome://tracing. Threads may keep tracing meanwhile.
+ * @returns the number of written spans, or -1 on error
+ */
+LCUI_API int LCUITrace_Dump(FILE *fp);
+
+LCUI_API int LCUITrace_DumpFile(const char *path);
+
+/** Drop recorded spans of all threads */
+LCUI_API void LCUITrace_Clear(void);
+
+LCUI_API void LCUI_InitTrace(void);
+
+LCUI_API void LCUI_FreeTrace(void);
+
+LCUI_END_HEADER
+
+#endif
@@ -33,8 +33,10 @@
 
 #ifdef LCUI_WORKER_C
 typedef struct LCUI_WorkerRec_ *LCUI_Worker;
+typedef struct LCUI_WorkerPoolRec_ *LCUI_WorkerPool;
 #else
 typedef void* LCUI_Worker;
+typedef void* LCUI_WorkerPool;
 #endif
 
 LCUI_API LCUI_Worker LCUIWorker_New(void);
@@ -49,4 +51,37 @@ LCUI_API int LCUIWorker_RunAsync(LCUI_Worker worker);
 
 LCUI_API void LCUIWorker_Destroy(LCUI_Worker worker);
 
+/**
+ * 新建工作线程池
+ * 每个线程都有自己的任务队列，空闲的线程会从其它线程的队列中窃取任务，不在
+ * 线程池中的线程添加的任务会轮流放到各个线程的收件队列中
+ * @param[in] n 线程数量，小于 1 时使用处理器核心数量
+ */
+LCUI_API LCUI_WorkerPool LCUIWorkerPool_New(int n);
+
+/**
+ * 添加任务
+ * 在工作线程中添加的任务会放到该线程自己的队列中，添加任务时不需要加锁
+ * @param[in] priority 任务的优先级
+ * @param[in] callback 任务完成后添加至主线程中执行的任务，可以为 NULL
+ * @returns 接收该任务的队列所属的线程编号，该任务仍可能被其它线程窃取执行；
+ * 失败时返回负数
+ */
+LCUI_API int LCUIWorkerPool_PostTask(LCUI_WorkerPool pool, LCUI_Task task,
+				     LCUI_TaskPriority priority,
+				     LCUI_Task callback);
+
+/**
+ * 添加任务至指定编号的线程
+ * 该任务不会被其它线程窃取，添加到同一线程的任务会按顺序逐个执行
+ */
+LCUI_API int LCUIWorkerPool_PostTaskTo(LCUI_WorkerPool pool, LCUI_Task task,
+				       int worker_id);
+
+/** 获取线程池中的线程数量 */
+LCUI_API int LCUIWorkerPool_GetThreads(LCUI_WorkerPool pool);
+
+/** 销毁线程池，还未执行的任务会被丢弃 */
+LCUI_API void LCUIWorkerPool_Destroy(LCUI_WorkerPool pool);
+
 #endif
@@ -0,0 +1,64 @@
+/* atomic.h -- atomic operations and memory fences
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * These wrap the GCC __sync builtins and the Windows Interlocked functions.
+ * The increments, decrements, compare-and-swaps and pointer exchanges are
+ * full memory barriers. Counters should be volatile long, which is 32 bits
+ * on Windows.
+ */
+
+#ifndef LCUI_ATOMIC_H
+#define LCUI_ATOMIC_H
+
+#ifdef LCUI_BUILD_IN_WIN32
+#include <Windows.h>
+#define MemoryFence() MemoryBarrier()
+#define AtomicIncrement(PTR) InterlockedIncrement((volatile LONG *)(PTR))
+#define AtomicDecrement(PTR) InterlockedDecrement((volatile LONG *)(PTR))
+#define AtomicReset(PTR) InterlockedExchange((volatile LONG *)(PTR), 0)
+#define AtomicCompareExchange(PTR, OLD, NEW)                               \
+	((unsigned long)InterlockedCompareExchange((volatile LONG *)(PTR), \
+						   (LONG)(NEW), (LONG)(OLD)) == \
+	 (unsigned long)(OLD))
+#define AtomicExchangePointer(PTR, VAL) \
+	InterlockedExchangePointer((PVOID volatile *)(PTR), (PVOID)(VAL))
+#else
+#define MemoryFence() __sync_synchronize()
+#define AtomicIncrement(PTR) __sync_add_and_fetch(PTR, 1)
+#define AtomicDecrement(PTR) __sync_sub_and_fetch(PTR, 1)
+#define AtomicReset(PTR) __sync_lock_test_and_set(PTR, 0)
+#define AtomicCompareExchange(PTR, OLD, NEW) \
+	__sync_bool_compare_and_swap(PTR, OLD, NEW)
+/* __sync_lock_test_and_set() is only an acquire barrier */
+#define AtomicExchangePointer(PTR, VAL) \
+	(__sync_synchronize(), __sync_lock_test_and_set(PTR, VAL))
+#endif
+
+#endif
@@ -42,6 +42,7 @@
 #include <LCUI/timer.h>
 #include <LCUI/cursor.h>
 #include <LCUI/thread.h>
+#include <LCUI/font.h>
 #include <LCUI/display.h>
 #include <LCUI/platform.h>
 #include <LCUI/settings.h>
@@ -49,6 +50,7 @@
 #ifdef LCUI_DISPLAY_H
 #include LCUI_DISPLAY_H
 #endif
+#include "tile_renderer.h"
 
 /* clang-format off */
 
@@ -65,7 +67,10 @@ typedef struct SurfaceRecordRec_ {
 	LCUI_BOOL rendered;
 
 	/** dirty rectangles for rendering */
-	LinkedList rects;
+	LCUI_DirtyRegionRec region;
+
+	/** rectangles rendered since the last present */
+	LCUI_DirtyRegionRec damage;
 
 	/** flashing rect list */
 	LinkedList flash_rects;
@@ -79,10 +84,16 @@ static struct LCUI_DisplayModule {
 	LCUI_BOOL active;
 	LCUI_DisplayMode mode;
 	LinkedList surfaces;
-	LinkedList rects;
+	LCUI_DirtyRegionRec region;
 	LCUI_DisplayDriver driver;
 	LCUI_SettingsRec settings;
 	int settings_change_handler_id;
+
+	/** tile renderer, shared by all surfaces */
+	LCUI_TileRenderer tiles;
+
+	/** flash rects may be appended by any rendering thread */
+	LCUI_Mutex flash_rects_mutex;
 } display;
 
 /* clang-format on */
@@ -101,7 +112,8 @@ static void OnDestroySurfaceRecord(void *data)
 	SurfaceRecord record = data;
 
 	Surface_Close(record->surface);
-	LinkedList_Clear(&record->rects, free);
+	DirtyRegion_Destroy(&record->region);
+	DirtyRegion_Destroy(&record->damage);
 	LinkedList_Clear(&record->flash_rects, free);
 	free(record);
 }
@@ -109,6 +121,8 @@ static void OnDestroySurfaceRecord(void *data)
 static void OnSettingsChangeEvent(LCUI_SysEvent e, void *arg)
 {
 	Settings_Init(&display.settings);
+	TileRenderer_SetThreads(display.tiles,
+				display.settings.parallel_rendering_threads);
 }
 
 static size_t LCUIDisplay_RenderFlashRect(SurfaceRecord record,
@@ -170,6 +184,7 @@ static size_t LCUIDisplay_UpdateFlashRects(SurfaceRecord record)
 			continue;
 		}
 		LCUIDisplay_RenderFlashRect(record, flash_rect);
+		DirtyRegion_Add(&record->damage, &flash_rect->rect);
 		record->rendered = TRUE;
 	}
 	return count;
@@ -180,10 +195,12 @@ static void LCUIDisplay_AppendFlashRects(SurfaceRecord record, LCUI_Rect *rect)
 	LinkedListNode *node;
 	FlashRect flash_rect;
 
+	LCUIMutex_Lock(&display.flash_rects_mutex);
 	for (LinkedList_Each(node, &record->flash_rects)) {
 		flash_rect = node->data;
 		if (is_rect_equals(&flash_rect->rect, rect)) {
 			flash_rect->paint_time = LCUI_GetTime();
+			LCUIMutex_Unlock(&display.flash_rects_mutex);
 			return;
 		}
 	}
@@ -192,6 +209,7 @@ static void LCUIDisplay_AppendFlashRects(SurfaceRecord record, LCUI_Rect *rect)
 	flash_rect->rect = *rect;
 	flash_rect->paint_time = LCUI_GetTime();
 	LinkedList_Append(&record->flash_rects, flash_rect);
+	LCUIMutex_Unlock(&display.flash_rects_mutex);
 }
 
 static void GetRenderingLayerSize(int *width, int *height)
@@ -213,6 +231,7 @@ static void SurfaceRecord_DumpRects(SurfaceRecord record, LinkedList *rects)
 	} DirtyLayerRec, *DirtyLayer;
 
 	int i;
+	size_t n;
 	int max_dirty;
 	int layer_width;
 	int layer_height;
@@ -221,7 +240,6 @@ static void SurfaceRecord_DumpRects(SurfaceRecord record, LinkedList *rects)
 	LCUI_Rect *sub_rect;
 	DirtyLayer layer;
 	DirtyLayerRec *layers;
-	LinkedListNode *node;
 
 	GetRenderingLayerSize(&layer_width, &layer_height);
 	max_dirty = (int)(0.8 * layer_width * layer_height);
@@ -237,8 +255,8 @@ static void SurfaceRecord_DumpRects(SurfaceRecord record, LinkedList *rects)
 		LinkedList_Init(&layer->rects);
 	}
 	sub_rect = malloc(sizeof(LCUI_Rect));
-	for (LinkedList_Each(node, &record->rects)) {
-		rect = *(LCUI_Rect *)node->data;
+	for (n = 0; n < record->region.length; ++n) {
+		rect = record->region.rects[n];
 		for (i = 0; i < display.settings.parallel_rendering_threads;
 		     ++i) {
 			layer = &layers[i];
@@ -268,7 +286,7 @@ static void SurfaceRecord_DumpRects(SurfaceRecord record, LinkedList *rects)
 			LinkedList_Concat(rects, &layer->rects);
 		}
 	}
-	RectList_Clear(&record->rects);
+	DirtyRegion_Clear(&record->region);
 	free(sub_rect);
 	free(layers);
 }
@@ -277,6 +295,8 @@ static size_t LCUIDisplay_RenderSurfaceRect(SurfaceRecord record,
 					    LCUI_Rect *rect)
 {
 	size_t count;
+	LCUI_BOOL traced;
+	char detail[LCUI_TRACE_DETAIL_LEN];
 	LCUI_PaintContext paint;
 
 	if (!record->widget || !record->surface ||
@@ -287,6 +307,12 @@ static size_t LCUIDisplay_RenderSurfaceRect(SurfaceRecord record,
 	if (!paint) {
 		return 0;
 	}
+	traced = LCUITrace_IsEnabled();
+	if (traced) {
+		snprintf(detail, LCUI_TRACE_DETAIL_LEN, "%d,%d %dx%d", rect->x,
+			 rect->y, rect->width, rect->height);
+		LCUITrace_Begin("render", "render rect", detail);
+	}
 	DEBUG_MSG("[thread %d/%d] rect: (%d,%d,%d,%d)\n", omp_get_thread_num(),
 		  omp_get_num_threads(), paint->rect.x, paint->rect.y,
 		  paint->rect.width, paint->rect.height);
@@ -298,10 +324,35 @@ static size_t LCUIDisplay_RenderSurfaceRect(SurfaceRecord record,
 		LCUICursor_Paint(paint);
 	}
 	Surface_EndPaint(record->surface, paint);
+	if (traced) {
+		LCUITrace_End();
+	}
 	return count;
 }
 
-static size_t LCUIDisplay_RenderSurface(SurfaceRecord record)
+static size_t LCUIDisplay_RenderSurfaceTile(void *arg, LCUI_Rect *rect)
+{
+	return LCUIDisplay_RenderSurfaceRect(arg, rect);
+}
+
+static size_t LCUIDisplay_RenderSurfaceTiles(SurfaceRecord record)
+{
+	size_t i;
+	LCUI_SysEventRec ev;
+
+	ev.type = LCUI_PAINT;
+	for (i = 0; i < record->region.length; ++i) {
+		ev.paint.rect = record->region.rects[i];
+		LCUI_TriggerEvent(&ev, NULL);
+		TileRenderer_AddDirtyRect(display.tiles,
+					  &record->region.rects[i]);
+	}
+	DirtyRegion_Clear(&record->region);
+	return TileRenderer_Render(display.tiles,
+				   LCUIDisplay_RenderSurfaceTile, record);
+}
+
+static size_t LCUIDisplay_RenderSurfaceStrips(SurfaceRecord record)
 {
 	int i = 0;
 	int dirty = 0;
@@ -350,6 +401,25 @@ static size_t LCUIDisplay_RenderSurface(SurfaceRecord record)
 	}
 	free(rect_array);
 	RectList_Clear(&rects);
+	return count;
+}
+
+static size_t LCUIDisplay_RenderSurface(SurfaceRecord record)
+{
+	size_t i, count;
+
+	if (record->region.length < 1) {
+		return 0;
+	}
+	for (i = 0; i < record->region.length; ++i) {
+		DirtyRegion_Add(&record->damage, &record->region.rects[i]);
+	}
+	if (display.settings.parallel_rendering_mode ==
+	    LCUI_PARALLEL_RENDERING_TILES) {
+		count = LCUIDisplay_RenderSurfaceTiles(record);
+	} else {
+		count = LCUIDisplay_RenderSurfaceStrips(record);
+	}
 	record->rendered = count > 0;
 	count += LCUIDisplay_UpdateFlashRects(record);
 	return count;
@@ -370,12 +440,12 @@ void LCUIDisplay_Update(void)
 		if (record->widget && surface && Surface_IsReady(surface)) {
 			Surface_Update(surface);
 		}
-		Widget_GetInvalidArea(record->widget, &record->rects);
+		Widget_GetInvalidArea(record->widget, &record->region);
 	}
 	if (display.mode == LCUI_DMODE_SEAMLESS || !record) {
 		return;
 	}
-	LinkedList_Concat(&record->rects, &display.rects);
+	DirtyRegion_Concat(&record->region, &display.region);
 }
 
 size_t LCUIDisplay_Render(void)
@@ -390,15 +460,19 @@ size_t LCUIDisplay_Render(void)
 		count += LCUIDisplay_RenderSurface(node->data);
 		count += LCUIDisplay_UpdateFlashRects(node->data);
 	}
+	/* all renderers have finished, the scratch memory can be reused */
+	LCUIFrameArena_Reset();
+	LCUIFont_EndFrame();
 	return count;
 }
 
-void LCUIDisplay_Present(void)
+size_t LCUIDisplay_Present(void)
 {
+	size_t bytes = 0;
 	LinkedListNode *sn;
 
 	if (!display.active) {
-		return;
+		return 0;
 	}
 	for (LinkedList_Each(sn, &display.surfaces)) {
 		SurfaceRecord record = sn->data;
@@ -407,9 +481,14 @@ void LCUIDisplay_Present(void)
 			continue;
 		}
 		if (record->rendered) {
-			Surface_Present(surface);
+			bytes += Surface_PresentRects(surface,
+						      record->damage.rects,
+						      record->damage.length);
+			record->rendered = FALSE;
 		}
+		DirtyRegion_Clear(&record->damage);
 	}
+	return bytes;
 }
 
 void LCUIDisplay_InvalidateArea(LCUI_Rect *rect)
@@ -427,7 +506,34 @@ void LCUIDisplay_InvalidateArea(LCUI_Rect *rect)
 		rect = &area;
 	}
 	RectToInvalidArea(rect, &area);
-	RectList_Add(&display.rects, &area);
+	DirtyRegion_Add(&display.region, &area);
+}
+
+LCUI_BOOL LCUIDisplay_HasPendingPaint(void)
+{
+	LCUI_Widget w;
+	LinkedListNode *node;
+	SurfaceRecord record;
+
+	if (!display.active) {
+		return FALSE;
+	}
+	if (display.region.length > 0) {
+		return TRUE;
+	}
+	for (LinkedList_Each(node, &display.surfaces)) {
+		record = node->data;
+		w = record->widget;
+		if (record->rendered || record->region.length > 0 ||
+		    record->flash_rects.length > 0) {
+			return TRUE;
+		}
+		if (w && (w->has_child_invalid_area ||
+			  w->invalid_area_type != LCUI_INVALID_AREA_TYPE_NONE)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
 }
 
 static LCUI_Widget LCUIDisplay_GetBindWidget(LCUI_Surface surface)
@@ -496,6 +602,8 @@ static void LCUIDisplay_BindSurface(LCUI_Widget widget)
 	record->surface = Surface_New();
 	record->widget = widget;
 	record->rendered = FALSE;
+	DirtyRegion_Init(&record->region);
+	DirtyRegion_Init(&record->damage);
 	LinkedList_Init(&record->flash_rects);
 	LCUIMetrics_ComputeRectActual(&rect, &widget->box.canvas);
 	if (Widget_CheckStyleValid(widget, key_top) &&
@@ -810,6 +918,20 @@ void Surface_Present(LCUI_Surface surface)
 	}
 }
 
+size_t Surface_PresentRects(LCUI_Surface surface, const LCUI_Rect *rects,
+			    size_t n_rects)
+{
+	if (!display.driver) {
+		return 0;
+	}
+	if (display.driver->presentRects) {
+		return display.driver->presentRects(surface, rects, n_rects);
+	}
+	display.driver->present(surface);
+	return (size_t)Surface_GetWidth(surface) * Surface_GetHeight(surface) *
+	       sizeof(LCUI_ARGB);
+}
+
 /** 响应顶级部件的各种事件 */
 static void OnSurfaceEvent(LCUI_Widget w, LCUI_WidgetEvent e, void *arg)
 {
@@ -942,8 +1064,19 @@ int LCUIDisplay_BindEvent(int event_id, LCUI_EventFunc func, void *arg,
 	return -1;
 }
 
+static LCUI_BOOL LCUIDisplay_IsHeadlessDriver(LCUI_DisplayDriver driver)
+{
+	return driver && strcmp(driver->name, "headless") == 0;
+}
+
+LCUI_BOOL LCUIDisplay_IsHeadless(void)
+{
+	return display.active && LCUIDisplay_IsHeadlessDriver(display.driver);
+}
+
 int LCUI_InitDisplay(LCUI_DisplayDriver driver)
 {
+	const char *env;
 	LCUI_Widget root;
 	if (display.active) {
 		return -1;
@@ -955,13 +1088,22 @@ int LCUI_InitDisplay(LCUI_DisplayDriver driver)
 	display.width = DEFAULT_WIDTH;
 	display.height = DEFAULT_HEIGHT;
 	Settings_Init(&display.settings);
+	display.tiles = TileRenderer_New();
+	TileRenderer_SetThreads(display.tiles,
+				display.settings.parallel_rendering_threads);
+	LCUIMutex_Init(&display.flash_rects_mutex);
 	display.settings_change_handler_id = LCUI_BindEvent(
 	    LCUI_SETTINGS_CHANGE, OnSettingsChangeEvent, NULL, NULL);
 
-	LinkedList_Init(&display.rects);
+	DirtyRegion_Init(&display.region);
 	LinkedList_Init(&display.surfaces);
 	if (!display.driver) {
-		display.driver = LCUI_CreateDisplayDriver();
+		env = getenv("LCUI_DISPLAY_DRIVER");
+		if (env && strcmp(env, "headless") == 0) {
+			display.driver = LCUI_CreateHeadlessDisplayDriver();
+		} else {
+			display.driver = LCUI_CreateDisplayDriver();
+		}
 	}
 	if (!display.driver) {
 		Logger_Warning("[display] init failed\n");
@@ -989,12 +1131,18 @@ int LCUI_FreeDisplay(void)
 		return -1;
 	}
 	display.active = FALSE;
-	RectList_Clear(&display.rects);
+	DirtyRegion_Destroy(&display.region);
 	LCUIDisplay_CleanSurfaces();
-	if (display.driver) {
+	if (LCUIDisplay_IsHeadlessDriver(display.driver)) {
+		LCUI_DestroyHeadlessDisplayDriver(display.driver);
+	} else if (display.driver) {
 		LCUI_DestroyDisplayDriver(display.driver);
 	}
+	display.driver = NULL;
 	LCUI_UnbindEvent(display.settings_change_handler_id);
 	display.settings_change_handler_id = -1;
+	TileRenderer_Destroy(display.tiles);
+	LCUIMutex_Destroy(&display.flash_rects_mutex);
+	display.tiles = NULL;
 	return 0;
 }
@@ -45,6 +45,21 @@
 #define SmoothLeftPixel(PX, X) (uchar_t)((PX)->a * (1.0 - (X - 1.0 * (int)X)))
 #define SmoothRightPixel(PX, X) (uchar_t)((PX)->a * (X - 1.0 * (int)X))
 
+/* Fade out a pixel of the cropped content, premultiplied pixels fade all
+ * channels */
+INLINE void FadeContentPixel(const LCUI_Graph *graph, LCUI_ARGB *px,
+			     double x)
+{
+	double k = 1.0 - (x - 1.0 * (int)x);
+
+	if (graph->color_type == LCUI_COLOR_TYPE_PARGB) {
+		px->r = (uchar_t)(px->r * k);
+		px->g = (uchar_t)(px->g * k);
+		px->b = (uchar_t)(px->b * k);
+	}
+	px->a = (uchar_t)(px->a * k);
+}
+
 #define BorderRenderContext()                             \
 	int x, y;                                         \
 	int right;                                        \
@@ -471,7 +486,7 @@ static int CropContentTopLeft(LCUI_Graph *dst, int bound_left, int bound_top,
 		outer_xi = max(0, min(outer_xi, rect.width));
 		p = Graph_GetPixelPointer(dst, rect.x, rect.y + yi);
 		for (xi = 0; xi < outer_xi; ++xi, ++p) {
-			p->alpha = 0;
+			p->value = 0;
 		}
 		/* If inner ellipse is circle */
 		if (radius_x == radius_y) {
@@ -479,9 +494,9 @@ static int CropContentTopLeft(LCUI_Graph *dst, int bound_left, int bound_top,
 				x = ToGeoX(xi, center_x);
 				d = sqrt(x * x + y * y) - radius_x;
 				if (d >= 1.0) {
-					p->alpha = 0;
+					p->value = 0;
 				} else if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
+					FadeContentPixel(dst, p, d);
 				} else {
 					break;
 				}
@@ -493,9 +508,9 @@ static int CropContentTopLeft(LCUI_Graph *dst, int bound_left, int bound_top,
 				x = ToGeoX(xi, center_x);
 				d = x - outer_x;
 				if (d >= 1.0) {
-					p->alpha = 0;
+					p->value = 0;
 				} else if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
+					FadeContentPixel(dst, p, d);
 				} else {
 					break;
 				}
@@ -540,7 +555,7 @@ static int CropContentTopRight(LCUI_Graph *dst, int bound_left, int bound_top,
 					break;
 				}
 				if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
+					FadeContentPixel(dst, p, d);
 				}
 			}
 		} else {
@@ -553,12 +568,12 @@ static int CropContentTopRight(LCUI_Graph *dst, int bound_left, int bound_top,
 					break;
 				}
 				if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
+					FadeContentPixel(dst, p, d);
 				}
 			}
 		}
 		for (; xi < rect.width; ++xi, ++p) {
-			p->alpha = 0;
+			p->value = 0;
 		}
 	}
 	return 0;
@@ -592,16 +607,16 @@ static int CropContentBottomLeft(LCUI_Graph *dst, int bound_left, int bound_top,
 		outer_xi = max(0, min(outer_xi, rect.width));
 		p = Graph_GetPixelPointer(dst, rect.x, rect.y + yi);
 		for (xi = 0; xi < outer_xi; ++xi, ++p) {
-			p->alpha = 0;
+			p->value = 0;
 		}
 		if (radius_x == radius_y) {
 			for (; xi < rect.width; ++xi, ++p) {
 				x = ToGeoX(xi, center_x);
 				d = sqrt(x * x + y * y) - radius_x;
 				if (d >= 1.0) {
-					p->alpha = 0;
+					p->value = 0;
 				} else if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
+					FadeContentPixel(dst, p, d);
 				} else {
 					break;
 				}
@@ -613,9 +628,9 @@ static int CropContentBottomLeft(LCUI_Graph *dst, int bound_left, int bound_top,
 				x = ToGeoX(xi, center_x);
 				d = x - outer_x;
 				if (d >= 1.0) {
-					p->alpha = 0;
+					p->value = 0;
 				} else if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
+					FadeContentPixel(dst, p, d);
 				} else {
 					break;
 				}
@@ -661,7 +676,7 @@ static int CropContentBottomRight(LCUI_Graph *dst, int bound_left,
 					break;
 				}
 				if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
+					FadeContentPixel(dst, p, d);
 				}
 			}
 		} else {
@@ -674,12 +689,12 @@ static int CropContentBottomRight(LCUI_Graph *dst, int bound_left,
 					break;
 				}
 				if (d >= 0) {
-					p->alpha = SmoothLeftPixel(p, d);
+					FadeContentPixel(dst, p, d);
 				}
 			}
 		}
 		for (; xi < rect.width; ++xi, ++p) {
-			p->alpha = 0;
+			p->value = 0;
 		}
 	}
 	return 0;
@@ -37,19 +37,24 @@
 #include <LCUI/types.h>
 #include <LCUI/util.h>
 #include <LCUI/graph.h>
+#include <LCUI/thread.h>
+#include <LCUI/main.h>
+#include <LCUI/settings.h>
 #include <LCUI/font.h>
+#include "glyphcache.h"
+#include "glyphfile.h"
+#include "../graph_mixer.h"
 
 /* clang-format off */
 
 #define FONT_CACHE_SIZE		32
 #define FONT_CACHE_MAX_SIZE	1024
+#define GLYPH_CACHE_MAX_BYTES	(4096 * 1024)
 
 /**
- * 库中缓存的字体位图是分组存放的，共有三级分组，分别为：
- * 字符->字体信息->字体大小
- * 获取字体位图时的搜索顺序为：先找到字符的记录，然后在记录中的字体数据库里找
- * 到指定字体样式标识号的字体位图库，之后在字体位图库中找到指定像素大小的字体
- * 位图。
+ * 库中缓存的字体位图以 字符+字体+字体大小 为键存放在字形缓存中，位图的像素数据
+ * 存放在共享的图集页中，超出内存预算时会清除最近最少使用的页，被清除的位图在下
+ * 次绘制时重新渲染。
  */
 
 typedef struct LCUI_FontStyleNodeRec_ {
@@ -75,7 +80,11 @@ static struct LCUI_FontLibraryModule {
 	LCUI_BOOL active;		/**< 标记，指示数据库是否初始化 */
 	Dict *font_families;		/**< 字族信息库，以字族名称索引字体信息 */
 	DictType font_families_type;	/**< 字族信息库的字典类型数据 */
-	RBTree bitmap_cache;		/**< 字体位图缓存区 */
+	LCUI_GlyphCache bitmap_cache;	/**< 字体位图缓存区 */
+	LCUI_Mutex bitmap_mutex;	/**< 字体位图渲染锁 */
+	LCUI_GlyphFile bitmap_file;	/**< 字体位图缓存文件 */
+	size_t file_hit_count;		/**< 从缓存文件中载入的位图数量 */
+	int settings_change_handler_id;
 	LCUI_FontCache *font_cache;	/**< 字体信息缓存区 */
 	LCUI_Font default_font;		/**< 默认字体的信息 */
 	LCUI_Font incore_font;		/**< 内置字体的信息 */
@@ -87,9 +96,6 @@ static struct LCUI_FontLibraryModule {
 
 #define FontBitmap_IsValid(fbmp) \
 	((fbmp) && (fbmp)->width > 0 && (fbmp)->rows > 0)
-#define SelectChar(ch) (RBTree *)RBTree_GetData(&fontlib.bitmap_cache, ch)
-#define SelectFont(ch, font_id) (RBTree *)RBTree_GetData(ch, font_id)
-#define SelectBitmap(font, size) (LCUI_FontBitmap *)RBTree_GetData(font, size)
 #define SelectFontFamliy(family_name) \
 	(LCUI_FontFamilyNode)         \
 	    Dict_FetchValue(fontlib.font_families, family_name);
@@ -215,6 +221,7 @@ LCUI_Font Font(const char *family_name, const char *style_name)
 	font->id = 0;
 	font->data = NULL;
 	font->engine = NULL;
+	font->file_key = 0;
 	font->family_name = strdup2(family_name);
 	font->style_name = strdup2(style_name);
 	font->weight = LCUIFont_DetectWeight(style_name);
@@ -243,18 +250,6 @@ static void DestroyFontFamilyNode(void *privdata, void *data)
 	free(node);
 }
 
-static void DestroyFontBitmap(void *arg)
-{
-	FontBitmap_Free(arg);
-	free(arg);
-}
-
-static void DestroyTreeNode(void *arg)
-{
-	RBTree_Destroy(arg);
-	free(arg);
-}
-
 int LCUIFont_Add(LCUI_Font font)
 {
 	LCUI_Font exists_font;
@@ -519,57 +514,64 @@ void LCUIFont_SetDefault(int id)
 LCUI_FontBitmap *LCUIFont_AddBitmap(wchar_t ch, int font_id, int size,
 				    const LCUI_FontBitmap *bmp)
 {
-	LCUI_FontBitmap *bmp_cache;
-	RBTree *tree_font, *tree_bmp;
+	const LCUI_FontBitmap *glyph;
 
 	if (!fontlib.active) {
 		return NULL;
 	}
-	/* 获取字符的字体信息集 */
-	tree_font = SelectChar(ch);
-	if (!tree_font) {
-		tree_font = NEW(RBTree, 1);
-		if (!tree_font) {
-			return NULL;
-		}
-		RBTree_Init(tree_font);
-		RBTree_OnDestroy(tree_font, DestroyTreeNode);
-		RBTree_Insert(&fontlib.bitmap_cache, ch, tree_font);
-	}
 	/* 当字体ID不大于0时，使用内置字体 */
 	if (font_id <= 0) {
 		font_id = fontlib.incore_font->id;
 	}
-	/* 获取相应字体样式标识号的字体位图库 */
-	tree_bmp = SelectFont(tree_font, font_id);
-	if (!tree_bmp) {
-		tree_bmp = NEW(RBTree, 1);
-		if (!tree_bmp) {
-			return NULL;
-		}
-		RBTree_Init(tree_bmp);
-		RBTree_OnDestroy(tree_bmp, DestroyFontBitmap);
-		RBTree_Insert(tree_font, font_id, tree_bmp);
-	}
-	/* 在字体位图库中获取指定像素大小的字体位图 */
-	bmp_cache = SelectBitmap(tree_bmp, size);
-	if (!bmp_cache) {
-		bmp_cache = NEW(LCUI_FontBitmap, 1);
-		if (!bmp_cache) {
-			return NULL;
-		}
-		RBTree_Insert(tree_bmp, size, bmp_cache);
+	/* 缓存中保存的是位图数据的拷贝，原位图数据已不再需要 */
+	glyph = GlyphCache_Put(fontlib.bitmap_cache, ch, font_id, size, bmp);
+	free(bmp->buffer);
+	return (LCUI_FontBitmap *)glyph;
+}
+
+/** 从缓存文件中载入字体位图，位图数据不会被复制 */
+static const LCUI_FontBitmap *LCUIFont_LoadFileBitmap(wchar_t ch, int font_id,
+						      int size)
+{
+	LCUI_Font font;
+	LCUI_FontBitmap bmp;
+
+	if (!fontlib.bitmap_file) {
+		return NULL;
+	}
+	font = LCUIFont_GetById(font_id);
+	if (!font || !font->file_key) {
+		return NULL;
+	}
+	if (!GlyphFile_Get(fontlib.bitmap_file, font->file_key, ch, size,
+			   &bmp)) {
+		return NULL;
+	}
+	fontlib.file_hit_count++;
+	return GlyphCache_PutStatic(fontlib.bitmap_cache, ch, font_id, size,
+				    &bmp);
+}
+
+/** 将渲染出的字体位图保存至缓存文件中 */
+static void LCUIFont_SaveFileBitmap(wchar_t ch, int font_id, int size,
+				    const LCUI_FontBitmap *bmp)
+{
+	LCUI_Font font;
+
+	if (!fontlib.bitmap_file) {
+		return;
+	}
+	font = LCUIFont_GetById(font_id);
+	if (font && font->file_key) {
+		GlyphFile_Add(fontlib.bitmap_file, font->file_key, ch, size,
+			      bmp);
 	}
-	/* 拷贝数据至该空间内 */
-	memcpy(bmp_cache, bmp, sizeof(LCUI_FontBitmap));
-	return bmp_cache;
 }
 
 int LCUIFont_GetBitmap(wchar_t ch, int font_id, int size,
 		       const LCUI_FontBitmap **bmp)
 {
 	int ret;
-	RBTree *ctx;
 	LCUI_FontBitmap bmp_cache;
 
 	*bmp = NULL;
@@ -583,36 +585,89 @@ int LCUIFont_GetBitmap(wchar_t ch, int font_id, int size,
 			font_id = fontlib.incore_font->id;
 		}
 	}
-	do {
-		if (!(ctx = SelectChar(ch))) {
-			break;
-		}
-		ctx = SelectFont(ctx, font_id);
-		if (!ctx) {
-			break;
-		}
-		*bmp = SelectBitmap(ctx, size);
-		if (*bmp) {
-			return 0;
-		}
-		break;
-	} while (0);
+	*bmp = GlyphCache_Get(fontlib.bitmap_cache, ch, font_id, size);
+	if (*bmp) {
+		return 0;
+	}
 	if (ch == 0) {
 		return -1;
 	}
+	/* 字体引擎不是线程安全的 */
+	LCUIMutex_Lock(&fontlib.bitmap_mutex);
+	*bmp = LCUIFont_LoadFileBitmap(ch, font_id, size);
+	if (*bmp) {
+		LCUIMutex_Unlock(&fontlib.bitmap_mutex);
+		return 0;
+	}
 	FontBitmap_Init(&bmp_cache);
 	ret = LCUIFont_RenderBitmap(&bmp_cache, ch, font_id, size);
 	if (ret == 0) {
+		LCUIFont_SaveFileBitmap(ch, font_id, size, &bmp_cache);
 		*bmp = LCUIFont_AddBitmap(ch, font_id, size, &bmp_cache);
+		LCUIMutex_Unlock(&fontlib.bitmap_mutex);
 		return 0;
 	}
 	ret = LCUIFont_GetBitmap(0, font_id, size, bmp);
 	if (ret != 0) {
 		*bmp = LCUIFont_AddBitmap(0, font_id, size, &bmp_cache);
+	} else {
+		FontBitmap_Free(&bmp_cache);
 	}
+	LCUIMutex_Unlock(&fontlib.bitmap_mutex);
 	return -1;
 }
 
+const LCUI_FontBitmap *LCUIFont_LoadBitmap(const LCUI_FontBitmap *bmp)
+{
+	int size, font_id;
+	wchar_t ch;
+	LCUI_FontBitmap bmp_cache;
+	const LCUI_FontBitmap *glyph;
+
+	if (GlyphCache_Load(fontlib.bitmap_cache, bmp)) {
+		return bmp;
+	}
+	GlyphCache_GetKey(bmp, &ch, &font_id, &size);
+	LCUIMutex_Lock(&fontlib.bitmap_mutex);
+	FontBitmap_Init(&bmp_cache);
+	LCUIFont_RenderBitmap(&bmp_cache, ch, font_id, size);
+	/* 重新载入的像素数据在当前帧内不会被清除 */
+	glyph = GlyphCache_Put(fontlib.bitmap_cache, ch, font_id, size,
+			       &bmp_cache);
+	FontBitmap_Free(&bmp_cache);
+	LCUIMutex_Unlock(&fontlib.bitmap_mutex);
+	return glyph;
+}
+
+void LCUIFont_EndFrame(void)
+{
+	GlyphCache_EndFrame(fontlib.bitmap_cache);
+}
+
+void LCUIFont_GetBitmapCacheProfile(LCUI_GlyphCacheProfile profile)
+{
+	GlyphCache_GetProfile(fontlib.bitmap_cache, profile);
+	LCUIMutex_Lock(&fontlib.bitmap_mutex);
+	profile->file_hit_count = fontlib.file_hit_count;
+	fontlib.file_hit_count = 0;
+	LCUIMutex_Unlock(&fontlib.bitmap_mutex);
+}
+
+int LCUIFont_OpenCacheFile(const char *path)
+{
+	if (!fontlib.active || fontlib.bitmap_file) {
+		return -1;
+	}
+	fontlib.bitmap_file = GlyphFile_Open(path);
+	if (!fontlib.bitmap_file) {
+		Logger_Warning("[font] failed to open cache file: %s\n", path);
+		return -2;
+	}
+	Logger_Debug("[font] cache file: %s, %zu glyphs\n", path,
+		     GlyphFile_GetCount(fontlib.bitmap_file));
+	return 0;
+}
+
 static int LCUIFont_LoadFileEx(LCUI_FontEngine *engine, const char *file)
 {
 	LCUI_Font *fonts;
@@ -628,7 +683,11 @@ static int LCUIFont_LoadFileEx(LCUI_FontEngine *engine, const char *file)
 		return -2;
 	}
 	for (i = 0; i < num_fonts; ++i) {
+		if (!fonts[i]) {
+			continue;
+		}
 		fonts[i]->engine = engine;
+		fonts[i]->file_key = GlyphFile_GetFontKey(file, i);
 		id = LCUIFont_Add(fonts[i]);
 		Logger_Debug("[font] add family: %s, style name: %s, id: %d\n",
 			    fonts[i]->family_name, fonts[i]->style_name, id);
@@ -714,88 +773,72 @@ int FontBitmap_Print(LCUI_FontBitmap *fontbmp)
 	return 0;
 }
 
-static void FontBitmap_MixARGB(LCUI_Graph *graph, LCUI_Rect *write_rect,
-			       const LCUI_FontBitmap *bmp, LCUI_Color color,
-			       LCUI_Rect *read_rect)
-{
-	int x, y;
-	LCUI_Color c;
-	LCUI_ARGB *px, *px_row_des;
-	uchar_t *byte_ptr, *byte_row_ptr;
-
-	byte_row_ptr = bmp->buffer + read_rect->y * bmp->width;
-	px_row_des = graph->argb + write_rect->y * graph->width;
-	byte_row_ptr += read_rect->x;
-	px_row_des += write_rect->x;
-	for (y = 0; y < read_rect->height; ++y) {
-		px = px_row_des;
-		byte_ptr = byte_row_ptr;
-		for (x = 0; x < read_rect->width; ++x, ++byte_ptr, ++px) {
-			c = color;
-			c.alpha = (uchar_t)(*byte_ptr * color.alpha / 255.0);
-			LCUI_OverPixel(px, &c);
+int FontBitmap_MixRow(LCUI_Graph *graph, const LCUI_Pos *pos,
+		      const LCUI_FontBitmap **bmps, size_t n, LCUI_Color color)
+{
+	int y;
+	size_t i;
+	uchar_t *row;
+	const uchar_t *mask;
+	LCUI_Graph *source;
+	LCUI_Rect r_rect, w_rect, valid;
+	const LCUI_PixelMixerRec *mixer = PixelMixer_Get();
+	void (*mask_argb)(LCUI_ARGB *, const uchar_t *, size_t, LCUI_ARGB);
+
+	if (color.alpha == 0) {
+		return 0;
+	}
+	/* 获取引用区域在源图像中的位置 */
+	Graph_GetValidRect(graph, &valid);
+	source = Graph_GetQuote(graph);
+	switch (source->color_type) {
+	case LCUI_COLOR_TYPE_ARGB:
+		mask_argb = mixer->mask_argb;
+		break;
+	case LCUI_COLOR_TYPE_PARGB:
+		mask_argb = mixer->mask_pargb;
+		break;
+	default:
+		mask_argb = NULL;
+		break;
+	}
+	for (i = 0; i < n; ++i) {
+		w_rect.x = pos[i].x;
+		w_rect.y = pos[i].y;
+		w_rect.width = bmps[i]->width;
+		w_rect.height = bmps[i]->rows;
+		/* 获取需要裁剪的区域 */
+		LCUIRect_GetCutArea(graph->width, graph->height, w_rect,
+				    &r_rect);
+		if (r_rect.width <= 0 || r_rect.height <= 0) {
+			continue;
 		}
-		px_row_des += graph->width;
-		byte_row_ptr += bmp->width;
-	}
-}
-
-static void FontBitmap_MixRGB(LCUI_Graph *graph, LCUI_Rect *write_rect,
-			      const LCUI_FontBitmap *bmp, LCUI_Color color,
-			      LCUI_Rect *read_rect)
-{
-	int x, y;
-	uchar_t *byte_src, *byte_row_src, *byte_row_des, *byte_des, alpha;
-	byte_row_src = bmp->buffer + read_rect->y * bmp->width + read_rect->x;
-	byte_row_des = graph->bytes + write_rect->y * graph->bytes_per_row;
-	byte_row_des += write_rect->x * graph->bytes_per_pixel;
-	for (y = 0; y < read_rect->height; ++y) {
-		byte_src = byte_row_src;
-		byte_des = byte_row_des;
-		for (x = 0; x < read_rect->width; ++x) {
-			alpha = (uchar_t)(*byte_src * color.alpha / 255);
-			ALPHA_BLEND(*byte_des, color.b, alpha);
-			++byte_des;
-			ALPHA_BLEND(*byte_des, color.g, alpha);
-			++byte_des;
-			ALPHA_BLEND(*byte_des, color.r, alpha);
-			++byte_des;
-			++byte_src;
+		w_rect.x += r_rect.x + valid.x;
+		w_rect.y += r_rect.y + valid.y;
+		mask = bmps[i]->buffer + r_rect.y * bmps[i]->width + r_rect.x;
+		row = source->bytes + w_rect.y * source->bytes_per_row +
+		      w_rect.x * source->bytes_per_pixel;
+		for (y = 0; y < r_rect.height; ++y) {
+			if (mask_argb) {
+				mask_argb((LCUI_ARGB *)row, mask, r_rect.width,
+					  color);
+			} else {
+				mixer->mask_rgb(row, mask, r_rect.width, color);
+			}
+			row += source->bytes_per_row;
+			mask += bmps[i]->width;
 		}
-		byte_row_des += graph->bytes_per_row;
-		byte_row_src += bmp->width;
 	}
+	return 0;
 }
 
 int FontBitmap_Mix(LCUI_Graph *graph, LCUI_Pos pos, const LCUI_FontBitmap *bmp,
 		   LCUI_Color color)
 {
-	LCUI_Graph write_slot;
-	LCUI_Rect r_rect, w_rect;
 	if (pos.x > (int)graph->width || pos.y > (int)graph->height) {
 		return -2;
 	}
-	/* 获取写入区域 */
-	w_rect.x = pos.x;
-	w_rect.y = pos.y;
-	w_rect.width = bmp->width;
-	w_rect.height = bmp->rows;
-	/* 获取需要裁剪的区域 */
-	LCUIRect_GetCutArea(graph->width, graph->height, w_rect, &r_rect);
-	w_rect.x += r_rect.x;
-	w_rect.y += r_rect.y;
-	w_rect.width = r_rect.width;
-	w_rect.height = r_rect.height;
-	Graph_Quote(&write_slot, graph, &w_rect);
-	Graph_GetValidRect(&write_slot, &w_rect);
-	/* 获取背景图引用的源图形 */
-	graph = Graph_GetQuote(graph);
-	if (graph->color_type == LCUI_COLOR_TYPE_ARGB) {
-		FontBitmap_MixARGB(graph, &w_rect, bmp, color, &r_rect);
-	} else {
-		FontBitmap_MixRGB(graph, &w_rect, bmp, color, &r_rect);
-	}
-	return 0;
+	return FontBitmap_MixRow(graph, &pos, &bmp, 1, color);
 }
 
 int LCUIFont_RenderBitmap(LCUI_FontBitmap *buff, wchar_t ch, int font_id,
@@ -829,11 +872,11 @@ static void LCUIFont_InitBase(void)
 	fontlib.font_cache_num = 1;
 	fontlib.font_cache = NEW(LCUI_FontCache, 1);
 	fontlib.font_cache[0] = FontCache();
-	RBTree_Init(&fontlib.bitmap_cache);
+	fontlib.bitmap_cache = GlyphCache_New(GLYPH_CACHE_MAX_BYTES);
+	LCUIMutex_Init(&fontlib.bitmap_mutex);
 	Dict_InitStringKeyType(&fontlib.font_families_type);
 	fontlib.font_families_type.valDestructor = DestroyFontFamilyNode;
 	fontlib.font_families = Dict_Create(&fontlib.font_families_type, NULL);
-	RBTree_OnDestroy(&fontlib.bitmap_cache, DestroyTreeNode);
 	fontlib.active = TRUE;
 }
 
@@ -872,7 +915,14 @@ static void LCUIFont_FreeBase(void)
 		DeleteFontCache(fontlib.font_cache[fontlib.font_cache_num]);
 	}
 	Dict_Release(fontlib.font_families);
-	RBTree_Destroy(&fontlib.bitmap_cache);
+	GlyphCache_Delete(fontlib.bitmap_cache);
+	LCUIMutex_Destroy(&fontlib.bitmap_mutex);
+	fontlib.bitmap_cache = NULL;
+	/* 字体位图缓存中可能有引用文件中的位图，所以最后关闭文件 */
+	if (fontlib.bitmap_file) {
+		GlyphFile_Close(fontlib.bitmap_file);
+		fontlib.bitmap_file = NULL;
+	}
 	free(fontlib.font_cache);
 	fontlib.font_cache = NULL;
 }
@@ -980,15 +1030,37 @@ static void LCUIFont_LoadDefaultFonts(void)
 #endif
 }
 
+static void OnSettingsChangeEvent(LCUI_SysEvent e, void *arg)
+{
+	LCUI_SettingsRec settings;
+
+	Settings_Init(&settings);
+	if (settings.glyph_cache_size > 0) {
+		GlyphCache_SetMaxBytes(
+		    fontlib.bitmap_cache,
+		    (size_t)settings.glyph_cache_size * 1024);
+	}
+}
+
 void LCUI_InitFontLibrary(void)
 {
+	const char *cache_file = getenv("LCUI_GLYPH_CACHE_FILE");
+
 	LCUIFont_InitBase();
+	if (cache_file) {
+		LCUIFont_OpenCacheFile(cache_file);
+	}
 	LCUIFont_InitEngine();
 	LCUIFont_LoadDefaultFonts();
+	OnSettingsChangeEvent(NULL, NULL);
+	fontlib.settings_change_handler_id = LCUI_BindEvent(
+	    LCUI_SETTINGS_CHANGE, OnSettingsChangeEvent, NULL, NULL);
 }
 
 void LCUI_FreeFontLibrary(void)
 {
+	LCUI_UnbindEvent(fontlib.settings_change_handler_id);
+	fontlib.settings_change_handler_id = -1;
 	LCUIFont_FreeBase();
 	LCUIFont_FreeEngine();
 }
@@ -0,0 +1,560 @@
+/* glyphcache.c -- bounded glyph bitmap cache
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Glyphs are found in a hash table keyed by (code, font id, pixel size).
+ * Their metrics are kept in blocks which are never freed before the cache,
+ * because text layers keep pointers to them, and only the pixels are
+ * evicted.
+ *
+ * Pixels are packed into atlas pages. A page is a linear buffer which is
+ * filled from the start, so every bitmap is still contiguous and can be
+ * drawn as before. When the budget is used up, the page used least recently
+ * is emptied and filled again, glyphs larger than a page get a page of
+ * their own.
+ *
+ * Readers do not lock. A reader marks the page as used in the current frame
+ * and then checks that the glyph still points to it, while the evictor
+ * detaches the glyphs and then checks that the page was not used in the
+ * current frame. With a memory barrier between the store and the load on
+ * both sides, at least one of them sees the other, so a page is never
+ * refilled while a reader may read it. Page records are only freed when
+ * a frame ends.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/types.h>
+#include <LCUI/util.h>
+#include <LCUI/thread.h>
+#include <LCUI/font.h>
+#include "../atomic.h"
+#include "glyphcache.h"
+
+#define GLYPH_CACHE_BUCKETS 16384
+#define GLYPH_BLOCK_SIZE 256
+
+typedef struct LCUI_GlyphPageRec_ LCUI_GlyphPageRec, *LCUI_GlyphPage;
+typedef struct LCUI_GlyphRec_ LCUI_GlyphRec, *LCUI_Glyph;
+
+struct LCUI_GlyphRec_ {
+	/* it is returned to callers, so it must be the first member */
+	LCUI_FontBitmap bitmap;
+
+	wchar_t ch;
+	int font_id;
+	int size;
+
+	/* the page which holds the pixels, NULL if they were evicted */
+	LCUI_GlyphPage volatile page;
+
+	/* next glyph in the same hash bucket */
+	LCUI_Glyph volatile next;
+
+	/* next glyph in the same page */
+	LCUI_Glyph page_next;
+};
+
+struct LCUI_GlyphPageRec_ {
+	unsigned char *data;
+	size_t size;
+	size_t used;
+
+	/* the last frame in which the pixels were read */
+	volatile unsigned last_used;
+
+	/*
+	 * It has been emptied while a reader was using it, the pixels are
+	 * kept until the frame ends.
+	 */
+	LCUI_BOOL retired;
+
+	LCUI_Glyph glyphs;
+	LinkedListNode node;
+};
+
+typedef struct LCUI_GlyphBlockRec_ {
+	LCUI_GlyphRec glyphs[GLYPH_BLOCK_SIZE];
+	size_t length;
+	struct LCUI_GlyphBlockRec_ *next;
+} LCUI_GlyphBlockRec, *LCUI_GlyphBlock;
+
+typedef struct LCUI_GlyphCacheRec_ {
+	LCUI_Glyph volatile *buckets;
+	LCUI_GlyphBlock blocks;
+
+	/* pages in order of creation */
+	LinkedList pages;
+
+	/* the page which new pixels are appended to */
+	LCUI_GlyphPage current;
+
+	/*
+	 * For glyphs whose pixels are not owned by the cache, such as glyphs
+	 * without pixels and glyphs in a mapped file, it is never evicted.
+	 */
+	LCUI_GlyphPageRec static_page;
+
+	volatile unsigned frame;
+	size_t max_bytes;
+	size_t memory_usage;
+	size_t count;
+	size_t eviction_count;
+
+	/* updated by readers */
+	volatile long hit_count;
+	volatile long miss_count;
+
+	/* serializes writers */
+	LCUI_Mutex mutex;
+} LCUI_GlyphCacheRec;
+
+/* the buffer of glyphs which have no pixels, but a buffer */
+static unsigned char empty_pixels[1];
+
+static unsigned GlyphCache_Hash(wchar_t ch, int font_id, int size)
+{
+	uint64_t key = (uint32_t)ch;
+
+	key = key * 0x9E3779B97F4A7C15ull ^ (uint32_t)font_id;
+	key = key * 0x9E3779B97F4A7C15ull ^ (uint32_t)size;
+	key *= 0x9E3779B97F4A7C15ull;
+	return (unsigned)(key >> 32) % GLYPH_CACHE_BUCKETS;
+}
+
+LCUI_GlyphCache GlyphCache_New(size_t max_bytes)
+{
+	LCUI_GlyphCache cache;
+
+	cache = NEW(LCUI_GlyphCacheRec, 1);
+	if (!cache) {
+		return NULL;
+	}
+	cache->buckets = NEW(LCUI_Glyph, GLYPH_CACHE_BUCKETS);
+	if (!cache->buckets) {
+		free(cache);
+		return NULL;
+	}
+	cache->max_bytes = max_bytes;
+	LinkedList_Init(&cache->pages);
+	LCUIMutex_Init(&cache->mutex);
+	return cache;
+}
+
+static void GlyphCache_FreePage(LCUI_GlyphCache cache, LCUI_GlyphPage page)
+{
+	LinkedList_Unlink(&cache->pages, &page->node);
+	if (cache->current == page) {
+		cache->current = NULL;
+	}
+	if (page->data) {
+		cache->memory_usage -= page->size;
+		free(page->data);
+	}
+	free(page);
+}
+
+void GlyphCache_Delete(LCUI_GlyphCache cache)
+{
+	LCUI_GlyphBlock block;
+
+	while (cache->pages.head.next) {
+		GlyphCache_FreePage(cache, cache->pages.head.next->data);
+	}
+	while (cache->blocks) {
+		block = cache->blocks;
+		cache->blocks = block->next;
+		free(block);
+	}
+	LCUIMutex_Destroy(&cache->mutex);
+	free((void *)cache->buckets);
+	free(cache);
+}
+
+void GlyphCache_SetMaxBytes(LCUI_GlyphCache cache, size_t max_bytes)
+{
+	LCUIMutex_Lock(&cache->mutex);
+	cache->max_bytes = max_bytes;
+	LCUIMutex_Unlock(&cache->mutex);
+}
+
+static LCUI_Glyph GlyphCache_Find(LCUI_GlyphCache cache, wchar_t ch,
+				  int font_id, int size)
+{
+	LCUI_Glyph glyph;
+
+	glyph = cache->buckets[GlyphCache_Hash(ch, font_id, size)];
+	for (; glyph; glyph = glyph->next) {
+		if (glyph->ch == ch && glyph->font_id == font_id &&
+		    glyph->size == size) {
+			return glyph;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Mark the page of a glyph as used in the current frame
+ * @returns FALSE if the pixels of the glyph were evicted
+ */
+static LCUI_BOOL GlyphCache_Touch(LCUI_GlyphCache cache, LCUI_Glyph glyph)
+{
+	LCUI_GlyphPage page = glyph->page;
+
+	if (!page) {
+		return FALSE;
+	}
+	page->last_used = cache->frame;
+	MemoryFence();
+	return glyph->page == page;
+}
+
+const LCUI_FontBitmap *GlyphCache_Get(LCUI_GlyphCache cache, wchar_t ch,
+				      int font_id, int size)
+{
+	LCUI_Glyph glyph = GlyphCache_Find(cache, ch, font_id, size);
+
+	if (glyph && GlyphCache_Touch(cache, glyph)) {
+		AtomicIncrement(&cache->hit_count);
+		return &glyph->bitmap;
+	}
+	AtomicIncrement(&cache->miss_count);
+	return NULL;
+}
+
+LCUI_BOOL GlyphCache_Load(LCUI_GlyphCache cache, const LCUI_FontBitmap *bmp)
+{
+	if (GlyphCache_Touch(cache, (LCUI_Glyph)bmp)) {
+		AtomicIncrement(&cache->hit_count);
+		return TRUE;
+	}
+	AtomicIncrement(&cache->miss_count);
+	return FALSE;
+}
+
+void GlyphCache_GetKey(const LCUI_FontBitmap *bmp, wchar_t *ch, int *font_id,
+		       int *size)
+{
+	LCUI_Glyph glyph = (LCUI_Glyph)bmp;
+
+	*ch = glyph->ch;
+	*font_id = glyph->font_id;
+	*size = glyph->size;
+}
+
+/**
+ * Detach glyphs from the page
+ * @returns FALSE if a reader used the page in the current frame
+ */
+static LCUI_BOOL GlyphCache_EvictPage(LCUI_GlyphCache cache,
+				      LCUI_GlyphPage page)
+{
+	LCUI_Glyph glyph;
+
+	for (glyph = page->glyphs; glyph; glyph = page->glyphs) {
+		page->glyphs = glyph->page_next;
+		glyph->page_next = NULL;
+		glyph->page = NULL;
+		cache->count--;
+		cache->eviction_count++;
+	}
+	if (cache->current == page) {
+		cache->current = NULL;
+	}
+	MemoryFence();
+	if (page->last_used == cache->frame) {
+		page->retired = TRUE;
+		return FALSE;
+	}
+	page->used = 0;
+	return TRUE;
+}
+
+static LCUI_GlyphPage GlyphCache_FindLeastRecentlyUsedPage(
+    LCUI_GlyphCache cache)
+{
+	unsigned age, max_age = 0;
+	LinkedListNode *node;
+	LCUI_GlyphPage page, lru_page = NULL;
+
+	for (LinkedList_Each(node, &cache->pages)) {
+		page = node->data;
+		if (!page->data || page->retired || page->used == 0) {
+			continue;
+		}
+		age = cache->frame - page->last_used;
+		if (age > max_age) {
+			max_age = age;
+			lru_page = page;
+		}
+	}
+	return lru_page;
+}
+
+static LCUI_GlyphPage GlyphCache_GetFreePage(LCUI_GlyphCache cache, size_t n)
+{
+	LinkedListNode *node;
+	LCUI_GlyphPage page;
+	size_t size = max(n, GLYPH_PAGE_SIZE);
+
+	for (LinkedList_Each(node, &cache->pages)) {
+		page = node->data;
+		if (page->data && page->size == size && page->used == 0 &&
+		    !page->retired) {
+			return page;
+		}
+	}
+	while (cache->memory_usage + size > cache->max_bytes) {
+		page = GlyphCache_FindLeastRecentlyUsedPage(cache);
+		if (!page) {
+			break;
+		}
+		if (!GlyphCache_EvictPage(cache, page)) {
+			continue;
+		}
+		if (page->size == size) {
+			return page;
+		}
+		/* readers can no longer see the pixels, but the record is
+		 * freed at the end of the frame */
+		free(page->data);
+		page->data = NULL;
+		cache->memory_usage -= page->size;
+	}
+	page = NEW(LCUI_GlyphPageRec, 1);
+	if (!page) {
+		return NULL;
+	}
+	page->data = malloc(size);
+	if (!page->data) {
+		free(page);
+		return NULL;
+	}
+	page->size = size;
+	page->node.data = page;
+	cache->memory_usage += size;
+	LinkedList_AppendNode(&cache->pages, &page->node);
+	return page;
+}
+
+static unsigned char *GlyphCache_Alloc(LCUI_GlyphCache cache, size_t n,
+				       LCUI_GlyphPage *out_page)
+{
+	unsigned char *data;
+	LCUI_GlyphPage page = cache->current;
+
+	if (!page || page->size - page->used < n) {
+		page = GlyphCache_GetFreePage(cache, n);
+		if (!page) {
+			return NULL;
+		}
+		if (page->size == GLYPH_PAGE_SIZE) {
+			cache->current = page;
+		}
+	}
+	data = page->data + page->used;
+	page->used += n;
+	/* the glyph is added for drawing, do not evict it in this frame */
+	page->last_used = cache->frame;
+	*out_page = page;
+	return data;
+}
+
+static LCUI_Glyph GlyphCache_NewGlyph(LCUI_GlyphCache cache)
+{
+	LCUI_GlyphBlock block = cache->blocks;
+
+	if (!block || block->length >= GLYPH_BLOCK_SIZE) {
+		block = NEW(LCUI_GlyphBlockRec, 1);
+		if (!block) {
+			return NULL;
+		}
+		block->next = cache->blocks;
+		cache->blocks = block;
+	}
+	return &block->glyphs[block->length++];
+}
+
+/* Add a glyph or attach pixels to it, the mutex must be locked */
+static LCUI_Glyph GlyphCache_Attach(LCUI_GlyphCache cache, LCUI_Glyph glyph,
+				    wchar_t ch, int font_id, int size,
+				    const LCUI_FontBitmap *bmp,
+				    unsigned char *data, LCUI_GlyphPage page)
+{
+	unsigned hash = GLYPH_CACHE_BUCKETS;
+
+	if (!glyph) {
+		glyph = GlyphCache_NewGlyph(cache);
+		if (!glyph) {
+			return NULL;
+		}
+		glyph->bitmap = *bmp;
+		glyph->ch = ch;
+		glyph->font_id = font_id;
+		glyph->size = size;
+		glyph->page = page;
+		hash = GlyphCache_Hash(ch, font_id, size);
+		glyph->next = cache->buckets[hash];
+	}
+	glyph->bitmap.buffer = data;
+	if (page != &cache->static_page) {
+		glyph->page_next = page->glyphs;
+		page->glyphs = glyph;
+		cache->count++;
+	}
+	/* publish the glyph after its fields are written */
+	MemoryFence();
+	if (hash < GLYPH_CACHE_BUCKETS) {
+		cache->buckets[hash] = glyph;
+	} else {
+		glyph->page = page;
+	}
+	return glyph;
+}
+
+const LCUI_FontBitmap *GlyphCache_Put(LCUI_GlyphCache cache, wchar_t ch,
+				      int font_id, int size,
+				      const LCUI_FontBitmap *bmp)
+{
+	int width, rows;
+	LCUI_BOOL has_buffer;
+	size_t n = 0;
+	unsigned char *data = NULL;
+	LCUI_Glyph glyph;
+	LCUI_GlyphPage page = &cache->static_page;
+
+	LCUIMutex_Lock(&cache->mutex);
+	glyph = GlyphCache_Find(cache, ch, font_id, size);
+	if (glyph && glyph->page) {
+		LCUIMutex_Unlock(&cache->mutex);
+		return &glyph->bitmap;
+	}
+	if (glyph) {
+		/* the metrics may be in use, so only the pixels are reloaded */
+		width = glyph->bitmap.width;
+		rows = glyph->bitmap.rows;
+		has_buffer = glyph->bitmap.buffer != NULL;
+	} else {
+		width = bmp->width;
+		rows = bmp->rows;
+		has_buffer = bmp->buffer != NULL;
+	}
+	if (has_buffer) {
+		n = (size_t)width * rows;
+		data = empty_pixels;
+	}
+	if (n > 0) {
+		data = GlyphCache_Alloc(cache, n, &page);
+		if (!data) {
+			LCUIMutex_Unlock(&cache->mutex);
+			return NULL;
+		}
+		if (bmp->buffer && bmp->width == width && bmp->rows == rows) {
+			memcpy(data, bmp->buffer, n);
+		} else {
+			memset(data, 0, n);
+		}
+	}
+	glyph = GlyphCache_Attach(cache, glyph, ch, font_id, size, bmp, data,
+				  page);
+	if (!glyph && page != &cache->static_page) {
+		page->used -= n;
+	}
+	LCUIMutex_Unlock(&cache->mutex);
+	return glyph ? &glyph->bitmap : NULL;
+}
+
+const LCUI_FontBitmap *GlyphCache_PutStatic(LCUI_GlyphCache cache,
+					    wchar_t ch, int font_id, int size,
+					    const LCUI_FontBitmap *bmp)
+{
+	LCUI_Glyph glyph;
+
+	LCUIMutex_Lock(&cache->mutex);
+	glyph = GlyphCache_Find(cache, ch, font_id, size);
+	if (glyph) {
+		/* the metrics are in use, keep them and copy the pixels */
+		LCUIMutex_Unlock(&cache->mutex);
+		return GlyphCache_Put(cache, ch, font_id, size, bmp);
+	}
+	glyph = GlyphCache_Attach(cache, NULL, ch, font_id, size, bmp,
+				  bmp->buffer, &cache->static_page);
+	LCUIMutex_Unlock(&cache->mutex);
+	return glyph ? &glyph->bitmap : NULL;
+}
+
+void GlyphCache_EndFrame(LCUI_GlyphCache cache)
+{
+	LinkedListNode *node, *prev;
+	LCUI_GlyphPage page;
+
+	LCUIMutex_Lock(&cache->mutex);
+	cache->frame++;
+	for (LinkedList_Each(node, &cache->pages)) {
+		page = node->data;
+		if (page->retired) {
+			page->retired = FALSE;
+			page->used = 0;
+		}
+		/* free evicted pages of large glyphs, and empty pages which
+		 * exceed the budget */
+		if (!page->data ||
+		    (page->used == 0 && (page->size != GLYPH_PAGE_SIZE ||
+					 cache->memory_usage >
+					     cache->max_bytes))) {
+			prev = node->prev;
+			GlyphCache_FreePage(cache, page);
+			node = prev;
+		}
+	}
+	/* no reader is running, so pages can be freed now */
+	while (cache->memory_usage > cache->max_bytes) {
+		page = GlyphCache_FindLeastRecentlyUsedPage(cache);
+		if (!page) {
+			break;
+		}
+		GlyphCache_EvictPage(cache, page);
+		GlyphCache_FreePage(cache, page);
+	}
+	LCUIMutex_Unlock(&cache->mutex);
+}
+
+void GlyphCache_GetProfile(LCUI_GlyphCache cache,
+			   LCUI_GlyphCacheProfile profile)
+{
+	LCUIMutex_Lock(&cache->mutex);
+	profile->hit_count = (size_t)AtomicReset(&cache->hit_count);
+	profile->miss_count = (size_t)AtomicReset(&cache->miss_count);
+	profile->eviction_count = cache->eviction_count;
+	profile->count = cache->count;
+	profile->memory_usage = cache->memory_usage;
+	cache->eviction_count = 0;
+	LCUIMutex_Unlock(&cache->mutex);
+}
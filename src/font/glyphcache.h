@@ -0,0 +1,96 @@
+/* glyphcache.h -- bounded glyph bitmap cache
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LCUI_FONT_GLYPH_CACHE_H
+#define LCUI_FONT_GLYPH_CACHE_H
+
+/** Size of the atlas pages which glyph bitmaps are packed into */
+#define GLYPH_PAGE_SIZE 65536
+
+typedef struct LCUI_GlyphCacheRec_ *LCUI_GlyphCache;
+
+LCUI_GlyphCache GlyphCache_New(size_t max_bytes);
+
+void GlyphCache_Delete(LCUI_GlyphCache cache);
+
+/**
+ * Set the memory budget of atlas pages. Pages used least recently are
+ * evicted when a new page would exceed it.
+ */
+void GlyphCache_SetMaxBytes(LCUI_GlyphCache cache, size_t max_bytes);
+
+/**
+ * Find a glyph without locking, it may be called from any thread.
+ * A glyph whose pixels were evicted is a miss, put it again to reload the
+ * pixels into the same bitmap. The returned bitmap stays valid until the
+ * cache is deleted, and its pixels are kept until GlyphCache_EndFrame() is
+ * called, see GlyphCache_Load().
+ */
+const LCUI_FontBitmap *GlyphCache_Get(LCUI_GlyphCache cache, wchar_t ch,
+				      int font_id, int size);
+
+/**
+ * Check whether the pixels of a glyph can be read, it may be called from
+ * any thread without locking. When it returns TRUE, the pixels are kept
+ * until GlyphCache_EndFrame() is called.
+ */
+LCUI_BOOL GlyphCache_Load(LCUI_GlyphCache cache, const LCUI_FontBitmap *glyph);
+
+/**
+ * Copy a bitmap into the cache, the glyph is added or its pixels are
+ * reloaded. The buffer of bmp is not taken.
+ * @returns the cached glyph, or NULL if there is no memory
+ */
+const LCUI_FontBitmap *GlyphCache_Put(LCUI_GlyphCache cache, wchar_t ch,
+				      int font_id, int size,
+				      const LCUI_FontBitmap *bmp);
+
+/**
+ * Add a glyph whose pixels are not copied, they are never evicted and must
+ * stay valid until the cache is deleted.
+ */
+const LCUI_FontBitmap *GlyphCache_PutStatic(LCUI_GlyphCache cache,
+					    wchar_t ch, int font_id, int size,
+					    const LCUI_FontBitmap *bmp);
+
+/** Get the key of a cached glyph */
+void GlyphCache_GetKey(const LCUI_FontBitmap *glyph, wchar_t *ch,
+		       int *font_id, int *size);
+
+/**
+ * Start a new frame. All readers of the previous frame must have finished,
+ * pages read by them can be evicted from now on.
+ */
+void GlyphCache_EndFrame(LCUI_GlyphCache cache);
+
+/** Get the profile, hit, miss and eviction counts are reset */
+void GlyphCache_GetProfile(LCUI_GlyphCache cache,
+			   LCUI_GlyphCacheProfile profile);
+
+#endif
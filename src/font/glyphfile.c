@@ -0,0 +1,576 @@
+/* glyphfile.c -- persistent glyph bitmap cache file
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The file starts with a header, and glyph records are only ever appended
+ * after it, each record is followed by its pixels and padded to 8 bytes.
+ *
+ * When the file is opened, the valid part of it is mapped read-only and
+ * the records are indexed in a hash table, so glyphs are used in place
+ * without being copied or decoded. Records are written by a single write()
+ * in append mode under an exclusive advisory lock, and the file is checked
+ * under a shared lock, so processes sharing the file neither interleave
+ * records nor see a record being written.
+ *
+ * The file is never truncated, because other processes may have mapped
+ * it. A file with an invalid header, or a record torn by a crash which
+ * would hide the records appended after it, is replaced by writing its
+ * valid part to a temporary file and renaming it over the old one.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <LCUI_Build.h>
+#include <LCUI/types.h>
+#include <LCUI/util.h>
+#include <LCUI/font.h>
+#include "glyphfile.h"
+
+#ifdef LCUI_BUILD_IN_WIN32
+#include <Windows.h>
+#include <io.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define GLYPH_FILE_MAGIC "LCUIGLYF"
+
+/* increase it when glyphs are rendered differently */
+#define GLYPH_FILE_VERSION 1
+
+#define GLYPH_FILE_BYTE_ORDER 0x01020304
+#define GLYPH_RECORD_MAGIC 0x594C474C
+
+#define GlyphRecord_GetSize(REC) \
+	(sizeof(GlyphRecordRec) + (((size_t)(REC)->width * (REC)->rows + 7) & ~7))
+
+typedef struct GlyphFileHeaderRec_ {
+	char magic[8];
+	uint32_t version;
+
+	/* files written on a machine of another byte order are discarded */
+	uint32_t byte_order;
+} GlyphFileHeaderRec;
+
+typedef struct GlyphRecordRec_ {
+	uint32_t magic;
+	uint32_t ch;
+	uint64_t font_key;
+	int32_t size;
+	int16_t top;
+	int16_t left;
+	uint16_t width;
+	uint16_t rows;
+	int16_t advance_x;
+	int16_t advance_y;
+} GlyphRecordRec, *GlyphRecord;
+
+typedef struct LCUI_GlyphFileRec_ {
+	int fd;
+	char *path;
+
+	/* the mapped part of the file */
+	const unsigned char *data;
+	size_t data_size;
+#ifdef LCUI_BUILD_IN_WIN32
+	HANDLE mapping;
+#endif
+
+	/* hash table of mapped records, its size is a power of two */
+	const GlyphRecordRec **index;
+	size_t index_size;
+	size_t count;
+} LCUI_GlyphFileRec;
+
+static uint64_t HashString(uint64_t hash, const char *str, size_t len)
+{
+	size_t i;
+
+	/* FNV-1a */
+	for (i = 0; i < len; ++i) {
+		hash ^= (unsigned char)str[i];
+		hash *= 0x100000001B3ull;
+	}
+	return hash;
+}
+
+uint64_t GlyphFile_GetFontKey(const char *path, int face_index)
+{
+	struct stat buf;
+	uint64_t key = 0xCBF29CE484222325ull;
+
+	if (stat(path, &buf) != 0) {
+		return 0;
+	}
+	key = HashString(key, path, strlen(path) + 1);
+	key = HashString(key, (const char *)&face_index, sizeof(face_index));
+	key = HashString(key, (const char *)&buf.st_size, sizeof(buf.st_size));
+	key = HashString(key, (const char *)&buf.st_mtime,
+			 sizeof(buf.st_mtime));
+	return key ? key : 1;
+}
+
+static size_t GlyphFile_Hash(uint64_t font_key, wchar_t ch, int size)
+{
+	uint64_t key = font_key;
+
+	key = key * 0x9E3779B97F4A7C15ull ^ (uint32_t)ch;
+	key = key * 0x9E3779B97F4A7C15ull ^ (uint32_t)size;
+	key *= 0x9E3779B97F4A7C15ull;
+	return (size_t)(key >> 32);
+}
+
+static LCUI_BOOL GlyphFile_Map(LCUI_GlyphFile file, size_t size)
+{
+#ifdef LCUI_BUILD_IN_WIN32
+	HANDLE handle = (HANDLE)_get_osfhandle(file->fd);
+
+	file->mapping =
+	    CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!file->mapping) {
+		return FALSE;
+	}
+	file->data = MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, size);
+	if (!file->data) {
+		CloseHandle(file->mapping);
+		file->mapping = NULL;
+		return FALSE;
+	}
+#else
+	void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, file->fd, 0);
+
+	if (data == MAP_FAILED) {
+		return FALSE;
+	}
+	file->data = data;
+#endif
+	file->data_size = size;
+	return TRUE;
+}
+
+static void GlyphFile_Unmap(LCUI_GlyphFile file)
+{
+	if (!file->data) {
+		return;
+	}
+#ifdef LCUI_BUILD_IN_WIN32
+	UnmapViewOfFile(file->data);
+	CloseHandle(file->mapping);
+	file->mapping = NULL;
+#else
+	munmap((void *)file->data, file->data_size);
+#endif
+	file->data = NULL;
+	file->data_size = 0;
+}
+
+static LCUI_BOOL GlyphFile_CheckHeader(LCUI_GlyphFile file)
+{
+	const GlyphFileHeaderRec *header = (const void *)file->data;
+
+	return file->data_size >= sizeof(GlyphFileHeaderRec) &&
+	       memcmp(header->magic, GLYPH_FILE_MAGIC, 8) == 0 &&
+	       header->version == GLYPH_FILE_VERSION &&
+	       header->byte_order == GLYPH_FILE_BYTE_ORDER;
+}
+
+/**
+ * Check records of the mapped file
+ * @returns the size of the valid part of the file
+ */
+static size_t GlyphFile_CheckRecords(LCUI_GlyphFile file, size_t *count)
+{
+	size_t pos = sizeof(GlyphFileHeaderRec);
+	const GlyphRecordRec *rec;
+
+	*count = 0;
+	while (pos + sizeof(GlyphRecordRec) <= file->data_size) {
+		rec = (const void *)(file->data + pos);
+		if (rec->magic != GLYPH_RECORD_MAGIC ||
+		    pos + GlyphRecord_GetSize(rec) > file->data_size) {
+			break;
+		}
+		pos += GlyphRecord_GetSize(rec);
+		*count += 1;
+	}
+	return pos;
+}
+
+static const GlyphRecordRec **GlyphFile_Find(LCUI_GlyphFile file,
+					     uint64_t font_key, wchar_t ch,
+					     int size)
+{
+	size_t mask = file->index_size - 1;
+	size_t i = GlyphFile_Hash(font_key, ch, size) & mask;
+	const GlyphRecordRec *rec;
+
+	for (; (rec = file->index[i]); i = (i + 1) & mask) {
+		if (rec->font_key == font_key && rec->ch == (uint32_t)ch &&
+		    rec->size == size) {
+			break;
+		}
+	}
+	return &file->index[i];
+}
+
+static int GlyphFile_BuildIndex(LCUI_GlyphFile file, size_t count)
+{
+	size_t pos = sizeof(GlyphFileHeaderRec);
+	const GlyphRecordRec *rec;
+	const GlyphRecordRec **slot;
+
+	file->index_size = 64;
+	while (file->index_size < count * 2) {
+		file->index_size *= 2;
+	}
+	file->index = NEW(const GlyphRecordRec *, file->index_size);
+	if (!file->index) {
+		return -ENOMEM;
+	}
+	file->count = 0;
+	while (count-- > 0) {
+		rec = (const void *)(file->data + pos);
+		pos += GlyphRecord_GetSize(rec);
+		slot = GlyphFile_Find(file, rec->font_key, rec->ch, rec->size);
+		/* duplicates are written by processes sharing the file */
+		if (!*slot) {
+			*slot = rec;
+			file->count++;
+		}
+	}
+	return 0;
+}
+
+static void GlyphFile_Lock(LCUI_GlyphFile file, LCUI_BOOL exclusive)
+{
+#ifdef LCUI_BUILD_IN_WIN32
+	OVERLAPPED overlapped = { 0 };
+	HANDLE handle = (HANDLE)_get_osfhandle(file->fd);
+
+	/* Windows locks are mandatory, so a byte far beyond the end of the
+	 * file is locked to keep reads and writes of the records unblocked */
+	overlapped.OffsetHigh = 0x7FFFFFFF;
+	LockFileEx(handle, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, 1, 0,
+		   &overlapped);
+#else
+	while (flock(file->fd, exclusive ? LOCK_EX : LOCK_SH) != 0 &&
+	       errno == EINTR)
+		;
+#endif
+}
+
+static void GlyphFile_Unlock(LCUI_GlyphFile file)
+{
+#ifdef LCUI_BUILD_IN_WIN32
+	OVERLAPPED overlapped = { 0 };
+	HANDLE handle = (HANDLE)_get_osfhandle(file->fd);
+
+	overlapped.OffsetHigh = 0x7FFFFFFF;
+	UnlockFileEx(handle, 0, 1, 0, &overlapped);
+#else
+	flock(file->fd, LOCK_UN);
+#endif
+}
+
+/**
+ * Map the file and check it
+ * @param[out] size the size of the file
+ * @param[out] valid_size the size of the valid part, 0 if the header is
+ *  invalid
+ * @param[out] count the number of valid records
+ */
+static int GlyphFile_Check(LCUI_GlyphFile file, size_t *size,
+			   size_t *valid_size, size_t *count)
+{
+	long len;
+
+	GlyphFile_Unmap(file);
+	*count = 0;
+	*valid_size = 0;
+	len = (long)lseek(file->fd, 0, SEEK_END);
+	if (len < 0) {
+		return -1;
+	}
+	*size = (size_t)len;
+	if (len == 0) {
+		return 0;
+	}
+	if (!GlyphFile_Map(file, *size)) {
+		return -1;
+	}
+	if (GlyphFile_CheckHeader(file)) {
+		*valid_size = GlyphFile_CheckRecords(file, count);
+	}
+	return 0;
+}
+
+/** Check if the file has been replaced by another process */
+static LCUI_BOOL GlyphFile_IsReplaced(LCUI_GlyphFile file)
+{
+#ifdef LCUI_BUILD_IN_WIN32
+	return FALSE;
+#else
+	struct stat opened, current;
+
+	if (fstat(file->fd, &opened) != 0 ||
+	    stat(file->path, &current) != 0) {
+		return TRUE;
+	}
+	return opened.st_dev != current.st_dev ||
+	       opened.st_ino != current.st_ino;
+#endif
+}
+
+/**
+ * Write the header and the valid records of the mapped file to a temporary
+ * file, which will be renamed to replace the file
+ */
+static int GlyphFile_WriteTemp(LCUI_GlyphFile file, const char *temp_path,
+			       size_t valid_size)
+{
+	int fd;
+	int ret = 0;
+	size_t len;
+	GlyphFileHeaderRec header = { GLYPH_FILE_MAGIC, GLYPH_FILE_VERSION,
+				      GLYPH_FILE_BYTE_ORDER };
+
+	fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+	if (fd == -1) {
+		return -1;
+	}
+	if (write(fd, &header, sizeof(header)) != sizeof(header)) {
+		ret = -1;
+	} else if (valid_size > sizeof(header)) {
+		len = valid_size - sizeof(header);
+		if (write(fd, file->data + sizeof(header), len) != (long)len) {
+			ret = -1;
+		}
+	}
+	if (close(fd) != 0) {
+		ret = -1;
+	}
+	if (ret != 0) {
+		remove(temp_path);
+	}
+	return ret;
+}
+
+static int GlyphFile_Replace(LCUI_GlyphFile file)
+{
+	int ret = 0;
+	size_t size, valid_size, count;
+	char *temp_path;
+
+	temp_path = malloc(strlen(file->path) + 32);
+	if (!temp_path) {
+		return -ENOMEM;
+	}
+	sprintf(temp_path, "%s.%d.tmp", file->path, (int)getpid());
+	GlyphFile_Lock(file, TRUE);
+	ret = GlyphFile_Check(file, &size, &valid_size, &count);
+	/* skip it if another process has replaced the file */
+	if (ret == 0 && (valid_size == 0 || valid_size < size) &&
+	    !GlyphFile_IsReplaced(file)) {
+		Logger_Warning("[font] replace the glyph cache file, %zu of "
+			       "%zu bytes are valid\n",
+			       valid_size, size);
+		ret = GlyphFile_WriteTemp(file, temp_path, valid_size);
+	} else {
+		temp_path[0] = 0;
+	}
+	GlyphFile_Unmap(file);
+	GlyphFile_Unlock(file);
+	/* Windows can not rename a file over an open one */
+	close(file->fd);
+	file->fd = -1;
+	if (ret == 0 && temp_path[0]) {
+#ifdef LCUI_BUILD_IN_WIN32
+		if (!MoveFileExA(temp_path, file->path,
+				 MOVEFILE_REPLACE_EXISTING)) {
+#else
+		if (rename(temp_path, file->path) != 0) {
+#endif
+			remove(temp_path);
+			ret = -1;
+		}
+	}
+	free(temp_path);
+	if (ret != 0) {
+		return ret;
+	}
+	file->fd =
+	    open(file->path, O_RDWR | O_CREAT | O_APPEND | O_BINARY, 0644);
+	return file->fd == -1 ? -1 : 0;
+}
+
+static int GlyphFile_Load(LCUI_GlyphFile file)
+{
+	int ret, retry;
+	size_t size, valid_size, count;
+
+	for (retry = 0; retry < 3; ++retry) {
+		GlyphFile_Lock(file, FALSE);
+		ret = GlyphFile_Check(file, &size, &valid_size, &count);
+		GlyphFile_Unlock(file);
+		if (ret != 0) {
+			return ret;
+		}
+		/* the torn tail is ignored, the records in front of it are
+		 * still valid while the file is being replaced */
+		if (valid_size > 0 && valid_size == size) {
+			return GlyphFile_BuildIndex(file, count);
+		}
+		ret = GlyphFile_Replace(file);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+	return -1;
+}
+
+LCUI_GlyphFile GlyphFile_Open(const char *path)
+{
+	LCUI_GlyphFile file;
+
+	file = NEW(LCUI_GlyphFileRec, 1);
+	if (!file) {
+		return NULL;
+	}
+	file->path = strdup2(path);
+	file->fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_BINARY, 0644);
+	if (!file->path || file->fd == -1) {
+		if (file->fd != -1) {
+			close(file->fd);
+		}
+		free(file->path);
+		free(file);
+		return NULL;
+	}
+	if (GlyphFile_Load(file) != 0) {
+		GlyphFile_Close(file);
+		return NULL;
+	}
+	return file;
+}
+
+void GlyphFile_Close(LCUI_GlyphFile file)
+{
+	GlyphFile_Unmap(file);
+	if (file->fd != -1) {
+		close(file->fd);
+	}
+	free(file->index);
+	free(file->path);
+	free(file);
+}
+
+LCUI_BOOL GlyphFile_Get(LCUI_GlyphFile file, uint64_t font_key, wchar_t ch,
+			int size, LCUI_FontBitmap *bmp)
+{
+	const GlyphRecordRec *rec;
+
+	if (!file->index) {
+		return FALSE;
+	}
+	rec = *GlyphFile_Find(file, font_key, ch, size);
+	if (!rec) {
+		return FALSE;
+	}
+	FontBitmap_Init(bmp);
+	bmp->top = rec->top;
+	bmp->left = rec->left;
+	bmp->width = rec->width;
+	bmp->rows = rec->rows;
+	bmp->pitch = rec->width;
+	bmp->advance.x = rec->advance_x;
+	bmp->advance.y = rec->advance_y;
+	bmp->buffer = (uchar_t *)(rec + 1);
+	return TRUE;
+}
+
+#define IsInt16(N) ((N) >= -32768 && (N) <= 32767)
+
+int GlyphFile_Add(LCUI_GlyphFile file, uint64_t font_key, wchar_t ch,
+		  int size, const LCUI_FontBitmap *bmp)
+{
+	int ret = 0;
+	size_t len;
+	GlyphRecordRec rec;
+	unsigned char *buf;
+
+	if (!bmp->buffer || bmp->width < 0 || bmp->width > 65535 ||
+	    bmp->rows < 0 || bmp->rows > 65535 || !IsInt16(bmp->top) ||
+	    !IsInt16(bmp->left) || !IsInt16(bmp->advance.x) ||
+	    !IsInt16(bmp->advance.y)) {
+		return -1;
+	}
+	rec.magic = GLYPH_RECORD_MAGIC;
+	rec.ch = (uint32_t)ch;
+	rec.font_key = font_key;
+	rec.size = size;
+	rec.top = (int16_t)bmp->top;
+	rec.left = (int16_t)bmp->left;
+	rec.width = (uint16_t)bmp->width;
+	rec.rows = (uint16_t)bmp->rows;
+	rec.advance_x = (int16_t)bmp->advance.x;
+	rec.advance_y = (int16_t)bmp->advance.y;
+	len = GlyphRecord_GetSize(&rec);
+	buf = calloc(len, 1);
+	if (!buf) {
+		return -ENOMEM;
+	}
+	memcpy(buf, &rec, sizeof(rec));
+	memcpy(buf + sizeof(rec), bmp->buffer, (size_t)bmp->width * bmp->rows);
+	GlyphFile_Lock(file, TRUE);
+	if (write(file->fd, buf, len) != (long)len) {
+		ret = -1;
+	}
+	GlyphFile_Unlock(file);
+	free(buf);
+	return ret;
+}
+
+size_t GlyphFile_GetCount(LCUI_GlyphFile file)
+{
+	return file->count;
+}
@@ -0,0 +1,66 @@
+/* glyphfile.h -- persistent glyph bitmap cache file
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LCUI_FONT_GLYPH_FILE_H
+#define LCUI_FONT_GLYPH_FILE_H
+
+typedef struct LCUI_GlyphFileRec_ *LCUI_GlyphFile;
+
+/**
+ * Get the identity of a font face from the path, size and modification time
+ * of its file, glyphs rendered from a modified file are not reused.
+ * @returns the key, or 0 if the file cannot be found
+ */
+uint64_t GlyphFile_GetFontKey(const char *path, int face_index);
+
+/**
+ * Open a glyph cache file, it is created if it does not exist. Records in
+ * the file are mapped into memory and new glyphs are appended to it.
+ * @returns NULL if the file cannot be opened
+ */
+LCUI_GlyphFile GlyphFile_Open(const char *path);
+
+void GlyphFile_Close(LCUI_GlyphFile file);
+
+/**
+ * Find a glyph which was saved before the file was opened, it may be called
+ * from any thread. The buffer of bmp points to the mapped file, it is valid
+ * until the file is closed.
+ */
+LCUI_BOOL GlyphFile_Get(LCUI_GlyphFile file, uint64_t font_key, wchar_t ch,
+			int size, LCUI_FontBitmap *bmp);
+
+/** Append a glyph to the file, it can be found after the file is reopened */
+int GlyphFile_Add(LCUI_GlyphFile file, uint64_t font_key, wchar_t ch,
+		  int size, const LCUI_FontBitmap *bmp);
+
+/** Get the number of glyphs which can be found in the file */
+size_t GlyphFile_GetCount(LCUI_GlyphFile file);
+
+#endif
@@ -28,7 +28,9 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wctype.h>
 #include <LCUI_Build.h>
 #include <LCUI/types.h>
@@ -46,6 +48,27 @@ typedef enum { TEXT_ACTION_INSERT, TEXT_ACTION_APPEND } TextAction;
 	(n >= layer->text_rows.length) ? NULL : layer->text_rows.rows[n]
 #define GetDefaultLineHeight(H) iround(H * 1.42857143)
 #define ISALPHA(CH) (CH >= 'a' && CH <= 'z') || (CH >= 'A' && CH <= 'Z')
+#define GLYPH_BATCH_SIZE 64
+#define LOWBIT(X) ((X) & -(X))
+#define TEXT_ROW_MIN_CAPACITY 8
+
+/** 排版前的文本行记录，用于找出排版后有变化的文本行 */
+typedef struct TextRowSnapshotRec_ {
+	int offset;		/**< 行首文字在段落中的位置 */
+	int length;
+	int y;
+	LCUI_Rect rect;
+	LCUI_BOOL has_rect;
+	LCUI_BOOL unchanged;	/**< 排版后是否有位置和内容都相同的文本行 */
+} TextRowSnapshotRec, *TextRowSnapshot;
+
+/** 待绘制的一组相同颜色的文字 */
+typedef struct GlyphBatchRec_ {
+	size_t length;
+	LCUI_Color color;
+	LCUI_Pos pos[GLYPH_BATCH_SIZE];
+	const LCUI_FontBitmap *bitmaps[GLYPH_BATCH_SIZE];
+} GlyphBatchRec, *GlyphBatch;
 
 /* 根据对齐方式，计算文本行的起始X轴位置 */
 static int TextLayer_GetRowStartX(LCUI_TextLayer layer, LCUI_TextRow txtrow)
@@ -92,13 +115,33 @@ int TextLayer_GetRowTextLength(LCUI_TextLayer layer, int row)
 	return layer->text_rows.rows[row]->length;
 }
 
-/** 添加 更新文本排版 的任务 */
-void TextLayer_AddUpdateTypeset(LCUI_TextLayer layer, int start_row)
+/**
+ * 添加 更新文本排版 的任务
+ * 排版会处理到 end_row 所在段落的最后一行，end_row 为 -1 时处理到最后一行
+ */
+static void TextLayer_AddUpdateTypesetRange(LCUI_TextLayer layer,
+					    int start_row, int end_row)
 {
+	if (!layer->task.update_typeset) {
+		layer->task.typeset_start_row = start_row;
+		layer->task.typeset_end_row = end_row;
+		layer->task.update_typeset = TRUE;
+		return;
+	}
 	if (start_row < layer->task.typeset_start_row) {
 		layer->task.typeset_start_row = start_row;
 	}
-	layer->task.update_typeset = TRUE;
+	if (end_row < 0 || layer->task.typeset_end_row < 0) {
+		layer->task.typeset_end_row = -1;
+	} else if (end_row > layer->task.typeset_end_row) {
+		layer->task.typeset_end_row = end_row;
+	}
+}
+
+/** 添加 更新文本排版 的任务 */
+void TextLayer_AddUpdateTypeset(LCUI_TextLayer layer, int start_row)
+{
+	TextLayer_AddUpdateTypesetRange(layer, start_row, -1);
 }
 
 static void TextRow_Init(LCUI_TextRow txtrow)
@@ -106,27 +149,416 @@ static void TextRow_Init(LCUI_TextRow txtrow)
 	txtrow->width = 0;
 	txtrow->height = 0;
 	txtrow->length = 0;
-	txtrow->string = NULL;
+	txtrow->capacity = 0;
+	txtrow->codes = NULL;
+	txtrow->bitmaps = NULL;
+	txtrow->styles = NULL;
+	txtrow->styles_length = 0;
 	txtrow->eol = LCUI_EOL_NONE;
 	txtrow->text_height = 0;
 }
 
 static void TextRow_Destroy(LCUI_TextRow txtrow)
 {
-	int i;
-	for (i = 0; i < txtrow->length; ++i) {
-		if (txtrow->string[i]) {
-			free(txtrow->string[i]);
-		}
+	if (txtrow->codes) {
+		free(txtrow->codes);
+	}
+	if (txtrow->bitmaps) {
+		free(txtrow->bitmaps);
+	}
+	if (txtrow->styles) {
+		free(txtrow->styles);
 	}
 	txtrow->width = 0;
 	txtrow->height = 0;
 	txtrow->length = 0;
+	txtrow->capacity = 0;
 	txtrow->text_height = 0;
-	if (txtrow->string) {
-		free(txtrow->string);
+	txtrow->codes = NULL;
+	txtrow->bitmaps = NULL;
+	txtrow->styles = NULL;
+	txtrow->styles_length = 0;
+}
+
+/** 设置文本行的字符数组的容量 */
+static int TextRow_SetCapacity(LCUI_TextRow txtrow, int capacity)
+{
+	wchar_t *codes;
+	const LCUI_FontBitmap **bitmaps;
+
+	codes = realloc(txtrow->codes, sizeof(wchar_t) * capacity);
+	if (!codes) {
+		return -ENOMEM;
+	}
+	txtrow->codes = codes;
+	bitmaps = realloc(txtrow->bitmaps, sizeof(*bitmaps) * capacity);
+	if (!bitmaps) {
+		return -ENOMEM;
+	}
+	txtrow->bitmaps = bitmaps;
+	txtrow->capacity = capacity;
+	return 0;
+}
+
+/** 确保文本行能够容纳 len 个文字，容量成倍增长以均摊追加文字的开销 */
+static int TextRow_Reserve(LCUI_TextRow txtrow, int len)
+{
+	if (len <= txtrow->capacity) {
+		return 0;
+	}
+	len = max(len, max(txtrow->capacity * 2, TEXT_ROW_MIN_CAPACITY));
+	return TextRow_SetCapacity(txtrow, len);
+}
+
+/** 释放字符数组中未使用的空间 */
+static void TextRow_Shrink(LCUI_TextRow txtrow)
+{
+	if (txtrow->length > 0 && txtrow->length < txtrow->capacity) {
+		TextRow_SetCapacity(txtrow, txtrow->length);
+	}
+}
+
+/** 获取第 col 列的文字所在的样式段，如果没有样式段则返回 -1 */
+static int TextRow_FindStyleRun(LCUI_TextRow txtrow, int col)
+{
+	int mid, low = 0, high = txtrow->styles_length - 1;
+
+	if (high < 0) {
+		return -1;
+	}
+	/* 查找起始列不大于 col 的最后一个样式段 */
+	while (low < high) {
+		mid = (low + high + 1) / 2;
+		if (txtrow->styles[mid].start <= col) {
+			low = mid;
+		} else {
+			high = mid - 1;
+		}
+	}
+	return low;
+}
+
+/** 获取样式段的结束列，即下一个样式段的起始列 */
+static int TextRow_GetStyleRunEnd(LCUI_TextRow txtrow, int i)
+{
+	if (i + 1 < txtrow->styles_length) {
+		return txtrow->styles[i + 1].start;
 	}
-	txtrow->string = NULL;
+	return txtrow->length;
+}
+
+static LCUI_TextStyle TextRow_GetStyle(LCUI_TextRow txtrow, int col)
+{
+	int i = TextRow_FindStyleRun(txtrow, col);
+	return i < 0 ? NULL : txtrow->styles[i].style;
+}
+
+/**
+ * 在样式段列表的末尾添加样式段
+ * 起始列不能小于最后一个样式段的起始列，相邻的相同样式的段会被合并
+ */
+static int TextRow_AddStyleRun(LCUI_TextRow txtrow, int start,
+			       LCUI_TextStyle style)
+{
+	int n = txtrow->styles_length;
+	LCUI_TextStyleRun runs;
+
+	if (n > 0) {
+		if (txtrow->styles[n - 1].style == style) {
+			return 0;
+		}
+		/* 最后一个样式段是空的，直接替换它的样式 */
+		if (txtrow->styles[n - 1].start == start) {
+			if (n > 1 && txtrow->styles[n - 2].style == style) {
+				--txtrow->styles_length;
+			} else if (n == 1 && !style) {
+				txtrow->styles_length = 0;
+			} else {
+				txtrow->styles[n - 1].style = style;
+			}
+			return 0;
+		}
+	} else if (!style) {
+		return 0;
+	}
+	runs = realloc(txtrow->styles, sizeof(LCUI_TextStyleRunRec) * (n + 2));
+	if (!runs) {
+		return -ENOMEM;
+	}
+	/* 样式段需要从第 0 列开始 */
+	if (n == 0 && start > 0) {
+		runs[n].start = 0;
+		runs[n].style = NULL;
+		++n;
+	}
+	runs[n].start = start;
+	runs[n].style = style;
+	txtrow->styles = runs;
+	txtrow->styles_length = n + 1;
+	return 0;
+}
+
+/** 在文本行的末尾追加文字 */
+static int TextRow_Append(LCUI_TextRow txtrow, wchar_t code,
+			  const LCUI_FontBitmap *bitmap, LCUI_TextStyle style)
+{
+	if (TextRow_Reserve(txtrow, txtrow->length + 1) != 0 ||
+	    TextRow_AddStyleRun(txtrow, txtrow->length, style) != 0) {
+		return -ENOMEM;
+	}
+	txtrow->codes[txtrow->length] = code;
+	txtrow->bitmaps[txtrow->length] = bitmap;
+	++txtrow->length;
+	return 0;
+}
+
+/** 截断文本行，只保留前 len 个文字 */
+static void TextRow_Truncate(LCUI_TextRow txtrow, int len)
+{
+	if (len >= txtrow->length) {
+		return;
+	}
+	txtrow->length = max(len, 0);
+	while (txtrow->styles_length > 0 &&
+	       txtrow->styles[txtrow->styles_length - 1].start >=
+		   txtrow->length) {
+		--txtrow->styles_length;
+	}
+	if (txtrow->styles_length == 1 && !txtrow->styles[0].style) {
+		txtrow->styles_length = 0;
+	}
+}
+
+/** 将 src 中从 start 列开始的文字移动至 dst 的末尾 */
+static int TextRow_MoveTail(LCUI_TextRow dst, LCUI_TextRow src, int start)
+{
+	int i, n = src->length - start;
+
+	if (n <= 0) {
+		return 0;
+	}
+	if (TextRow_Reserve(dst, dst->length + n) != 0) {
+		return -ENOMEM;
+	}
+	memcpy(dst->codes + dst->length, src->codes + start,
+	       sizeof(wchar_t) * n);
+	memcpy(dst->bitmaps + dst->length, src->bitmaps + start,
+	       sizeof(*dst->bitmaps) * n);
+	i = TextRow_FindStyleRun(src, start);
+	if (i < 0) {
+		TextRow_AddStyleRun(dst, dst->length, NULL);
+	} else {
+		TextRow_AddStyleRun(dst, dst->length, src->styles[i].style);
+		for (++i; i < src->styles_length; ++i) {
+			TextRow_AddStyleRun(
+			    dst, dst->length + src->styles[i].start - start,
+			    src->styles[i].style);
+		}
+	}
+	dst->length += n;
+	TextRow_Truncate(src, start);
+	return 0;
+}
+
+/** 删除文本行中第 start 至 end - 1 列的文字 */
+static void TextRow_Delete(LCUI_TextRow txtrow, int start, int end)
+{
+	int i, j, n, count;
+	LCUI_TextStyle style;
+
+	n = end - start;
+	if (start < 0 || n <= 0) {
+		return;
+	}
+	if (end >= txtrow->length) {
+		TextRow_Truncate(txtrow, start);
+		return;
+	}
+	memmove(txtrow->codes + start, txtrow->codes + end,
+		sizeof(wchar_t) * (txtrow->length - end));
+	memmove(txtrow->bitmaps + start, txtrow->bitmaps + end,
+		sizeof(*txtrow->bitmaps) * (txtrow->length - end));
+	txtrow->length -= n;
+	if (txtrow->styles_length < 1) {
+		return;
+	}
+	/* 删除后，第 end 列的文字所在的样式段从 start 列开始 */
+	i = TextRow_FindStyleRun(txtrow, start);
+	j = TextRow_FindStyleRun(txtrow, end);
+	count = txtrow->styles_length;
+	style = txtrow->styles[j].style;
+	txtrow->styles_length = i + 1;
+	if (txtrow->styles[i].start == start) {
+		if (i > 0 && txtrow->styles[i - 1].style == style) {
+			txtrow->styles_length = i;
+		} else {
+			txtrow->styles[i].style = style;
+		}
+	} else if (txtrow->styles[i].style != style) {
+		txtrow->styles[i + 1].start = start;
+		txtrow->styles[i + 1].style = style;
+		txtrow->styles_length = i + 2;
+	}
+	/* 后面的样式段与 j 段的样式不同，只需前移 */
+	for (++j; j < count; ++j) {
+		txtrow->styles[txtrow->styles_length] = txtrow->styles[j];
+		txtrow->styles[txtrow->styles_length].start -= n;
+		++txtrow->styles_length;
+	}
+	if (txtrow->styles_length == 1 && !txtrow->styles[0].style) {
+		txtrow->styles_length = 0;
+	}
+}
+
+static void TextRowList_Init(LCUI_TextRowList list)
+{
+	list->length = 0;
+	list->rows = NULL;
+	list->height_tree = NULL;
+	list->height_tree_size = 0;
+	list->height_tree_length = 0;
+	list->max_width = 0;
+	list->max_width_count = 0;
+}
+
+/**
+ * 重建失效的行高树节点
+ * 节点 j 记录了第 j - lowbit(j) 至 j - 1 行的高度之和，它等于第 j - 1 行的
+ * 高度加上节点 j - 1, j - 2, j - 4 ... j - lowbit(j) / 2 的值
+ */
+static int TextRowList_BuildHeightTree(LCUI_TextRowList list)
+{
+	int i, j, size;
+	int *tree;
+
+	if (list->height_tree_length >= list->length) {
+		return 0;
+	}
+	if (list->height_tree_size < list->length + 1) {
+		size = max(list->length + 1, list->height_tree_size * 2);
+		tree = realloc(list->height_tree, sizeof(int) * size);
+		if (!tree) {
+			return -ENOMEM;
+		}
+		list->height_tree = tree;
+		list->height_tree_size = size;
+	}
+	tree = list->height_tree;
+	for (j = list->height_tree_length + 1; j <= list->length; ++j) {
+		tree[j] = list->rows[j - 1]->height;
+		for (i = 1; i < LOWBIT(j); i <<= 1) {
+			tree[j] += tree[j - i];
+		}
+	}
+	list->height_tree_length = list->length;
+	return 0;
+}
+
+/** 获取前 n 行的高度之和，即第 n 行的 Y 轴坐标 */
+static int TextRowList_GetRowY(LCUI_TextRowList list, int n)
+{
+	int y = 0;
+
+	if (n > list->length) {
+		n = list->length;
+	}
+	if (TextRowList_BuildHeightTree(list) != 0) {
+		while (n > 0) {
+			y += list->rows[--n]->height;
+		}
+		return y;
+	}
+	for (; n > 0; n -= LOWBIT(n)) {
+		y += list->height_tree[n];
+	}
+	return y;
+}
+
+/**
+ * 查找底边的 Y 轴坐标不小于 y 的第一个文本行
+ * @returns 文本行的序号，如果没有则返回总行数
+ */
+static int TextRowList_FindRow(LCUI_TextRowList list, int y)
+{
+	int i = 0, step = 1;
+
+	if (y <= 0) {
+		return 0;
+	}
+	if (TextRowList_BuildHeightTree(list) != 0) {
+		for (; i < list->length; ++i) {
+			y -= list->rows[i]->height;
+			if (y <= 0) {
+				break;
+			}
+		}
+		return i;
+	}
+	while (step * 2 <= list->length) {
+		step *= 2;
+	}
+	/* 从高位到低位确定前 i 行的高度之和小于 y 的最大的 i */
+	for (; step > 0; step /= 2) {
+		if (i + step <= list->length &&
+		    list->height_tree[i + step] < y) {
+			i += step;
+			y -= list->height_tree[i];
+		}
+	}
+	return i;
+}
+
+/** 获取最大行宽，如果宽度最大的行都已变窄，则重新统计 */
+static int TextRowList_GetMaxWidth(LCUI_TextRowList list)
+{
+	int i;
+
+	if (list->max_width_count > 0) {
+		return list->max_width;
+	}
+	list->max_width = 0;
+	for (i = 0; i < list->length; ++i) {
+		if (list->rows[i]->width > list->max_width) {
+			list->max_width = list->rows[i]->width;
+			list->max_width_count = 1;
+		} else if (list->rows[i]->width == list->max_width) {
+			++list->max_width_count;
+		}
+	}
+	return list->max_width;
+}
+
+static void TextRowList_UpdateMaxWidth(LCUI_TextRowList list, int old_width,
+				       int new_width)
+{
+	if (list->max_width_count == 0 || old_width == new_width) {
+		return;
+	}
+	if (new_width > list->max_width) {
+		list->max_width = new_width;
+		list->max_width_count = 1;
+	} else if (new_width == list->max_width) {
+		++list->max_width_count;
+	} else if (old_width == list->max_width) {
+		--list->max_width_count;
+	}
+}
+
+/** 设置文本行的尺寸，并更新行高树和最大行宽 */
+static void TextRowList_SetRowSize(LCUI_TextRowList list, int i_row,
+				   int width, int height)
+{
+	int j;
+	LCUI_TextRow txtrow = list->rows[i_row];
+	int delta = height - txtrow->height;
+
+	for (j = i_row + 1; delta != 0 && j <= list->height_tree_length;
+	     j += LOWBIT(j)) {
+		list->height_tree[j] += delta;
+	}
+	TextRowList_UpdateMaxWidth(list, txtrow->width, width);
+	txtrow->width = width;
+	txtrow->height = height;
 }
 
 /** 向文本行列表中插入新的文本行 */
@@ -157,6 +589,11 @@ static LCUI_TextRow TextRowList_InsertNewRow(LCUI_TextRowList rowlist,
 	}
 	txtrows[i_row] = txtrow;
 	rowlist->rows = txtrows;
+	/* 新的文本行的尺寸为 0，它后面的行高树节点都已失效 */
+	rowlist->height_tree_length = min(rowlist->height_tree_length, i_row);
+	if (rowlist->max_width_count > 0 && rowlist->max_width == 0) {
+		++rowlist->max_width_count;
+	}
 	return txtrow;
 }
 
@@ -166,6 +603,11 @@ static int TextRowList_RemoveRow(LCUI_TextRowList rowlist, int i_row)
 	if (i_row < 0 || i_row >= rowlist->length) {
 		return -1;
 	}
+	rowlist->height_tree_length = min(rowlist->height_tree_length, i_row);
+	if (rowlist->rows[i_row]->width == rowlist->max_width &&
+	    rowlist->max_width_count > 0) {
+		--rowlist->max_width_count;
+	}
 	TextRow_Destroy(rowlist->rows[i_row]);
 	free(rowlist->rows[i_row]);
 	for (; i_row < rowlist->length - 1; ++i_row) {
@@ -177,100 +619,58 @@ static int TextRowList_RemoveRow(LCUI_TextRowList rowlist, int i_row)
 }
 
 /** 更新文本行的尺寸 */
-static void TextLayer_UpdateRowSize(LCUI_TextLayer layer, LCUI_TextRow txtrow)
+static void TextLayer_UpdateRowSize(LCUI_TextLayer layer, int row)
 {
-	int i;
-	LCUI_TextChar txtchar;
-	txtrow->width = 0;
+	int i, width = 0, height;
+	const LCUI_FontBitmap *bitmap;
+	LCUI_TextRow txtrow = layer->text_rows.rows[row];
+
 	txtrow->text_height = layer->text_default_style.pixel_size;
 	for (i = 0; i < txtrow->length; ++i) {
-		txtchar = txtrow->string[i];
-		if (!txtchar->bitmap) {
+		bitmap = txtrow->bitmaps[i];
+		if (!bitmap) {
 			continue;
 		}
-		txtrow->width += txtchar->bitmap->advance.x;
-		if (txtrow->text_height < txtchar->bitmap->advance.y) {
-			txtrow->text_height = txtchar->bitmap->advance.y;
+		width += bitmap->advance.x;
+		if (txtrow->text_height < bitmap->advance.y) {
+			txtrow->text_height = bitmap->advance.y;
 		}
 	}
 	if (layer->line_height > -1) {
-		txtrow->height = layer->line_height;
+		height = layer->line_height;
 	} else {
-		txtrow->height = GetDefaultLineHeight(txtrow->text_height);
+		height = GetDefaultLineHeight(txtrow->text_height);
 	}
+	TextRowList_SetRowSize(&layer->text_rows, row, width, height);
 }
 
-/** 设置文本行的字符串长度 */
-static int TextRow_SetLength(LCUI_TextRow txtrow, int len)
-{
-	LCUI_TextChar *txtstr;
-	if (len < 0) {
-		len = 0;
-	}
-	txtstr = realloc(txtrow->string, sizeof(LCUI_TextChar) * (len + 1));
-	if (!txtstr) {
-		return -1;
-	}
-	txtstr[len] = NULL;
-	txtrow->string = txtstr;
-	txtrow->length = len;
-	return 0;
-}
-
-/** 将字符数据直接插入至文本行 */
-static int TextRow_Insert(LCUI_TextRow txtrow, int ins_pos,
-			  LCUI_TextChar txtchar)
-{
-	int i;
-	if (ins_pos < 0) {
-		ins_pos = txtrow->length + 1 + ins_pos;
-		if (ins_pos < 0) {
-			ins_pos = 0;
-		}
-	} else if (ins_pos > txtrow->length) {
-		ins_pos = txtrow->length;
-	}
-	TextRow_SetLength(txtrow, txtrow->length + 1);
-	for (i = txtrow->length - 1; i > ins_pos; --i) {
-		txtrow->string[i] = txtrow->string[i - 1];
-	}
-	txtrow->string[ins_pos] = txtchar;
-	return 0;
-}
-
-/** 向文本行插入一个字符数据副本 */
-static int TextRow_InsertCopy(LCUI_TextRow txtrow, int ins_pos,
-			      LCUI_TextChar txtchar)
-{
-	LCUI_TextChar txtchar2;
-	txtchar2 = malloc(sizeof(LCUI_TextCharRec));
-	*txtchar2 = *txtchar;
-	return TextRow_Insert(txtrow, ins_pos, txtchar2);
-}
-
-/** 更新字体位图 */
-static void TextChar_UpdateBitmap(LCUI_TextChar ch, LCUI_TextStyle style)
+/** 获取文字的字体位图 */
+static const LCUI_FontBitmap *TextLayer_GetCharBitmap(LCUI_TextLayer layer,
+						      wchar_t code,
+						      LCUI_TextStyle style)
 {
 	int i = 0;
-	int size = style->pixel_size;
-	int *font_ids = style->font_ids;
-	if (ch->style) {
-		if (ch->style->has_family) {
-			font_ids = ch->style->font_ids;
+	int size = layer->text_default_style.pixel_size;
+	int *font_ids = layer->text_default_style.font_ids;
+	const LCUI_FontBitmap *bitmap = NULL;
+
+	if (style) {
+		if (style->has_family) {
+			font_ids = style->font_ids;
 		}
-		if (ch->style->has_pixel_size) {
-			size = ch->style->pixel_size;
+		if (style->has_pixel_size) {
+			size = style->pixel_size;
 		}
 	}
 	while (font_ids && font_ids[i] > 0) {
-		int ret = LCUIFont_GetBitmap(ch->code, font_ids[i], size,
-					     &ch->bitmap);
+		int ret = LCUIFont_GetBitmap(code, font_ids[i], size, &bitmap);
 		if (ret == 0) {
-			return;
+			return bitmap;
 		}
 		++i;
 	}
-	LCUIFont_GetBitmap(ch->code, -1, size, &ch->bitmap);
+	LCUIFont_GetBitmap(code, -1, size, &bitmap);
+	return bitmap;
 }
 
 /** 新建文本图层 */
@@ -291,8 +691,7 @@ LCUI_TextLayer TextLayer_New(void)
 	layer->new_offset_x = 0;
 	layer->new_offset_y = 0;
 	layer->line_height = -1;
-	layer->text_rows.length = 0;
-	layer->text_rows.rows = NULL;
+	TextRowList_Init(&layer->text_rows);
 	layer->text_align = SV_LEFT;
 	layer->enable_autowrap = FALSE;
 	layer->enable_mulitiline = FALSE;
@@ -301,6 +700,7 @@ LCUI_TextLayer TextLayer_New(void)
 	TextStyle_Init(&layer->text_default_style);
 	LinkedList_Init(&layer->text_styles);
 	layer->task.typeset_start_row = 0;
+	layer->task.typeset_end_row = -1;
 	layer->task.update_typeset = 0;
 	layer->task.update_bitmap = 0;
 	layer->task.redraw_all = 0;
@@ -317,11 +717,13 @@ static void TextRowList_Destroy(LCUI_TextRowList list)
 		free(list->rows[row]);
 		list->rows[row] = NULL;
 	}
-	list->length = 0;
 	if (list->rows) {
 		free(list->rows);
 	}
-	list->rows = NULL;
+	if (list->height_tree) {
+		free(list->height_tree);
+	}
+	TextRowList_Init(list);
 }
 
 static void OnDestroyTextStyle(void *data)
@@ -356,11 +758,8 @@ static int TextLayer_GetRowRect(LCUI_TextLayer layer, int i_row, int start_col,
 		return -1;
 	}
 	/* 先计算在有效区域内的起始行的Y轴坐标 */
-	rect->y = layer->offset_y;
+	rect->y = layer->offset_y + TextRowList_GetRowY(&layer->text_rows, i_row);
 	rect->x = layer->offset_x;
-	for (i = 0; i < i_row; ++i) {
-		rect->y += layer->text_rows.rows[i]->height;
-	}
 	txtrow = layer->text_rows.rows[i_row];
 	if (end_col < 0 || end_col >= txtrow->length) {
 		end_col = txtrow->length - 1;
@@ -371,17 +770,17 @@ static int TextLayer_GetRowRect(LCUI_TextLayer layer, int i_row, int start_col,
 		rect->width = txtrow->width;
 	} else {
 		for (i = 0; i < start_col; ++i) {
-			if (!txtrow->string[i]->bitmap) {
+			if (!txtrow->bitmaps[i]) {
 				continue;
 			}
-			rect->x += txtrow->string[i]->bitmap->advance.x;
+			rect->x += txtrow->bitmaps[i]->advance.x;
 		}
 		rect->width = 0;
 		for (i = start_col; i <= end_col && i < txtrow->length; ++i) {
-			if (!txtrow->string[i]->bitmap) {
+			if (!txtrow->bitmaps[i]) {
 				continue;
 			}
-			rect->width += txtrow->string[i]->bitmap->advance.x;
+			rect->width += txtrow->bitmaps[i]->advance.x;
 		}
 	}
 	if (rect->width <= 0 || rect->height <= 0) {
@@ -411,14 +810,10 @@ void TextLayer_InvalidateRowsRect(LCUI_TextLayer layer, int start_row,
 		end_row = layer->text_rows.length - 1;
 	}
 
-	y = layer->offset_y;
-	for (i = 0; i < layer->text_rows.length; ++i) {
-		y += layer->text_rows.rows[i]->height;
-		if (i >= start_row && y >= 0) {
-			y -= layer->text_rows.rows[i]->height;
-			break;
-		}
-	}
+	/* 从可见的第一行开始 */
+	i = TextRowList_FindRow(&layer->text_rows, -layer->offset_y);
+	i = max(i, start_row);
+	y = layer->offset_y + TextRowList_GetRowY(&layer->text_rows, i);
 	for (; i <= end_row; ++i) {
 		TextLayer_GetRowRect(layer, i, 0, -1, &rect);
 		RectList_Add(&layer->dirty_rects, &rect);
@@ -459,15 +854,9 @@ int TextLayer_SetCaretPosByPixelPos(LCUI_TextLayer layer, int x, int y)
 {
 	LCUI_TextRow txtrow;
 	int i, pixel_pos, ins_x, ins_y;
-	pixel_pos = layer->offset_y;
-	for (i = 0; i < layer->text_rows.length; ++i) {
-		pixel_pos += layer->text_rows.rows[i]->height;
-		if (pixel_pos >= y) {
-			ins_y = i;
-			break;
-		}
-	}
-	if (i >= layer->text_rows.length) {
+
+	ins_y = TextRowList_FindRow(&layer->text_rows, y - layer->offset_y);
+	if (ins_y >= layer->text_rows.length) {
 		if (layer->text_rows.length > 0) {
 			ins_y = layer->text_rows.length - 1;
 		} else {
@@ -481,14 +870,13 @@ int TextLayer_SetCaretPosByPixelPos(LCUI_TextLayer layer, int x, int y)
 	pixel_pos = layer->offset_x;
 	pixel_pos += TextLayer_GetRowStartX(layer, txtrow);
 	for (i = 0; i < txtrow->length; ++i) {
-		LCUI_TextChar txtchar;
-		txtchar = txtrow->string[i];
-		if (!txtchar->bitmap) {
+		const LCUI_FontBitmap *bitmap = txtrow->bitmaps[i];
+		if (!bitmap) {
 			continue;
 		}
-		pixel_pos += txtchar->bitmap->advance.x;
+		pixel_pos += bitmap->advance.x;
 		/* 如果在当前字中心点的前面 */
-		if (x <= pixel_pos - txtchar->bitmap->advance.x / 2) {
+		if (x <= pixel_pos - bitmap->advance.x / 2) {
 			ins_x = i;
 			break;
 		}
@@ -511,18 +899,14 @@ int TextLayer_GetCharPixelPos(LCUI_TextLayer layer, int row, int col,
 	} else if (col > layer->text_rows.rows[row]->length) {
 		return -3;
 	}
-	/* 累加前几行的高度 */
-	for (i = 0; i < row; ++i) {
-		pixel_y += layer->text_rows.rows[i]->height;
-	}
+	pixel_y = TextRowList_GetRowY(&layer->text_rows, row);
 	txtrow = layer->text_rows.rows[row];
 	pixel_x = TextLayer_GetRowStartX(layer, txtrow);
 	for (i = 0; i < col; ++i) {
-		LCUI_TextChar txtchar = txtrow->string[i];
-		if (!txtchar || !txtchar->bitmap) {
+		if (!txtrow->bitmaps[i]) {
 			continue;
 		}
-		pixel_x += txtchar->bitmap->advance.x;
+		pixel_x += txtrow->bitmaps[i]->advance.x;
 	}
 	pixel_pos->x = pixel_x;
 	pixel_pos->y = pixel_y;
@@ -554,26 +938,20 @@ void TextLayer_ClearText(LCUI_TextLayer layer)
 static void TextLayer_BreakTextRow(LCUI_TextLayer layer, int row, int col,
 				   LCUI_EOLChar eol)
 {
-	int n;
 	LCUI_TextRow txtrow, next;
 	txtrow = TextLayer_GetRow(layer, row);
 	next = TextRowList_InsertNewRow(&layer->text_rows, row + 1);
 	/* 将本行原有的行尾符转移至下一行 */
 	next->eol = txtrow->eol;
 	txtrow->eol = eol;
-	for (n = txtrow->length - 1; n >= col; --n) {
-		TextRow_Insert(next, 0, txtrow->string[n]);
-		txtrow->string[n] = NULL;
-	}
-	txtrow->length = col;
-	TextLayer_UpdateRowSize(layer, txtrow);
-	TextLayer_UpdateRowSize(layer, next);
+	TextRow_MoveTail(next, txtrow, col);
+	TextLayer_UpdateRowSize(layer, row);
+	TextLayer_UpdateRowSize(layer, row + 1);
 }
 
 /** 将指定行与下一行合并 */
 static void TextLayer_MergeRow(LCUI_TextLayer layer, int row)
 {
-	int i, j;
 	LCUI_TextRow txtrow = TextLayer_GetRow(layer, row);
 	LCUI_TextRow next = TextLayer_GetRow(layer, row + 1);
 
@@ -586,80 +964,261 @@ static void TextLayer_MergeRow(LCUI_TextLayer layer, int row)
 			layer->insert_x += txtrow->length;
 		}
 	}
-	i = txtrow->length;
-	TextRow_SetLength(txtrow, txtrow->length + next->length);
-	for (j = 0; j < next->length; ++i, ++j) {
-		txtrow->string[i] = next->string[j];
-		next->string[j] = NULL;
-	}
+	TextRow_MoveTail(txtrow, next, 0);
 	txtrow->eol = next->eol;
-	TextLayer_UpdateRowSize(layer, txtrow);
+	TextLayer_UpdateRowSize(layer, row);
 	TextRowList_RemoveRow(&layer->text_rows, row + 1);
 }
 
+/**
+ * 在指定列处对文本行进行自动换行
+ * 如果下一行是同一段落的后续行，则将超出的文字移到它的开头，只有在段落的最后
+ * 一行也放不下时才插入新行，以免每次排版都插入和删除文本行
+ */
+static void TextLayer_WrapTextRow(LCUI_TextLayer layer, int row, int col)
+{
+	LCUI_TextRow txtrow = layer->text_rows.rows[row];
+	LCUI_TextRow next = TextLayer_GetRow(layer, row + 1);
+
+	if (txtrow->eol != LCUI_EOL_NONE || !next) {
+		TextLayer_BreakTextRow(layer, row, col, LCUI_EOL_NONE);
+		if (layer->insert_y > row) {
+			++layer->insert_y;
+		}
+	} else {
+		if (layer->insert_y == row + 1) {
+			layer->insert_y = row;
+			layer->insert_x += txtrow->length;
+		}
+		TextRow_MoveTail(txtrow, next, 0);
+		TextRow_MoveTail(next, txtrow, col);
+		TextLayer_UpdateRowSize(layer, row);
+		TextLayer_UpdateRowSize(layer, row + 1);
+	}
+	/* 插入点在被移走的文字中，它也跟着移到下一行 */
+	if (layer->insert_y == row && layer->insert_x > col) {
+		layer->insert_y = row + 1;
+		layer->insert_x -= col;
+	}
+}
+
 /** 对指定行的文本进行排版 */
 static void TextLayer_TextRowTypeset(LCUI_TextLayer layer, int row)
 {
-	int col, row_width = 0, word_col = 0;
+	int col, row_width, word_col;
 	int max_width =
 	    layer->fixed_width > 0 ? layer->fixed_width : layer->max_width;
 
-	LCUI_TextChar txtchar;
-	LCUI_TextRow txtrow = layer->text_rows.rows[row];
+	const LCUI_FontBitmap *bitmap;
+	LCUI_TextRow next, txtrow = layer->text_rows.rows[row];
 	LCUI_BOOL autowrap =
 	    max_width > 0 && layer->enable_autowrap && layer->enable_mulitiline;
 
-	for (col = 0; col < txtrow->length; ++col) {
-		txtchar = txtrow->string[col];
-		if (!txtchar->bitmap) {
-			continue;
-		}
-		/* 累加行宽度 */
-		row_width += txtchar->bitmap->advance.x;
-		/* 如果是当前行的第一个字符，或者行宽度没有超过宽度限制 */
-		if (!autowrap || col < 1 || row_width <= max_width) {
-			if (ISALPHA(txtchar->code)) {
-			} else {
-				word_col = col + 1;
+	while (1) {
+		row_width = 0;
+		word_col = 0;
+		/* 不需要自动换行时，行宽由 TextLayer_UpdateRowSize() 计算 */
+		for (col = 0; autowrap && col < txtrow->length; ++col) {
+			bitmap = txtrow->bitmaps[col];
+			if (!bitmap) {
+				continue;
 			}
-			continue;
-		}
-		if (layer->word_break == LCUI_WORD_BREAK_NORMAL) {
-			if (word_col < 1) {
+			/* 累加行宽度 */
+			row_width += bitmap->advance.x;
+			/* 如果是当前行的第一个字符，或者行宽度没有超过宽度限制 */
+			if (col < 1 || row_width <= max_width) {
+				if (ISALPHA(txtrow->codes[col])) {
+				} else {
+					word_col = col + 1;
+				}
 				continue;
 			}
-			col = word_col;
+			if (layer->word_break == LCUI_WORD_BREAK_NORMAL) {
+				if (word_col < 1) {
+					continue;
+				}
+				col = word_col;
+			}
+			TextLayer_WrapTextRow(layer, row, col);
+			return;
 		}
-		TextLayer_BreakTextRow(layer, row, col, LCUI_EOL_NONE);
-		return;
+		TextLayer_UpdateRowSize(layer, row);
+		/* 如果本行有换行符，或者是最后一行 */
+		if (txtrow->eol != LCUI_EOL_NONE ||
+		    row == layer->text_rows.length - 1) {
+			return;
+		}
+		next = layer->text_rows.rows[row + 1];
+		/* 下一行的文字都已转移至本行，删除下一行 */
+		if (next->length < 1) {
+			TextLayer_MergeRow(layer, row);
+			continue;
+		}
+		/* 本行的文本宽度未达到限制宽度，需要将下行的文本转移至本行 */
+		if (layer->insert_y == row + 1) {
+			layer->insert_y = row;
+			layer->insert_x += txtrow->length;
+		}
+		TextRow_MoveTail(txtrow, next, 0);
 	}
-	TextLayer_UpdateRowSize(layer, txtrow);
-	/* 如果本行有换行符，或者是最后一行 */
-	if (txtrow->eol != LCUI_EOL_NONE ||
-	    row == layer->text_rows.length - 1) {
-		return;
+}
+
+/** 记录排版前各个文本行的位置、长度和矩形区域 */
+static void TextLayer_TakeRowsSnapshot(LCUI_TextLayer layer, int start_row,
+				       int n_rows, TextRowSnapshot rows)
+{
+	int i, offset = 0;
+	int y = TextRowList_GetRowY(&layer->text_rows, start_row);
+	LCUI_TextRow txtrow;
+
+	for (i = 0; i < n_rows; ++i) {
+		txtrow = layer->text_rows.rows[start_row + i];
+		rows[i].offset = offset;
+		rows[i].length = txtrow->length;
+		rows[i].y = y;
+		rows[i].has_rect = TextLayer_GetRowRect(layer, start_row + i, 0,
+							-1, &rows[i].rect) == 0;
+		rows[i].unchanged = FALSE;
+		offset += txtrow->length;
+		y += txtrow->height;
 	}
-	row_width = txtrow->width;
-	/* 本行的文本宽度未达到限制宽度，需要将下行的文本转移至本行 */
-	if (txtrow->eol == LCUI_EOL_NONE) {
-		TextLayer_InvalidateRowRect(layer, row, 0, -1);
-		TextLayer_InvalidateRowRect(layer, row + 1, 0, -1);
-		TextLayer_MergeRow(layer, row);
-		TextLayer_TextRowTypeset(layer, row);
+}
+
+/**
+ * 标记排版后有变化的文本行的矩形区域为无效
+ * 位置、内容和区域都与排版前相同，并且不在被编辑的范围内的文本行不需要重绘，
+ * 其余的文本行需要重绘排版前后的区域
+ */
+static void TextLayer_InvalidateChangedRows(LCUI_TextLayer layer,
+					    int start_row, int end_row,
+					    TextRowSnapshot rows, int n_rows,
+					    int edit_start, int edit_end)
+{
+	int i, row, offset = 0;
+	LCUI_Rect rect;
+	LCUI_BOOL has_rect;
+	LCUI_TextRow txtrow;
+	TextRowSnapshot old;
+
+	for (i = 0, row = start_row; row <= end_row; ++row) {
+		txtrow = layer->text_rows.rows[row];
+		has_rect = TextLayer_GetRowRect(layer, row, 0, -1, &rect) == 0;
+		while (i < n_rows && rows[i].offset < offset) {
+			++i;
+		}
+		old = i < n_rows ? &rows[i] : NULL;
+		if (old && (start_row + i < edit_start ||
+			    start_row + i > edit_end) &&
+		    old->offset == offset && old->length == txtrow->length &&
+		    old->has_rect == has_rect &&
+		    (!has_rect || LCUIRect_IsEquals(&old->rect, &rect))) {
+			old->unchanged = TRUE;
+			offset += txtrow->length;
+			continue;
+		}
+		offset += txtrow->length;
+		if (has_rect) {
+			RectList_Add(&layer->dirty_rects, &rect);
+		}
+	}
+	for (i = 0; i < n_rows; ++i) {
+		if (!rows[i].unchanged && rows[i].has_rect) {
+			RectList_Add(&layer->dirty_rects, &rows[i].rect);
+		}
 	}
 }
 
-/** 从指定行开始，对文本进行排版 */
-static void TextLayer_TextTypeset(LCUI_TextLayer layer, int start_row)
+/**
+ * 对指定范围内的文本进行排版
+ * 段落（以换行符结尾的连续文本行）之间的排版互不影响，所以排版最多处理到结束行
+ * 所在段落的最后一行。在被编辑的范围之后，如果某一行排版后的行首位置和长度与
+ * 排版前的某一行相同，那么从这一行开始的排版结果都不会变，可以提前结束。
+ * 只有内容或位置有变化的文本行需要重绘，后面的文本行只有在高度变化时才需要重绘
+ */
+static void TextLayer_TextTypeset(LCUI_TextLayer layer, int start_row,
+				  int end_row)
 {
-	int row;
-	/* 记录排版前各个文本行的矩形区域 */
-	TextLayer_InvalidateRowsRect(layer, start_row, -1);
-	for (row = start_row; row < layer->text_rows.length; ++row) {
+	int i, row, length, offset, y, old_y, height;
+	int n_rows, edit_start, edit_end;
+	LCUI_Rect rect;
+	LCUI_TextRow next;
+	TextRowSnapshot rows;
+	LCUI_TextRowList list = &layer->text_rows;
+
+	if (list->length < 1) {
+		return;
+	}
+	if (end_row < 0 || end_row >= list->length) {
+		end_row = list->length - 1;
+	}
+	start_row = max(0, min(start_row, end_row));
+	edit_start = start_row;
+	edit_end = end_row;
+	/* 上一行是自动换行产生的，本行开头的文字可能会移到上一行 */
+	if (start_row > 0 && list->rows[start_row - 1]->eol == LCUI_EOL_NONE) {
+		--start_row;
+	}
+	while (end_row < list->length - 1 &&
+	       list->rows[end_row]->eol == LCUI_EOL_NONE) {
+		++end_row;
+	}
+	old_y = TextRowList_GetRowY(list, end_row + 1);
+	height = TextLayer_GetHeight(layer);
+	n_rows = end_row - start_row + 1;
+	rows = malloc(sizeof(TextRowSnapshotRec) * n_rows);
+	if (!rows) {
+		/* 没有排版前的记录，只能重绘段落和它后面的所有文本行 */
+		edit_end = list->length - 1;
+		TextLayer_InvalidateRowsRect(layer, start_row, -1);
+	} else {
+		TextLayer_TakeRowsSnapshot(layer, start_row, n_rows, rows);
+	}
+	for (i = 0, offset = 0, row = start_row; row <= end_row; ++row) {
+		length = list->length;
 		TextLayer_TextRowTypeset(layer, row);
+		/* 断行和合并行会改变段落的行数 */
+		end_row += list->length - length;
+		offset += list->rows[row]->length;
+		if (!rows || row >= end_row) {
+			continue;
+		}
+		next = list->rows[row + 1];
+		while (i < n_rows && rows[i].offset < offset) {
+			++i;
+		}
+		if (i < n_rows && start_row + i > edit_end &&
+		    rows[i].offset == offset && rows[i].length == next->length) {
+			/* 后面的文本行与排版前的第 i 行及其之后的行相同 */
+			end_row = row;
+			old_y = rows[i].y;
+			n_rows = i;
+			break;
+		}
+	}
+	if (rows) {
+		TextLayer_InvalidateChangedRows(layer, start_row, end_row,
+						rows, n_rows, edit_start,
+						edit_end);
+		free(rows);
+	} else {
+		TextLayer_InvalidateRowsRect(layer, start_row, -1);
+	}
+	y = TextRowList_GetRowY(list, end_row + 1);
+	if (y == old_y) {
+		return;
+	}
+	/* 段落的高度有变化，后面的文本行都需要重绘 */
+	rect.x = layer->offset_x;
+	rect.y = layer->offset_y + min(y, old_y);
+	rect.width = max(layer->fixed_width,
+			 max(layer->width, TextLayer_GetWidth(layer)));
+	rect.height = max(height, height + y - old_y) - min(y, old_y);
+	if (layer->max_height > 0) {
+		rect.height = min(rect.height, layer->max_height - rect.y);
+	}
+	if (rect.width > 0 && rect.height > 0) {
+		RectList_Add(&layer->dirty_rects, &rect);
 	}
-	/* 记录排版后各个文本行的矩形区域 */
-	TextLayer_InvalidateRowsRect(layer, start_row, -1);
 }
 
 static const wchar_t *TextLayer_ProcessStyleTag(LCUI_TextLayer layer,
@@ -698,7 +1257,7 @@ static int TextLayer_ProcessText(LCUI_TextLayer layer, const wchar_t *wstr,
 {
 	LCUI_EOLChar eol;
 	LCUI_TextRow txtrow;
-	LCUI_TextCharRec txtchar;
+	LCUI_TextRowRec tail;
 	LinkedList tmp_tags;
 	const wchar_t *p;
 	int cur_col, cur_row, start_row, ins_x, ins_y;
@@ -737,6 +1296,9 @@ static int TextLayer_ProcessText(LCUI_TextLayer layer, const wchar_t *wstr,
 	start_row = cur_row;
 	ins_x = cur_col;
 	ins_y = cur_row;
+	/* 先移出插入点后面的文字，让新的文字只需追加至行尾 */
+	TextRow_Init(&tail);
+	TextRow_MoveTail(&tail, txtrow, ins_x);
 	for (p = wstr; *p; ++p) {
 		if (layer->enable_style_tag) {
 			const wchar_t *pp;
@@ -763,6 +1325,8 @@ static int TextLayer_ProcessText(LCUI_TextLayer layer, const wchar_t *wstr,
 				rect_has_added = TRUE;
 				start_row = ins_y;
 			}
+			/* 当前行已不会再追加文字，释放多余的空间 */
+			TextRow_Shrink(txtrow);
 			/* 将当前行中的插入点为截点，进行断行 */
 			TextLayer_BreakTextRow(layer, ins_y, ins_x, eol);
 			layer->width = max(layer->width, txtrow->width);
@@ -773,15 +1337,16 @@ static int TextLayer_ProcessText(LCUI_TextLayer layer, const wchar_t *wstr,
 			txtrow = TextLayer_GetRow(layer, ins_y);
 			continue;
 		}
-		txtchar.style = style;
-		txtchar.code = *p;
-		TextChar_UpdateBitmap(&txtchar, &layer->text_default_style);
-		TextRow_InsertCopy(txtrow, ins_x, &txtchar);
+		TextRow_Append(txtrow, *p,
+			       TextLayer_GetCharBitmap(layer, *p, style), style);
 		++layer->length;
 		++ins_x;
 	}
+	/* 将移出的文字放回插入点后面 */
+	TextRow_MoveTail(txtrow, &tail, 0);
+	TextRow_Destroy(&tail);
 	/* 更新当前行的尺寸 */
-	TextLayer_UpdateRowSize(layer, txtrow);
+	TextLayer_UpdateRowSize(layer, ins_y);
 	layer->width = max(layer->width, txtrow->width);
 	if (action == TEXT_ACTION_INSERT) {
 		layer->insert_x = ins_x;
@@ -789,7 +1354,7 @@ static int TextLayer_ProcessText(LCUI_TextLayer layer, const wchar_t *wstr,
 	}
 	/* 若启用了自动换行模式，则标记需要重新对文本进行排版 */
 	if (layer->enable_autowrap || need_typeset) {
-		TextLayer_AddUpdateTypeset(layer, cur_row);
+		TextLayer_AddUpdateTypesetRange(layer, cur_row, ins_y);
 	} else {
 		TextLayer_InvalidateRowRect(layer, cur_row, 0, -1);
 	}
@@ -884,7 +1449,7 @@ size_t TextLayer_GetTextW(LCUI_TextLayer layer, size_t start_pos,
 	for (i = 0; row < layer->text_rows.length && i < max_len; ++row) {
 		row_ptr = layer->text_rows.rows[row];
 		for (; col < row_ptr->length && i < max_len; ++col, ++i) {
-			wstr_buff[i] = row_ptr->string[col]->code;
+			wstr_buff[i] = row_ptr->codes[col];
 		}
 	}
 	wstr_buff[i] = 0;
@@ -893,38 +1458,12 @@ size_t TextLayer_GetTextW(LCUI_TextLayer layer, size_t start_pos,
 
 int TextLayer_GetWidth(LCUI_TextLayer layer)
 {
-	int i, row, w, max_w;
-	LCUI_TextRow txtrow;
-
-	DEBUG_MSG("rows: %d, font-size: %d\n", layer->text_rows.length,
-		  layer->text_default_style.pixel_size);
-	for (row = 0, max_w = 0; row < layer->text_rows.length; ++row) {
-		txtrow = layer->text_rows.rows[row];
-		for (i = 0, w = 0; i < txtrow->length; ++i) {
-			if (!txtrow->string[i]->bitmap ||
-			    !txtrow->string[i]->bitmap->buffer) {
-				continue;
-			}
-			w += txtrow->string[i]->bitmap->advance.x;
-			DEBUG_MSG("[%d/%d] %d %c, width: %d/%d\n", i,
-				  txtrow->length, txtrow->string[i]->code,
-				  txtrow->string[i]->code,
-				  txtrow->string[i]->bitmap->advance.x, w);
-		}
-		if (w > max_w) {
-			max_w = w;
-		}
-	}
-	return max_w;
+	return TextRowList_GetMaxWidth(&layer->text_rows);
 }
 
 int TextLayer_GetHeight(LCUI_TextLayer layer)
 {
-	int i, h;
-	for (i = 0, h = 0; i < layer->text_rows.length; ++i) {
-		h += layer->text_rows.rows[i]->height;
-	}
-	return h;
+	return TextRowList_GetRowY(&layer->text_rows, layer->text_rows.length);
 }
 
 int TextLayer_SetFixedSize(LCUI_TextLayer layer, int width, int height)
@@ -933,8 +1472,7 @@ int TextLayer_SetFixedSize(LCUI_TextLayer layer, int width, int height)
 	layer->fixed_height = height;
 	layer->task.redraw_all = TRUE;
 	if (layer->enable_autowrap) {
-		layer->task.typeset_start_row = 0;
-		layer->task.update_typeset = TRUE;
+		TextLayer_AddUpdateTypeset(layer, 0);
 	}
 	return 0;
 }
@@ -945,8 +1483,7 @@ int TextLayer_SetMaxSize(LCUI_TextLayer layer, int width, int height)
 	layer->max_height = height;
 	layer->task.redraw_all = TRUE;
 	if (layer->enable_autowrap) {
-		layer->task.typeset_start_row = 0;
-		layer->task.update_typeset = TRUE;
+		TextLayer_AddUpdateTypeset(layer, 0);
 	}
 	return 0;
 }
@@ -1021,7 +1558,7 @@ static int TextLayer_TextDeleteEx(LCUI_TextLayer layer, int char_y, int char_x,
 		return 0;
 	}
 	/* 获取上一行文本 */
-	prev_txtrow = layer->text_rows.rows[char_y - 1];
+	prev_txtrow = char_y > 0 ? layer->text_rows.rows[char_y - 1] : NULL;
 	// 计算起始行与结束行拼接后的长度
 	// 起始行：0 1 2 3 4 5，起点位置：2
 	// 结束行：0 1 2 3 4 5，终点位置：4
@@ -1030,36 +1567,29 @@ static int TextLayer_TextDeleteEx(LCUI_TextLayer layer, int char_y, int char_x,
 	if (len < 0) {
 		return -3;
 	}
+	txtrow = layer->text_rows.rows[char_y];
 	/* 如果是同一行 */
-	if (txtrow == end_txtrow) {
+	if (char_y == end_y) {
 		if (end_x > end_txtrow->length) {
 			return -4;
 		}
 		TextLayer_InvalidateRowRect(layer, char_y, char_x, -1);
-		TextLayer_AddUpdateTypeset(layer, char_y);
-		for (i = char_x, j = end_x; j < txtrow->length; ++i, ++j) {
-			txtrow->string[i] = txtrow->string[j];
-		}
+		TextLayer_AddUpdateTypesetRange(layer, char_y, char_y);
+		TextRow_Delete(txtrow, char_x, end_x);
 		/* 如果当前行为空，也不是第一行，并且上一行没有结束符 */
 		if (len <= 0 && end_y > 0 &&
 		    prev_txtrow->eol != LCUI_EOL_NONE) {
+			/* 后面的文本行会上移，记录它们移动前后的区域 */
+			TextLayer_InvalidateRowsRect(layer, end_y, -1);
 			TextRowList_RemoveRow(&layer->text_rows, end_y);
+			TextLayer_InvalidateRowsRect(layer, end_y, -1);
+			return 0;
 		}
-		/* 调整起始行的容量 */
-		TextRow_SetLength(txtrow, len);
 		/* 更新文本行的尺寸 */
-		TextLayer_UpdateRowSize(layer, txtrow);
+		TextLayer_UpdateRowSize(layer, char_y);
 		return 0;
 	}
-	/* 如果结束点在行尾，并且该行不是最后一行 */
-	if (end_x == end_txtrow->length &&
-	    end_y < layer->text_rows.length - 1) {
-		++end_y;
-		end_txtrow = TextLayer_GetRow(layer, end_y);
-		end_x = -1;
-		len = char_x + end_txtrow->length;
-	}
-	TextRow_SetLength(txtrow, len);
+	TextRow_Truncate(txtrow, char_x);
 	/* 标记当前行后面的所有行的矩形需区域需要刷新 */
 	TextLayer_InvalidateRowsRect(layer, char_y + 1, -1);
 	/* 移除起始行与结束行之间的文本行 */
@@ -1067,14 +1597,11 @@ static int TextLayer_TextDeleteEx(LCUI_TextLayer layer, int char_y, int char_x,
 		TextLayer_InvalidateRowRect(layer, i, 0, -1);
 		TextRowList_RemoveRow(&layer->text_rows, i);
 	}
-	i = char_x;
-	j = end_x + 1;
 	end_y = char_y + 1;
-	/* 将结束行的内容拼接至起始行 */
-	for (; i < len && j < end_txtrow->length; ++i, ++j) {
-		txtrow->string[i] = end_txtrow->string[j];
-	}
-	TextLayer_UpdateRowSize(layer, txtrow);
+	/* 将结束行的剩余内容拼接至起始行 */
+	TextRow_MoveTail(txtrow, end_txtrow, end_x);
+	txtrow->eol = end_txtrow->eol;
+	TextLayer_UpdateRowSize(layer, char_y);
 	TextLayer_InvalidateRowRect(layer, end_y, 0, -1);
 	/* 移除结束行 */
 	TextRowList_RemoveRow(&layer->text_rows, end_y);
@@ -1084,7 +1611,9 @@ static int TextLayer_TextDeleteEx(LCUI_TextLayer layer, int char_y, int char_x,
 		TextLayer_InvalidateRowRect(layer, char_y, 0, -1);
 		TextRowList_RemoveRow(&layer->text_rows, char_y);
 	}
-	TextLayer_AddUpdateTypeset(layer, char_y);
+	/* 后面的文本行都上移了，记录它们的新位置 */
+	TextLayer_InvalidateRowsRect(layer, char_y, -1);
+	TextLayer_AddUpdateTypesetRange(layer, char_y, char_y);
 	return 0;
 }
 
@@ -1180,20 +1709,24 @@ static void TextLayer_UpdateTextStyleCache(LCUI_TextLayer layer)
 void TextLayer_ReloadCharBitmap(LCUI_TextLayer layer)
 {
 	int row, col;
+	LCUI_TextRow txtrow;
+
 	TextLayer_UpdateTextStyleCache(layer);
 	for (row = 0; row < layer->text_rows.length; ++row) {
-		LCUI_TextRow txtrow = layer->text_rows.rows[row];
+		txtrow = layer->text_rows.rows[row];
 		for (col = 0; col < txtrow->length; ++col) {
-			LCUI_TextChar txtchar = txtrow->string[col];
-			TextChar_UpdateBitmap(txtchar,
-					      &layer->text_default_style);
+			txtrow->bitmaps[col] = TextLayer_GetCharBitmap(
+			    layer, txtrow->codes[col],
+			    TextRow_GetStyle(txtrow, col));
 		}
-		TextLayer_UpdateRowSize(layer, txtrow);
+		TextLayer_UpdateRowSize(layer, row);
 	}
 }
 
 void TextLayer_Update(LCUI_TextLayer layer, LinkedList *rects)
 {
+	int width;
+
 	if (layer->task.update_bitmap) {
 		TextLayer_InvalidateRowsRect(layer, 0, -1);
 		TextLayer_ReloadCharBitmap(layer);
@@ -1202,11 +1735,21 @@ void TextLayer_Update(LCUI_TextLayer layer, LinkedList *rects)
 		layer->task.redraw_all = TRUE;
 	}
 	if (layer->task.update_typeset) {
-		TextLayer_TextTypeset(layer, layer->task.typeset_start_row);
+		TextLayer_TextTypeset(layer, layer->task.typeset_start_row,
+				      layer->task.typeset_end_row);
 		layer->task.update_typeset = FALSE;
 		layer->task.typeset_start_row = 0;
+		layer->task.typeset_end_row = -1;
 	}
-	layer->width = TextLayer_GetWidth(layer);
+	width = TextLayer_GetWidth(layer);
+	/* 居中和右对齐的文本行的位置取决于文本宽度 */
+	if (width != layer->width && layer->fixed_width <= 0 &&
+	    layer->text_align != SV_LEFT) {
+		TextLayer_InvalidateRowsRect(layer, 0, -1);
+		layer->width = width;
+		TextLayer_InvalidateRowsRect(layer, 0, -1);
+	}
+	layer->width = width;
 	/* 如果坐标偏移量有变化，记录各个文本行区域 */
 	if (layer->new_offset_x != layer->offset_x ||
 	    layer->new_offset_y != layer->offset_y) {
@@ -1239,38 +1782,65 @@ static void TextLayer_ValidateArea(LCUI_TextLayer layer, LCUI_Rect *area)
 	LCUIRect_ValidateArea(area, width, height);
 }
 
-static void TextLayer_DrawChar(LCUI_TextLayer layer, LCUI_TextChar ch,
-			       LCUI_Graph *graph, LCUI_Pos ch_pos)
+static void GlyphBatch_Flush(GlyphBatch batch, LCUI_Graph *graph)
+{
+	if (batch->length > 0) {
+		FontBitmap_MixRow(graph, batch->pos, batch->bitmaps,
+				  batch->length, batch->color);
+		batch->length = 0;
+	}
+}
+
+static void TextLayer_DrawChar(LCUI_TextLayer layer,
+			       const LCUI_FontBitmap *bitmap,
+			       LCUI_TextStyle style, LCUI_Graph *graph,
+			       LCUI_Pos ch_pos, GlyphBatch batch)
 {
-	/* 判断文字使用的前景颜色，再进行绘制 */
-	if (ch->style && ch->style->has_fore_color) {
-		FontBitmap_Mix(graph, ch_pos, ch->bitmap,
-			       ch->style->fore_color);
+	LCUI_Color color;
+	/* 位图的像素数据可能已被缓存清除，需要先载入 */
+	const LCUI_FontBitmap *bmp = LCUIFont_LoadBitmap(bitmap);
+
+	if (!bmp) {
+		return;
+	}
+	/* 判断文字使用的前景颜色 */
+	if (style && style->has_fore_color) {
+		color = style->fore_color;
 	} else {
-		FontBitmap_Mix(graph, ch_pos, ch->bitmap,
-			       layer->text_default_style.fore_color);
+		color = layer->text_default_style.fore_color;
 	}
+	/* 颜色不同或队列已满时，先绘制队列中的文字 */
+	if (batch->length >= GLYPH_BATCH_SIZE ||
+	    (batch->length > 0 && batch->color.value != color.value)) {
+		GlyphBatch_Flush(batch, graph);
+	}
+	batch->color = color;
+	batch->pos[batch->length] = ch_pos;
+	batch->bitmaps[batch->length] = bmp;
+	++batch->length;
 }
 
 static void TextLayer_DrawTextRow(LCUI_TextLayer layer, LCUI_Rect *area,
 				  LCUI_Graph *graph, LCUI_Pos layer_pos,
 				  LCUI_TextRow txtrow, int y)
 {
-	LCUI_TextChar txtchar;
 	LCUI_Pos ch_pos;
-	int baseline, col, x;
+	LCUI_TextStyle style;
+	GlyphBatchRec batch;
+	const LCUI_FontBitmap *bitmap;
+	int baseline, col, x, run, run_end;
 	baseline = txtrow->text_height * 4 / 5;
 	x = TextLayer_GetRowStartX(layer, txtrow) + layer->offset_x;
 	/* 确定从哪个文字开始绘制 */
 	for (col = 0; col < txtrow->length; ++col) {
-		txtchar = txtrow->string[col];
+		bitmap = txtrow->bitmaps[col];
 		/* 忽略无字体位图的文字 */
-		if (!txtchar->bitmap) {
+		if (!bitmap) {
 			continue;
 		}
-		x += txtchar->bitmap->advance.x;
+		x += bitmap->advance.x;
 		if (x > area->x) {
-			x -= txtchar->bitmap->advance.x;
+			x -= bitmap->advance.x;
 			break;
 		}
 	}
@@ -1279,35 +1849,48 @@ static void TextLayer_DrawTextRow(LCUI_TextLayer layer, LCUI_Rect *area,
 		y += txtrow->height;
 		return;
 	}
-	/* 遍历该行的文字 */
+	/* 遍历该行的文字，相邻的相同颜色的文字会被一起绘制 */
+	batch.length = 0;
+	run = TextRow_FindStyleRun(txtrow, col);
+	run_end = TextRow_GetStyleRunEnd(txtrow, run);
+	style = run < 0 ? NULL : txtrow->styles[run].style;
 	for (; col < txtrow->length; ++col) {
-		txtchar = txtrow->string[col];
-		if (!txtchar->bitmap) {
+		/* 进入下一个样式段 */
+		if (col >= run_end) {
+			++run;
+			run_end = TextRow_GetStyleRunEnd(txtrow, run);
+			style = txtrow->styles[run].style;
+		}
+		bitmap = txtrow->bitmaps[col];
+		if (!bitmap) {
 			continue;
 		}
 		/* 计算字体位图的绘制坐标 */
 		ch_pos.x = layer_pos.x + x;
 		ch_pos.y = layer_pos.y + y;
-		if (txtchar->style && txtchar->style->has_back_color) {
+		if (style && style->has_back_color) {
 			LCUI_Rect rect;
+			/* 背景色会覆盖前面的文字，需要先绘制它们 */
+			GlyphBatch_Flush(&batch, graph);
 			rect.x = ch_pos.x;
 			rect.y = ch_pos.y;
 			rect.height = txtrow->height;
-			rect.width = txtchar->bitmap->advance.x;
-			Graph_FillRect(graph, txtchar->style->back_color, &rect,
-				       TRUE);
+			rect.width = bitmap->advance.x;
+			Graph_FillRect(graph, style->back_color, &rect, TRUE);
 		}
-		ch_pos.x += txtchar->bitmap->left;
+		ch_pos.x += bitmap->left;
 		ch_pos.y += baseline;
 		ch_pos.y += (txtrow->height - baseline) / 2;
-		ch_pos.y -= txtchar->bitmap->top;
-		TextLayer_DrawChar(layer, txtchar, graph, ch_pos);
-		x += txtchar->bitmap->advance.x;
+		ch_pos.y -= bitmap->top;
+		TextLayer_DrawChar(layer, bitmap, style, graph, ch_pos,
+				   &batch);
+		x += bitmap->advance.x;
 		/* 如果超过绘制区域则不继续绘制该行文本 */
 		if (x > area->x + area->width) {
 			break;
 		}
 	}
+	GlyphBatch_Flush(&batch, graph);
 }
 
 int TextLayer_RenderTo(LCUI_TextLayer layer, LCUI_Rect area, LCUI_Pos layer_pos,
@@ -1316,17 +1899,12 @@ int TextLayer_RenderTo(LCUI_TextLayer layer, LCUI_Rect area, LCUI_Pos layer_pos,
 	int y, row;
 	LCUI_TextRow txtrow;
 
-	y = layer->offset_y;
 	/* 确定可绘制的最大区域范围 */
 	TextLayer_ValidateArea(layer, &area);
-	for (row = 0; row < layer->text_rows.length; ++row) {
-		txtrow = TextLayer_GetRow(layer, row);
-		y += txtrow->height;
-		if (y > area.y) {
-			y -= txtrow->height;
-			break;
-		}
-	}
+	/* 找到底边在绘制区域内的第一行 */
+	row = TextRowList_FindRow(&layer->text_rows,
+				  area.y - layer->offset_y + 1);
+	y = layer->offset_y + TextRowList_GetRowY(&layer->text_rows, row);
 	/* 如果没有可绘制的文本行 */
 	if (row >= layer->text_rows.length) {
 		return -1;
@@ -1362,16 +1940,14 @@ void TextLayer_SetTextStyle(LCUI_TextLayer layer, LCUI_TextStyle style)
 void TextLayer_SetTextAlign(LCUI_TextLayer layer, int align)
 {
 	layer->text_align = align;
-	layer->task.update_typeset = TRUE;
-	layer->task.typeset_start_row = 0;
+	TextLayer_AddUpdateTypeset(layer, 0);
 }
 
 /** 设置文本行的高度 */
 void TextLayer_SetLineHeight(LCUI_TextLayer layer, int height)
 {
 	layer->line_height = height;
-	layer->task.update_typeset = TRUE;
-	layer->task.typeset_start_row = 0;
+	TextLayer_AddUpdateTypeset(layer, 0);
 }
 
 LCUI_BOOL TextLayer_SetOffset(LCUI_TextLayer layer, int offset_x, int offset_y)
@@ -36,6 +36,7 @@
 #include <LCUI/types.h>
 #include <LCUI/util.h>
 #include <LCUI/graph.h>
+#include "graph_mixer.h"
 
 void Graph_PrintInfo(LCUI_Graph *graph)
 {
@@ -70,6 +71,7 @@ void Graph_Init(LCUI_Graph *graph)
 	graph->height = 0;
 	graph->bytes_per_pixel = 3;
 	graph->bytes_per_row = 0;
+	graph->is_scratch = FALSE;
 }
 
 LCUI_Color RGB(uchar_t r, uchar_t g, uchar_t b)
@@ -106,6 +108,7 @@ static unsigned get_pixel_size(int color_type)
 	case LCUI_COLOR_TYPE_RGB888:
 		return 3;
 	case LCUI_COLOR_TYPE_ARGB8888:
+	case LCUI_COLOR_TYPE_PARGB8888:
 	default:
 		break;
 	}
@@ -132,7 +135,7 @@ static void PixelsFormatRGB(const uchar_t *in_pixels, uchar_t *out_pixels,
 		p_out_px = (LCUI_ARGB8888 *)(((uchar_t *)p_out_px) + 3);
 	}
 	/* 最后一个像素，以逐个字节的形式写数据 */
-	p_out_byte = (uchar_t *)(p_out_px + 1);
+	p_out_byte = (uchar_t *)p_out_px;
 	*p_out_byte++ = p_px->blue;
 	*p_out_byte++ = p_px->green;
 	*p_out_byte++ = p_px->red;
@@ -386,7 +389,10 @@ static int Graph_ARGBToRGB(LCUI_Graph *graph)
 		byte_row_des += graph->bytes_per_row;
 		px_row_src += graph->width;
 	}
-	free(graph->argb);
+	if (!graph->is_scratch) {
+		free(graph->argb);
+	}
+	graph->is_scratch = FALSE;
 	graph->bytes = buffer;
 	graph->color_type = LCUI_COLOR_TYPE_RGB888;
 	graph->bytes_per_pixel = 3;
@@ -416,72 +422,18 @@ static int Graph_CutARGB(const LCUI_Graph *graph, LCUI_Rect rect,
 	return 0;
 }
 
-/* FIXME: improve alpha blending method
- * Existing alpha blending methods are inefficient and need to be optimized
- */
-
 static void Graph_MixARGBWithAlpha(LCUI_Graph *dst, LCUI_Rect des_rect,
 				   const LCUI_Graph *src, int src_x, int src_y)
 {
-	int x, y;
-	LCUI_ARGB *px_src, *px_dst;
+	int y;
 	LCUI_ARGB *px_row_src, *px_row_des;
-	double a, out_a, out_r, out_g, out_b, src_a;
+	const LCUI_PixelMixerRec *mixer = PixelMixer_Get();
+
 	px_row_src = src->argb + src_y * src->width + src_x;
 	px_row_des = dst->argb + des_rect.y * dst->width + des_rect.x;
-	if (src->opacity < 1.0) {
-		goto mix_with_opacity;
-	}
 	for (y = 0; y < des_rect.height; ++y) {
-		px_src = px_row_src;
-		px_dst = px_row_des;
-		for (x = 0; x < des_rect.width; ++x) {
-			src_a = px_src->a / 255.0;
-			a = (1.0 - src_a) * px_dst->a / 255.0;
-			out_r = px_dst->r * a + px_src->r * src_a;
-			out_g = px_dst->g * a + px_src->g * src_a;
-			out_b = px_dst->b * a + px_src->b * src_a;
-			out_a = src_a + a;
-			if (out_a > 0) {
-				out_r /= out_a;
-				out_g /= out_a;
-				out_b /= out_a;
-			}
-			px_dst->r = (uchar_t)(out_r + 0.5);
-			px_dst->g = (uchar_t)(out_g + 0.5);
-			px_dst->b = (uchar_t)(out_b + 0.5);
-			px_dst->a = (uchar_t)(255.0 * out_a + 0.5);
-			++px_src;
-			++px_dst;
-		}
-		px_row_des += dst->width;
-		px_row_src += src->width;
-	}
-	return;
-
-mix_with_opacity:
-	for (y = 0; y < des_rect.height; ++y) {
-		px_src = px_row_src;
-		px_dst = px_row_des;
-		for (x = 0; x < des_rect.width; ++x) {
-			src_a = px_src->a / 255.0 * src->opacity;
-			a = (1.0 - src_a) * px_dst->a / 255.0;
-			out_r = px_dst->r * a + px_src->r * src_a;
-			out_g = px_dst->g * a + px_src->g * src_a;
-			out_b = px_dst->b * a + px_src->b * src_a;
-			out_a = src_a + a;
-			if (out_a > 0) {
-				out_r /= out_a;
-				out_g /= out_a;
-				out_b /= out_a;
-			}
-			px_dst->r = (uchar_t)(out_r + 0.5);
-			px_dst->g = (uchar_t)(out_g + 0.5);
-			px_dst->b = (uchar_t)(out_b + 0.5);
-			px_dst->a = (uchar_t)(255.0 * out_a + 0.5);
-			++px_src;
-			++px_dst;
-		}
+		mixer->over_argb(px_row_des, px_row_src, des_rect.width,
+				 src->opacity);
 		px_row_des += dst->width;
 		px_row_src += src->width;
 	}
@@ -490,38 +442,15 @@ mix_with_opacity:
 static void Graph_MixARGB(LCUI_Graph *dest, LCUI_Rect des_rect,
 			  const LCUI_Graph *src, int src_x, int src_y)
 {
-	int x, y;
-	uchar_t a;
-	LCUI_ARGB *px_src, *px_dest;
+	int y;
 	LCUI_ARGB *px_row_src, *px_row_des;
+	const LCUI_PixelMixerRec *mixer = PixelMixer_Get();
+
 	px_row_src = src->argb + src_y * src->width + src_x;
 	px_row_des = dest->argb + des_rect.y * dest->width + des_rect.x;
-	if (src->opacity < 1.0) {
-		goto mix_with_opacity;
-	}
-	for (y = 0; y < des_rect.height; ++y) {
-		px_src = px_row_src;
-		px_dest = px_row_des;
-		for (x = 0; x < des_rect.width; ++x) {
-			PIXEL_BLEND(px_dest, px_src, px_src->a);
-			++px_src;
-			++px_dest;
-		}
-		px_row_des += dest->width;
-		px_row_src += src->width;
-	}
-	return;
-
-mix_with_opacity:
 	for (y = 0; y < des_rect.height; ++y) {
-		px_src = px_row_src;
-		px_dest = px_row_des;
-		for (x = 0; x < des_rect.width; ++x) {
-			a = (uchar_t)(px_src->a * src->opacity);
-			PIXEL_BLEND(px_dest, px_src, a);
-			++px_src;
-			++px_dest;
-		}
+		mixer->mix_argb(px_row_des, px_row_src, des_rect.width,
+				src->opacity);
 		px_row_des += dest->width;
 		px_row_src += src->width;
 	}
@@ -530,47 +459,18 @@ mix_with_opacity:
 static void Graph_MixARGBToRGB(LCUI_Graph *des, LCUI_Rect des_rect,
 			       const LCUI_Graph *src, int src_x, int src_y)
 {
-	int x, y;
-	uchar_t a;
-	LCUI_ARGB *px, *px_row;
-	uchar_t *rowbytep, *bytep;
+	int y;
+	LCUI_ARGB *px_row;
+	uchar_t *rowbytep;
+	const LCUI_PixelMixerRec *mixer = PixelMixer_Get();
 
 	/* 计算并保存第一行的首个像素的位置 */
 	px_row = src->argb + src_y * src->width + src_x;
 	rowbytep = des->bytes + des_rect.y * des->bytes_per_row;
 	rowbytep += des_rect.x * des->bytes_per_pixel;
-	if (src->opacity < 1.0) {
-		goto mix_with_opacity;
-	}
 	for (y = 0; y < des_rect.height; ++y) {
-		px = px_row;
-		bytep = rowbytep;
-		for (x = 0; x < des_rect.width; ++x, ++px) {
-			*bytep = _ALPHA_BLEND(*bytep, px->b, px->a);
-			++bytep;
-			*bytep = _ALPHA_BLEND(*bytep, px->g, px->a);
-			++bytep;
-			*bytep = _ALPHA_BLEND(*bytep, px->r, px->a);
-			++bytep;
-		}
-		rowbytep += des->bytes_per_row;
-		px_row += src->width;
-	}
-	return;
-
-mix_with_opacity:
-	for (y = 0; y < des_rect.height; ++y) {
-		px = px_row;
-		bytep = rowbytep;
-		for (x = 0; x < des_rect.width; ++x, ++px) {
-			a = (uchar_t)(px->a * src->opacity);
-			*bytep = _ALPHA_BLEND(*bytep, px->b, a);
-			++bytep;
-			*bytep = _ALPHA_BLEND(*bytep, px->g, a);
-			++bytep;
-			*bytep = _ALPHA_BLEND(*bytep, px->r, a);
-			++bytep;
-		}
+		mixer->mix_argb_to_rgb(rowbytep, px_row, des_rect.width,
+				       src->opacity);
 		rowbytep += des->bytes_per_row;
 		px_row += src->width;
 	}
@@ -707,6 +607,256 @@ static uchar_t Graph_BilinearResamplingCore(uchar_t a, uchar_t b, uchar_t c,
 
 /*-------------------------------- End ARGB --------------------------------*/
 
+/*---------------------------------- PARGB ---------------------------------*/
+
+typedef void (*RowMixerPtr)(LCUI_ARGB *, const LCUI_ARGB *, size_t, float);
+
+/** number of pixels which are unpremultiplied into a stack buffer at once */
+#define UNPREMULTIPLY_CHUNK_SIZE 256
+
+/**
+ * ceil(255 * 65536 / a), (c * table[a] + 32768) >> 16 is the same as
+ * (c * 255 + a / 2) / a for every c and a, but without a division
+ */
+static const unsigned unpremultiply_table[256] = {
+	0, 16711680, 8355840, 5570560, 4177920, 3342336, 2785280,
+	2387383, 2088960, 1856854, 1671168, 1519244, 1392640, 1285514,
+	1193692, 1114112, 1044480, 983040, 928427, 879563, 835584,
+	795795, 759622, 726595, 696320, 668468, 642757, 618952,
+	596846, 576265, 557056, 539087, 522240, 506415, 491520,
+	477477, 464214, 451668, 439782, 428505, 417792, 407602,
+	397898, 388644, 379811, 371371, 363298, 355568, 348160,
+	341055, 334234, 327680, 321379, 315315, 309476, 303849,
+	298423, 293188, 288133, 283249, 278528, 273962, 269544,
+	265265, 261120, 257103, 253208, 249429, 245760, 242199,
+	238739, 235376, 232107, 228928, 225834, 222823, 219891,
+	217035, 214253, 211541, 208896, 206318, 203801, 201346,
+	198949, 196608, 194322, 192089, 189906, 187772, 185686,
+	183645, 181649, 179696, 177784, 175913, 174080, 172286,
+	170528, 168805, 167117, 165463, 163840, 162250, 160690,
+	159159, 157658, 156184, 154738, 153319, 151925, 150556,
+	149212, 147891, 146594, 145319, 144067, 142835, 141625,
+	140435, 139264, 138114, 136981, 135868, 134772, 133694,
+	132633, 131589, 130560, 129548, 128552, 127571, 126604,
+	125652, 124715, 123791, 122880, 121984, 121100, 120228,
+	119370, 118523, 117688, 116865, 116054, 115253, 114464,
+	113685, 112917, 112159, 111412, 110674, 109946, 109227,
+	108518, 107818, 107127, 106444, 105771, 105105, 104448,
+	103800, 103159, 102526, 101901, 101283, 100673, 100070,
+	99475, 98886, 98304, 97730, 97161, 96600, 96045,
+	95496, 94953, 94417, 93886, 93362, 92843, 92330,
+	91823, 91321, 90825, 90334, 89848, 89368, 88892,
+	88422, 87957, 87496, 87040, 86590, 86143, 85701,
+	85264, 84831, 84403, 83979, 83559, 83143, 82732,
+	82324, 81920, 81521, 81125, 80733, 80345, 79961,
+	79580, 79203, 78829, 78459, 78092, 77729, 77369,
+	77013, 76660, 76310, 75963, 75619, 75278, 74941,
+	74606, 74275, 73946, 73620, 73297, 72977, 72660,
+	72345, 72034, 71724, 71418, 71114, 70813, 70514,
+	70218, 69924, 69632, 69344, 69057, 68773, 68491,
+	68211, 67934, 67659, 67386, 67116, 66847, 66581,
+	66317, 66055, 65795, 65536
+};
+
+static void PixelsPremultiply(LCUI_ARGB *px, size_t n)
+{
+	LCUI_ARGB *end = px + n;
+
+	for (; px < end; ++px) {
+		px->r = (uchar_t)((px->r * px->a + 127) / 255);
+		px->g = (uchar_t)((px->g * px->a + 127) / 255);
+		px->b = (uchar_t)((px->b * px->a + 127) / 255);
+	}
+}
+
+static void PixelsUnpremultiply(LCUI_ARGB *dst, const LCUI_ARGB *src,
+				size_t n)
+{
+	unsigned a, k;
+	const LCUI_ARGB *end = src + n;
+
+	for (; src < end; ++src, ++dst) {
+		a = src->a;
+		if (a == 0) {
+			dst->value = 0;
+			continue;
+		}
+		k = unpremultiply_table[a];
+		dst->r = (uchar_t)min(255, (src->r * k + 32768) >> 16);
+		dst->g = (uchar_t)min(255, (src->g * k + 32768) >> 16);
+		dst->b = (uchar_t)min(255, (src->b * k + 32768) >> 16);
+		dst->a = (uchar_t)a;
+	}
+}
+
+static void Graph_MixRows(LCUI_Graph *dst, LCUI_Rect des_rect,
+			  const LCUI_Graph *src, int src_x, int src_y,
+			  RowMixerPtr mix)
+{
+	int y;
+	LCUI_ARGB *px_row_src, *px_row_des;
+
+	px_row_src = src->argb + src_y * src->width + src_x;
+	px_row_des = dst->argb + des_rect.y * dst->width + des_rect.x;
+	for (y = 0; y < des_rect.height; ++y) {
+		mix(px_row_des, px_row_src, des_rect.width, src->opacity);
+		px_row_des += dst->width;
+		px_row_src += src->width;
+	}
+}
+
+static void Graph_MixPARGB(LCUI_Graph *dst, LCUI_Rect des_rect,
+			   const LCUI_Graph *src, int src_x, int src_y)
+{
+	Graph_MixRows(dst, des_rect, src, src_x, src_y,
+		      PixelMixer_Get()->mix_pargb);
+}
+
+static void Graph_MixPARGBWithAlpha(LCUI_Graph *dst, LCUI_Rect des_rect,
+				    const LCUI_Graph *src, int src_x,
+				    int src_y)
+{
+	Graph_MixRows(dst, des_rect, src, src_x, src_y,
+		      PixelMixer_Get()->over_pargb);
+}
+
+static void Graph_MixARGBToPARGB(LCUI_Graph *dst, LCUI_Rect des_rect,
+				 const LCUI_Graph *src, int src_x, int src_y)
+{
+	Graph_MixRows(dst, des_rect, src, src_x, src_y,
+		      PixelMixer_Get()->over_argb_to_pargb);
+}
+
+/**
+ * Mix a premultiplied graph into a straight graph with the source-over
+ * operator. The result is straight, so this is the only case that has to
+ * unpremultiply the source pixels.
+ */
+static void Graph_MixPARGBToARGBWithAlpha(LCUI_Graph *dst, LCUI_Rect des_rect,
+					  const LCUI_Graph *src, int src_x,
+					  int src_y)
+{
+	int x, y, n;
+	LCUI_ARGB buffer[UNPREMULTIPLY_CHUNK_SIZE];
+	LCUI_ARGB *px_row_src, *px_row_des;
+	const LCUI_PixelMixerRec *mixer = PixelMixer_Get();
+
+	px_row_src = src->argb + src_y * src->width + src_x;
+	px_row_des = dst->argb + des_rect.y * dst->width + des_rect.x;
+	for (y = 0; y < des_rect.height; ++y) {
+		for (x = 0; x < des_rect.width; x += n) {
+			n = min(des_rect.width - x, UNPREMULTIPLY_CHUNK_SIZE);
+			PixelsUnpremultiply(buffer, px_row_src + x, n);
+			mixer->over_argb(px_row_des + x, buffer, n,
+					 src->opacity);
+		}
+		px_row_des += dst->width;
+		px_row_src += src->width;
+	}
+}
+
+static void Graph_MixPARGBToRGB(LCUI_Graph *des, LCUI_Rect des_rect,
+				const LCUI_Graph *src, int src_x, int src_y)
+{
+	int y;
+	LCUI_ARGB *px_row;
+	uchar_t *rowbytep;
+	const LCUI_PixelMixerRec *mixer = PixelMixer_Get();
+
+	px_row = src->argb + src_y * src->width + src_x;
+	rowbytep = des->bytes + des_rect.y * des->bytes_per_row;
+	rowbytep += des_rect.x * des->bytes_per_pixel;
+	for (y = 0; y < des_rect.height; ++y) {
+		mixer->mix_pargb_to_rgb(rowbytep, px_row, des_rect.width,
+					src->opacity);
+		rowbytep += des->bytes_per_row;
+		px_row += src->width;
+	}
+}
+
+/**
+ * Replace pixels of a premultiplied graph, the source pixels will be
+ * premultiplied if the source graph is straight.
+ */
+static void Graph_ReplaceToPARGB(LCUI_Graph *des, LCUI_Rect des_rect,
+				 const LCUI_Graph *src, int src_x, int src_y)
+{
+	int y;
+	LCUI_ARGB *px_row_src, *px_row_des;
+	const LCUI_PixelMixerRec *mixer = PixelMixer_Get();
+	RowMixerPtr mix = mixer->over_argb_to_pargb;
+
+	if (src->color_type == LCUI_COLOR_TYPE_PARGB) {
+		if (src->opacity >= 1.0f) {
+			Graph_ReplaceARGB(des, des_rect, src, src_x, src_y);
+			return;
+		}
+		mix = mixer->over_pargb;
+	}
+	/* mixing into transparent pixels is the same as scaling the source */
+	px_row_src = src->argb + src_y * src->width + src_x;
+	px_row_des = des->argb + des_rect.y * des->width + des_rect.x;
+	for (y = 0; y < des_rect.height; ++y) {
+		memset(px_row_des, 0, sizeof(LCUI_ARGB) * des_rect.width);
+		mix(px_row_des, px_row_src, des_rect.width, src->opacity);
+		px_row_des += des->width;
+		px_row_src += src->width;
+	}
+}
+
+static void Graph_ReplacePARGBToARGB(LCUI_Graph *des, LCUI_Rect des_rect,
+				     const LCUI_Graph *src, int src_x,
+				     int src_y)
+{
+	int x, y;
+	LCUI_ARGB *px_row_src, *px_row_des;
+
+	px_row_src = src->argb + src_y * src->width + src_x;
+	px_row_des = des->argb + des_rect.y * des->width + des_rect.x;
+	for (y = 0; y < des_rect.height; ++y) {
+		PixelsUnpremultiply(px_row_des, px_row_src, des_rect.width);
+		if (src->opacity < 1.0f) {
+			for (x = 0; x < des_rect.width; ++x) {
+				px_row_des[x].a =
+				    (uchar_t)(src->opacity * px_row_des[x].a);
+			}
+		}
+		px_row_des += des->width;
+		px_row_src += src->width;
+	}
+}
+
+/**
+ * Replace pixels of a RGB graph, the source pixels are unpremultiplied and
+ * their alpha is dropped, as replacing with a straight graph does.
+ */
+static void Graph_ReplacePARGBToRGB(LCUI_Graph *des, LCUI_Rect des_rect,
+				    const LCUI_Graph *src, int src_x,
+				    int src_y)
+{
+	int x, y, n;
+	LCUI_ARGB buffer[UNPREMULTIPLY_CHUNK_SIZE];
+	LCUI_ARGB *px_row_src;
+	uchar_t *byte_row_des;
+
+	px_row_src = src->argb + src_y * src->width + src_x;
+	byte_row_des = des->bytes + des_rect.y * des->bytes_per_row;
+	byte_row_des += des_rect.x * des->bytes_per_pixel;
+	for (y = 0; y < des_rect.height; ++y) {
+		for (x = 0; x < des_rect.width; x += n) {
+			n = min(des_rect.width - x, UNPREMULTIPLY_CHUNK_SIZE);
+			PixelsUnpremultiply(buffer, px_row_src + x, n);
+			PixelsFormat((uchar_t *)buffer, LCUI_COLOR_TYPE_ARGB,
+				     byte_row_des + x * des->bytes_per_pixel,
+				     des->color_type, n);
+		}
+		byte_row_des += des->bytes_per_row;
+		px_row_src += src->width;
+	}
+}
+
+/*-------------------------------- End PARGB -------------------------------*/
+
 int Graph_SetColorType(LCUI_Graph *graph, int color_type)
 {
 	if (graph->color_type == color_type) {
@@ -717,6 +867,22 @@ int Graph_SetColorType(LCUI_Graph *graph, int color_type)
 		switch (color_type) {
 		case LCUI_COLOR_TYPE_RGB888:
 			return Graph_ARGBToRGB(graph);
+		case LCUI_COLOR_TYPE_PARGB8888:
+			PixelsPremultiply(graph->argb,
+					  graph->width * graph->height);
+			graph->color_type = color_type;
+			return 0;
+		default:
+			break;
+		}
+		break;
+	case LCUI_COLOR_TYPE_PARGB8888:
+		switch (color_type) {
+		case LCUI_COLOR_TYPE_ARGB8888:
+			PixelsUnpremultiply(graph->argb, graph->argb,
+					    graph->width * graph->height);
+			graph->color_type = color_type;
+			return 0;
 		default:
 			break;
 		}
@@ -771,6 +937,48 @@ int Graph_Create(LCUI_Graph *graph, unsigned width, unsigned height)
 	return 0;
 }
 
+int Graph_CreateScratch(LCUI_Graph *graph, unsigned width, unsigned height)
+{
+	size_t size;
+	LCUI_Arena arena = LCUIFrameArena_Get();
+
+	if (!arena) {
+		return Graph_Create(graph, width, height);
+	}
+	if (width > 10000 || height > 10000) {
+		Logger_Error("graph size is too large!");
+		abort();
+	}
+	if (width < 1 || height < 1) {
+		Graph_Free(graph);
+		return -1;
+	}
+	graph->bytes_per_pixel = get_pixel_size(graph->color_type);
+	graph->bytes_per_row = graph->bytes_per_pixel * width;
+	size = graph->bytes_per_row * height;
+	if (Graph_IsValid(graph)) {
+		if (graph->mem_size >= size) {
+			memset(graph->bytes, 0, graph->mem_size);
+			graph->width = width;
+			graph->height = height;
+			return 0;
+		}
+		Graph_Free(graph);
+	}
+	graph->bytes = Arena_Alloc(arena, size);
+	if (!graph->bytes) {
+		graph->width = 0;
+		graph->height = 0;
+		return -2;
+	}
+	memset(graph->bytes, 0, size);
+	graph->is_scratch = TRUE;
+	graph->mem_size = size;
+	graph->width = width;
+	graph->height = height;
+	return 0;
+}
+
 LCUI_BOOL Graph_IsValid(const LCUI_Graph *graph)
 {
 	if (graph->quote.is_valid) {
@@ -803,8 +1011,12 @@ void Graph_Free(LCUI_Graph *graph)
 		return;
 	}
 	if (graph->bytes) {
-		free(graph->bytes);
+		/* scratch memory is reclaimed when the frame arena is reset */
+		if (!graph->is_scratch) {
+			free(graph->bytes);
+		}
 		graph->bytes = NULL;
+		graph->is_scratch = FALSE;
 	}
 	graph->width = 0;
 	graph->height = 0;
@@ -996,7 +1208,7 @@ int Graph_Zoom(const LCUI_Graph *graph, LCUI_Graph *buff, LCUI_BOOL keep_scale,
 	if (Graph_Create(buff, width, height) < 0) {
 		return -2;
 	}
-	if (graph->color_type == LCUI_COLOR_TYPE_ARGB) {
+	if (LCUI_IsARGBColorType(graph->color_type)) {
 		LCUI_ARGB *px_src, *px_des, *px_row_src;
 		for (y = 0; y < height; ++y) {
 			src_y = (int)(y * scale_y);
@@ -1036,12 +1248,12 @@ int Graph_ZoomBilinear(const LCUI_Graph *graph, LCUI_Graph *buff,
 	LCUI_Rect rect;
 	LCUI_ARGB a, b, c, d, t_color;
 
-	int x, y, i, j;
+	int x, y, x1, y1, i, j;
 	float x_diff, y_diff;
 	double scale_x = 0.0, scale_y = 0.0;
 
 	if (graph->color_type != LCUI_COLOR_TYPE_RGB &&
-	    graph->color_type != LCUI_COLOR_TYPE_ARGB) {
+	    !LCUI_IsARGBColorType(graph->color_type)) {
 		/* fall back to nearest scaling */
 		Logger_Debug("[graph] unable to perform bilinear scaling, "
 			     "fallback...\n");
@@ -1094,14 +1306,13 @@ int Graph_ZoomBilinear(const LCUI_Graph *graph, LCUI_Graph *buff,
 			y = (int)(scale_y * i);
 			x_diff = (float)((scale_x * j) - x);
 			y_diff = (float)((scale_y * i) - y);
-			Graph_GetPixel(graph, x + rect.x + 0, y + rect.y + 0,
-				       a);
-			Graph_GetPixel(graph, x + rect.x + 1, y + rect.y + 0,
-				       b);
-			Graph_GetPixel(graph, x + rect.x + 0, y + rect.y + 1,
-				       c);
-			Graph_GetPixel(graph, x + rect.x + 1, y + rect.y + 1,
-				       d);
+			/* 边缘的像素不与另一侧的像素混合 */
+			x1 = x + 1 < rect.width ? x + 1 : x;
+			y1 = y + 1 < rect.height ? y + 1 : y;
+			Graph_GetPixel(graph, x + rect.x, y + rect.y, a);
+			Graph_GetPixel(graph, x1 + rect.x, y + rect.y, b);
+			Graph_GetPixel(graph, x + rect.x, y1 + rect.y, c);
+			Graph_GetPixel(graph, x1 + rect.x, y1 + rect.y, d);
 			t_color.b = Graph_BilinearResamplingCore(
 			    a.b, b.b, c.b, d.b, x_diff, y_diff);
 			t_color.g = Graph_BilinearResamplingCore(
@@ -1116,6 +1327,89 @@ int Graph_ZoomBilinear(const LCUI_Graph *graph, LCUI_Graph *buff,
 	return 0;
 }
 
+/** 将图像缩小为原来的一半，每个像素取 2x2 区域的平均值 */
+static int Graph_ShrinkByHalf(const LCUI_Graph *graph, LCUI_Graph *buff)
+{
+	int x, y, i, bpp, sum;
+	const uchar_t *row1, *row2;
+	uchar_t *byte_des;
+	LCUI_Rect rect;
+
+	Graph_GetValidRect(graph, &rect);
+	graph = Graph_GetQuote(graph);
+	bpp = graph->bytes_per_pixel;
+	buff->color_type = graph->color_type;
+	if (Graph_Create(buff, rect.width / 2, rect.height / 2) < 0) {
+		return -2;
+	}
+	for (y = 0; y < buff->height; ++y) {
+		row1 = graph->bytes + (rect.y + y * 2) * graph->bytes_per_row;
+		row1 += rect.x * bpp;
+		row2 = row1 + graph->bytes_per_row;
+		byte_des = buff->bytes + y * buff->bytes_per_row;
+		for (x = 0; x < buff->width; ++x) {
+			for (i = 0; i < bpp; ++i) {
+				sum = row1[i] + row1[i + bpp];
+				sum += row2[i] + row2[i + bpp];
+				*byte_des++ = (uchar_t)((sum + 2) >> 2);
+			}
+			row1 += bpp * 2;
+			row2 += bpp * 2;
+		}
+	}
+	return 0;
+}
+
+int Graph_ZoomMipmap(const LCUI_Graph *graph, LCUI_Graph *buff,
+		     LCUI_BOOL keep_scale, int width, int height)
+{
+	int ret;
+	LCUI_Rect rect;
+	LCUI_Graph level, next;
+	const LCUI_Graph *src = graph;
+	double scale_x = 0.0, scale_y = 0.0;
+
+	if (!Graph_IsValid(graph) || (width <= 0 && height <= 0)) {
+		return -1;
+	}
+	Graph_GetValidRect(graph, &rect);
+	if (width > 0) {
+		scale_x = 1.0 * rect.width / width;
+	}
+	if (height > 0) {
+		scale_y = 1.0 * rect.height / height;
+	}
+	if (width <= 0) {
+		scale_x = scale_y;
+	}
+	if (height <= 0) {
+		scale_y = scale_x;
+	}
+	if (keep_scale) {
+		if (scale_x < scale_y) {
+			scale_y = scale_x;
+		} else {
+			scale_x = scale_y;
+		}
+	}
+	Graph_Init(&level);
+	/* 先逐级缩小一半，直到与目标尺寸相差不到两倍，再进行双线性插值 */
+	while (scale_x >= 2.0 && scale_y >= 2.0) {
+		Graph_Init(&next);
+		if (Graph_ShrinkByHalf(src, &next) != 0) {
+			break;
+		}
+		Graph_Free(&level);
+		level = next;
+		src = &level;
+		scale_x /= 2.0;
+		scale_y /= 2.0;
+	}
+	ret = Graph_ZoomBilinear(src, buff, keep_scale, width, height);
+	Graph_Free(&level);
+	return ret;
+}
+
 int Graph_Cut(const LCUI_Graph *graph, LCUI_Rect rect, LCUI_Graph *buff)
 {
 	if (!Graph_IsValid(graph)) {
@@ -1127,6 +1421,7 @@ int Graph_Cut(const LCUI_Graph *graph, LCUI_Rect rect, LCUI_Graph *buff)
 	}
 	switch (graph->color_type) {
 	case LCUI_COLOR_TYPE_ARGB8888:
+	case LCUI_COLOR_TYPE_PARGB8888:
 		return Graph_CutARGB(graph, rect, buff);
 	case LCUI_COLOR_TYPE_RGB888:
 		return Graph_CutRGB(graph, rect, buff);
@@ -1142,6 +1437,7 @@ int Graph_HorizFlip(const LCUI_Graph *graph, LCUI_Graph *buff)
 	case LCUI_COLOR_TYPE_RGB888:
 		return Graph_HorizFlipRGB(graph, buff);
 	case LCUI_COLOR_TYPE_ARGB8888:
+	case LCUI_COLOR_TYPE_PARGB8888:
 		return Graph_HorizFlipARGB(graph, buff);
 	default:
 		break;
@@ -1155,6 +1451,7 @@ int Graph_VertiFlip(const LCUI_Graph *graph, LCUI_Graph *buff)
 	case LCUI_COLOR_TYPE_RGB888:
 		return Graph_VertiFlipRGB(graph, buff);
 	case LCUI_COLOR_TYPE_ARGB8888:
+	case LCUI_COLOR_TYPE_PARGB8888:
 		return Graph_VertiFlipARGB(graph, buff);
 	default:
 		break;
@@ -1178,6 +1475,9 @@ int Graph_FillRect(LCUI_Graph *graph, LCUI_Color color, LCUI_Rect *rect,
 		return Graph_FillRectRGB(graph, color, rect2);
 	case LCUI_COLOR_TYPE_ARGB8888:
 		return Graph_FillRectARGB(graph, color, rect2, with_alpha);
+	case LCUI_COLOR_TYPE_PARGB8888:
+		PixelsPremultiply(&color, 1);
+		return Graph_FillRectARGB(graph, color, rect2, TRUE);
 	default:
 		break;
 	}
@@ -1276,6 +1576,8 @@ int Graph_Mix(LCUI_Graph *back, const LCUI_Graph *fore, int left, int top,
 	case LCUI_COLOR_TYPE_ARGB8888:
 		if (back->color_type == LCUI_COLOR_TYPE_RGB888) {
 			mixer = Graph_MixARGBToRGB;
+		} else if (back->color_type == LCUI_COLOR_TYPE_PARGB8888) {
+			mixer = Graph_MixARGBToPARGB;
 		} else {
 			if (with_alpha) {
 				mixer = Graph_MixARGBWithAlpha;
@@ -1283,6 +1585,20 @@ int Graph_Mix(LCUI_Graph *back, const LCUI_Graph *fore, int left, int top,
 				mixer = Graph_MixARGB;
 			}
 		}
+		break;
+	case LCUI_COLOR_TYPE_PARGB8888:
+		if (back->color_type == LCUI_COLOR_TYPE_RGB888) {
+			mixer = Graph_MixPARGBToRGB;
+		} else if (back->color_type == LCUI_COLOR_TYPE_PARGB8888) {
+			mixer = Graph_MixPARGBWithAlpha;
+		} else {
+			if (with_alpha) {
+				mixer = Graph_MixPARGBToARGBWithAlpha;
+			} else {
+				mixer = Graph_MixPARGB;
+			}
+		}
+		break;
 	default:
 		break;
 	}
@@ -1321,7 +1637,23 @@ int Graph_Replace(LCUI_Graph *back, const LCUI_Graph *fore, int left, int top)
 		Graph_ReplaceRGB(back, write_rect, fore, left, top);
 		break;
 	case LCUI_COLOR_TYPE_ARGB8888:
+		if (back->color_type == LCUI_COLOR_TYPE_PARGB8888) {
+			Graph_ReplaceToPARGB(back, write_rect, fore, left, top);
+			break;
+		}
 		Graph_ReplaceARGB(back, write_rect, fore, left, top);
+		break;
+	case LCUI_COLOR_TYPE_PARGB8888:
+		if (back->color_type == LCUI_COLOR_TYPE_ARGB8888) {
+			Graph_ReplacePARGBToARGB(back, write_rect, fore, left,
+						 top);
+		} else if (back->color_type == LCUI_COLOR_TYPE_PARGB8888) {
+			Graph_ReplaceToPARGB(back, write_rect, fore, left, top);
+		} else {
+			Graph_ReplacePARGBToRGB(back, write_rect, fore, left,
+						top);
+		}
+		break;
 	default:
 		break;
 	}
@@ -0,0 +1,1480 @@
+/* graph_mixer.c -- pixel mixing kernels
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The scalar kernels are the reference implementation. The SIMD kernels must
+ * give the same result for mix_argb and mix_argb_to_rgb, and may differ by 1
+ * for over_argb, which is computed in single precision.
+ *
+ * PIXEL_BLEND() is computed in 16-bit lanes with the following identity:
+ *
+ *   ((f - b) * a >> 8) + b == (f * a + b * (256 - a)) >> 8
+ *
+ * the right side never exceeds 255 * 256, so it fits in an unsigned 16-bit
+ * lane and needs no sign handling.
+ *
+ * The premultiplied (PARGB) kernels use integers only and must give the same
+ * result on every instruction set. They never divide, x * y / 255 is rounded
+ * with:
+ *
+ *   t = x * y + 128, (t + (t >> 8)) >> 8
+ *
+ * which is exact for 8-bit inputs and also fits in a 16-bit lane. A source
+ * pixel with zero alpha never changes the background.
+ *
+ * The coverage mask kernels draw glyphs. They expand the mask into a short
+ * span of the solid color on the stack, then mix the span with the row
+ * kernels above, so their results are as exact as those kernels. The alpha
+ * of the span is mask * color.a / 255 rounded down, computed with:
+ *
+ *   (x + (x >> 8) + 1) >> 8
+ *
+ * which is exact for x <= 255 * 255.
+ *
+ * The AVX2 kernels mix the remaining pixels with the SSE2 kernels, or the
+ * scalar kernels if there is no SSE2 version, and they clear the upper
+ * halves of the YMM registers before it. The compiler does not always do it
+ * for functions with the target attribute, and the SSE code that runs after
+ * them becomes several times slower. It matters for short rows, such as the
+ * rows of glyphs.
+ */
+
+#include <LCUI_Build.h>
+#include <LCUI/types.h>
+#include <LCUI/util.h>
+#include <LCUI/graph.h>
+#include "graph_mixer.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#define MIXER_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define MIXER_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+static const LCUI_PixelMixerRec *current_mixer = NULL;
+
+/*--------------------------------- Scalar ---------------------------------*/
+
+static void PixelMixer_MixARGB(LCUI_ARGB *dst, const LCUI_ARGB *src, size_t n,
+			       float opacity)
+{
+	uchar_t a;
+	const LCUI_ARGB *end = src + n;
+
+	if (opacity < 1.0f) {
+		for (; src < end; ++src, ++dst) {
+			a = (uchar_t)(src->a * opacity);
+			PIXEL_BLEND(dst, src, a);
+		}
+		return;
+	}
+	for (; src < end; ++src, ++dst) {
+		PIXEL_BLEND(dst, src, src->a);
+	}
+}
+
+static void PixelMixer_OverARGB(LCUI_ARGB *dst, const LCUI_ARGB *src,
+				size_t n, float opacity)
+{
+	double a, out_a, out_r, out_g, out_b, src_a;
+	const LCUI_ARGB *end = src + n;
+
+	for (; src < end; ++src, ++dst) {
+		/* the same as the fast paths of the SIMD kernels */
+		if (src->a == 0) {
+			continue;
+		}
+		if (src->a == 255 && opacity >= 1.0f) {
+			*dst = *src;
+			continue;
+		}
+		src_a = src->a / 255.0;
+		if (opacity < 1.0f) {
+			src_a *= opacity;
+		}
+		a = (1.0 - src_a) * dst->a / 255.0;
+		out_r = dst->r * a + src->r * src_a;
+		out_g = dst->g * a + src->g * src_a;
+		out_b = dst->b * a + src->b * src_a;
+		out_a = src_a + a;
+		if (out_a > 0) {
+			out_r /= out_a;
+			out_g /= out_a;
+			out_b /= out_a;
+		}
+		dst->r = (uchar_t)(out_r + 0.5);
+		dst->g = (uchar_t)(out_g + 0.5);
+		dst->b = (uchar_t)(out_b + 0.5);
+		dst->a = (uchar_t)(255.0 * out_a + 0.5);
+	}
+}
+
+static void PixelMixer_MixARGBToRGB(uchar_t *dst, const LCUI_ARGB *src,
+				    size_t n, float opacity)
+{
+	uchar_t a;
+	const LCUI_ARGB *end = src + n;
+
+	for (; src < end; ++src) {
+		a = src->a;
+		if (opacity < 1.0f) {
+			a = (uchar_t)(src->a * opacity);
+		}
+		*dst = _ALPHA_BLEND(*dst, src->b, a);
+		++dst;
+		*dst = _ALPHA_BLEND(*dst, src->g, a);
+		++dst;
+		*dst = _ALPHA_BLEND(*dst, src->r, a);
+		++dst;
+	}
+}
+
+INLINE int PixelMixer_OpacityToInt(float opacity)
+{
+	if (opacity >= 1.0f) {
+		return 255;
+	}
+	if (opacity <= 0.0f) {
+		return 0;
+	}
+	return (int)(opacity * 255.0f + 0.5f);
+}
+
+INLINE uchar_t PixelMixer_MulDiv255(int x, int y)
+{
+	int t = x * y + 128;
+	return (uchar_t)((t + (t >> 8)) >> 8);
+}
+
+/**
+ * Source-over operator for premultiplied pixels:
+ *   dst = src * opacity + dst * (1 - src.a * opacity)
+ * @param straight the source is straight ARGB and will be premultiplied
+ * @param keep_alpha the background is straight ARGB, keep its alpha
+ */
+INLINE void PixelMixer_OverPARGBRow(LCUI_ARGB *dst, const LCUI_ARGB *src,
+				    size_t n, int op, LCUI_BOOL straight,
+				    LCUI_BOOL keep_alpha)
+{
+	int a, ia;
+	const LCUI_ARGB *end = src + n;
+
+	for (; src < end; ++src, ++dst) {
+		if (src->a == 0) {
+			continue;
+		}
+		a = PixelMixer_MulDiv255(src->a, op);
+		ia = 255 - a;
+		if (straight) {
+			dst->r = min(255, PixelMixer_MulDiv255(src->r, a) +
+					      PixelMixer_MulDiv255(dst->r, ia));
+			dst->g = min(255, PixelMixer_MulDiv255(src->g, a) +
+					      PixelMixer_MulDiv255(dst->g, ia));
+			dst->b = min(255, PixelMixer_MulDiv255(src->b, a) +
+					      PixelMixer_MulDiv255(dst->b, ia));
+		} else {
+			dst->r = min(255, PixelMixer_MulDiv255(src->r, op) +
+					      PixelMixer_MulDiv255(dst->r, ia));
+			dst->g = min(255, PixelMixer_MulDiv255(src->g, op) +
+					      PixelMixer_MulDiv255(dst->g, ia));
+			dst->b = min(255, PixelMixer_MulDiv255(src->b, op) +
+					      PixelMixer_MulDiv255(dst->b, ia));
+		}
+		if (!keep_alpha) {
+			dst->a = min(255, a + PixelMixer_MulDiv255(dst->a, ia));
+		}
+	}
+}
+
+static void PixelMixer_OverPARGB(LCUI_ARGB *dst, const LCUI_ARGB *src,
+				 size_t n, float opacity)
+{
+	PixelMixer_OverPARGBRow(dst, src, n, PixelMixer_OpacityToInt(opacity),
+				FALSE, FALSE);
+}
+
+static void PixelMixer_MixPARGB(LCUI_ARGB *dst, const LCUI_ARGB *src,
+				size_t n, float opacity)
+{
+	PixelMixer_OverPARGBRow(dst, src, n, PixelMixer_OpacityToInt(opacity),
+				FALSE, TRUE);
+}
+
+static void PixelMixer_OverARGBToPARGB(LCUI_ARGB *dst, const LCUI_ARGB *src,
+				       size_t n, float opacity)
+{
+	PixelMixer_OverPARGBRow(dst, src, n, PixelMixer_OpacityToInt(opacity),
+				TRUE, FALSE);
+}
+
+static void PixelMixer_MixPARGBToRGB(uchar_t *dst, const LCUI_ARGB *src,
+				     size_t n, float opacity)
+{
+	int ia;
+	int op = PixelMixer_OpacityToInt(opacity);
+	const LCUI_ARGB *end = src + n;
+
+	for (; src < end; ++src, dst += 3) {
+		if (src->a == 0) {
+			continue;
+		}
+		ia = 255 - PixelMixer_MulDiv255(src->a, op);
+		dst[0] = min(255, PixelMixer_MulDiv255(src->b, op) +
+				      PixelMixer_MulDiv255(dst[0], ia));
+		dst[1] = min(255, PixelMixer_MulDiv255(src->g, op) +
+				      PixelMixer_MulDiv255(dst[1], ia));
+		dst[2] = min(255, PixelMixer_MulDiv255(src->r, op) +
+				      PixelMixer_MulDiv255(dst[2], ia));
+	}
+}
+
+#define MASK_SPAN_SIZE 64
+
+typedef void (*PixelMixer_ExpandMaskFunc)(LCUI_ARGB *, const uchar_t *,
+					  size_t, LCUI_ARGB);
+typedef void (*PixelMixer_RowFunc)(LCUI_ARGB *, const LCUI_ARGB *, size_t,
+				   float);
+typedef void (*PixelMixer_RowToRGBFunc)(uchar_t *, const LCUI_ARGB *, size_t,
+					float);
+
+/** Expand the mask into pixels of the solid color */
+static void PixelMixer_ExpandMask(LCUI_ARGB *dst, const uchar_t *mask,
+				  size_t n, LCUI_ARGB color)
+{
+	const uchar_t *end = mask + n;
+
+	for (; mask < end; ++mask, ++dst) {
+		*dst = color;
+		dst->a = (uchar_t)(*mask * color.a / 255);
+	}
+}
+
+static void PixelMixer_MaskRow(LCUI_ARGB *dst, const uchar_t *mask, size_t n,
+			       LCUI_ARGB color, PixelMixer_ExpandMaskFunc expand,
+			       PixelMixer_RowFunc mix)
+{
+	size_t len;
+	LCUI_ARGB span[MASK_SPAN_SIZE];
+
+	for (; n > 0; n -= len, dst += len, mask += len) {
+		len = min(n, MASK_SPAN_SIZE);
+		expand(span, mask, len, color);
+		mix(dst, span, len, 1.0f);
+	}
+}
+
+static void PixelMixer_MaskRowToRGB(uchar_t *dst, const uchar_t *mask,
+				    size_t n, LCUI_ARGB color,
+				    PixelMixer_ExpandMaskFunc expand,
+				    PixelMixer_RowToRGBFunc mix)
+{
+	size_t len;
+	LCUI_ARGB span[MASK_SPAN_SIZE];
+
+	for (; n > 0; n -= len, dst += len * 3, mask += len) {
+		len = min(n, MASK_SPAN_SIZE);
+		expand(span, mask, len, color);
+		mix(dst, span, len, 1.0f);
+	}
+}
+
+static void PixelMixer_MaskARGB(LCUI_ARGB *dst, const uchar_t *mask, size_t n,
+				LCUI_ARGB color)
+{
+	PixelMixer_MaskRow(dst, mask, n, color, PixelMixer_ExpandMask,
+			   PixelMixer_OverARGB);
+}
+
+static void PixelMixer_MaskPARGB(LCUI_ARGB *dst, const uchar_t *mask,
+				 size_t n, LCUI_ARGB color)
+{
+	PixelMixer_MaskRow(dst, mask, n, color, PixelMixer_ExpandMask,
+			   PixelMixer_OverARGBToPARGB);
+}
+
+/** The same as PixelMixer_MixARGBToRGB() with the expanded mask */
+static void PixelMixer_MaskRGB(uchar_t *dst, const uchar_t *mask, size_t n,
+			       LCUI_ARGB color)
+{
+	uchar_t a;
+	const uchar_t *end = mask + n;
+
+	for (; mask < end; ++mask, dst += 3) {
+		if (*mask == 0) {
+			continue;
+		}
+		a = (uchar_t)(*mask * color.a / 255);
+		dst[0] = _ALPHA_BLEND(dst[0], color.b, a);
+		dst[1] = _ALPHA_BLEND(dst[1], color.g, a);
+		dst[2] = _ALPHA_BLEND(dst[2], color.r, a);
+	}
+}
+
+/*---------------------------------- SSE2 ----------------------------------*/
+
+#ifdef MIXER_X86
+
+TARGET_SSE2 INLINE __m128i PixelMixer_ScaleAlphaSSE2(__m128i s, __m128 opacity)
+{
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xff000000);
+	__m128i a = _mm_srli_epi32(s, 24);
+
+	a = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(a), opacity));
+	return _mm_or_si128(_mm_andnot_si128(alpha_mask, s),
+			    _mm_slli_epi32(a, 24));
+}
+
+/** PIXEL_BLEND() for 4 pixels */
+TARGET_SSE2 INLINE __m128i PixelMixer_Blend4SSE2(__m128i d, __m128i s)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c256 = _mm_set1_epi16(256);
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xff000000);
+	__m128i s_lo = _mm_unpacklo_epi8(s, zero);
+	__m128i s_hi = _mm_unpackhi_epi8(s, zero);
+	__m128i d_lo = _mm_unpacklo_epi8(d, zero);
+	__m128i d_hi = _mm_unpackhi_epi8(d, zero);
+	__m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, 0xff), 0xff);
+	__m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, 0xff), 0xff);
+
+	d_lo = _mm_add_epi16(_mm_mullo_epi16(s_lo, a_lo),
+			     _mm_mullo_epi16(d_lo, _mm_sub_epi16(c256, a_lo)));
+	d_hi = _mm_add_epi16(_mm_mullo_epi16(s_hi, a_hi),
+			     _mm_mullo_epi16(d_hi, _mm_sub_epi16(c256, a_hi)));
+	s = _mm_packus_epi16(_mm_srli_epi16(d_lo, 8), _mm_srli_epi16(d_hi, 8));
+	return _mm_or_si128(_mm_andnot_si128(alpha_mask, s),
+			    _mm_and_si128(d, alpha_mask));
+}
+
+TARGET_SSE2 static void PixelMixer_MixARGBSSE2(LCUI_ARGB *dst,
+					       const LCUI_ARGB *src, size_t n,
+					       float opacity)
+{
+	size_t i;
+	__m128i s, d;
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xff000000);
+	const __m128 op = _mm_set1_ps(opacity);
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		s = _mm_loadu_si128((const __m128i *)(src + i));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(
+			_mm_and_si128(s, alpha_mask), _mm_setzero_si128())) ==
+		    0xffff) {
+			continue;
+		}
+		if (opacity < 1.0f) {
+			s = PixelMixer_ScaleAlphaSSE2(s, op);
+		}
+		d = _mm_loadu_si128((const __m128i *)(dst + i));
+		_mm_storeu_si128((__m128i *)(dst + i),
+				 PixelMixer_Blend4SSE2(d, s));
+	}
+	PixelMixer_MixARGB(dst + i, src + i, n - i, opacity);
+}
+
+/** Source-over operator for 4 pixels, in single precision */
+TARGET_SSE2 INLINE __m128i PixelMixer_Over4SSE2(__m128i d, __m128i s,
+						float opacity)
+{
+	const __m128i mask = _mm_set1_epi32(0xff);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 k = _mm_set1_ps(1.0f / 255.0f);
+	__m128 sa, da, a, out_a, inv, c;
+	__m128i out;
+
+	sa = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(s, 24)), k);
+	if (opacity < 1.0f) {
+		sa = _mm_mul_ps(sa, _mm_set1_ps(opacity));
+	}
+	da = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(d, 24)), k);
+	a = _mm_mul_ps(_mm_sub_ps(one, sa), da);
+	out_a = _mm_add_ps(sa, a);
+	inv = _mm_and_ps(_mm_cmpgt_ps(out_a, zero), _mm_div_ps(one, out_a));
+	sa = _mm_mul_ps(sa, inv);
+	a = _mm_mul_ps(a, inv);
+
+	c = _mm_add_ps(
+	    _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(d, mask)), a),
+	    _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(s, mask)), sa));
+	out = _mm_cvttps_epi32(_mm_add_ps(c, half));
+	c = _mm_add_ps(
+	    _mm_mul_ps(
+		_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(d, 8), mask)), a),
+	    _mm_mul_ps(
+		_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(s, 8), mask)),
+		sa));
+	out = _mm_or_si128(
+	    out, _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(c, half)), 8));
+	c = _mm_add_ps(
+	    _mm_mul_ps(
+		_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(d, 16), mask)),
+		a),
+	    _mm_mul_ps(
+		_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(s, 16), mask)),
+		sa));
+	out = _mm_or_si128(
+	    out, _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(c, half)), 16));
+	c = _mm_add_ps(_mm_mul_ps(out_a, _mm_set1_ps(255.0f)), half);
+	return _mm_or_si128(out, _mm_slli_epi32(_mm_cvttps_epi32(c), 24));
+}
+
+TARGET_SSE2 static void PixelMixer_OverARGBSSE2(LCUI_ARGB *dst,
+						const LCUI_ARGB *src, size_t n,
+						float opacity)
+{
+	size_t i;
+	__m128i s, d, sa;
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xff000000);
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		s = _mm_loadu_si128((const __m128i *)(src + i));
+		sa = _mm_and_si128(s, alpha_mask);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(
+			sa, _mm_setzero_si128())) == 0xffff) {
+			continue;
+		}
+		if (opacity >= 1.0f &&
+		    _mm_movemask_epi8(_mm_cmpeq_epi32(sa, alpha_mask)) ==
+			0xffff) {
+			_mm_storeu_si128((__m128i *)(dst + i), s);
+			continue;
+		}
+		d = _mm_loadu_si128((const __m128i *)(dst + i));
+		_mm_storeu_si128((__m128i *)(dst + i),
+				 PixelMixer_Over4SSE2(d, s, opacity));
+	}
+	PixelMixer_OverARGB(dst + i, src + i, n - i, opacity);
+}
+
+/** x * y / 255 for each 16-bit lane, rounded */
+TARGET_SSE2 INLINE __m128i PixelMixer_MulDiv255SSE2(__m128i x, __m128i y)
+{
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/** Premultiplied source-over for 2 pixels unpacked to 16-bit lanes */
+TARGET_SSE2 INLINE __m128i PixelMixer_OverPARGB2SSE2(__m128i d, __m128i s,
+						     __m128i op,
+						     LCUI_BOOL straight)
+{
+	const __m128i alpha_lanes =
+	    _mm_set1_epi64x((long long)0xffff000000000000ULL);
+	__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xff), 0xff);
+
+	a = PixelMixer_MulDiv255SSE2(a, op);
+	if (straight) {
+		op = _mm_or_si128(_mm_andnot_si128(alpha_lanes, a),
+				  _mm_and_si128(alpha_lanes, op));
+	}
+	s = PixelMixer_MulDiv255SSE2(s, op);
+	d = PixelMixer_MulDiv255SSE2(d, _mm_sub_epi16(_mm_set1_epi16(255), a));
+	return _mm_add_epi16(s, d);
+}
+
+TARGET_SSE2 INLINE __m128i PixelMixer_OverPARGB4SSE2(__m128i d, __m128i s,
+						     __m128i op,
+						     LCUI_BOOL straight,
+						     LCUI_BOOL keep_alpha)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xff000000);
+	__m128i keep = _mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), zero);
+	__m128i out = _mm_packus_epi16(
+	    PixelMixer_OverPARGB2SSE2(_mm_unpacklo_epi8(d, zero),
+				      _mm_unpacklo_epi8(s, zero), op, straight),
+	    PixelMixer_OverPARGB2SSE2(_mm_unpackhi_epi8(d, zero),
+				      _mm_unpackhi_epi8(s, zero), op,
+				      straight));
+
+	if (keep_alpha) {
+		keep = _mm_or_si128(keep, alpha_mask);
+	}
+	return _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, out));
+}
+
+TARGET_SSE2 INLINE void PixelMixer_OverPARGBRowSSE2(LCUI_ARGB *dst,
+						    const LCUI_ARGB *src,
+						    size_t n, int op,
+						    LCUI_BOOL straight,
+						    LCUI_BOOL keep_alpha)
+{
+	size_t i;
+	__m128i s, d, sa;
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xff000000);
+	const __m128i op16 = _mm_set1_epi16((short)op);
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		s = _mm_loadu_si128((const __m128i *)(src + i));
+		sa = _mm_and_si128(s, alpha_mask);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(
+			sa, _mm_setzero_si128())) == 0xffff) {
+			continue;
+		}
+		if (op == 255 && !keep_alpha &&
+		    _mm_movemask_epi8(_mm_cmpeq_epi32(sa, alpha_mask)) ==
+			0xffff) {
+			_mm_storeu_si128((__m128i *)(dst + i), s);
+			continue;
+		}
+		d = _mm_loadu_si128((const __m128i *)(dst + i));
+		_mm_storeu_si128(
+		    (__m128i *)(dst + i),
+		    PixelMixer_OverPARGB4SSE2(d, s, op16, straight, keep_alpha));
+	}
+	PixelMixer_OverPARGBRow(dst + i, src + i, n - i, op, straight,
+				keep_alpha);
+}
+
+TARGET_SSE2 static void PixelMixer_OverPARGBSSE2(LCUI_ARGB *dst,
+						 const LCUI_ARGB *src, size_t n,
+						 float opacity)
+{
+	PixelMixer_OverPARGBRowSSE2(dst, src, n,
+				    PixelMixer_OpacityToInt(opacity), FALSE,
+				    FALSE);
+}
+
+TARGET_SSE2 static void PixelMixer_MixPARGBSSE2(LCUI_ARGB *dst,
+						const LCUI_ARGB *src, size_t n,
+						float opacity)
+{
+	PixelMixer_OverPARGBRowSSE2(dst, src, n,
+				    PixelMixer_OpacityToInt(opacity), FALSE,
+				    TRUE);
+}
+
+TARGET_SSE2 static void PixelMixer_OverARGBToPARGBSSE2(LCUI_ARGB *dst,
+						       const LCUI_ARGB *src,
+						       size_t n, float opacity)
+{
+	PixelMixer_OverPARGBRowSSE2(dst, src, n,
+				    PixelMixer_OpacityToInt(opacity), TRUE,
+				    FALSE);
+}
+
+/** x / 255 for each 16-bit lane, rounded down */
+TARGET_SSE2 INLINE __m128i PixelMixer_DivFloor255SSE2(__m128i x)
+{
+	x = _mm_add_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)),
+			  _mm_set1_epi16(1));
+	return _mm_srli_epi16(x, 8);
+}
+
+TARGET_SSE2 static void PixelMixer_ExpandMaskSSE2(LCUI_ARGB *dst,
+						  const uchar_t *mask,
+						  size_t n, LCUI_ARGB color)
+{
+	size_t i;
+	__m128i a;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rgb = _mm_set1_epi32(color.value & 0xffffff);
+	const __m128i ca = _mm_set1_epi16(color.a);
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		a = _mm_unpacklo_epi8(
+		    _mm_loadl_epi64((const __m128i *)(mask + i)), zero);
+		if (color.a < 255) {
+			a = PixelMixer_DivFloor255SSE2(_mm_mullo_epi16(a, ca));
+		}
+		_mm_storeu_si128(
+		    (__m128i *)(dst + i),
+		    _mm_or_si128(rgb,
+				 _mm_slli_epi32(_mm_unpacklo_epi16(a, zero), 24)));
+		_mm_storeu_si128(
+		    (__m128i *)(dst + i + 4),
+		    _mm_or_si128(rgb,
+				 _mm_slli_epi32(_mm_unpackhi_epi16(a, zero), 24)));
+	}
+	PixelMixer_ExpandMask(dst + i, mask + i, n - i, color);
+}
+
+TARGET_SSE2 static void PixelMixer_MaskARGBSSE2(LCUI_ARGB *dst,
+						const uchar_t *mask, size_t n,
+						LCUI_ARGB color)
+{
+	PixelMixer_MaskRow(dst, mask, n, color, PixelMixer_ExpandMaskSSE2,
+			   PixelMixer_OverARGBSSE2);
+}
+
+TARGET_SSE2 static void PixelMixer_MaskPARGBSSE2(LCUI_ARGB *dst,
+						 const uchar_t *mask, size_t n,
+						 LCUI_ARGB color)
+{
+	PixelMixer_MaskRow(dst, mask, n, color, PixelMixer_ExpandMaskSSE2,
+			   PixelMixer_OverARGBToPARGBSSE2);
+}
+
+/*---------------------------------- AVX2 ----------------------------------*/
+
+TARGET_AVX2 INLINE __m256i PixelMixer_ScaleAlphaAVX2(__m256i s, __m256 opacity)
+{
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+	__m256i a = _mm256_srli_epi32(s, 24);
+
+	a = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(a), opacity));
+	return _mm256_or_si256(_mm256_andnot_si256(alpha_mask, s),
+			       _mm256_slli_epi32(a, 24));
+}
+
+TARGET_AVX2 INLINE __m256i PixelMixer_Blend8AVX2(__m256i d, __m256i s)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i c256 = _mm256_set1_epi16(256);
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+	__m256i s_lo = _mm256_unpacklo_epi8(s, zero);
+	__m256i s_hi = _mm256_unpackhi_epi8(s, zero);
+	__m256i d_lo = _mm256_unpacklo_epi8(d, zero);
+	__m256i d_hi = _mm256_unpackhi_epi8(d, zero);
+	__m256i a_lo =
+	    _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_lo, 0xff), 0xff);
+	__m256i a_hi =
+	    _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_hi, 0xff), 0xff);
+
+	d_lo = _mm256_add_epi16(
+	    _mm256_mullo_epi16(s_lo, a_lo),
+	    _mm256_mullo_epi16(d_lo, _mm256_sub_epi16(c256, a_lo)));
+	d_hi = _mm256_add_epi16(
+	    _mm256_mullo_epi16(s_hi, a_hi),
+	    _mm256_mullo_epi16(d_hi, _mm256_sub_epi16(c256, a_hi)));
+	s = _mm256_packus_epi16(_mm256_srli_epi16(d_lo, 8),
+				_mm256_srli_epi16(d_hi, 8));
+	return _mm256_or_si256(_mm256_andnot_si256(alpha_mask, s),
+			       _mm256_and_si256(d, alpha_mask));
+}
+
+TARGET_AVX2 static void PixelMixer_MixARGBAVX2(LCUI_ARGB *dst,
+					       const LCUI_ARGB *src, size_t n,
+					       float opacity)
+{
+	size_t i;
+	__m256i s, d;
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+	const __m256 op = _mm256_set1_ps(opacity);
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		s = _mm256_loadu_si256((const __m256i *)(src + i));
+		if (_mm256_testz_si256(s, alpha_mask)) {
+			continue;
+		}
+		if (opacity < 1.0f) {
+			s = PixelMixer_ScaleAlphaAVX2(s, op);
+		}
+		d = _mm256_loadu_si256((const __m256i *)(dst + i));
+		_mm256_storeu_si256((__m256i *)(dst + i),
+				    PixelMixer_Blend8AVX2(d, s));
+	}
+	_mm256_zeroupper();
+	PixelMixer_MixARGBSSE2(dst + i, src + i, n - i, opacity);
+}
+
+TARGET_AVX2 INLINE __m256i PixelMixer_Over8AVX2(__m256i d, __m256i s,
+						float opacity)
+{
+	const __m256i mask = _mm256_set1_epi32(0xff);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 k = _mm256_set1_ps(1.0f / 255.0f);
+	__m256 sa, da, a, out_a, inv, c;
+	__m256i out;
+	int shift;
+
+	sa = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(s, 24)), k);
+	if (opacity < 1.0f) {
+		sa = _mm256_mul_ps(sa, _mm256_set1_ps(opacity));
+	}
+	da = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(d, 24)), k);
+	a = _mm256_mul_ps(_mm256_sub_ps(one, sa), da);
+	out_a = _mm256_add_ps(sa, a);
+	inv = _mm256_and_ps(_mm256_cmp_ps(out_a, zero, _CMP_GT_OQ),
+			    _mm256_div_ps(one, out_a));
+	sa = _mm256_mul_ps(sa, inv);
+	a = _mm256_mul_ps(a, inv);
+	c = _mm256_add_ps(_mm256_mul_ps(out_a, _mm256_set1_ps(255.0f)), half);
+	out = _mm256_slli_epi32(_mm256_cvttps_epi32(c), 24);
+	for (shift = 0; shift < 24; shift += 8) {
+		c = _mm256_add_ps(
+		    _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(
+				      _mm256_srli_epi32(d, shift), mask)),
+				  a),
+		    _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(
+				      _mm256_srli_epi32(s, shift), mask)),
+				  sa));
+		c = _mm256_add_ps(c, half);
+		out = _mm256_or_si256(
+		    out, _mm256_slli_epi32(_mm256_cvttps_epi32(c), shift));
+	}
+	return out;
+}
+
+TARGET_AVX2 static void PixelMixer_OverARGBAVX2(LCUI_ARGB *dst,
+						const LCUI_ARGB *src, size_t n,
+						float opacity)
+{
+	size_t i;
+	__m256i s, d, sa;
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		s = _mm256_loadu_si256((const __m256i *)(src + i));
+		sa = _mm256_and_si256(s, alpha_mask);
+		if (_mm256_testz_si256(sa, sa)) {
+			continue;
+		}
+		if (opacity >= 1.0f &&
+		    _mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, alpha_mask)) ==
+			-1) {
+			_mm256_storeu_si256((__m256i *)(dst + i), s);
+			continue;
+		}
+		d = _mm256_loadu_si256((const __m256i *)(dst + i));
+		_mm256_storeu_si256((__m256i *)(dst + i),
+				    PixelMixer_Over8AVX2(d, s, opacity));
+	}
+	_mm256_zeroupper();
+	PixelMixer_OverARGBSSE2(dst + i, src + i, n - i, opacity);
+}
+
+/** Mix 8 pixels into a RGB888 row, pixels are unpacked with byte shuffles */
+TARGET_AVX2 static void PixelMixer_MixARGBToRGBAVX2(uchar_t *dst,
+						    const LCUI_ARGB *src,
+						    size_t n, float opacity)
+{
+	size_t i;
+	__m128i lo, hi;
+	__m256i s, d;
+	const __m128i unpack_lo = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7,
+						8, -1, 9, 10, 11, -1);
+	const __m128i unpack_hi = _mm_setr_epi8(4, 5, 6, -1, 7, 8, 9, -1, 10,
+						11, 12, -1, 13, 14, 15, -1);
+	const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13,
+					   14, -1, -1, -1, -1);
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+	const __m256 op = _mm256_set1_ps(opacity);
+
+	for (i = 0; i + 8 <= n; i += 8, dst += 24) {
+		s = _mm256_loadu_si256((const __m256i *)(src + i));
+		if (_mm256_testz_si256(s, alpha_mask)) {
+			continue;
+		}
+		if (opacity < 1.0f) {
+			s = PixelMixer_ScaleAlphaAVX2(s, op);
+		}
+		/* both loads stay inside the 24 bytes of these pixels */
+		lo = _mm_loadu_si128((const __m128i *)dst);
+		hi = _mm_loadu_si128((const __m128i *)(dst + 8));
+		lo = _mm_shuffle_epi8(lo, unpack_lo);
+		hi = _mm_shuffle_epi8(hi, unpack_hi);
+		d = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+		d = PixelMixer_Blend8AVX2(d, s);
+		lo = _mm_shuffle_epi8(_mm256_castsi256_si128(d), pack);
+		hi = _mm_shuffle_epi8(_mm256_extracti128_si256(d, 1), pack);
+		_mm_storeu_si128((__m128i *)dst,
+				 _mm_or_si128(lo, _mm_slli_si128(hi, 12)));
+		_mm_storel_epi64((__m128i *)(dst + 16), _mm_srli_si128(hi, 4));
+	}
+	_mm256_zeroupper();
+	PixelMixer_MixARGBToRGB(dst, src + i, n - i, opacity);
+}
+
+TARGET_AVX2 INLINE __m256i PixelMixer_MulDiv255AVX2(__m256i x, __m256i y)
+{
+	__m256i t =
+	    _mm256_add_epi16(_mm256_mullo_epi16(x, y), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)),
+				 8);
+}
+
+TARGET_AVX2 INLINE __m256i PixelMixer_OverPARGB4AVX2(__m256i d, __m256i s,
+						     __m256i op,
+						     LCUI_BOOL straight)
+{
+	const __m256i alpha_lanes =
+	    _mm256_set1_epi64x((long long)0xffff000000000000ULL);
+	__m256i a =
+	    _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xff), 0xff);
+
+	a = PixelMixer_MulDiv255AVX2(a, op);
+	if (straight) {
+		op = _mm256_or_si256(_mm256_andnot_si256(alpha_lanes, a),
+				     _mm256_and_si256(alpha_lanes, op));
+	}
+	s = PixelMixer_MulDiv255AVX2(s, op);
+	d = PixelMixer_MulDiv255AVX2(
+	    d, _mm256_sub_epi16(_mm256_set1_epi16(255), a));
+	return _mm256_add_epi16(s, d);
+}
+
+TARGET_AVX2 INLINE __m256i PixelMixer_OverPARGB8AVX2(__m256i d, __m256i s,
+						     __m256i op,
+						     LCUI_BOOL straight,
+						     LCUI_BOOL keep_alpha)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+	__m256i keep =
+	    _mm256_cmpeq_epi32(_mm256_and_si256(s, alpha_mask), zero);
+	__m256i out = _mm256_packus_epi16(
+	    PixelMixer_OverPARGB4AVX2(_mm256_unpacklo_epi8(d, zero),
+				      _mm256_unpacklo_epi8(s, zero), op,
+				      straight),
+	    PixelMixer_OverPARGB4AVX2(_mm256_unpackhi_epi8(d, zero),
+				      _mm256_unpackhi_epi8(s, zero), op,
+				      straight));
+
+	if (keep_alpha) {
+		keep = _mm256_or_si256(keep, alpha_mask);
+	}
+	return _mm256_or_si256(_mm256_and_si256(keep, d),
+			       _mm256_andnot_si256(keep, out));
+}
+
+TARGET_AVX2 INLINE void PixelMixer_OverPARGBRowAVX2(LCUI_ARGB *dst,
+						    const LCUI_ARGB *src,
+						    size_t n, int op,
+						    LCUI_BOOL straight,
+						    LCUI_BOOL keep_alpha)
+{
+	size_t i;
+	__m256i s, d, sa;
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+	const __m256i op16 = _mm256_set1_epi16((short)op);
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		s = _mm256_loadu_si256((const __m256i *)(src + i));
+		sa = _mm256_and_si256(s, alpha_mask);
+		if (_mm256_testz_si256(sa, sa)) {
+			continue;
+		}
+		if (op == 255 && !keep_alpha &&
+		    _mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, alpha_mask)) ==
+			-1) {
+			_mm256_storeu_si256((__m256i *)(dst + i), s);
+			continue;
+		}
+		d = _mm256_loadu_si256((const __m256i *)(dst + i));
+		_mm256_storeu_si256(
+		    (__m256i *)(dst + i),
+		    PixelMixer_OverPARGB8AVX2(d, s, op16, straight, keep_alpha));
+	}
+	_mm256_zeroupper();
+	PixelMixer_OverPARGBRowSSE2(dst + i, src + i, n - i, op, straight,
+				    keep_alpha);
+}
+
+TARGET_AVX2 static void PixelMixer_OverPARGBAVX2(LCUI_ARGB *dst,
+						 const LCUI_ARGB *src, size_t n,
+						 float opacity)
+{
+	PixelMixer_OverPARGBRowAVX2(dst, src, n,
+				    PixelMixer_OpacityToInt(opacity), FALSE,
+				    FALSE);
+}
+
+TARGET_AVX2 static void PixelMixer_MixPARGBAVX2(LCUI_ARGB *dst,
+						const LCUI_ARGB *src, size_t n,
+						float opacity)
+{
+	PixelMixer_OverPARGBRowAVX2(dst, src, n,
+				    PixelMixer_OpacityToInt(opacity), FALSE,
+				    TRUE);
+}
+
+TARGET_AVX2 static void PixelMixer_OverARGBToPARGBAVX2(LCUI_ARGB *dst,
+						       const LCUI_ARGB *src,
+						       size_t n, float opacity)
+{
+	PixelMixer_OverPARGBRowAVX2(dst, src, n,
+				    PixelMixer_OpacityToInt(opacity), TRUE,
+				    FALSE);
+}
+
+TARGET_AVX2 static void PixelMixer_MixPARGBToRGBAVX2(uchar_t *dst,
+						     const LCUI_ARGB *src,
+						     size_t n, float opacity)
+{
+	size_t i;
+	__m128i lo, hi;
+	__m256i s, d;
+	const __m128i unpack_lo = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7,
+						8, -1, 9, 10, 11, -1);
+	const __m128i unpack_hi = _mm_setr_epi8(4, 5, 6, -1, 7, 8, 9, -1, 10,
+						11, 12, -1, 13, 14, 15, -1);
+	const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13,
+					   14, -1, -1, -1, -1);
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+	const int op = PixelMixer_OpacityToInt(opacity);
+	const __m256i op16 = _mm256_set1_epi16((short)op);
+
+	for (i = 0; i + 8 <= n; i += 8, dst += 24) {
+		s = _mm256_loadu_si256((const __m256i *)(src + i));
+		if (_mm256_testz_si256(s, alpha_mask)) {
+			continue;
+		}
+		lo = _mm_loadu_si128((const __m128i *)dst);
+		hi = _mm_loadu_si128((const __m128i *)(dst + 8));
+		lo = _mm_shuffle_epi8(lo, unpack_lo);
+		hi = _mm_shuffle_epi8(hi, unpack_hi);
+		d = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+		d = PixelMixer_OverPARGB8AVX2(d, s, op16, FALSE, TRUE);
+		lo = _mm_shuffle_epi8(_mm256_castsi256_si128(d), pack);
+		hi = _mm_shuffle_epi8(_mm256_extracti128_si256(d, 1), pack);
+		_mm_storeu_si128((__m128i *)dst,
+				 _mm_or_si128(lo, _mm_slli_si128(hi, 12)));
+		_mm_storel_epi64((__m128i *)(dst + 16), _mm_srli_si128(hi, 4));
+	}
+	_mm256_zeroupper();
+	PixelMixer_MixPARGBToRGB(dst, src + i, n - i, opacity);
+}
+
+TARGET_AVX2 static void PixelMixer_ExpandMaskAVX2(LCUI_ARGB *dst,
+						  const uchar_t *mask,
+						  size_t n, LCUI_ARGB color)
+{
+	size_t i;
+	__m256i a;
+	const __m256i rgb = _mm256_set1_epi32(color.value & 0xffffff);
+	const __m256i ca = _mm256_set1_epi32(color.a);
+	const __m256i one = _mm256_set1_epi32(1);
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		a = _mm256_cvtepu8_epi32(
+		    _mm_loadl_epi64((const __m128i *)(mask + i)));
+		if (color.a < 255) {
+			a = _mm256_mullo_epi16(a, ca);
+			a = _mm256_add_epi32(
+			    _mm256_add_epi32(a, _mm256_srli_epi32(a, 8)), one);
+			a = _mm256_srli_epi32(a, 8);
+		}
+		_mm256_storeu_si256((__m256i *)(dst + i),
+				    _mm256_or_si256(rgb, _mm256_slli_epi32(a, 24)));
+	}
+	PixelMixer_ExpandMask(dst + i, mask + i, n - i, color);
+}
+
+TARGET_AVX2 static void PixelMixer_MaskARGBAVX2(LCUI_ARGB *dst,
+						const uchar_t *mask, size_t n,
+						LCUI_ARGB color)
+{
+	PixelMixer_MaskRow(dst, mask, n, color, PixelMixer_ExpandMaskAVX2,
+			   PixelMixer_OverARGBAVX2);
+}
+
+TARGET_AVX2 static void PixelMixer_MaskPARGBAVX2(LCUI_ARGB *dst,
+						 const uchar_t *mask, size_t n,
+						 LCUI_ARGB color)
+{
+	PixelMixer_MaskRow(dst, mask, n, color, PixelMixer_ExpandMaskAVX2,
+			   PixelMixer_OverARGBToPARGBAVX2);
+}
+
+TARGET_AVX2 static void PixelMixer_MaskRGBAVX2(uchar_t *dst,
+					       const uchar_t *mask, size_t n,
+					       LCUI_ARGB color)
+{
+	/* rows shorter than a vector are cheaper without expanding */
+	if (n < 8) {
+		PixelMixer_MaskRGB(dst, mask, n, color);
+		return;
+	}
+	PixelMixer_MaskRowToRGB(dst, mask, n, color,
+				PixelMixer_ExpandMaskAVX2,
+				PixelMixer_MixARGBToRGBAVX2);
+}
+
+static LCUI_BOOL PixelMixer_HasSSE2(void)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+	return TRUE;
+#elif defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2") ? TRUE : FALSE;
+#elif defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) ? TRUE : FALSE;
+#else
+	return FALSE;
+#endif
+}
+
+static LCUI_BOOL PixelMixer_HasAVX2(void)
+{
+#if defined(__GNUC__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") ? TRUE : FALSE;
+#elif defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return FALSE;
+	}
+	__cpuid(info, 1);
+	/* the OS must save the YMM registers (OSXSAVE, AVX and XCR0) */
+	if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) ||
+	    (_xgetbv(0) & 6) != 6) {
+		return FALSE;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) ? TRUE : FALSE;
+#else
+	return FALSE;
+#endif
+}
+
+#endif /* MIXER_X86 */
+
+/*---------------------------------- NEON ----------------------------------*/
+
+#ifdef MIXER_NEON
+
+INLINE void PixelMixer_U8ToF32(uint8x8_t v, float32x4_t *lo, float32x4_t *hi)
+{
+	uint16x8_t w = vmovl_u8(v);
+
+	*lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(w)));
+	*hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(w)));
+}
+
+INLINE uint8x8_t PixelMixer_F32ToU8(float32x4_t lo, float32x4_t hi)
+{
+	return vmovn_u16(vcombine_u16(vmovn_u32(vcvtq_u32_f32(lo)),
+				      vmovn_u32(vcvtq_u32_f32(hi))));
+}
+
+INLINE float32x4_t PixelMixer_RecipNEON(float32x4_t x)
+{
+#if defined(__aarch64__) || defined(_M_ARM64)
+	return vdivq_f32(vdupq_n_f32(1.0f), x);
+#else
+	float32x4_t r = vrecpeq_f32(x);
+
+	r = vmulq_f32(vrecpsq_f32(x, r), r);
+	return vmulq_f32(vrecpsq_f32(x, r), r);
+#endif
+}
+
+INLINE uint8x8_t PixelMixer_ScaleAlphaNEON(uint8x8_t a, float opacity)
+{
+	float32x4_t lo, hi;
+
+	PixelMixer_U8ToF32(a, &lo, &hi);
+	return PixelMixer_F32ToU8(vmulq_n_f32(lo, opacity),
+				  vmulq_n_f32(hi, opacity));
+}
+
+/** PIXEL_BLEND() for one channel of 8 pixels */
+INLINE uint8x8_t PixelMixer_Blend8NEON(uint8x8_t d, uint8x8_t s, uint8x8_t a,
+				       uint16x8_t ia)
+{
+	return vshrn_n_u16(vmlaq_u16(vmull_u8(s, a), vmovl_u8(d), ia), 8);
+}
+
+static void PixelMixer_MixARGBNEON(LCUI_ARGB *dst, const LCUI_ARGB *src,
+				   size_t n, float opacity)
+{
+	size_t i;
+	uint8x8_t a;
+	uint16x8_t ia;
+	uint8x8x4_t s, d;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		s = vld4_u8((const uint8_t *)(src + i));
+		a = s.val[3];
+		if (vget_lane_u64(vreinterpret_u64_u8(a), 0) == 0) {
+			continue;
+		}
+		if (opacity < 1.0f) {
+			a = PixelMixer_ScaleAlphaNEON(a, opacity);
+		}
+		ia = vsubq_u16(vdupq_n_u16(256), vmovl_u8(a));
+		d = vld4_u8((const uint8_t *)(dst + i));
+		d.val[0] = PixelMixer_Blend8NEON(d.val[0], s.val[0], a, ia);
+		d.val[1] = PixelMixer_Blend8NEON(d.val[1], s.val[1], a, ia);
+		d.val[2] = PixelMixer_Blend8NEON(d.val[2], s.val[2], a, ia);
+		vst4_u8((uint8_t *)(dst + i), d);
+	}
+	PixelMixer_MixARGB(dst + i, src + i, n - i, opacity);
+}
+
+static void PixelMixer_OverARGBNEON(LCUI_ARGB *dst, const LCUI_ARGB *src,
+				    size_t n, float opacity)
+{
+	int c, h;
+	size_t i;
+	uint64_t sa_bits;
+	uint8x8x4_t s, d;
+	float32x4_t sc[2][4], dc[2][4];
+	float32x4_t sa, da, a, out_a, inv;
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t one = vdupq_n_f32(1.0f);
+	const float32x4_t half = vdupq_n_f32(0.5f);
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		s = vld4_u8((const uint8_t *)(src + i));
+		sa_bits = vget_lane_u64(vreinterpret_u64_u8(s.val[3]), 0);
+		if (sa_bits == 0) {
+			continue;
+		}
+		if (opacity >= 1.0f && sa_bits == ~(uint64_t)0) {
+			vst4_u8((uint8_t *)(dst + i), s);
+			continue;
+		}
+		d = vld4_u8((const uint8_t *)(dst + i));
+		for (c = 0; c < 4; ++c) {
+			PixelMixer_U8ToF32(s.val[c], &sc[0][c], &sc[1][c]);
+			PixelMixer_U8ToF32(d.val[c], &dc[0][c], &dc[1][c]);
+		}
+		for (h = 0; h < 2; ++h) {
+			sa = vmulq_n_f32(sc[h][3], 1.0f / 255.0f);
+			if (opacity < 1.0f) {
+				sa = vmulq_n_f32(sa, opacity);
+			}
+			da = vmulq_n_f32(dc[h][3], 1.0f / 255.0f);
+			a = vmulq_f32(vsubq_f32(one, sa), da);
+			out_a = vaddq_f32(sa, a);
+			inv = vreinterpretq_f32_u32(
+			    vandq_u32(vcgtq_f32(out_a, zero),
+				      vreinterpretq_u32_f32(
+					  PixelMixer_RecipNEON(out_a))));
+			sa = vmulq_f32(sa, inv);
+			a = vmulq_f32(a, inv);
+			for (c = 0; c < 3; ++c) {
+				dc[h][c] = vaddq_f32(
+				    vmlaq_f32(vmulq_f32(dc[h][c], a), sc[h][c],
+					      sa),
+				    half);
+			}
+			dc[h][3] = vmlaq_n_f32(half, out_a, 255.0f);
+		}
+		for (c = 0; c < 4; ++c) {
+			d.val[c] = PixelMixer_F32ToU8(dc[0][c], dc[1][c]);
+		}
+		vst4_u8((uint8_t *)(dst + i), d);
+	}
+	PixelMixer_OverARGB(dst + i, src + i, n - i, opacity);
+}
+
+static void PixelMixer_MixARGBToRGBNEON(uchar_t *dst, const LCUI_ARGB *src,
+					size_t n, float opacity)
+{
+	size_t i;
+	uint8x8_t a;
+	uint16x8_t ia;
+	uint8x8x4_t s;
+	uint8x8x3_t d;
+
+	for (i = 0; i + 8 <= n; i += 8, dst += 24) {
+		s = vld4_u8((const uint8_t *)(src + i));
+		a = s.val[3];
+		if (vget_lane_u64(vreinterpret_u64_u8(a), 0) == 0) {
+			continue;
+		}
+		if (opacity < 1.0f) {
+			a = PixelMixer_ScaleAlphaNEON(a, opacity);
+		}
+		ia = vsubq_u16(vdupq_n_u16(256), vmovl_u8(a));
+		d = vld3_u8(dst);
+		d.val[0] = PixelMixer_Blend8NEON(d.val[0], s.val[0], a, ia);
+		d.val[1] = PixelMixer_Blend8NEON(d.val[1], s.val[1], a, ia);
+		d.val[2] = PixelMixer_Blend8NEON(d.val[2], s.val[2], a, ia);
+		vst3_u8(dst, d);
+	}
+	PixelMixer_MixARGBToRGB(dst, src + i, n - i, opacity);
+}
+
+
+INLINE uint8x8_t PixelMixer_MulDiv255NEON(uint8x8_t x, uint8x8_t y)
+{
+	uint16x8_t t = vmull_u8(x, y);
+	return vraddhn_u16(t, vrshrq_n_u16(t, 8));
+}
+
+INLINE void PixelMixer_OverPARGBRowNEON(LCUI_ARGB *dst, const LCUI_ARGB *src,
+					size_t n, int op, LCUI_BOOL straight,
+					LCUI_BOOL keep_alpha)
+{
+	int c;
+	size_t i;
+	uint64_t sa_bits;
+	uint8x8_t a, ia, keep;
+	uint8x8x4_t s, d;
+	const uint8x8_t op8 = vdup_n_u8((uint8_t)op);
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		s = vld4_u8((const uint8_t *)(src + i));
+		sa_bits = vget_lane_u64(vreinterpret_u64_u8(s.val[3]), 0);
+		if (sa_bits == 0) {
+			continue;
+		}
+		if (op == 255 && !keep_alpha && sa_bits == ~(uint64_t)0) {
+			vst4_u8((uint8_t *)(dst + i), s);
+			continue;
+		}
+		d = vld4_u8((const uint8_t *)(dst + i));
+		keep = vceq_u8(s.val[3], vdup_n_u8(0));
+		a = PixelMixer_MulDiv255NEON(s.val[3], op8);
+		ia = vmvn_u8(a);
+		for (c = 0; c < 3; ++c) {
+			s.val[c] = vqadd_u8(
+			    PixelMixer_MulDiv255NEON(s.val[c], straight ? a : op8),
+			    PixelMixer_MulDiv255NEON(d.val[c], ia));
+			d.val[c] = vbsl_u8(keep, d.val[c], s.val[c]);
+		}
+		if (!keep_alpha) {
+			a = vqadd_u8(a, PixelMixer_MulDiv255NEON(d.val[3], ia));
+			d.val[3] = vbsl_u8(keep, d.val[3], a);
+		}
+		vst4_u8((uint8_t *)(dst + i), d);
+	}
+	PixelMixer_OverPARGBRow(dst + i, src + i, n - i, op, straight,
+				keep_alpha);
+}
+
+static void PixelMixer_OverPARGBNEON(LCUI_ARGB *dst, const LCUI_ARGB *src,
+				     size_t n, float opacity)
+{
+	PixelMixer_OverPARGBRowNEON(dst, src, n,
+				    PixelMixer_OpacityToInt(opacity), FALSE,
+				    FALSE);
+}
+
+static void PixelMixer_MixPARGBNEON(LCUI_ARGB *dst, const LCUI_ARGB *src,
+				    size_t n, float opacity)
+{
+	PixelMixer_OverPARGBRowNEON(dst, src, n,
+				    PixelMixer_OpacityToInt(opacity), FALSE,
+				    TRUE);
+}
+
+static void PixelMixer_OverARGBToPARGBNEON(LCUI_ARGB *dst,
+					   const LCUI_ARGB *src, size_t n,
+					   float opacity)
+{
+	PixelMixer_OverPARGBRowNEON(dst, src, n,
+				    PixelMixer_OpacityToInt(opacity), TRUE,
+				    FALSE);
+}
+
+static void PixelMixer_MixPARGBToRGBNEON(uchar_t *dst, const LCUI_ARGB *src,
+					 size_t n, float opacity)
+{
+	int c;
+	size_t i;
+	uint8x8_t ia, keep;
+	uint8x8x4_t s;
+	uint8x8x3_t d;
+	const uint8x8_t op8 =
+	    vdup_n_u8((uint8_t)PixelMixer_OpacityToInt(opacity));
+
+	for (i = 0; i + 8 <= n; i += 8, dst += 24) {
+		s = vld4_u8((const uint8_t *)(src + i));
+		if (vget_lane_u64(vreinterpret_u64_u8(s.val[3]), 0) == 0) {
+			continue;
+		}
+		d = vld3_u8(dst);
+		keep = vceq_u8(s.val[3], vdup_n_u8(0));
+		ia = vmvn_u8(PixelMixer_MulDiv255NEON(s.val[3], op8));
+		for (c = 0; c < 3; ++c) {
+			s.val[c] =
+			    vqadd_u8(PixelMixer_MulDiv255NEON(s.val[c], op8),
+				     PixelMixer_MulDiv255NEON(d.val[c], ia));
+			d.val[c] = vbsl_u8(keep, d.val[c], s.val[c]);
+		}
+		vst3_u8(dst, d);
+	}
+	PixelMixer_MixPARGBToRGB(dst, src + i, n - i, opacity);
+}
+
+static void PixelMixer_ExpandMaskNEON(LCUI_ARGB *dst, const uchar_t *mask,
+				      size_t n, LCUI_ARGB color)
+{
+	size_t i;
+	uint16x8_t t;
+	uint8x8x4_t s;
+	const uint8x8_t ca = vdup_n_u8(color.a);
+
+	s.val[0] = vdup_n_u8(color.b);
+	s.val[1] = vdup_n_u8(color.g);
+	s.val[2] = vdup_n_u8(color.r);
+	for (i = 0; i + 8 <= n; i += 8) {
+		s.val[3] = vld1_u8(mask + i);
+		if (color.a < 255) {
+			t = vmull_u8(s.val[3], ca);
+			t = vaddq_u16(t, vsraq_n_u16(vdupq_n_u16(1), t, 8));
+			s.val[3] = vshrn_n_u16(t, 8);
+		}
+		vst4_u8((uint8_t *)(dst + i), s);
+	}
+	PixelMixer_ExpandMask(dst + i, mask + i, n - i, color);
+}
+
+static void PixelMixer_MaskARGBNEON(LCUI_ARGB *dst, const uchar_t *mask,
+				    size_t n, LCUI_ARGB color)
+{
+	PixelMixer_MaskRow(dst, mask, n, color, PixelMixer_ExpandMaskNEON,
+			   PixelMixer_OverARGBNEON);
+}
+
+static void PixelMixer_MaskPARGBNEON(LCUI_ARGB *dst, const uchar_t *mask,
+				     size_t n, LCUI_ARGB color)
+{
+	PixelMixer_MaskRow(dst, mask, n, color, PixelMixer_ExpandMaskNEON,
+			   PixelMixer_OverARGBToPARGBNEON);
+}
+
+static void PixelMixer_MaskRGBNEON(uchar_t *dst, const uchar_t *mask,
+				   size_t n, LCUI_ARGB color)
+{
+	if (n < 8) {
+		PixelMixer_MaskRGB(dst, mask, n, color);
+		return;
+	}
+	PixelMixer_MaskRowToRGB(dst, mask, n, color,
+				PixelMixer_ExpandMaskNEON,
+				PixelMixer_MixARGBToRGBNEON);
+}
+
+#endif /* MIXER_NEON */
+
+/*---------------------------------- End -----------------------------------*/
+
+static const LCUI_PixelMixerRec pixel_mixers[] = {
+	{ LCUI_PIXEL_MIXER_SCALAR, PixelMixer_MixARGB, PixelMixer_OverARGB,
+	  PixelMixer_MixARGBToRGB, PixelMixer_OverPARGB, PixelMixer_MixPARGB,
+	  PixelMixer_MixPARGBToRGB, PixelMixer_OverARGBToPARGB,
+	  PixelMixer_MaskARGB, PixelMixer_MaskPARGB, PixelMixer_MaskRGB },
+#ifdef MIXER_X86
+	/* SSE2 has no byte shuffle, unpacking RGB888 pixels costs more than
+	 * what the vectorized mixing saves */
+	{ LCUI_PIXEL_MIXER_SSE2, PixelMixer_MixARGBSSE2,
+	  PixelMixer_OverARGBSSE2, PixelMixer_MixARGBToRGB,
+	  PixelMixer_OverPARGBSSE2, PixelMixer_MixPARGBSSE2,
+	  PixelMixer_MixPARGBToRGB, PixelMixer_OverARGBToPARGBSSE2,
+	  PixelMixer_MaskARGBSSE2, PixelMixer_MaskPARGBSSE2,
+	  PixelMixer_MaskRGB },
+	{ LCUI_PIXEL_MIXER_AVX2, PixelMixer_MixARGBAVX2,
+	  PixelMixer_OverARGBAVX2, PixelMixer_MixARGBToRGBAVX2,
+	  PixelMixer_OverPARGBAVX2, PixelMixer_MixPARGBAVX2,
+	  PixelMixer_MixPARGBToRGBAVX2, PixelMixer_OverARGBToPARGBAVX2,
+	  PixelMixer_MaskARGBAVX2, PixelMixer_MaskPARGBAVX2,
+	  PixelMixer_MaskRGBAVX2 },
+#endif
+#ifdef MIXER_NEON
+	{ LCUI_PIXEL_MIXER_NEON, PixelMixer_MixARGBNEON,
+	  PixelMixer_OverARGBNEON, PixelMixer_MixARGBToRGBNEON,
+	  PixelMixer_OverPARGBNEON, PixelMixer_MixPARGBNEON,
+	  PixelMixer_MixPARGBToRGBNEON, PixelMixer_OverARGBToPARGBNEON,
+	  PixelMixer_MaskARGBNEON, PixelMixer_MaskPARGBNEON,
+	  PixelMixer_MaskRGBNEON },
+#endif
+};
+
+static const LCUI_PixelMixerRec *PixelMixer_Find(LCUI_PixelMixerType type)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(pixel_mixers) / sizeof(pixel_mixers[0]); ++i) {
+		if (pixel_mixers[i].type == type) {
+			return &pixel_mixers[i];
+		}
+	}
+	return NULL;
+}
+
+static LCUI_BOOL PixelMixer_IsSupported(LCUI_PixelMixerType type)
+{
+	switch (type) {
+	case LCUI_PIXEL_MIXER_SCALAR:
+		return TRUE;
+#ifdef MIXER_X86
+	case LCUI_PIXEL_MIXER_SSE2:
+		return PixelMixer_HasSSE2();
+	case LCUI_PIXEL_MIXER_AVX2:
+		return PixelMixer_HasAVX2();
+#endif
+#ifdef MIXER_NEON
+	case LCUI_PIXEL_MIXER_NEON:
+		return TRUE;
+#endif
+	default:
+		break;
+	}
+	return FALSE;
+}
+
+const LCUI_PixelMixerRec *PixelMixer_Get(void)
+{
+	int type;
+
+	if (current_mixer) {
+		return current_mixer;
+	}
+	for (type = LCUI_PIXEL_MIXER_NEON; type > LCUI_PIXEL_MIXER_SCALAR;
+	     --type) {
+		if (PixelMixer_IsSupported(type)) {
+			break;
+		}
+	}
+	current_mixer = PixelMixer_Find(type);
+	return current_mixer;
+}
+
+int Graph_SetMixerType(LCUI_PixelMixerType type)
+{
+	if (!PixelMixer_IsSupported(type)) {
+		return -1;
+	}
+	current_mixer = PixelMixer_Find(type);
+	return 0;
+}
+
+LCUI_PixelMixerType Graph_GetMixerType(void)
+{
+	return PixelMixer_Get()->type;
+}
@@ -0,0 +1,90 @@
+/* graph_mixer.h -- pixel mixing kernels
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LCUI_GRAPH_MIXER_H
+#define LCUI_GRAPH_MIXER_H
+
+/**
+ * Row mixing kernels. Every kernel mixes n pixels of a foreground row into a
+ * background row, the opacity is the opacity of the foreground graph.
+ */
+typedef struct LCUI_PixelMixerRec_ {
+	LCUI_PixelMixerType type;
+
+	/** ARGB -> ARGB, the same as PIXEL_BLEND(), background alpha is kept */
+	void (*mix_argb)(LCUI_ARGB *dst, const LCUI_ARGB *src, size_t n,
+			 float opacity);
+
+	/** ARGB -> ARGB, source-over operator, background alpha is updated */
+	void (*over_argb)(LCUI_ARGB *dst, const LCUI_ARGB *src, size_t n,
+			  float opacity);
+
+	/** ARGB -> RGB888 */
+	void (*mix_argb_to_rgb)(uchar_t *dst, const LCUI_ARGB *src, size_t n,
+				float opacity);
+
+	/** PARGB -> PARGB, source-over operator */
+	void (*over_pargb)(LCUI_ARGB *dst, const LCUI_ARGB *src, size_t n,
+			   float opacity);
+
+	/** PARGB -> ARGB, background alpha is kept */
+	void (*mix_pargb)(LCUI_ARGB *dst, const LCUI_ARGB *src, size_t n,
+			  float opacity);
+
+	/** PARGB -> RGB888 */
+	void (*mix_pargb_to_rgb)(uchar_t *dst, const LCUI_ARGB *src, size_t n,
+				 float opacity);
+
+	/** ARGB -> PARGB, source-over operator, source is premultiplied */
+	void (*over_argb_to_pargb)(LCUI_ARGB *dst, const LCUI_ARGB *src,
+				   size_t n, float opacity);
+
+	/**
+	 * Coverage mask kernels, they draw n pixels of a solid color through
+	 * an A8 mask, such as a row of a glyph bitmap. The alpha of each
+	 * pixel is mask * color.a / 255, rounded down.
+	 */
+
+	/** A8 mask -> ARGB, source-over operator */
+	void (*mask_argb)(LCUI_ARGB *dst, const uchar_t *mask, size_t n,
+			  LCUI_ARGB color);
+
+	/** A8 mask -> PARGB, source-over operator */
+	void (*mask_pargb)(LCUI_ARGB *dst, const uchar_t *mask, size_t n,
+			   LCUI_ARGB color);
+
+	/** A8 mask -> RGB888 */
+	void (*mask_rgb)(uchar_t *dst, const uchar_t *mask, size_t n,
+			 LCUI_ARGB color);
+} LCUI_PixelMixerRec, *LCUI_PixelMixer;
+
+/** Get the pixel mixer selected for the current CPU */
+const LCUI_PixelMixerRec *PixelMixer_Get(void);
+
+#endif
@@ -98,11 +98,47 @@ typedef struct StyleLinkRec_ {
 	Dict *parents;		/**< 父级节点 */
 } StyleLinkRec, *StyleLink;
 
+/** 样式表缓存在索引中的记录 */
+typedef struct StyleSheetCacheKeyRec_ {
+	LinkedList *list;	/**< 所属的索引列表 */
+	LinkedListNode node;	/**< 在索引列表中的结点 */
+} StyleSheetCacheKeyRec, *StyleSheetCacheKey;
+
+/**
+ * 样式表缓存
+ * 缓存以选择器最右边结点的类型、ID、类名和状态名为索引，在添加新的样式规则
+ * 时，只有与规则最右边结点匹配的缓存才会被移除
+ */
+typedef struct StyleSheetCacheRec_ {
+	unsigned hash;			/**< 选择器的哈希值 */
+	LCUI_StyleSheet sheet;		/**< 计算后的样式表 */
+	LCUI_SelectorNode snode;	/**< 选择器最右边的结点 */
+	size_t keys_count;		/**< 索引记录数量 */
+	StyleSheetCacheKey keys;	/**< 索引记录 */
+} StyleSheetCacheRec, *StyleSheetCache;
+
+/**
+ * 样式失效规则
+ * 记录选择器中左边的结点与最右边结点的关系，以左边结点的 ID、类名和状态名为
+ * 索引。当部件的这些名称发生变化时，只有匹配最右边结点的子级部件才需要刷新样式
+ */
+typedef struct StyleInvalidationRuleRec_ {
+	LCUI_SelectorNode ancestor;	/**< 左边的结点 */
+	LCUI_SelectorNode target;	/**< 最右边的结点 */
+} StyleInvalidationRuleRec, *StyleInvalidationRule;
+
 static struct {
 	LCUI_BOOL active;
 	LCUI_Mutex mutex;		/**< 互斥锁 */
+	LCUI_Cond readers_cond;		/**< 条件变量，用于等待合并样式表的线程 */
+	int readers;			/**< 正在锁外合并样式表的线程数量 */
 	LinkedList groups;		/**< 样式组列表 */
 	Dict *cache;			/**< 样式表缓存，以选择器的 hash 值索引 */
+	Dict *cache_index;		/**< 样式表缓存的索引，以结点名称索引 */
+	Dict *batch_nodes;		/**< 批量添加期间待处理的规则结点 */
+	int batch_level;		/**< 批量添加的嵌套层数 */
+	LCUI_BOOL batch_clear_all;	/**< 批量添加结束后是否清空缓存 */
+	Dict *invalidation_map;		/**< 样式失效规则表，以带前缀的名称索引 */
 	Dict *names;			/**< 样式属性名称表，以值的名称索引 */
 	Dict *value_keys;		/**< 样式属性值表，以值的名称索引 */
 	Dict *value_names;		/**< 样式属性值名称表，以值索引 */
@@ -112,6 +148,10 @@ static struct {
 	DictType style_link_dict;	/**< 样式链接表的类型 */
 	DictType style_group_dict;	/**< 样式组的类型 */
 	DictType cache_dict;		/**< 样式表缓存的类型 */
+	DictType cache_index_dict;	/**< 样式表缓存索引的类型 */
+	DictType batch_nodes_dict;	/**< 待处理的规则结点表的类型 */
+	DictType invalidation_map_dict;	/**< 样式失效规则表的类型 */
+	DictType invalidation_rules_dict; /**< 样式失效规则列表的类型 */
 	strpool_t *strpool;		/**< 字符串池 */
 	int count;			/**< 当前记录的属性数量 */
 } library;
@@ -180,6 +220,7 @@ static KeyNameGroupRec style_name_map[] = {
 	{ key_box_shadow_color, "box-shadow-color" },
 	{ key_pointer_events, "pointer-events" },
 	{ key_focusable, "focusable" },
+	{ key_will_change, "will-change" },
 	{ key_box_sizing, "box-sizing" },
 	{ key_flex_basis, "flex-basis" },
 	{ key_flex_direction, "flex-direction" },
@@ -238,7 +279,9 @@ static KeyNameGroupRec style_value_map[] = {
 	{ SV_NOWRAP, "nowrap" },
 	{ SV_WRAP, "wrap" },
 	{ SV_ROW, "row" },
-	{ SV_COLUMN, "column" }
+	{ SV_COLUMN, "column" },
+	{ SV_SCROLL_POSITION, "scroll-position" },
+	{ SV_OPACITY, "opacity" }
 };
 
 static int LCUI_DirectAddStyleName(int key, const char *name)
@@ -361,7 +404,7 @@ LCUI_BOOL SelectorNode_Match(LCUI_SelectorNode sn1, LCUI_SelectorNode sn2)
 		}
 		for (i = 0; sn2->classes[i]; ++i) {
 			for (j = 0; sn1->classes[j]; ++j) {
-				if (strcmp(sn2->classes[i], sn1->classes[i]) ==
+				if (strcmp(sn2->classes[i], sn1->classes[j]) ==
 				    0) {
 					j = -1;
 					break;
@@ -378,7 +421,7 @@ LCUI_BOOL SelectorNode_Match(LCUI_SelectorNode sn1, LCUI_SelectorNode sn2)
 		}
 		for (i = 0; sn2->status[i]; ++i) {
 			for (j = 0; sn1->status[j]; ++j) {
-				if (strcmp(sn2->status[i], sn1->status[i]) ==
+				if (strcmp(sn2->status[i], sn1->status[j]) ==
 				    0) {
 					j = -1;
 					break;
@@ -410,6 +453,14 @@ static void SelectorNode_Copy(LCUI_SelectorNode dst, LCUI_SelectorNode src)
 	}
 }
 
+static LCUI_SelectorNode SelectorNode_Duplicate(LCUI_SelectorNode node)
+{
+	LCUI_SelectorNode dup = NEW(LCUI_SelectorNodeRec, 1);
+
+	SelectorNode_Copy(dup, node);
+	return dup;
+}
+
 void SelectorNode_Delete(LCUI_SelectorNode node)
 {
 	if (node->type) {
@@ -1017,13 +1068,15 @@ LCUI_Selector Selector(const char *selector)
 	LCUI_SelectorNode node = NULL;
 	LCUI_Selector s = NEW(LCUI_SelectorRec, 1);
 
-	s->batch_num = ++batch_num;
 	s->nodes = NEW(LCUI_SelectorNode, MAX_SELECTOR_DEPTH);
 	if (!selector) {
 		s->length = 0;
 		s->nodes[0] = NULL;
 		return s;
 	}
+	/* 空选择器由部件生成，不参与排序，也就不需要批次号，这样部件的选择器
+	 * 可以在样式计算线程中生成 */
+	s->batch_num = ++batch_num;
 	for (ni = 0, si = 0, p = selector; *p; ++p) {
 		if (!node && is_saving) {
 			node = NEW(LCUI_SelectorNodeRec, 1);
@@ -1300,15 +1353,222 @@ static LCUI_StyleList LCUI_SelectStyleList(LCUI_Selector selector,
 	return snode->list;
 }
 
+/** 添加样式表缓存到指定名称的索引列表中 */
+static void StyleSheetCache_AddKey(StyleSheetCache cache, const char *prefix,
+				   const char *name)
+{
+	LinkedList *list;
+	StyleSheetCacheKey key;
+	char buf[MAX_NAME_LEN + 2];
+
+	snprintf(buf, MAX_NAME_LEN + 2, "%s%s", prefix, name);
+	list = Dict_FetchValue(library.cache_index, buf);
+	if (!list) {
+		list = NEW(LinkedList, 1);
+		LinkedList_Init(list);
+		Dict_Add(library.cache_index, buf, list);
+	}
+	key = &cache->keys[cache->keys_count++];
+	key->list = list;
+	key->node.data = cache;
+	LinkedList_AppendNode(list, &key->node);
+}
+
+static StyleSheetCache StyleSheetCache_New(LCUI_Selector s,
+					   LCUI_StyleSheet sheet)
+{
+	size_t i, n;
+	LCUI_SelectorNode sn;
+	StyleSheetCache cache = NEW(StyleSheetCacheRec, 1);
+
+	cache->hash = s->hash;
+	cache->sheet = sheet;
+	if (s->length < 1) {
+		return cache;
+	}
+	sn = SelectorNode_Duplicate(s->nodes[s->length - 1]);
+	cache->snode = sn;
+	n = (sn->type ? 1 : 0) + (sn->id ? 1 : 0);
+	for (i = 0; sn->classes && sn->classes[i]; ++i, ++n);
+	for (i = 0; sn->status && sn->status[i]; ++i, ++n);
+	if (n < 1) {
+		return cache;
+	}
+	cache->keys = NEW(StyleSheetCacheKeyRec, n);
+	if (sn->type) {
+		StyleSheetCache_AddKey(cache, "", sn->type);
+	}
+	if (sn->id) {
+		StyleSheetCache_AddKey(cache, "#", sn->id);
+	}
+	for (i = 0; sn->classes && sn->classes[i]; ++i) {
+		StyleSheetCache_AddKey(cache, ".", sn->classes[i]);
+	}
+	for (i = 0; sn->status && sn->status[i]; ++i) {
+		StyleSheetCache_AddKey(cache, ":", sn->status[i]);
+	}
+	return cache;
+}
+
+static void StyleSheetCache_Delete(StyleSheetCache cache)
+{
+	size_t i;
+
+	for (i = 0; i < cache->keys_count; ++i) {
+		LinkedList_Unlink(cache->keys[i].list, &cache->keys[i].node);
+	}
+	if (cache->snode) {
+		SelectorNode_Delete(cache->snode);
+	}
+	StyleSheet_Delete(cache->sheet);
+	free(cache->keys);
+	free(cache);
+}
+
+/**
+ * 移除可能受新样式规则影响的样式表缓存
+ * 规则最右边的结点只能匹配包含它的 ID、类名、状态名或类型名的结点，所以只需
+ * 要检查其中一个名称的索引列表
+ */
+static void LCUI_ClearCachedStyleSheets(LCUI_SelectorNode sn)
+{
+	char name[MAX_NAME_LEN + 2];
+	LinkedList *list;
+	LinkedListNode *node, *next;
+	StyleSheetCache cache;
+
+	if (sn->id) {
+		snprintf(name, MAX_NAME_LEN + 2, "#%s", sn->id);
+	} else if (sn->classes && sn->classes[0]) {
+		snprintf(name, MAX_NAME_LEN + 2, ".%s", sn->classes[0]);
+	} else if (sn->status && sn->status[0]) {
+		snprintf(name, MAX_NAME_LEN + 2, ":%s", sn->status[0]);
+	} else if (sn->type && strcmp(sn->type, "*") != 0) {
+		snprintf(name, MAX_NAME_LEN + 2, "%s", sn->type);
+	} else {
+		Dict_Empty(library.cache);
+		return;
+	}
+	list = Dict_FetchValue(library.cache_index, name);
+	if (!list) {
+		return;
+	}
+	for (node = list->head.next; node; node = next) {
+		next = node->next;
+		cache = node->data;
+		if (SelectorNode_Match(cache->snode, sn)) {
+			Dict_Delete(library.cache, &cache->hash);
+		}
+	}
+}
+
+void LCUI_BeginStyleSheetBatch(void)
+{
+	LCUIMutex_Lock(&library.mutex);
+	library.batch_level += 1;
+	LCUIMutex_Unlock(&library.mutex);
+}
+
+void LCUI_EndStyleSheetBatch(void)
+{
+	DictEntry *entry;
+	DictIterator *iter;
+
+	LCUIMutex_Lock(&library.mutex);
+	if (library.batch_level < 1 || --library.batch_level > 0) {
+		LCUIMutex_Unlock(&library.mutex);
+		return;
+	}
+	if (library.batch_clear_all) {
+		Dict_Empty(library.cache);
+	} else {
+		iter = Dict_GetIterator(library.batch_nodes);
+		while ((entry = Dict_Next(iter))) {
+			LCUI_ClearCachedStyleSheets(DictEntry_GetVal(entry));
+		}
+		Dict_ReleaseIterator(iter);
+	}
+	Dict_Empty(library.batch_nodes);
+	library.batch_clear_all = FALSE;
+	LCUIMutex_Unlock(&library.mutex);
+}
+
+static void LCUI_AddStyleInvalidationRule(const char *prefix,
+					  const char *name,
+					  LCUI_SelectorNode ancestor,
+					  LCUI_SelectorNode target)
+{
+	Dict *rules;
+	StyleInvalidationRule rule;
+	char key[MAX_NAME_LEN + 2];
+	char rule_key[MAX_SELECTOR_LEN];
+
+	snprintf(key, MAX_NAME_LEN + 2, "%s%s", prefix, name);
+	rules = Dict_FetchValue(library.invalidation_map, key);
+	if (!rules) {
+		rules = Dict_Create(&library.invalidation_rules_dict, NULL);
+		Dict_Add(library.invalidation_map, key, rules);
+	}
+	snprintf(rule_key, MAX_SELECTOR_LEN, "%s %s", ancestor->fullname,
+		 target->fullname);
+	if (Dict_FetchValue(rules, rule_key)) {
+		return;
+	}
+	rule = NEW(StyleInvalidationRuleRec, 1);
+	rule->ancestor = SelectorNode_Duplicate(ancestor);
+	rule->target = SelectorNode_Duplicate(target);
+	Dict_Add(rules, rule_key, rule);
+}
+
+/** 为选择器中除最右边以外的结点记录样式失效规则 */
+static void LCUI_AddStyleInvalidationRules(LCUI_Selector selector)
+{
+	int i, j;
+	LCUI_SelectorNode sn, target;
+
+	target = selector->nodes[selector->length - 1];
+	for (i = 0; i < selector->length - 1; ++i) {
+		sn = selector->nodes[i];
+		if (sn->id) {
+			LCUI_AddStyleInvalidationRule("#", sn->id, sn, target);
+		}
+		for (j = 0; sn->classes && sn->classes[j]; ++j) {
+			LCUI_AddStyleInvalidationRule(".", sn->classes[j], sn,
+						      target);
+		}
+		for (j = 0; sn->status && sn->status[j]; ++j) {
+			LCUI_AddStyleInvalidationRule(":", sn->status[j], sn,
+						      target);
+		}
+	}
+}
+
 int LCUI_PutStyleSheet(LCUI_Selector selector, LCUI_StyleSheet in_ss,
 		       const char *space)
 {
 	LCUI_StyleList list;
+	LCUI_SelectorNode sn;
+
 	LCUIMutex_Lock(&library.mutex);
-	Dict_Empty(library.cache);
 	list = LCUI_SelectStyleList(selector, space);
 	if (list) {
+		/* 其它线程可能正在锁外读取这些样式列表 */
+		while (library.readers > 0) {
+			LCUICond_Wait(&library.readers_cond, &library.mutex);
+		}
 		StyleList_Merge(list, in_ss);
+		LCUI_AddStyleInvalidationRules(selector);
+		sn = selector->nodes[selector->length - 1];
+		if (library.batch_level < 1) {
+			LCUI_ClearCachedStyleSheets(sn);
+		} else if (!sn->fullname) {
+			library.batch_clear_all = TRUE;
+		} else if (!library.batch_clear_all &&
+			   !Dict_FetchValue(library.batch_nodes,
+					    sn->fullname)) {
+			Dict_Add(library.batch_nodes, sn->fullname,
+				 SelectorNode_Duplicate(sn));
+		}
 	}
 	LCUIMutex_Unlock(&library.mutex);
 	return 0;
@@ -1422,6 +1682,47 @@ int LCUI_FindStyleSheetFromGroup(int group, const char *name, LCUI_Selector s,
 	return (int)count;
 }
 
+size_t LCUI_GetStyleInvalidationTargets(LCUI_SelectorNode sn,
+					const char *name, LinkedList *targets)
+{
+	size_t count = 0;
+	DictEntry *entry;
+	DictIterator *iter;
+	LinkedListNode *node;
+	LCUI_SelectorNode target;
+	StyleInvalidationRule rule;
+	Dict *rules;
+
+	LCUIMutex_Lock(&library.mutex);
+	rules = Dict_FetchValue(library.invalidation_map, name);
+	if (!rules) {
+		LCUIMutex_Unlock(&library.mutex);
+		return 0;
+	}
+	iter = Dict_GetIterator(rules);
+	while ((entry = Dict_Next(iter))) {
+		rule = DictEntry_GetVal(entry);
+		if (!SelectorNode_Match(sn, rule->ancestor)) {
+			continue;
+		}
+		for (LinkedList_Each(node, targets)) {
+			target = node->data;
+			if (strcmp(target->fullname, rule->target->fullname) ==
+			    0) {
+				break;
+			}
+		}
+		if (!node) {
+			LinkedList_Append(targets,
+					  SelectorNode_Duplicate(rule->target));
+			count += 1;
+		}
+	}
+	Dict_ReleaseIterator(iter);
+	LCUIMutex_Unlock(&library.mutex);
+	return count;
+}
+
 static void PrintStyleName(int key)
 {
 	const char *name;
@@ -1582,25 +1883,57 @@ void LCUI_PrintCSSLibrary(void)
 	Logger_Debug("style library end\n");
 }
 
+LCUI_CachedStyleSheet LCUI_FindCachedStyleSheet(unsigned hash)
+{
+	StyleSheetCache cache;
+
+	LCUIMutex_Lock(&library.mutex);
+	cache = Dict_FetchValue(library.cache, &hash);
+	LCUIMutex_Unlock(&library.mutex);
+	return cache ? cache->sheet : NULL;
+}
+
 LCUI_CachedStyleSheet LCUI_GetCachedStyleSheet(LCUI_Selector s)
 {
 	LinkedList list;
+	StyleSheetCache cache;
 	LinkedListNode *node;
 	LCUI_StyleSheet ss;
 
 	LinkedList_Init(&list);
-	ss = Dict_FetchValue(library.cache, &s->hash);
-	if (ss) {
-		return ss;
+	LCUIMutex_Lock(&library.mutex);
+	cache = Dict_FetchValue(library.cache, &s->hash);
+	if (cache) {
+		LCUIMutex_Unlock(&library.mutex);
+		return cache->sheet;
 	}
-	ss = StyleSheet();
 	LCUI_FindStyleSheet(s, &list);
+	/*
+	 * 在锁外合并样式表，这样多个线程可以同时处理未命中的选择器，修改
+	 * 样式列表的线程会等待合并完成
+	 */
+	library.readers += 1;
+	LCUIMutex_Unlock(&library.mutex);
+	ss = StyleSheet();
 	for (LinkedList_Each(node, &list)) {
 		StyleNode sn = node->data;
 		StyleSheet_MergeList(ss, sn->list);
 	}
 	LinkedList_Clear(&list, NULL);
-	Dict_Add(library.cache, &s->hash, ss);
+	LCUIMutex_Lock(&library.mutex);
+	if (--library.readers == 0) {
+		LCUICond_Broadcast(&library.readers_cond);
+	}
+	/* 其它线程可能已经缓存了相同选择器的样式表 */
+	cache = Dict_FetchValue(library.cache, &s->hash);
+	if (cache) {
+		LCUIMutex_Unlock(&library.mutex);
+		StyleSheet_Delete(ss);
+		return cache->sheet;
+	}
+	cache = StyleSheetCache_New(s, ss);
+	Dict_Add(library.cache, &s->hash, cache);
+	LCUIMutex_Unlock(&library.mutex);
 	return ss;
 }
 
@@ -1640,7 +1973,32 @@ void LCUI_PrintStyleSheetsBySelector(LCUI_Selector s)
 
 static void StyleSheetCacheDestructor(void *privdata, void *val)
 {
-	StyleSheet_Delete(val);
+	StyleSheetCache_Delete(val);
+}
+
+static void StyleSheetCacheIndexDestructor(void *privdata, void *val)
+{
+	LinkedList_ClearData(val, NULL);
+	free(val);
+}
+
+static void SelectorNodeDestructor(void *privdata, void *val)
+{
+	SelectorNode_Delete(val);
+}
+
+static void StyleInvalidationRuleDestructor(void *privdata, void *val)
+{
+	StyleInvalidationRule rule = val;
+
+	SelectorNode_Delete(rule->ancestor);
+	SelectorNode_Delete(rule->target);
+	free(rule);
+}
+
+static void StyleInvalidationRulesDestructor(void *privdata, void *val)
+{
+	Dict_Release(val);
 }
 
 static void *DupStyleName(void *privdata, const void *val)
@@ -1688,12 +2046,35 @@ static void InitStylesheetCache(void)
 	dt->valDestructor = StyleSheetCacheDestructor;
 	dt->keyDestructor = IntKeyDict_KeyDestructor;
 	library.cache = Dict_Create(dt, NULL);
+	dt = &library.cache_index_dict;
+	Dict_InitStringCopyKeyType(dt);
+	dt->valDestructor = StyleSheetCacheIndexDestructor;
+	library.cache_index = Dict_Create(dt, NULL);
+	dt = &library.batch_nodes_dict;
+	Dict_InitStringCopyKeyType(dt);
+	dt->valDestructor = SelectorNodeDestructor;
+	library.batch_nodes = Dict_Create(dt, NULL);
+	library.batch_level = 0;
+	library.batch_clear_all = FALSE;
+	dt = &library.invalidation_rules_dict;
+	Dict_InitStringCopyKeyType(dt);
+	dt->valDestructor = StyleInvalidationRuleDestructor;
+	dt = &library.invalidation_map_dict;
+	Dict_InitStringCopyKeyType(dt);
+	dt->valDestructor = StyleInvalidationRulesDestructor;
+	library.invalidation_map = Dict_Create(dt, NULL);
 }
 
 static void DestroyStylesheetCache(void)
 {
 	Dict_Release(library.cache);
+	Dict_Release(library.cache_index);
+	Dict_Release(library.batch_nodes);
+	Dict_Release(library.invalidation_map);
 	library.cache = NULL;
+	library.cache_index = NULL;
+	library.batch_nodes = NULL;
+	library.invalidation_map = NULL;
 }
 
 static void StyleLinkDestructor(void *privdata, void *data)
@@ -1761,6 +2142,8 @@ void LCUI_InitCSSLibrary(void)
 	InitStyleNameLibrary();
 	InitStyleValueLibrary();
 	LCUIMutex_Init(&library.mutex);
+	LCUICond_Init(&library.readers_cond);
+	library.readers = 0;
 	LinkedList_Init(&library.groups);
 	skn_end = style_name_map + LEN(style_name_map);
 	for (skn = style_name_map; skn < skn_end; ++skn) {
@@ -1781,6 +2164,7 @@ void LCUI_FreeCSSLibrary(void)
 	DestroyStyleNameLibrary();
 	DestroyStyleValueLibrary();
 	LCUIMutex_Destroy(&library.mutex);
+	LCUICond_Destroy(&library.readers_cond);
 	LinkedList_Clear(&library.groups, (FuncPtr)DeleteStyleGroup);
 	strpool_destroy(library.strpool);
 }
@@ -843,6 +843,7 @@ static LCUI_CSSPropertyParserRec style_parser_map[] = {
 	{ key_focusable, NULL, OnParseBoolean },
 	{ key_pointer_events, NULL, OnParseStyleOption },
 	{ key_box_sizing, NULL, OnParseStyleOption },
+	{ key_will_change, NULL, OnParseStyleOption },
 
 	{ key_flex_basis, NULL, OnParseFlexBasis },
 	{ key_flex_grow, NULL, OnParseFlexGrow },
@@ -1084,16 +1085,12 @@ static void LoadFontFile(void *arg1, void *arg2)
 
 static void OnParsedFontFace(LCUI_CSSFontFace face)
 {
-	static int worker_id = -1;
 	LCUI_TaskRec task = { 0 };
 	task.func = LoadFontFile;
 	task.arg[0] = strdup2(face->src);
 	task.destroy_arg[0] = free;
-	if (worker_id > -1) {
-		LCUI_PostAsyncTaskTo(&task, worker_id);
-	} else {
-		worker_id = LCUI_PostAsyncTask(&task);
-	}
+	/* 字体文件需要逐个加载，所以都交给同一个工作线程 */
+	LCUI_PostAsyncTaskTo(&task, 0);
 }
 
 static char *getdirname(const char *path)
@@ -1232,12 +1229,14 @@ int LCUI_LoadCSSFile(const char *filepath)
 		return -1;
 	}
 	ctx = CSSParser_Begin(512, filepath);
+	LCUI_BeginStyleSheetBatch();
 	n = fread(buff, 1, 511, fp);
 	while (n > 0) {
 		buff[n] = 0;
 		LCUI_LoadCSSBlock(ctx, buff);
 		n = fread(buff, 1, 511, fp);
 	}
+	LCUI_EndStyleSheetBatch();
 	CSSParser_End(ctx);
 	fclose(fp);
 	return 0;
@@ -1251,9 +1250,11 @@ size_t LCUI_LoadCSSString(const char *str, const char *space)
 
 	DEBUG_MSG("parse begin\n");
 	ctx = CSSParser_Begin(512, space);
+	LCUI_BeginStyleSheetBatch();
 	for (cur = str; len > 0; cur += len) {
 		len = LCUI_LoadCSSBlock(ctx, cur);
 	}
+	LCUI_EndStyleSheetBatch();
 	CSSParser_End(ctx);
 	DEBUG_MSG("parse end\n");
 	return 0;
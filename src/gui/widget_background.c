@@ -34,18 +34,70 @@
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
 #include <LCUI/image.h>
+#include <LCUI/settings.h>
 #include <LCUI/gui/metrics.h>
 #include <LCUI/gui/widget.h>
 #include "widget_background.h"
 
 #define ComputeActual LCUIMetrics_ComputeActual
 
+typedef enum ScaleFilter {
+	SCALE_FILTER_BILINEAR,
+	SCALE_FILTER_MIPMAP
+} ScaleFilter;
+
 typedef struct ImageCacheRec_ {
 	char *path;
 	LCUI_Graph image;
 	LinkedList refs;
+	LinkedList scaled_images;
+
+	/** 图像的原始尺寸，在读取到图像的头部信息之前为 0 */
+	int width, height;
+
+	/** 解码时的缩小倍数，为 0 时表示图像还未解码或者已被移出缓存 */
+	int scale;
+
+	/** 是否正在读取图像 */
+	LCUI_BOOL loading;
+
+	/** node in the LRU list, the least recently painted image is at the tail */
+	LinkedListNode node;
 } ImageCacheRec, *ImageCache;
 
+/** 图像加载任务，在工作线程中读取图像后交给主线程处理 */
+typedef struct ImageLoaderTaskRec_ {
+	char *path;
+	int width, height;
+
+	/** 解码时的缩小倍数，为 0 时只读取图像的尺寸 */
+	int scale;
+	LCUI_Graph image;
+} ImageLoaderTaskRec, *ImageLoaderTask;
+
+/**
+ * 缩放后的图像
+ * 以源图像、目标尺寸和缩放算法为键，由使用同一源图像的部件共享
+ */
+typedef struct ScaledImageRec_ {
+	ImageCache source;
+	ScaleFilter filter;
+	LCUI_Graph image;
+	int width, height;
+
+	/** 是否正在缩放，缩放在锁外进行，完成后才能使用 image */
+	LCUI_BOOL pending;
+
+	/** number of painters which are using this image */
+	size_t refs;
+
+	/** node in the list of the source image */
+	LinkedListNode node;
+
+	/** node in the LRU list, the least recently used image is at the tail */
+	LinkedListNode lru_node;
+} ScaledImageRec, *ScaledImage;
+
 typedef struct ImageRefRec_ {
 	LCUI_Widget widget;
 	ImageCache cache;
@@ -56,8 +108,442 @@ static struct LCUI_WidgetBackgroundModule {
 	DictType dtype;
 	Dict *images;
 	RBTree refs;
+
+	LinkedList images_lru;
+	size_t images_max_bytes;
+	LCUI_ImageCacheProfileRec images_profile;
+	LCUI_Mutex images_mutex;
+
+	LinkedList scaled_images;
+	size_t scaled_images_max_bytes;
+	LCUI_ImageCacheProfileRec scaled_images_profile;
+	LCUI_Mutex scaled_images_mutex;
+	LCUI_Cond scaled_images_cond;
+	int settings_change_handler_id;
 } self;
 
+static ImageRef GetImageRef(LCUI_Widget widget)
+{
+	return RBTree_CustomGetData(&self.refs, widget);
+}
+
+static size_t ScaledImage_GetSize(ScaledImage scaled)
+{
+	return scaled->image.mem_size;
+}
+
+static void ScaledImage_Delete(ScaledImage scaled)
+{
+	LinkedList_Unlink(&scaled->source->scaled_images, &scaled->node);
+	LinkedList_Unlink(&self.scaled_images, &scaled->lru_node);
+	self.scaled_images_profile.count -= 1;
+	self.scaled_images_profile.memory_usage -= ScaledImage_GetSize(scaled);
+	Graph_Free(&scaled->image);
+	free(scaled);
+}
+
+/** 移除最久未使用的图像，直到占用的内存不超过限制，正在使用的图像会被跳过 */
+static void EvictScaledImages(void)
+{
+	ScaledImage scaled;
+	LinkedListNode *node, *prev;
+
+	node = self.scaled_images.tail.prev;
+	while (node && node != &self.scaled_images.head &&
+	       self.scaled_images_profile.memory_usage >
+		   self.scaled_images_max_bytes) {
+		prev = node->prev;
+		scaled = node->data;
+		if (scaled->refs < 1) {
+			ScaledImage_Delete(scaled);
+			self.scaled_images_profile.eviction_count += 1;
+		}
+		node = prev;
+	}
+}
+
+/** 添加一个正在缩放的图像，其它需要它的线程会等待缩放完成 */
+static ScaledImage CreateScaledImage(ImageCache cache, int width, int height)
+{
+	ScaledImage scaled;
+
+	scaled = NEW(ScaledImageRec, 1);
+	if (!scaled) {
+		return NULL;
+	}
+	Graph_Init(&scaled->image);
+	scaled->width = width;
+	scaled->height = height;
+	scaled->pending = TRUE;
+	scaled->source = cache;
+	scaled->node.data = scaled;
+	scaled->lru_node.data = scaled;
+	LinkedList_AppendNode(&cache->scaled_images, &scaled->node);
+	LinkedList_InsertNode(&self.scaled_images, 0, &scaled->lru_node);
+	self.scaled_images_profile.count += 1;
+	return scaled;
+}
+
+/** 缩放图像，不需要加锁，源图像在绘制期间不会被释放 */
+static int ResampleImage(ImageCache cache, int width, int height,
+			 LCUI_Graph *image, ScaleFilter *filter)
+{
+	if (width * 2 <= cache->image.width &&
+	    height * 2 <= cache->image.height) {
+		*filter = SCALE_FILTER_MIPMAP;
+		return Graph_ZoomMipmap(&cache->image, image, FALSE, width,
+					height);
+	}
+	*filter = SCALE_FILTER_BILINEAR;
+	return Graph_ZoomBilinear(&cache->image, image, FALSE, width, height);
+}
+
+/**
+ * 获取缩放后的背景图，如果没有缓存则创建
+ * 由于多个绘制线程可能同时使用同一图像，使用完后需要调用 ReleaseScaledImage()
+ * 缩放在锁外进行，其它线程需要同一尺寸的图像时会等待它完成，而不是重复缩放
+ * @returns 如果背景图不是从文件中加载的，或者缩放后的图像超出缓存大小限制，则
+ *  返回 NULL
+ */
+static ScaledImage AcquireScaledImage(LCUI_Widget w, const LCUI_Graph *image,
+				      int width, int height)
+{
+	int ret;
+	ImageRef ref;
+	ImageCache cache;
+	ScaleFilter filter;
+	ScaledImage scaled = NULL;
+	LinkedListNode *node;
+	LCUI_Graph resampled;
+
+	ref = GetImageRef(w);
+	if (!ref || Graph_GetQuote(image) != &ref->cache->image) {
+		return NULL;
+	}
+	if ((size_t)width * height * image->bytes_per_pixel >
+	    self.scaled_images_max_bytes) {
+		return NULL;
+	}
+	cache = ref->cache;
+	LCUIMutex_Lock(&self.scaled_images_mutex);
+	while (1) {
+		for (LinkedList_Each(node, &cache->scaled_images)) {
+			scaled = node->data;
+			if (scaled->width == width &&
+			    scaled->height == height) {
+				break;
+			}
+		}
+		/* 等待其它线程缩放完成 */
+		if (!node || !scaled->pending) {
+			break;
+		}
+		LCUICond_Wait(&self.scaled_images_cond,
+			      &self.scaled_images_mutex);
+	}
+	if (node) {
+		LinkedList_Unlink(&self.scaled_images, &scaled->lru_node);
+		LinkedList_InsertNode(&self.scaled_images, 0,
+				      &scaled->lru_node);
+		self.scaled_images_profile.hit_count += 1;
+		scaled->refs += 1;
+		EvictScaledImages();
+		LCUIMutex_Unlock(&self.scaled_images_mutex);
+		return scaled;
+	}
+	self.scaled_images_profile.miss_count += 1;
+	scaled = CreateScaledImage(cache, width, height);
+	if (!scaled) {
+		LCUIMutex_Unlock(&self.scaled_images_mutex);
+		return NULL;
+	}
+	/* 引用后不会被移除，缩放时不需要持有锁 */
+	scaled->refs += 1;
+	LCUIMutex_Unlock(&self.scaled_images_mutex);
+
+	Graph_Init(&resampled);
+	ret = ResampleImage(cache, width, height, &resampled, &filter);
+
+	LCUIMutex_Lock(&self.scaled_images_mutex);
+	scaled->pending = FALSE;
+	if (ret == 0) {
+		scaled->image = resampled;
+		scaled->filter = filter;
+		self.scaled_images_profile.memory_usage +=
+		    ScaledImage_GetSize(scaled);
+		EvictScaledImages();
+	} else {
+		ScaledImage_Delete(scaled);
+		scaled = NULL;
+	}
+	LCUICond_Broadcast(&self.scaled_images_cond);
+	LCUIMutex_Unlock(&self.scaled_images_mutex);
+	return scaled;
+}
+
+static void ReleaseScaledImage(ScaledImage scaled)
+{
+	LCUIMutex_Lock(&self.scaled_images_mutex);
+	scaled->refs -= 1;
+	LCUIMutex_Unlock(&self.scaled_images_mutex);
+}
+
+static void DestroyScaledImages(ImageCache cache)
+{
+	LinkedListNode *node;
+
+	LCUIMutex_Lock(&self.scaled_images_mutex);
+	while ((node = LinkedList_GetNode(&cache->scaled_images, 0))) {
+		ScaledImage_Delete(node->data);
+	}
+	LCUIMutex_Unlock(&self.scaled_images_mutex);
+}
+
+void LCUIWidget_GetScaledImageCacheProfile(LCUI_ImageCacheProfile profile)
+{
+	LCUIMutex_Lock(&self.scaled_images_mutex);
+	*profile = self.scaled_images_profile;
+	self.scaled_images_profile.hit_count = 0;
+	self.scaled_images_profile.miss_count = 0;
+	self.scaled_images_profile.eviction_count = 0;
+	LCUIMutex_Unlock(&self.scaled_images_mutex);
+}
+
+static LCUI_BOOL ImageCache_IsDecoded(ImageCache cache)
+{
+	return cache->scale > 0;
+}
+
+/** 判断是否有正在显示的部件使用该图像 */
+static LCUI_BOOL ImageCache_IsDisplayed(ImageCache cache)
+{
+	LCUI_Widget w;
+	LinkedListNode *node;
+
+	for (LinkedList_Each(node, &cache->refs)) {
+		for (w = node->data; w->parent; w = w->parent) {
+			if (!Widget_IsVisible(w)) {
+				break;
+			}
+		}
+		if (w == LCUIWidget_GetRoot() && Widget_IsVisible(w)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/** 释放已解码的图像数据，保留图像的尺寸以便重新解码 */
+static void ImageCache_FreeImage(ImageCache cache)
+{
+	DestroyScaledImages(cache);
+	if (ImageCache_IsDecoded(cache)) {
+		LinkedList_Unlink(&self.images_lru, &cache->node);
+		self.images_profile.count -= 1;
+		self.images_profile.memory_usage -= cache->image.mem_size;
+	}
+	Graph_Free(&cache->image);
+	cache->scale = 0;
+}
+
+static void ImageCache_SetImage(ImageCache cache, LCUI_Graph *image,
+				int scale)
+{
+	LCUIMutex_Lock(&self.images_mutex);
+	ImageCache_FreeImage(cache);
+	cache->image = *image;
+	cache->scale = scale;
+	Graph_Init(image);
+	LinkedList_InsertNode(&self.images_lru, 0, &cache->node);
+	self.images_profile.count += 1;
+	self.images_profile.memory_usage += cache->image.mem_size;
+	LCUIMutex_Unlock(&self.images_mutex);
+}
+
+/**
+ * 计算解码时可用的最大缩小倍数，缩小后的图像不能小于背景图的实际尺寸
+ * libjpeg 支持的缩小比例有 1/2、1/4 和 1/8，其它格式的图像也按这些比例缩小
+ */
+static int ComputeDecodeScale(ImageCache cache, int width, int height)
+{
+	int scale = 8;
+
+	if (width < 1 || height < 1) {
+		return 1;
+	}
+	while (scale > 1 &&
+	       (cache->width / scale < width || cache->height / scale < height)) {
+		scale /= 2;
+	}
+	return scale;
+}
+
+/** 根据使用该图像的部件的背景尺寸计算解码时的缩小倍数 */
+static int ImageCache_ComputeScale(ImageCache cache)
+{
+	int scale = 8;
+	LCUI_Background bg;
+	LinkedListNode *node;
+
+	if (cache->refs.length < 1) {
+		return 1;
+	}
+	for (LinkedList_Each(node, &cache->refs)) {
+		Widget_ComputeBackground(node->data, &bg);
+		scale = min(scale, ComputeDecodeScale(cache, bg.size.width,
+						      bg.size.height));
+	}
+	return scale;
+}
+
+static void ImageLoaderTask_Delete(void *arg)
+{
+	ImageLoaderTask task = arg;
+
+	Graph_Free(&task->image);
+	free(task->path);
+	free(task);
+}
+
+static void OnImageLoaded(void *arg1, void *arg2);
+
+static void ExecLoadImage(void *arg1, void *arg2)
+{
+	ImageLoaderTask loader = arg1;
+
+	if (loader->scale < 1) {
+		if (LCUI_GetImageSize(loader->path, &loader->width,
+				      &loader->height) != 0) {
+			loader->width = 0;
+			loader->height = 0;
+		}
+	} else if (LCUI_ReadImageFileWithScale(loader->path, loader->scale,
+					       &loader->image) != 0) {
+		Graph_Free(&loader->image);
+	}
+}
+
+/**
+ * 在工作线程中读取图像
+ * 如果还未读取到图像的尺寸，则先读取尺寸，等部件的背景尺寸确定后再解码
+ */
+static void ImageCache_PostLoad(ImageCache cache)
+{
+	LCUI_TaskRec task = { 0 };
+	LCUI_TaskRec callback = { 0 };
+	ImageLoaderTask loader;
+
+	loader = NEW(ImageLoaderTaskRec, 1);
+	loader->path = strdup2(cache->path);
+	Graph_Init(&loader->image);
+	if (cache->width > 0) {
+		loader->scale = ImageCache_ComputeScale(cache);
+		LCUIMutex_Lock(&self.images_mutex);
+		self.images_profile.miss_count += 1;
+		LCUIMutex_Unlock(&self.images_mutex);
+	}
+	task.func = ExecLoadImage;
+	task.arg[0] = loader;
+	/* 读取结果由完成回调交给主线程处理，加载任务就由回调负责释放 */
+	callback.func = OnImageLoaded;
+	callback.arg[0] = loader;
+	callback.destroy_arg[0] = ImageLoaderTask_Delete;
+	LCUI_PostAsyncTaskEx(&task, LCUI_TASK_PRIORITY_NORMAL, &callback);
+}
+
+static void ImageCache_Load(ImageCache cache)
+{
+	LCUIMutex_Lock(&self.images_mutex);
+	if (cache->loading) {
+		LCUIMutex_Unlock(&self.images_mutex);
+		return;
+	}
+	cache->loading = TRUE;
+	LCUIMutex_Unlock(&self.images_mutex);
+	ImageCache_PostLoad(cache);
+}
+
+static void OnImageLoadRequest(void *arg1, void *arg2)
+{
+	ImageCache cache;
+
+	if (!self.active) {
+		return;
+	}
+	cache = Dict_FetchValue(self.images, arg1);
+	if (cache) {
+		ImageCache_PostLoad(cache);
+	}
+}
+
+/**
+ * 在绘制时更新图像在 LRU 链表中的位置
+ * 如果图像已被移出缓存，或者解码后的尺寸比背景图的实际尺寸小，则重新加载
+ */
+static void ImageCache_Touch(ImageCache cache, int width, int height)
+{
+	LCUI_BOOL need_load = FALSE;
+	LCUI_TaskRec task = { 0 };
+
+	LCUIMutex_Lock(&self.images_mutex);
+	if (ImageCache_IsDecoded(cache)) {
+		LinkedList_Unlink(&self.images_lru, &cache->node);
+		LinkedList_InsertNode(&self.images_lru, 0, &cache->node);
+	}
+	if (!cache->loading && cache->width > 0) {
+		if (!ImageCache_IsDecoded(cache) ||
+		    ComputeDecodeScale(cache, width, height) < cache->scale) {
+			cache->loading = TRUE;
+			need_load = TRUE;
+		} else {
+			self.images_profile.hit_count += 1;
+		}
+	}
+	LCUIMutex_Unlock(&self.images_mutex);
+	/* 绘制可能在其它线程中进行，需要交给主线程加载 */
+	if (need_load) {
+		task.func = OnImageLoadRequest;
+		task.arg[0] = strdup2(cache->path);
+		task.destroy_arg[0] = free;
+		LCUI_PostTask(&task);
+	}
+}
+
+/** 移除最久未绘制的图像，直到占用的内存不超过限制，正在显示和加载的图像会被跳过 */
+static void EvictImages(void)
+{
+	ImageCache cache;
+	LinkedListNode *node, *prev;
+
+	LCUIMutex_Lock(&self.images_mutex);
+	node = self.images_lru.tail.prev;
+	while (node && node != &self.images_lru.head &&
+	       self.images_profile.memory_usage > self.images_max_bytes) {
+		prev = node->prev;
+		cache = node->data;
+		if (!cache->loading && !ImageCache_IsDisplayed(cache)) {
+			if (cache->refs.length < 1) {
+				Dict_Delete(self.images, cache->path);
+			} else {
+				ImageCache_FreeImage(cache);
+			}
+			self.images_profile.eviction_count += 1;
+		}
+		node = prev;
+	}
+	LCUIMutex_Unlock(&self.images_mutex);
+}
+
+void LCUIWidget_GetImageCacheProfile(LCUI_ImageCacheProfile profile)
+{
+	LCUIMutex_Lock(&self.images_mutex);
+	*profile = self.images_profile;
+	self.images_profile.hit_count = 0;
+	self.images_profile.miss_count = 0;
+	self.images_profile.eviction_count = 0;
+	LCUIMutex_Unlock(&self.images_mutex);
+}
+
 static void DestroyImageCache(ImageCache cache)
 {
 	LinkedListNode *node;
@@ -68,7 +554,7 @@ static void DestroyImageCache(ImageCache cache)
 		Graph_Init(&w->computed_style.background.image);
 		LinkedList_DeleteNode(&cache->refs, node);
 	}
-	Graph_Free(&cache->image);
+	ImageCache_FreeImage(cache);
 	free(cache->path);
 	cache->path = NULL;
 	free(cache);
@@ -79,6 +565,23 @@ static void ImageCacheDestructor(void *privdata, void *data)
 	DestroyImageCache(data);
 }
 
+static ImageCache CreateImageCache(const char *path)
+{
+	ImageCache cache;
+
+	cache = NEW(ImageCacheRec, 1);
+	cache->path = strdup2(path);
+	cache->node.data = cache;
+	Graph_Init(&cache->image);
+	LinkedList_Init(&cache->refs);
+	LinkedList_Init(&cache->scaled_images);
+	if (Dict_Add(self.images, cache->path, cache) != 0) {
+		DestroyImageCache(cache);
+		return NULL;
+	}
+	return cache;
+}
+
 static void AddImageRef(LCUI_Widget widget, ImageCache cache)
 {
 	ASSIGN(ref, ImageRef);
@@ -88,11 +591,6 @@ static void AddImageRef(LCUI_Widget widget, ImageCache cache)
 	LinkedList_Append(&cache->refs, widget);
 }
 
-static ImageRef GetImageRef(LCUI_Widget widget)
-{
-	return RBTree_CustomGetData(&self.refs, widget);
-}
-
 static void DeleteImageRef(LCUI_Widget widget)
 {
 	ImageRef ref;
@@ -115,33 +613,59 @@ static void DeleteImageRef(LCUI_Widget widget)
 		break;
 	}
 	RBTree_CustomErase(&self.refs, widget);
-	if (cache->refs.length < 1) {
+	if (cache->refs.length > 0) {
+		return;
+	}
+	/* 已解码的图像留在缓存中，直到占用的内存超出限制 */
+	if (!ImageCache_IsDecoded(cache) && !cache->loading) {
 		Dict_Delete(self.images, cache->path);
+	} else {
+		EvictImages();
 	}
 }
 
-static void ExecLoadImage(void *arg1, void *arg2)
+static void OnImageLoaded(void *arg1, void *arg2)
 {
-	char *path = arg2;
-	LCUI_Graph image;
-	LCUI_Widget w = arg1;
 	ImageCache cache;
+	LinkedListNode *node;
+	ImageLoaderTask task = arg1;
 
-	Graph_Init(&image);
-	if (LCUI_ReadImageFile(path, &image) != 0) {
+	if (!self.active) {
 		return;
 	}
-	cache = NEW(ImageCacheRec, 1);
-	cache->image = image;
-	cache->path = strdup2(path);
-	LinkedList_Init(&cache->refs);
-	if (Dict_Add(self.images, cache->path, cache) == 0) {
-		AddImageRef(w, cache);
+	cache = Dict_FetchValue(self.images, task->path);
+	if (!cache) {
+		return;
+	}
+	if (task->scale < 1) {
+		cache->width = task->width;
+		cache->height = task->height;
+		if (cache->width > 0 && cache->height > 0 &&
+		    cache->refs.length > 0) {
+			ImageCache_PostLoad(cache);
+			return;
+		}
+	} else if (Graph_IsValid(&task->image)) {
+		ImageCache_SetImage(cache, &task->image, task->scale);
 	} else {
-		DestroyImageCache(cache);
+		/* 解码失败的图像不会在绘制时重新加载 */
+		cache->width = -1;
+		cache->height = -1;
 	}
-	Graph_Quote(&w->computed_style.background.image, &cache->image, NULL);
-	Widget_InvalidateArea(w, NULL, SV_BORDER_BOX);
+	LCUIMutex_Lock(&self.images_mutex);
+	cache->loading = FALSE;
+	LCUIMutex_Unlock(&self.images_mutex);
+	if (cache->refs.length < 1 && !ImageCache_IsDecoded(cache)) {
+		Dict_Delete(self.images, cache->path);
+		return;
+	}
+	for (LinkedList_Each(node, &cache->refs)) {
+		LCUI_Widget w = node->data;
+		Graph_Quote(&w->computed_style.background.image, &cache->image,
+			    NULL);
+		Widget_InvalidateArea(w, NULL, SV_BORDER_BOX);
+	}
+	EvictImages();
 }
 
 static int OnCompareWidget(void *data, const void *keydata)
@@ -160,7 +684,6 @@ static void AsyncLoadImage(LCUI_Widget widget, const char *path)
 {
 	ImageRef ref;
 	ImageCache cache;
-	LCUI_TaskRec task = { 0 };
 	LCUI_Style s = &widget->style->sheet[key_background_image];
 
 	if (!self.active) {
@@ -176,23 +699,52 @@ static void AsyncLoadImage(LCUI_Widget widget, const char *path)
 		}
 	}
 	cache = Dict_FetchValue(self.images, path);
-	if (cache) {
-		AddImageRef(widget, cache);
-		Graph_Quote(&widget->computed_style.background.image,
-			    &cache->image, NULL);
-		Widget_InvalidateArea(widget, NULL, SV_BORDER_BOX);
+	if (!cache) {
+		cache = CreateImageCache(path);
+		if (!cache) {
+			return;
+		}
+	}
+	AddImageRef(widget, cache);
+	if (!ImageCache_IsDecoded(cache)) {
+		ImageCache_Load(cache);
 		return;
 	}
-	task.func = ExecLoadImage;
-	task.arg[0] = widget;
-	task.arg[1] = strdup2(path);
-	task.destroy_arg[1] = free;
-	LCUI_PostAsyncTask(&task);
+	Graph_Quote(&widget->computed_style.background.image, &cache->image,
+		    NULL);
+	Widget_InvalidateArea(widget, NULL, SV_BORDER_BOX);
+}
+
+static void OnSettingsChangeEvent(LCUI_SysEvent e, void *arg)
+{
+	LCUI_SettingsRec settings;
+
+	Settings_Init(&settings);
+	LCUIMutex_Lock(&self.scaled_images_mutex);
+	self.scaled_images_max_bytes =
+	    (size_t)settings.scaled_image_cache_size * 1024;
+	EvictScaledImages();
+	LCUIMutex_Unlock(&self.scaled_images_mutex);
+	self.images_max_bytes = (size_t)settings.image_cache_size * 1024;
+	if (self.active) {
+		EvictImages();
+	}
 }
 
 void LCUIWidget_InitImageLoader(void)
 {
 	RBTree_Init(&self.refs);
+	LinkedList_Init(&self.scaled_images);
+	LinkedList_Init(&self.images_lru);
+	LCUIMutex_Init(&self.scaled_images_mutex);
+	LCUICond_Init(&self.scaled_images_cond);
+	LCUIMutex_Init(&self.images_mutex);
+	memset(&self.scaled_images_profile, 0,
+	       sizeof(LCUI_ImageCacheProfileRec));
+	memset(&self.images_profile, 0, sizeof(LCUI_ImageCacheProfileRec));
+	OnSettingsChangeEvent(NULL, NULL);
+	self.settings_change_handler_id = LCUI_BindEvent(
+	    LCUI_SETTINGS_CHANGE, OnSettingsChangeEvent, NULL, NULL);
 	Dict_InitStringKeyType(&self.dtype);
 	self.dtype.valDestructor = ImageCacheDestructor;
 	self.images = Dict_Create(&self.dtype, NULL);
@@ -203,10 +755,14 @@ void LCUIWidget_InitImageLoader(void)
 
 void LCUIWidget_FreeImageLoader(void)
 {
+	self.active = FALSE;
+	LCUI_UnbindEvent(self.settings_change_handler_id);
 	Dict_Release(self.images);
 	RBTree_Destroy(&self.refs);
+	LCUIMutex_Destroy(&self.scaled_images_mutex);
+	LCUICond_Destroy(&self.scaled_images_cond);
+	LCUIMutex_Destroy(&self.images_mutex);
 	self.images = NULL;
-	self.active = FALSE;
 }
 
 void Widget_InitBackground(LCUI_Widget w)
@@ -315,42 +871,58 @@ void Widget_ComputeBackgroundStyle(LCUI_Widget widget)
 	}
 }
 
+LCUI_BOOL Widget_HasBackgroundImage(LCUI_Widget w)
+{
+	return Graph_IsValid(&w->computed_style.background.image) ||
+	       GetImageRef(w);
+}
+
 void Widget_ComputeBackground(LCUI_Widget w, LCUI_Background *out)
 {
+	ImageRef ref;
 	LCUI_StyleType type;
 	LCUI_RectF *box = &w->box.border;
 	LCUI_BackgroundStyle *bg = &w->computed_style.background;
 	float scale, x = 0, y = 0, width, height;
+	float image_width = (float)bg->image.width;
+	float image_height = (float)bg->image.height;
+
+	/* 图像可能是缩小后解码的，应该按原始尺寸计算 */
+	ref = GetImageRef(w);
+	if (ref && ref->cache->width > 0) {
+		image_width = (float)ref->cache->width;
+		image_height = (float)ref->cache->height;
+	}
 
 	/* 计算背景图应有的尺寸 */
 	if (bg->size.using_value) {
 		switch (bg->size.value) {
 		case SV_CONTAIN:
 			width = box->width;
-			scale = 1.0f * bg->image.width / width;
-			height = bg->image.height / scale;
+			scale = 1.0f * image_width / width;
+			height = image_height / scale;
 			if (height > box->height) {
 				height = box->height;
-				scale = 1.0f * bg->image.height / box->height;
-				width = bg->image.width / scale;
+				scale = 1.0f * image_height / box->height;
+				width = image_width / scale;
 			}
 			break;
 		case SV_COVER:
 			width = box->width;
-			scale = 1.0f * bg->image.width / width;
-			height = bg->image.height / scale;
+			scale = 1.0f * image_width / width;
+			height = image_height / scale;
 			if (height < box->height) {
 				height = box->height;
-				scale = 1.0f * bg->image.height / height;
-				width = bg->image.width / scale;
+				scale = 1.0f * image_height / height;
+				width = image_width / scale;
 			}
 			x = (box->width - width) / 2.0f;
 			y = (box->height - height) / 2.0f;
 			break;
 		case SV_AUTO:
 		default:
-			width = (float)bg->image.width;
-			height = (float)bg->image.height;
+			width = image_width;
+			height = image_height;
 			break;
 		}
 		out->position.x = ComputeActual(x, LCUI_STYPE_PX);
@@ -365,7 +937,7 @@ void Widget_ComputeBackground(LCUI_Widget w, LCUI_Background *out)
 			break;
 		case LCUI_STYPE_NONE:
 		case LCUI_STYPE_AUTO:
-			width = (float)bg->image.width;
+			width = image_width;
 			break;
 		default:
 			width = bg->size.width.value;
@@ -380,7 +952,7 @@ void Widget_ComputeBackground(LCUI_Widget w, LCUI_Background *out)
 			break;
 		case LCUI_STYPE_NONE:
 		case LCUI_STYPE_AUTO:
-			height = (float)bg->image.height;
+			height = image_height;
 			break;
 		default:
 			height = (float)bg->size.height.value;
@@ -472,10 +1044,32 @@ void Widget_ComputeBackground(LCUI_Widget w, LCUI_Background *out)
 void Widget_PaintBakcground(LCUI_Widget w, LCUI_PaintContext paint,
 			    LCUI_WidgetActualStyle style)
 {
+	ImageRef ref;
 	LCUI_Rect box;
+	LCUI_Background bg = style->background;
+	ScaledImage scaled = NULL;
+
 	box.x = style->padding_box.x - style->canvas_box.x;
 	box.y = style->padding_box.y - style->canvas_box.y;
 	box.width = style->padding_box.width;
 	box.height = style->padding_box.height;
-	Background_Paint(&style->background, &box, paint);
+	ref = GetImageRef(w);
+	if (ref) {
+		ImageCache_Touch(ref->cache, bg.size.width, bg.size.height);
+	}
+	/* 复用缩放后的背景图，避免每次绘制都重新缩放 */
+	if (bg.image && Graph_IsValid(bg.image) && bg.size.width > 0 &&
+	    bg.size.height > 0 &&
+	    (bg.size.width != bg.image->width ||
+	     bg.size.height != bg.image->height)) {
+		scaled = AcquireScaledImage(w, bg.image, bg.size.width,
+					    bg.size.height);
+		if (scaled) {
+			bg.image = &scaled->image;
+		}
+	}
+	Background_Paint(&bg, &box, paint);
+	if (scaled) {
+		ReleaseScaledImage(scaled);
+	}
 }
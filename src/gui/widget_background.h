@@ -42,3 +42,6 @@ void Widget_PaintBakcground(LCUI_Widget w, LCUI_PaintContext paint,
 				     LCUI_WidgetActualStyle style);
 
 void Widget_ComputeBackground(LCUI_Widget w, LCUI_Background *out);
+
+/** 判断部件是否有背景图，包括已被移出缓存、会在绘制时重新加载的背景图 */
+LCUI_BOOL Widget_HasBackgroundImage(LCUI_Widget w);
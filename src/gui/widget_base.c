@@ -67,6 +67,16 @@ size_t LCUIWidget_ClearTrash(void)
 	return count;
 }
 
+LCUI_BOOL LCUIWidget_HasPendingTasks(void)
+{
+	LCUI_Widget root = LCUIWidget.root;
+
+	if (LCUIWidget.trash.length > 0) {
+		return TRUE;
+	}
+	return root && (root->task.for_self || root->task.for_children);
+}
+
 static void Widget_AddToTrash(LCUI_Widget w)
 {
 	w->state = LCUI_WSTATE_DELETED;
@@ -89,6 +99,7 @@ static void Widget_Init(LCUI_Widget widget)
 	widget->computed_style.display = SV_BLOCK;
 	widget->computed_style.position = SV_STATIC;
 	widget->computed_style.pointer_events = SV_INHERIT;
+	widget->computed_style.will_change = SV_AUTO;
 	widget->computed_style.box_sizing = SV_CONTENT_BOX;
 	LinkedList_Init(&widget->children);
 	LinkedList_Init(&widget->children_show);
@@ -134,6 +145,8 @@ void Widget_ExecDestroy(LCUI_Widget w)
 		Widget_Unlink(w);
 	}
 	Widget_DestroyBackground(w);
+	Widget_DestroyLayer(w);
+	Widget_DestroyHitIndex(w);
 	Widget_DestroyEventTrigger(w);
 	Widget_DestroyChildren(w);
 	Widget_ClearPrototype(w);
@@ -210,6 +223,7 @@ void Widget_Empty(LCUI_Widget w)
 		child->parent = NULL;
 	}
 	LinkedList_ClearData(&w->children_show, NULL);
+	Widget_InvalidateHitIndex(w);
 	LinkedList_Concat(&LCUIWidget.trash, &w->children);
 	Widget_InvalidateArea(w, NULL, SV_GRAPH_BOX);
 	Widget_UpdateStyle(w, TRUE);
@@ -388,43 +402,84 @@ float Widget_ComputeYMetric(LCUI_Widget w, int key)
 	return LCUIMetrics_Compute(s->value, s->type);
 }
 
+/** 比较两个部件的显示顺序，z-index 大的、定位方式值大的、位置靠后的在前面 */
+static int CompareWidgetShowOrder(const void *a, const void *b)
+{
+	const LCUI_Widget wa = *(const LCUI_Widget *)a;
+	const LCUI_Widget wb = *(const LCUI_Widget *)b;
+	const LCUI_WidgetStyle *sa = &wa->computed_style;
+	const LCUI_WidgetStyle *sb = &wb->computed_style;
+
+	if (sa->z_index != sb->z_index) {
+		return sa->z_index > sb->z_index ? -1 : 1;
+	}
+	if (sa->position != sb->position) {
+		return sa->position > sb->position ? -1 : 1;
+	}
+	if (wa->index != wb->index) {
+		return wa->index > wb->index ? -1 : 1;
+	}
+	return 0;
+}
+
+/** 判断显示列表是否已经包含所有可显示的子部件，并且顺序正确 */
+static LCUI_BOOL Widget_IsChildrenShowSorted(LCUI_Widget w)
+{
+	size_t n = 0;
+	LCUI_Widget child, prev = NULL;
+	LinkedListNode *node;
+
+	for (LinkedList_Each(node, &w->children)) {
+		child = node->data;
+		if (child->state >= LCUI_WSTATE_READY) {
+			++n;
+		}
+	}
+	if (n != w->children_show.length) {
+		return FALSE;
+	}
+	for (LinkedList_Each(node, &w->children_show)) {
+		child = node->data;
+		if (child->parent != w || child->state < LCUI_WSTATE_READY) {
+			return FALSE;
+		}
+		if (prev && CompareWidgetShowOrder(&prev, &child) >= 0) {
+			return FALSE;
+		}
+		prev = child;
+	}
+	return TRUE;
+}
+
 void Widget_SortChildrenShow(LCUI_Widget w)
 {
-	LCUI_Widget child, target;
-	LCUI_WidgetStyle *s, *ts;
-	LinkedListNode *node, *target_node;
+	size_t i, n = 0;
+	LCUI_Widget child, *children;
+	LinkedListNode *node;
 	LinkedList *list;
 
 	list = &w->children_show;
-	LinkedList_ClearData(list, NULL);
+	/* 顺序没有变化时不重建列表，以免子部件的空间索引失效 */
+	if (Widget_IsChildrenShowSorted(w)) {
+		return;
+	}
+	children = malloc(sizeof(LCUI_Widget) * (w->children.length + 1));
+	if (!children) {
+		return;
+	}
 	for (LinkedList_Each(node, &w->children)) {
 		child = node->data;
-		s = &child->computed_style;
-		if (child->state < LCUI_WSTATE_READY) {
-			continue;
-		}
-		for (LinkedList_Each(target_node, list)) {
-			target = target_node->data;
-			ts = &target->computed_style;
-			if (s->z_index == ts->z_index) {
-				if (s->position == ts->position) {
-					if (child->index < target->index) {
-						continue;
-					}
-				} else if (s->position < ts->position) {
-					continue;
-				}
-			} else if (s->z_index < ts->z_index) {
-				continue;
-			}
-			LinkedList_Link(list, target_node->prev,
-					&child->node_show);
-			break;
-		}
-		if (!target_node) {
-			LinkedList_AppendNode(list, &child->node_show);
+		if (child->state >= LCUI_WSTATE_READY) {
+			children[n++] = child;
 		}
 	}
+	qsort(children, n, sizeof(LCUI_Widget), CompareWidgetShowOrder);
+	LinkedList_ClearData(list, NULL);
+	for (i = 0; i < n; ++i) {
+		LinkedList_AppendNode(list, &children[i]->node_show);
+	}
+	free(children);
+	Widget_InvalidateHitIndex(w);
 }
 
 LCUI_BOOL Widget_HasAutoStyle(LCUI_Widget w, int key)
@@ -501,6 +556,9 @@ void Widget_UpdateBoxPosition(LCUI_Widget w)
 			parent = parent->parent;
 		}
 	}
+	if (w->parent && (w->x != w->box.border.x || w->y != w->box.border.y)) {
+		Widget_InvalidateHitIndex(w->parent);
+	}
 	w->box.border.x = w->x;
 	w->box.border.y = w->y;
 	w->box.padding.x = w->x + w->computed_style.border.left.width;
@@ -535,6 +593,10 @@ void Widget_UpdateBoxSize(LCUI_Widget w)
 			parent = parent->parent;
 		}
 	}
+	if (w->parent && (w->width != w->box.border.width ||
+			  w->height != w->box.border.height)) {
+		Widget_InvalidateHitIndex(w->parent);
+	}
 	w->box.border.width = w->width;
 	w->box.border.height = w->height;
 	w->box.padding.width = w->box.border.width - BorderX(w);
@@ -35,19 +35,6 @@
 #include <LCUI/gui/widget_style.h>
 #include <LCUI/gui/widget_task.h>
 
-static void Widget_MarkChildrenRefreshByClasses(LCUI_Widget w)
-{
-	LinkedListNode *node;
-
-	if (w->rules && w->rules->ignore_classes_change) {
-		return;
-	}
-	Widget_AddTask(w, LCUI_WTASK_REFRESH_STYLE);
-	for (LinkedList_Each(node, &w->children)) {
-		Widget_MarkChildrenRefreshByClasses(node->data);
-	}
-}
-
 static int Widget_HandleClassesChange(LCUI_Widget w, const char *name)
 {
 	Widget_UpdateStyle(w, TRUE);
@@ -59,8 +46,7 @@ static int Widget_HandleClassesChange(LCUI_Widget w, const char *name)
 	if (w->state < LCUI_WSTATE_READY || w->state == LCUI_WSTATE_DELETED) {
 		return 1;
 	}
-	if (Widget_GetChildrenStyleChanges(w, 0, name) > 0) {
-		Widget_MarkChildrenRefreshByClasses(w);
+	if (Widget_RefreshChildrenStyleByChanges(w, 0, name) > 0) {
 		return 1;
 	}
 	return 0;
@@ -699,15 +699,12 @@ static LCUI_Widget Widget_GetEventTarget(LCUI_Widget widget, float x, float y,
 {
 	int pointer_events;
 
-	LCUI_Widget child;
+	LCUI_Widget child = NULL;
 	LCUI_Widget target = NULL;
-	LinkedListNode *node;
 
-	for (LinkedList_Each(node, &widget->children_show)) {
-		child = node->data;
+	while ((child = Widget_GetNextChildAt(widget, child, x, y))) {
 		if (!child->computed_style.visible ||
-		    child->state != LCUI_WSTATE_NORMAL ||
-		    !LCUIRect_HasPoint(&child->box.border, x, y)) {
+		    child->state != LCUI_WSTATE_NORMAL) {
 			continue;
 		}
 		pointer_events = child->computed_style.pointer_events;
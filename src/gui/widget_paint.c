@@ -31,10 +31,12 @@
 //#define DEBUG
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
 #include <LCUI/gui/widget.h>
 #include <LCUI/display.h>
+#include <LCUI/settings.h>
 #include "widget_border.h"
 #include "widget_background.h"
 #include "widget_shadow.h"
@@ -44,6 +46,7 @@
 
 #define MAX_VISIBLE_WIDTH 20000
 #define MAX_VISIBLE_HEIGHT 20000
+#define MAX_LAYER_SIZE 4096
 
 #ifdef DEBUG_FRAME_RENDER
 #include <LCUI/image.h>
@@ -70,6 +73,9 @@ typedef struct LCUI_WidgetRendererRec_ {
 	/* computed actual style */
 	LCUI_WidgetActualStyle style;
 
+	/* opacity used to mix the widget layer */
+	float opacity;
+
 	/* current target widget paint context */
 	LCUI_PaintContext paint;
 
@@ -103,21 +109,82 @@ typedef struct LCUI_WidgetRendererRec_ {
 	LCUI_BOOL has_layer_graph;
 	LCUI_BOOL can_render_self;
 	LCUI_BOOL can_render_centent;
+
+	/* frame arena where the renderer is allocated, and its position
+	 * before the allocation */
+	LCUI_Arena arena;
+	LCUI_ArenaMarkRec arena_mark;
 } LCUI_WidgetRendererRec, *LCUI_WidgetRenderer;
 
+/**
+ * Retained layer, it holds the rasterized canvas box of a widget and its
+ * children without opacity. It is kept across frames and only the areas
+ * changed in the widget are repainted, so moving the widget or changing its
+ * opacity only needs to mix the layer again.
+ */
+typedef struct LCUI_WidgetLayerRec_ {
+	LCUI_Mutex mutex;
+	LCUI_Widget widget;
+
+	/* FALSE if the whole layer needs to be repainted */
+	LCUI_BOOL is_valid;
+	LCUI_Graph graph;
+
+	/* areas to be repainted, in actual pixels relative to the layer */
+	LCUI_DirtyRegionRec dirty;
+
+	/* node in the LRU list, the layer mixed least recently is at the
+	 * tail */
+	LinkedListNode node;
+
+	/* properties painted into the layer */
+	float scale;
+	LCUI_BorderStyle border;
+	LCUI_BackgroundStyle background;
+	LCUI_BoxShadowStyle shadow;
+} LCUI_WidgetLayerRec;
+
 static struct LCUI_WidgetRenderModule {
 	LCUI_BOOL active;
 	LCUI_WidgetPrototype default_proto;
 	RBTree groups;
 	LinkedList rects;
+
+	/* color type of layer and content canvases */
+	LCUI_ColorType layer_color_type;
+	int settings_change_handler_id;
+
+	/* retain layers for translucent widgets without will-change */
+	LCUI_BOOL retain_translucent_layers;
+
+	/* retained layers, and the memory budget of their graphs */
+	LinkedList layers_lru;
+	size_t layers_max_bytes;
+
+	/* statistics of retained layers */
+	LCUI_WidgetLayersProfileRec layers;
+	LCUI_Mutex layers_mutex;
 } self = { 0 };
 
+typedef struct LCUI_LayerTargetRec_ LCUI_LayerTargetRec, *LCUI_LayerTarget;
+
+/* a layer which collected invalid areas are added to */
+struct LCUI_LayerTargetRec_ {
+	LCUI_WidgetLayer layer;
+
+	/* position of the widget canvas, it relative to root canvas */
+	float x, y;
+
+	/* the layer of an ancestor */
+	LCUI_LayerTarget parent;
+};
+
 /** 判断部件是否有可绘制内容 */
 static LCUI_BOOL Widget_IsPaintable(LCUI_Widget w)
 {
 	const LCUI_WidgetStyle *s = &w->computed_style;
 	if (s->background.color.alpha > 0 ||
-	    Graph_IsValid(&s->background.image) || s->border.top.width > 0 ||
+	    Widget_HasBackgroundImage(w) || s->border.top.width > 0 ||
 	    s->border.right.width > 0 || s->border.bottom.width > 0 ||
 	    s->border.left.width > 0 || s->shadow.blur > 0 ||
 	    s->shadow.spread > 0) {
@@ -134,6 +201,147 @@ static LCUI_BOOL Widget_HasRoundBorder(LCUI_Widget w)
 	       s->bottom_left_radius || s->bottom_right_radius;
 }
 
+/**
+ * Widgets that will change opacity or position keep their content in a
+ * retained layer, and so do translucent widgets if it is enabled in the
+ * settings, unless they are too large to be cached.
+ */
+static LCUI_BOOL Widget_ShouldRetainLayer(LCUI_Widget w)
+{
+	float scale = LCUIMetrics_GetScale();
+	float width = w->box.canvas.width * scale;
+	float height = w->box.canvas.height * scale;
+
+	if (w->computed_style.will_change == SV_AUTO &&
+	    (!self.retain_translucent_layers ||
+	     w->computed_style.opacity >= 1.0f)) {
+		return FALSE;
+	}
+	return width <= MAX_LAYER_SIZE && height <= MAX_LAYER_SIZE &&
+	       width * height * sizeof(LCUI_ARGB) <= self.layers_max_bytes;
+}
+
+/**
+ * Add an area to be repainted to the layer
+ * @param[in] rect area relative to the canvas box of the widget
+ */
+static void WidgetLayer_AddDirtyRect(LCUI_WidgetLayer layer,
+				     const LCUI_RectF *rect)
+{
+	LCUI_Rect actual_rect;
+
+	LCUIMetrics_ComputeRectActual(&actual_rect, rect);
+	/* the layer may be aligned to the pixel grid differently */
+	actual_rect.x -= 1;
+	actual_rect.y -= 1;
+	actual_rect.width += 2;
+	actual_rect.height += 2;
+	LCUIMutex_Lock(&layer->mutex);
+	DirtyRegion_Add(&layer->dirty, &actual_rect);
+	LCUIMutex_Unlock(&layer->mutex);
+}
+
+/** Add an invalid area of the widget to its own layer */
+static void Widget_InvalidateLayer(LCUI_Widget w, LCUI_RectF *in_rect,
+				   int box_type)
+{
+	LCUI_RectF rect, box;
+
+	switch (box_type) {
+	case SV_GRAPH_BOX:
+		box = w->box.canvas;
+		break;
+	case SV_BORDER_BOX:
+		box = w->box.border;
+		break;
+	case SV_PADDING_BOX:
+		box = w->box.padding;
+		break;
+	case SV_CONTENT_BOX:
+	default:
+		box = w->box.content;
+		break;
+	}
+	if (in_rect) {
+		rect = *in_rect;
+		LCUIRectF_ValidateArea(&rect, box.width, box.height);
+		rect.x += box.x;
+		rect.y += box.y;
+	} else {
+		rect = box;
+	}
+	rect.x -= w->box.canvas.x;
+	rect.y -= w->box.canvas.y;
+	WidgetLayer_AddDirtyRect(w->layer, &rect);
+}
+
+/**
+ * Add an invalid area to the layers of ancestors
+ * @param[in] rect area relative to root canvas
+ */
+static void LayerTarget_AddDirtyRect(LCUI_LayerTarget target,
+				     const LCUI_RectF *rect)
+{
+	LCUI_RectF layer_rect;
+
+	for (; target; target = target->parent) {
+		layer_rect = *rect;
+		layer_rect.x -= target->x;
+		layer_rect.y -= target->y;
+		WidgetLayer_AddDirtyRect(target->layer, &layer_rect);
+	}
+}
+
+void Widget_DestroyLayer(LCUI_Widget w)
+{
+	LCUI_WidgetLayer layer = w->layer;
+
+	if (!layer) {
+		return;
+	}
+	if (self.active) {
+		LCUIMutex_Lock(&self.layers_mutex);
+	}
+	LinkedList_Unlink(&self.layers_lru, &layer->node);
+	self.layers.count -= 1;
+	self.layers.memory_usage -= layer->graph.mem_size;
+	if (self.active) {
+		LCUIMutex_Unlock(&self.layers_mutex);
+	}
+	Graph_Free(&layer->graph);
+	DirtyRegion_Destroy(&layer->dirty);
+	LCUIMutex_Destroy(&layer->mutex);
+	free(layer);
+	w->layer = NULL;
+}
+
+/**
+ * Destroy the layers mixed least recently until the memory usage is within
+ * the budget, they must not be in use by renderers
+ */
+static void LCUIWidget_EvictLayers(void)
+{
+	LCUI_WidgetLayer layer;
+
+	while (self.layers.memory_usage > self.layers_max_bytes &&
+	       self.layers_lru.length > 0) {
+		layer = self.layers_lru.tail.prev->data;
+		self.layers.eviction_count += 1;
+		Widget_DestroyLayer(layer->widget);
+	}
+}
+
+void LCUIWidget_GetLayersProfile(LCUI_WidgetLayersProfile profile)
+{
+	LCUIMutex_Lock(&self.layers_mutex);
+	*profile = self.layers;
+	self.layers.hit_count = 0;
+	self.layers.miss_count = 0;
+	self.layers.eviction_count = 0;
+	self.layers.paint_area = 0;
+	LCUIMutex_Unlock(&self.layers_mutex);
+}
+
 void RectFToInvalidArea(const LCUI_RectF *rect, LCUI_Rect *area)
 {
 	LCUIMetrics_ComputeRectActual(area, rect);
@@ -155,6 +363,11 @@ LCUI_BOOL Widget_InvalidateArea(LCUI_Widget w, LCUI_RectF *in_rect,
 	if (!w->computed_style.visible) {
 		return FALSE;
 	}
+	/* The invalid area of the widget may be dropped before it is
+	 * collected, so it is added to its own layer now */
+	if (w->layer) {
+		Widget_InvalidateLayer(w, in_rect, box_type);
+	}
 	if (!in_rect) {
 		switch (box_type) {
 		case SV_BORDER_BOX:
@@ -230,25 +443,57 @@ LCUI_BOOL Widget_InvalidateArea(LCUI_Widget w, LCUI_RectF *in_rect,
 	return TRUE;
 }
 
-#define AddInvalidArea()                                               \
-	do {                                                           \
-		rect.x += x;                                           \
-		rect.y += y;                                           \
-		LCUIRectF_GetOverlayRect(&rect, &visible_area, &rect); \
-		if (rect.width > 0 && rect.height > 0) {               \
-			actual_rect = malloc(sizeof(LCUI_Rect));       \
-			RectFToInvalidArea(&rect, actual_rect);        \
-			LinkedList_Append(rects, actual_rect);         \
-		}                                                      \
+typedef struct InvalidAreaCollectorRec_ {
+	LCUI_DirtyRegion region;
+
+	/* offset of the actual rects */
+	int x, y;
+
+	/* layers of the ancestors of the current widget */
+	LCUI_LayerTarget layers;
+} InvalidAreaCollectorRec, *InvalidAreaCollector;
+
+#define AddInvalidArea()                                                  \
+	do {                                                              \
+		rect.x += x;                                              \
+		rect.y += y;                                              \
+		LayerTarget_AddDirtyRect(collector->layers, &rect);       \
+		LCUIRectF_GetOverlayRect(&rect, &visible_area, &rect);    \
+		if (rect.width > 0 && rect.height > 0) {                  \
+			RectFToInvalidArea(&rect, &actual_rect);          \
+			actual_rect.x -= collector->x;                    \
+			actual_rect.y -= collector->y;                    \
+			DirtyRegion_Add(collector->region, &actual_rect); \
+		}                                                         \
 	} while (0)
 
-static void Widget_CollectInvalidArea(LCUI_Widget w, LinkedList *rects, float x,
+static void Widget_CollectInvalidArea(LCUI_Widget w,
+				      InvalidAreaCollector collector, float x,
 				      float y, LCUI_RectF visible_area)
 {
 	LCUI_RectF rect;
-	LCUI_Rect *actual_rect;
+	LCUI_Rect actual_rect;
+	LCUI_LayerTargetRec target;
 	LinkedListNode *node;
 
+	if (w->layer && !Widget_ShouldRetainLayer(w)) {
+		Widget_DestroyLayer(w);
+	}
+	/* The layer of a widget is still valid when only its position or
+	 * opacity is changed, the invalid areas are added to the layers of
+	 * its ancestors by AddInvalidArea() */
+	if (w->layer) {
+		switch (w->invalid_area_type) {
+		case LCUI_INVALID_AREA_TYPE_PADDING_BOX:
+			Widget_InvalidateLayer(w, NULL, SV_PADDING_BOX);
+			break;
+		case LCUI_INVALID_AREA_TYPE_BORDER_BOX:
+			Widget_InvalidateLayer(w, NULL, SV_BORDER_BOX);
+			break;
+		default:
+			break;
+		}
+	}
 	if (w->parent && w->parent->invalid_area_type >=
 			     LCUI_INVALID_AREA_TYPE_PADDING_BOX) {
 		w->invalid_area_type = LCUI_INVALID_AREA_TYPE_CANVAS_BOX;
@@ -283,32 +528,37 @@ static void Widget_CollectInvalidArea(LCUI_Widget w, LinkedList *rects, float x,
 					 &visible_area);
 		visible_area.x += x;
 		visible_area.y += y;
+		target.parent = collector->layers;
+		if (w->layer) {
+			target.layer = w->layer;
+			target.x = x + w->box.canvas.x;
+			target.y = y + w->box.canvas.y;
+			collector->layers = &target;
+		}
 		for (LinkedList_Each(node, &w->children_show)) {
 			Widget_CollectInvalidArea(
-			    node->data, rects, x + w->box.padding.x,
+			    node->data, collector, x + w->box.padding.x,
 			    y + w->box.padding.y, visible_area);
 		}
+		collector->layers = target.parent;
 	}
 	w->invalid_area_type = LCUI_INVALID_AREA_TYPE_NONE;
 	w->has_child_invalid_area = FALSE;
 }
 
-size_t Widget_GetInvalidArea(LCUI_Widget w, LinkedList *rects)
+size_t Widget_GetInvalidArea(LCUI_Widget w, LCUI_DirtyRegion region)
 {
-	LCUI_Rect *rect;
-	LinkedListNode *node;
-
 	float scale = LCUIMetrics_GetScale();
-	int x = iround(w->box.padding.x * scale);
-	int y = iround(w->box.padding.y * scale);
+	InvalidAreaCollectorRec collector;
 
-	Widget_CollectInvalidArea(w, rects, 0, 0, w->box.padding);
-	for (LinkedList_Each(node, rects)) {
-		rect = node->data;
-		rect->x -= x;
-		rect->y -= y;
-	}
-	return rects->length;
+	collector.region = region;
+	collector.layers = NULL;
+	collector.x = iround(w->box.padding.x * scale);
+	collector.y = iround(w->box.padding.y * scale);
+	/* no renderer is running, the layers can be destroyed */
+	LCUIWidget_EvictLayers();
+	Widget_CollectInvalidArea(w, &collector, 0, 0, w->box.padding);
+	return region->length;
 }
 
 static int OnCompareGroup(void *data, const void *keydata)
@@ -324,12 +574,35 @@ static void OnDestroyGroup(void *data)
 	group->widget = NULL;
 }
 
+static void OnSettingsChangeEvent(LCUI_SysEvent e, void *arg)
+{
+	LCUI_SettingsRec settings;
+
+	Settings_Init(&settings);
+	if (settings.premultiplied_alpha) {
+		self.layer_color_type = LCUI_COLOR_TYPE_PARGB;
+	} else {
+		self.layer_color_type = LCUI_COLOR_TYPE_ARGB;
+	}
+	self.retain_translucent_layers = settings.retain_translucent_layers;
+	self.layers_max_bytes = (size_t)settings.widget_layer_cache_size * 1024;
+	if (self.active) {
+		LCUIWidget_EvictLayers();
+	}
+}
+
 void LCUIWidget_InitRenderer(void)
 {
+	LinkedList_Init(&self.layers_lru);
+	OnSettingsChangeEvent(NULL, NULL);
+	self.settings_change_handler_id = LCUI_BindEvent(
+	    LCUI_SETTINGS_CHANGE, OnSettingsChangeEvent, NULL, NULL);
 	RBTree_Init(&self.groups);
 	RBTree_OnCompare(&self.groups, OnCompareGroup);
 	RBTree_OnDestroy(&self.groups, OnDestroyGroup);
 	LinkedList_Init(&self.rects);
+	LCUIMutex_Init(&self.layers_mutex);
+	memset(&self.layers, 0, sizeof(self.layers));
 	self.default_proto = LCUIWidget_GetPrototype(NULL);
 	self.active = TRUE;
 }
@@ -337,6 +610,9 @@ void LCUIWidget_InitRenderer(void)
 void LCUIWidget_FreeRenderer(void)
 {
 	self.active = FALSE;
+	LCUIMutex_Destroy(&self.layers_mutex);
+	LCUI_UnbindEvent(self.settings_change_handler_id);
+	self.settings_change_handler_id = -1;
 	RectList_Clear(&self.rects);
 	RBTree_Destroy(&self.groups);
 }
@@ -405,16 +681,40 @@ int Widget_ConvertArea(LCUI_Widget w, LCUI_Rect *in_rect, LCUI_Rect *out_rect,
 	return 0;
 }
 
+/**
+ * Allocate a renderer from the frame arena, the renderer and its canvases
+ * are allocated in stack order, so they can be freed by rewinding the arena.
+ */
+static LCUI_WidgetRenderer WidgetRenderer_Alloc(void)
+{
+	LCUI_ArenaMarkRec mark;
+	LCUI_WidgetRenderer that;
+	LCUI_Arena arena = LCUIFrameArena_Get();
+
+	if (!arena) {
+		that = malloc(sizeof(LCUI_WidgetRendererRec));
+		that->arena = NULL;
+		return that;
+	}
+	Arena_GetMark(arena, &mark);
+	that = Arena_Alloc(arena, sizeof(LCUI_WidgetRendererRec));
+	that->arena = arena;
+	that->arena_mark = mark;
+	return that;
+}
+
 static LCUI_WidgetRenderer WidgetRenderer(LCUI_Widget w,
 					  LCUI_PaintContext paint,
 					  LCUI_WidgetActualStyle style,
-					  LCUI_WidgetRenderer parent)
+					  LCUI_WidgetRenderer parent,
+					  float opacity)
 {
-	ASSIGN(that, LCUI_WidgetRenderer);
+	LCUI_WidgetRenderer that = WidgetRenderer_Alloc();
 
 	that->target = w;
 	that->style = style;
 	that->paint = paint;
+	that->opacity = opacity;
 	that->has_self_graph = FALSE;
 	that->has_layer_graph = FALSE;
 	that->has_content_graph = FALSE;
@@ -426,7 +726,7 @@ static LCUI_WidgetRenderer WidgetRenderer(LCUI_Widget w,
 		that->x = that->y = 0;
 		that->root_paint = that->paint;
 	}
-	if (w->computed_style.opacity < 1.0) {
+	if (opacity < 1.0) {
 		that->has_self_graph = TRUE;
 		that->has_content_graph = TRUE;
 		that->has_layer_graph = TRUE;
@@ -436,12 +736,12 @@ static LCUI_WidgetRenderer WidgetRenderer(LCUI_Widget w,
 	Graph_Init(&that->self_graph);
 	Graph_Init(&that->layer_graph);
 	Graph_Init(&that->content_graph);
-	that->layer_graph.color_type = LCUI_COLOR_TYPE_ARGB;
+	that->layer_graph.color_type = self.layer_color_type;
 	that->can_render_self = Widget_IsPaintable(w);
 	if (that->can_render_self) {
 		that->self_graph.color_type = LCUI_COLOR_TYPE_ARGB;
-		Graph_Create(&that->self_graph, that->paint->rect.width,
-			     that->paint->rect.height);
+		Graph_CreateScratch(&that->self_graph, that->paint->rect.width,
+				    that->paint->rect.height);
 	}
 	/* get content rectangle left spacing and top */
 	that->content_left = w->box.padding.x - w->box.canvas.x;
@@ -486,10 +786,10 @@ static LCUI_WidgetRenderer WidgetRenderer(LCUI_Widget w,
 		return that;
 	}
 	if (that->has_content_graph) {
-		that->content_graph.color_type = LCUI_COLOR_TYPE_ARGB;
-		Graph_Create(&that->content_graph,
-			     that->actual_content_rect.width,
-			     that->actual_content_rect.height);
+		that->content_graph.color_type = self.layer_color_type;
+		Graph_CreateScratch(&that->content_graph,
+				    that->actual_content_rect.width,
+				    that->actual_content_rect.height);
 	}
 	return that;
 }
@@ -499,7 +799,11 @@ static void WidgetRenderer_Delete(LCUI_WidgetRenderer renderer)
 	Graph_Free(&renderer->layer_graph);
 	Graph_Free(&renderer->self_graph);
 	Graph_Free(&renderer->content_graph);
-	free(renderer);
+	if (renderer->arena) {
+		Arena_Rewind(renderer->arena, &renderer->arena_mark);
+	} else {
+		free(renderer);
+	}
 }
 
 static size_t WidgetRenderer_Render(LCUI_WidgetRenderer renderer);
@@ -546,6 +850,160 @@ static void Widget_ComputeActualContentBox(LCUI_Widget w,
 	LCUIMetrics_ComputeRectActual(&s->content_box, &rect);
 }
 
+/** Compute the actual style with the canvas box at the origin */
+static void Widget_ComputeLocalActualStyle(LCUI_Widget w,
+					   LCUI_WidgetActualStyle s)
+{
+	/* compute actual canvas box */
+	s->x = s->y = 0;
+	Widget_ComputeActualBorderBox(w, s);
+	Widget_ComputeActualCanvasBox(w, s);
+	/* reset widget position to relative paint rect */
+	s->x = (float)-s->canvas_box.x;
+	s->y = (float)-s->canvas_box.y;
+	Widget_ComputeActualBorderBox(w, s);
+	Widget_ComputeActualCanvasBox(w, s);
+	Widget_ComputeActualPaddingBox(w, s);
+	Widget_ComputeActualContentBox(w, s);
+}
+
+static LCUI_WidgetLayer Widget_GetLayer(LCUI_Widget w)
+{
+	LCUI_WidgetLayer layer;
+
+	LCUIMutex_Lock(&self.layers_mutex);
+	if (!w->layer) {
+		layer = NEW(LCUI_WidgetLayerRec, 1);
+		LCUIMutex_Init(&layer->mutex);
+		Graph_Init(&layer->graph);
+		DirtyRegion_Init(&layer->dirty);
+		layer->widget = w;
+		layer->node.data = layer;
+		LinkedList_InsertNode(&self.layers_lru, 0, &layer->node);
+		w->layer = layer;
+		self.layers.count += 1;
+	} else {
+		LinkedList_Unlink(&self.layers_lru, &w->layer->node);
+		LinkedList_InsertNode(&self.layers_lru, 0, &w->layer->node);
+	}
+	layer = w->layer;
+	LCUIMutex_Unlock(&self.layers_mutex);
+	return layer;
+}
+
+static LCUI_BOOL WidgetLayer_IsValid(LCUI_WidgetLayer layer, LCUI_Widget w,
+				     LCUI_WidgetActualStyle style)
+{
+	const LCUI_WidgetStyle *s = &w->computed_style;
+
+	/* changes that have not been collected yet */
+	if (w->has_child_invalid_area ||
+	    (w->invalid_area_type != LCUI_INVALID_AREA_TYPE_NONE &&
+	     w->invalid_area_type != LCUI_INVALID_AREA_TYPE_CANVAS_BOX)) {
+		return FALSE;
+	}
+	return layer->is_valid &&
+	       layer->graph.color_type == self.layer_color_type &&
+	       layer->graph.width == (unsigned)style->canvas_box.width &&
+	       layer->graph.height == (unsigned)style->canvas_box.height &&
+	       layer->scale == LCUIMetrics_GetScale() &&
+	       memcmp(&layer->border, &s->border, sizeof(s->border)) == 0 &&
+	       memcmp(&layer->background, &s->background,
+		      sizeof(s->background)) == 0 &&
+	       memcmp(&layer->shadow, &s->shadow, sizeof(s->shadow)) == 0;
+}
+
+/** Repaint an area of the layer, it is cleared before painting */
+static void WidgetLayer_Paint(LCUI_WidgetLayer layer, LCUI_Widget w,
+			      LCUI_WidgetActualStyle style, LCUI_Rect *rect)
+{
+	LCUI_PaintContextRec paint;
+	LCUI_WidgetRenderer renderer;
+
+	Graph_FillRect(&layer->graph, ARGB(0, 0, 0, 0), rect, TRUE);
+	paint.rect = *rect;
+	paint.with_alpha = TRUE;
+	Graph_Quote(&paint.canvas, &layer->graph, rect);
+	renderer = WidgetRenderer(w, &paint, style, NULL, 1.0f);
+	WidgetRenderer_Render(renderer);
+	WidgetRenderer_Delete(renderer);
+}
+
+/**
+ * Repaint the invalid areas of the layer, the whole layer is repainted if
+ * its size or the properties painted into it are changed
+ * @returns the number of pixels repainted
+ */
+static size_t WidgetLayer_Update(LCUI_WidgetLayer layer, LCUI_Widget w,
+				 LCUI_WidgetActualStyle style)
+{
+	size_t i, area = 0;
+	size_t mem_size = layer->graph.mem_size;
+	LCUI_Rect rect;
+
+	if (!WidgetLayer_IsValid(layer, w, style)) {
+		DirtyRegion_Clear(&layer->dirty);
+		layer->graph.color_type = self.layer_color_type;
+		if (Graph_Create(&layer->graph, style->canvas_box.width,
+				 style->canvas_box.height) == 0) {
+			rect.x = 0;
+			rect.y = 0;
+			rect.width = style->canvas_box.width;
+			rect.height = style->canvas_box.height;
+			WidgetLayer_Paint(layer, w, style, &rect);
+			area = (size_t)rect.width * rect.height;
+		}
+		layer->scale = LCUIMetrics_GetScale();
+		layer->border = w->computed_style.border;
+		layer->background = w->computed_style.background;
+		layer->shadow = w->computed_style.shadow;
+		layer->is_valid = TRUE;
+	}
+	for (i = 0; i < layer->dirty.length; ++i) {
+		rect = layer->dirty.rects[i];
+		LCUIRect_ValidateArea(&rect, layer->graph.width,
+				      layer->graph.height);
+		if (rect.width > 0 && rect.height > 0) {
+			WidgetLayer_Paint(layer, w, style, &rect);
+			area += (size_t)rect.width * rect.height;
+		}
+	}
+	DirtyRegion_Clear(&layer->dirty);
+	LCUIMutex_Lock(&self.layers_mutex);
+	if (area > 0) {
+		self.layers.miss_count += 1;
+		self.layers.paint_area += area;
+	} else {
+		self.layers.hit_count += 1;
+	}
+	self.layers.memory_usage += layer->graph.mem_size;
+	self.layers.memory_usage -= mem_size;
+	LCUIMutex_Unlock(&self.layers_mutex);
+	return area;
+}
+
+/** Render a widget by mixing its retained layer, repaint it if needed */
+static size_t Widget_RenderLayer(LCUI_Widget w, LCUI_PaintContext paint)
+{
+	LCUI_Graph graph;
+	LCUI_WidgetLayer layer;
+	LCUI_WidgetActualStyleRec style;
+
+	Widget_ComputeLocalActualStyle(w, &style);
+	layer = Widget_GetLayer(w);
+	LCUIMutex_Lock(&layer->mutex);
+	WidgetLayer_Update(layer, w, &style);
+	/* Graph_Mix() reads the opacity of the quoted graph */
+	layer->graph.opacity = w->computed_style.opacity;
+	LCUIMutex_Unlock(&layer->mutex);
+	/* the layer will not be changed again until the next frame */
+	if (Graph_QuoteReadOnly(&graph, &layer->graph, &paint->rect) != 0) {
+		return 1;
+	}
+	Graph_Mix(&paint->canvas, &graph, 0, 0, paint->with_alpha);
+	return 1;
+}
+
 static size_t WidgetRenderer_RenderChildren(LCUI_WidgetRenderer that)
 {
 	size_t total = 0, count = 0;
@@ -621,7 +1079,12 @@ static size_t WidgetRenderer_RenderChildren(LCUI_WidgetRenderer that)
 		}
 		DEBUG_MSG("child paint rect: (%d, %d, %d, %d)\n", paint_rect.x,
 			  paint_rect.y, paint_rect.width, paint_rect.height);
-		renderer = WidgetRenderer(child, &child_paint, &style, that);
+		if (Widget_ShouldRetainLayer(child)) {
+			total += Widget_RenderLayer(child, &child_paint);
+			continue;
+		}
+		renderer = WidgetRenderer(child, &child_paint, &style, that,
+					  child->computed_style.opacity);
 		total += WidgetRenderer_Render(renderer);
 		WidgetRenderer_Delete(renderer);
 	}
@@ -631,6 +1094,7 @@ static size_t WidgetRenderer_RenderChildren(LCUI_WidgetRenderer that)
 static size_t WidgetRenderer_Render(LCUI_WidgetRenderer renderer)
 {
 	size_t count = 0;
+	LCUI_BOOL with_alpha;
 	LCUI_PaintContextRec self_paint;
 	LCUI_WidgetRenderer that = renderer;
 
@@ -682,8 +1146,15 @@ static size_t WidgetRenderer_Render(LCUI_WidgetRenderer renderer)
 	}
 	if (!that->has_layer_graph) {
 		if (that->has_content_graph) {
+			/* Premultiplied content can be mixed into an opaque
+			 * canvas without the source-over operator */
+			with_alpha = TRUE;
+			if (that->content_graph.color_type ==
+			    LCUI_COLOR_TYPE_PARGB) {
+				with_alpha = that->paint->with_alpha;
+			}
 			Graph_Mix(&that->paint->canvas, &that->content_graph,
-				  content_x, content_y, TRUE);
+				  content_x, content_y, with_alpha);
 		}
 #ifdef DEBUG_FRAME_RENDER
 		sprintf(filename, "frame-%lu-L%d-%s-canvas.png", frame++,
@@ -701,7 +1172,11 @@ static size_t WidgetRenderer_Render(LCUI_WidgetRenderer renderer)
 	 * 前部件的图层，然后将该图层混合到输出的位图中
 	 */
 	if (that->can_render_self) {
-		Graph_Copy(&that->layer_graph, &that->self_graph);
+		/* self graph is always straight, it is converted to the color
+		 * type of the layer here */
+		Graph_CreateScratch(&that->layer_graph, that->paint->rect.width,
+				    that->paint->rect.height);
+		Graph_Replace(&that->layer_graph, &that->self_graph, 0, 0);
 		Graph_Mix(&that->layer_graph, &that->content_graph, content_x,
 			  content_y, TRUE);
 #ifdef DEBUG_FRAME_RENDER
@@ -714,12 +1189,12 @@ static size_t WidgetRenderer_Render(LCUI_WidgetRenderer renderer)
 		LCUI_WritePNGFile(filename, &that->layer_graph);
 #endif
 	} else {
-		Graph_Create(&that->layer_graph, that->paint->rect.width,
-			     that->paint->rect.height);
+		Graph_CreateScratch(&that->layer_graph, that->paint->rect.width,
+				    that->paint->rect.height);
 		Graph_Replace(&that->layer_graph, &that->content_graph,
 			      content_x, content_y);
 	}
-	that->layer_graph.opacity = that->target->computed_style.opacity;
+	that->layer_graph.opacity = that->opacity;
 	Graph_Mix(&that->paint->canvas, &that->layer_graph, 0, 0,
 		  that->paint->with_alpha);
 #ifdef DEBUG_FRAME_RENDER
@@ -741,18 +1216,9 @@ size_t Widget_Render(LCUI_Widget w, LCUI_PaintContext paint)
 	LCUI_WidgetRenderer renderer;
 	LCUI_WidgetActualStyleRec style;
 
-	/* compute actual canvas box */
-	style.x = style.y = 0;
-	Widget_ComputeActualBorderBox(w, &style);
-	Widget_ComputeActualCanvasBox(w, &style);
-	/* reset widget position to relative paint rect */
-	style.x = (float)-style.canvas_box.x;
-	style.y = (float)-style.canvas_box.y;
-	Widget_ComputeActualBorderBox(w, &style);
-	Widget_ComputeActualCanvasBox(w, &style);
-	Widget_ComputeActualPaddingBox(w, &style);
-	Widget_ComputeActualContentBox(w, &style);
-	renderer = WidgetRenderer(w, paint, &style, NULL);
+	Widget_ComputeLocalActualStyle(w, &style);
+	renderer = WidgetRenderer(w, paint, &style, NULL,
+				  w->computed_style.opacity);
 	DEBUG_MSG("[%d] %s: start render\n", renderer->target->index,
 		  renderer->target->type);
 	count = WidgetRenderer_Render(renderer);
@@ -36,19 +36,6 @@
 #include <LCUI/gui/widget_task.h>
 #include <LCUI/gui/widget_tree.h>
 
-static void Widget_MarkChildrenRefreshByStatus(LCUI_Widget w)
-{
-	LinkedListNode *node;
-
-	if (w->rules && w->rules->ignore_status_change) {
-		return;
-	}
-	Widget_AddTask(w, LCUI_WTASK_REFRESH_STYLE);
-	for (LinkedList_Each(node, &w->children)) {
-		Widget_MarkChildrenRefreshByStatus(node->data);
-	}
-}
-
 static int Widget_HandleStatusChange(LCUI_Widget w, const char *name)
 {
 	Widget_UpdateStyle(w, TRUE);
@@ -58,8 +45,7 @@ static int Widget_HandleStatusChange(LCUI_Widget w, const char *name)
 	if (w->rules && w->rules->ignore_status_change) {
 		return 0;
 	}
-	if (Widget_GetChildrenStyleChanges(w, 1, name) > 0) {
-		Widget_MarkChildrenRefreshByStatus(w);
+	if (Widget_RefreshChildrenStyleByChanges(w, 1, name) > 0) {
 		return 1;
 	}
 	return 0;
@@ -47,6 +47,9 @@ typedef struct LCUI_TaskCacheStatus {
 	LCUI_BOOL is_valid;
 } LCUI_TaskStatus;
 
+/** 类名和状态名变化的统计数据 */
+static LCUI_WidgetStyleChangesProfileRec style_changes_profile;
+
 /* clang-format off */
 
 /** 部件的缺省样式 */
@@ -115,12 +118,18 @@ void Widget_ComputeMarginStyle(LCUI_Widget w)
 
 void Widget_ComputeProperties(LCUI_Widget w)
 {
+	int will_change;
 	LCUI_Style s;
 	LCUI_WidgetStyle *style = &w->computed_style;
 
 	s = &w->style->sheet[key_focusable];
 	style->pointer_events =
 	    ComputeStyleOption(w, key_pointer_events, SV_INHERIT);
+	will_change = ComputeStyleOption(w, key_will_change, SV_AUTO);
+	if (style->will_change != will_change) {
+		style->will_change = will_change;
+		Widget_InvalidateArea(w, NULL, SV_GRAPH_BOX);
+	}
 	if (s->is_valid && s->type == LCUI_STYPE_BOOL && s->val_bool == 0) {
 		style->focusable = FALSE;
 	} else {
@@ -590,6 +599,105 @@ size_t Widget_GetChildrenStyleChanges(LCUI_Widget w, int type, const char *name)
 	return count;
 }
 
+/** 判断部件是否匹配选择器结点 */
+static LCUI_BOOL Widget_MatchSelectorNode(LCUI_Widget w, LCUI_SelectorNode sn)
+{
+	int i;
+
+	if (sn->id && (!w->id || strcmp(w->id, sn->id) != 0)) {
+		return FALSE;
+	}
+	if (sn->type && strcmp(sn->type, "*") != 0 &&
+	    (!w->type || strcmp(w->type, sn->type) != 0)) {
+		return FALSE;
+	}
+	for (i = 0; sn->classes && sn->classes[i]; ++i) {
+		if (!strlist_has(w->classes, sn->classes[i])) {
+			return FALSE;
+		}
+	}
+	for (i = 0; sn->status && sn->status[i]; ++i) {
+		if (!strlist_has(w->status, sn->status[i])) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static size_t Widget_MarkChildrenRefreshByTargets(LCUI_Widget w, int type,
+						  LinkedList *targets)
+{
+	size_t count = 0;
+	LCUI_Widget child;
+	LinkedListNode *node, *target_node;
+
+	for (LinkedList_Each(node, &w->children)) {
+		child = node->data;
+		if (child->rules &&
+		    (type == 0 ? child->rules->ignore_classes_change
+			       : child->rules->ignore_status_change)) {
+			continue;
+		}
+		for (LinkedList_Each(target_node, targets)) {
+			if (Widget_MatchSelectorNode(child, target_node->data)) {
+				break;
+			}
+		}
+		if (target_node) {
+			Widget_AddTask(child, LCUI_WTASK_REFRESH_STYLE);
+			count += 1;
+		} else {
+			style_changes_profile.skip_count += 1;
+		}
+		count += Widget_MarkChildrenRefreshByTargets(child, type, targets);
+	}
+	return count;
+}
+
+size_t Widget_RefreshChildrenStyleByChanges(LCUI_Widget w, int type,
+					    const char *name)
+{
+	char ch;
+	size_t i, n, count = 0;
+	char key[MAX_SELECTOR_LEN], **names = NULL;
+	LinkedList targets;
+	LCUI_SelectorNode sn;
+
+	switch (type) {
+	case 0:
+		ch = '.';
+		break;
+	case 1:
+		ch = ':';
+		break;
+	default:
+		return 0;
+	}
+	LinkedList_Init(&targets);
+	sn = Widget_GetSelectorNode(w);
+	n = strsplit(name, " ", &names);
+	for (i = 0; i < n; ++i) {
+		snprintf(key, sizeof(key), "%c%s", ch, names[i]);
+		LCUI_GetStyleInvalidationTargets(sn, key, &targets);
+		free(names[i]);
+	}
+	free(names);
+	SelectorNode_Delete(sn);
+	if (targets.length > 0) {
+		count = Widget_MarkChildrenRefreshByTargets(w, type, &targets);
+		style_changes_profile.changes_count += 1;
+		style_changes_profile.refresh_count += count;
+	}
+	LinkedList_Clear(&targets, (FuncPtr)SelectorNode_Delete);
+	return count;
+}
+
+void LCUIWidget_GetStyleChangesProfile(LCUI_WidgetStyleChangesProfile profile)
+{
+	*profile = style_changes_profile;
+	memset(&style_changes_profile, 0, sizeof(style_changes_profile));
+}
+
 void Widget_PrintStyleSheets(LCUI_Widget w)
 {
 	LCUI_Selector s = Widget_GetSelector(w);
@@ -665,7 +773,7 @@ void Widget_AddTaskByStyle(LCUI_Widget w, int key)
 		  LCUI_WTASK_BACKGROUND, TRUE },
 		{ key_box_shadow_start, key_box_shadow_end, LCUI_WTASK_SHADOW,
 		  TRUE },
-		{ key_pointer_events, key_focusable, LCUI_WTASK_PROPS, TRUE }
+		{ key_pointer_events, key_will_change, LCUI_WTASK_PROPS, TRUE }
 	};
 
 	for (i = 0; i < ARRAY_LEN(task_status); ++i) {
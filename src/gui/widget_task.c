@@ -28,12 +28,16 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "config.h"
+
 #include <time.h>
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
+#include <LCUI/settings.h>
 #include <LCUI/gui/widget.h>
 #include <LCUI/gui/metrics.h>
 #include "widget_diff.h"
@@ -41,6 +45,14 @@
 #include "widget_background.h"
 #include "widget_shadow.h"
 
+/** 并行计算样式时，每个线程一次领取的部件数量 */
+#define STYLE_JOB_CHUNK 32
+
+/** 部件数量少于该值时，并行计算样式的开销大于收益 */
+#define MIN_PARALLEL_STYLE_JOBS 64
+
+#define STYLE_MEMO_SIZE 256
+
 typedef struct LCUI_WidgetTaskContextRec_ *LCUI_WidgetTaskContext;
 
 typedef struct LCUI_WidgetTaskContextRec_ {
@@ -52,11 +64,46 @@ typedef struct LCUI_WidgetTaskContextRec_ {
 	LCUI_WidgetTasksProfile profile;
 } LCUI_WidgetTaskContextRec;
 
+/** 在并行阶段计算样式的部件 */
+typedef struct LCUI_WidgetStyleJobRec_ {
+	LCUI_Widget widget;
+
+	/** 是否已经执行过样式任务，diff 中记录了执行前的样式 */
+	LCUI_BOOL computed;
+	LCUI_WidgetStyleDiffRec diff;
+} LCUI_WidgetStyleJobRec, *LCUI_WidgetStyleJob;
+
+/** 需要匹配样式表的部件列表，按深度优先顺序排列 */
+typedef struct LCUI_WidgetStyleJobsRec_ {
+	LCUI_WidgetStyleJob jobs;
+	size_t length;
+	size_t size;
+} LCUI_WidgetStyleJobsRec, *LCUI_WidgetStyleJobs;
+
+/**
+ * 线程私有的选择器记录，记录中的样式表已经在样式库中缓存，兄弟部件的选择
+ * 器大都相同，这样可以减少对样式库的加锁次数
+ */
+typedef struct LCUI_StyleMemoRec_ {
+	unsigned hashes[STYLE_MEMO_SIZE];
+	LCUI_CachedStyleSheet sheets[STYLE_MEMO_SIZE];
+} LCUI_StyleMemoRec, *LCUI_StyleMemo;
+
 static struct WidgetTaskModule {
 	DictType style_cache_dict;
 	LCUI_MetricsRec metrics;
 	LCUI_BOOL refresh_all;
 	LCUI_WidgetFunction handlers[LCUI_WTASK_TOTAL_NUM];
+
+	/** 计算样式的线程数，为 0 时不进行并行计算 */
+	int style_threads;
+
+	/** 当前更新的代号，用于判断部件记录的选择器哈希值是否有效 */
+	unsigned style_generation;
+
+	/** 本次更新中在并行阶段计算样式的部件，保留到下次更新时复用 */
+	LCUI_WidgetStyleJobsRec style_jobs;
+	int settings_change_handler_id;
 } self;
 
 static size_t Widget_UpdateWithContext(LCUI_Widget w,
@@ -162,6 +209,9 @@ void Widget_AddTask(LCUI_Widget widget, int task)
 		return;
 	}
 	DEBUG_MSG("[%lu] %s, %d\n", widget->index, widget->type, task);
+	if (task == LCUI_WTASK_REFRESH_STYLE) {
+		widget->task.selector_hash = 0;
+	}
 	widget->task.for_self = TRUE;
 	widget->task.states[task] = TRUE;
 	widget = widget->parent;
@@ -170,6 +220,22 @@ void Widget_AddTask(LCUI_Widget widget, int task)
 		widget->task.for_children = TRUE;
 		widget = widget->parent;
 	}
+	/* 标记到达了顶层部件，说明这是新产生的任务，需要唤醒主循环 */
+	if (!widget) {
+		LCUI_Wakeup();
+	}
+}
+
+static void OnSettingsChangeEvent(LCUI_SysEvent e, void *arg)
+{
+	LCUI_SettingsRec settings;
+
+	Settings_Init(&settings);
+	if (settings.parallel_style_computation) {
+		self.style_threads = settings.parallel_rendering_threads;
+	} else {
+		self.style_threads = 0;
+	}
 }
 
 void LCUIWidget_InitTasks(void)
@@ -194,11 +260,59 @@ void LCUIWidget_InitTasks(void)
 	self.handlers[LCUI_WTASK_REFLOW] = NULL;
 	InitStylesheetCacheDict();
 	self.refresh_all = TRUE;
+	self.style_generation = 1;
+	OnSettingsChangeEvent(NULL, NULL);
+	self.settings_change_handler_id = LCUI_BindEvent(
+	    LCUI_SETTINGS_CHANGE, OnSettingsChangeEvent, NULL, NULL);
 }
 
 void LCUIWidget_FreeTasks(void)
 {
+	LCUI_UnbindEvent(self.settings_change_handler_id);
 	LCUIWidget_ClearTrash();
+	free(self.style_jobs.jobs);
+	self.style_jobs.jobs = NULL;
+	self.style_jobs.length = 0;
+	self.style_jobs.size = 0;
+}
+
+static LCUI_BOOL Widget_UseResolvedStyle(LCUI_Widget w)
+{
+	unsigned hash = w->task.selector_hash;
+	LCUI_CachedStyleSheet style;
+
+	if (!hash || w->task.selector_generation != self.style_generation) {
+		return FALSE;
+	}
+	w->task.selector_hash = 0;
+	/* 样式库可能在更新过程中被修改，所以重新查找一次 */
+	style = LCUI_FindCachedStyleSheet(hash);
+	if (!style) {
+		return FALSE;
+	}
+	w->inherited_style = style;
+	return TRUE;
+}
+
+/**
+ * 取出部件在并行阶段开始的样式差异记录
+ * 部件在本次更新中被再次更新时，样式任务需要重新比较，所以记录只能用一次
+ */
+static LCUI_BOOL Widget_TakeStyleDiff(LCUI_Widget w, LCUI_WidgetStyleDiff diff)
+{
+	LCUI_WidgetStyleJob job;
+
+	if (w->task.selector_generation != self.style_generation ||
+	    w->task.style_job >= self.style_jobs.length) {
+		return FALSE;
+	}
+	job = &self.style_jobs.jobs[w->task.style_job];
+	if (job->widget != w || !job->computed) {
+		return FALSE;
+	}
+	job->computed = FALSE;
+	*diff = job->diff;
+	return TRUE;
 }
 
 LCUI_WidgetTaskContext Widget_BeginUpdate(LCUI_Widget w,
@@ -257,7 +371,7 @@ LCUI_WidgetTaskContext Widget_BeginUpdate(LCUI_Widget w,
 			Selector_Delete(selector);
 		}
 		w->inherited_style = style;
-	} else {
+	} else if (!Widget_UseResolvedStyle(w)) {
 		selector = Widget_GetSelector(w);
 		w->inherited_style = LCUI_GetCachedStyleSheet(selector);
 		Selector_Delete(selector);
@@ -464,18 +578,24 @@ static size_t Widget_UpdateWithContext(LCUI_Widget w,
 			memset(&self_ctx->style_diff, 0,
 			       sizeof(LCUI_WidgetStyleDiffRec));
 			Widget_InitStyleDiff(w, &self_ctx->style_diff);
+		} else if (Widget_TakeStyleDiff(w, &self_ctx->style_diff)) {
+			Widget_InitStyleDiff(w, &self_ctx->style_diff);
 		} else {
 			Widget_InitStyleDiff(w, &self_ctx->style_diff);
 			Widget_BeginStyleDiff(w, &self_ctx->style_diff);
 		}
+		LCUITrace_Begin("widget", "style", w->type);
 		Widget_UpdateSelf(w, self_ctx);
+		LCUITrace_End();
 		Widget_EndStyleDiff(w, &self_ctx->style_diff);
 	}
 	if (w->task.for_children) {
 		count += Widget_UpdateChildren(w, self_ctx);
 	}
 	if (w->task.states[LCUI_WTASK_REFLOW]) {
+		LCUITrace_Begin("widget", "layout", w->type);
 		Widget_Reflow(w, LCUI_LAYOUT_RULE_AUTO);
+		LCUITrace_End();
 		w->task.states[LCUI_WTASK_REFLOW] = FALSE;
 	}
 	Widget_EndLayoutDiff(w, &self_ctx->layout_diff);
@@ -484,14 +604,184 @@ static size_t Widget_UpdateWithContext(LCUI_Widget w,
 	return count;
 }
 
+static int WidgetStyleJobs_Add(LCUI_WidgetStyleJobs jobs, LCUI_Widget w)
+{
+	size_t size;
+	LCUI_WidgetStyleJob list;
+
+	if (jobs->length >= jobs->size) {
+		size = max(jobs->size * 2, 256);
+		list = realloc(jobs->jobs, sizeof(LCUI_WidgetStyleJobRec) * size);
+		if (!list) {
+			return -ENOMEM;
+		}
+		jobs->jobs = list;
+		jobs->size = size;
+	}
+	jobs->jobs[jobs->length].widget = w;
+	jobs->jobs[jobs->length].computed = FALSE;
+	jobs->length += 1;
+	return 0;
+}
+
+/**
+ * 收集将要更新的部件，与 Widget_UpdateWithContext() 的遍历规则一致，
+ * 由父级缓存子级样式表的部件仍然在更新时串行处理
+ */
+static void Widget_CollectStyleJobs(LCUI_Widget w, LCUI_WidgetStyleJobs jobs)
+{
+	LinkedListNode *node;
+
+	if (!w->task.for_self && !w->task.for_children) {
+		return;
+	}
+	if (w->rules && w->rules->cache_children_style) {
+		return;
+	}
+	if (WidgetStyleJobs_Add(jobs, w) != 0) {
+		return;
+	}
+	if (!w->task.for_children) {
+		return;
+	}
+	for (LinkedList_Each(node, &w->children)) {
+		Widget_CollectStyleJobs(node->data, jobs);
+	}
+}
+
+/**
+ * 判断样式任务是否只读写部件自身的数据
+ * 其它任务会读取父级部件的尺寸和样式，或者会修改部件树以外的状态，需要
+ * 按顺序在主线程上执行
+ */
+static LCUI_BOOL IsLocalStyleTask(int task)
+{
+	switch (task) {
+	case LCUI_WTASK_REFRESH_STYLE:
+	case LCUI_WTASK_UPDATE_STYLE:
+	case LCUI_WTASK_VISIBLE:
+	case LCUI_WTASK_DISPLAY:
+	case LCUI_WTASK_ZINDEX:
+	case LCUI_WTASK_OPACITY:
+		return TRUE;
+	default:
+		break;
+	}
+	return FALSE;
+}
+
+/** 判断部件原型是否有自己的样式处理函数，它们需要与其它任务一起按顺序执行 */
+static LCUI_BOOL Widget_HasStyleHandlers(LCUI_Widget w)
+{
+	LCUI_WidgetPrototype proto = LCUIWidget_GetPrototype(NULL);
+
+	return w->proto && (w->proto->runtask != proto->runtask ||
+			    w->proto->refresh != proto->refresh ||
+			    w->proto->update != proto->update);
+}
+
+/** 执行部件自身的样式任务，其余任务留给串行更新 */
+static void Widget_ComputeLocalStyle(LCUI_Widget w, LCUI_WidgetStyleJob job)
+{
+	int i;
+	LCUI_BOOL *states = w->task.states;
+
+	if (!w->task.for_self || Widget_HasStyleHandlers(w)) {
+		return;
+	}
+	Widget_BeginStyleDiff(w, &job->diff);
+	for (i = 0; i < LCUI_WTASK_REFLOW; ++i) {
+		if (states[i] && IsLocalStyleTask(i)) {
+			states[i] = FALSE;
+			self.handlers[i](w);
+		}
+	}
+	job->computed = TRUE;
+}
+
+static void Widget_ResolveStyle(LCUI_WidgetStyleJob job, size_t index,
+				LCUI_StyleMemo memo, unsigned generation)
+{
+	unsigned i;
+	LCUI_Selector s;
+	LCUI_Widget w = job->widget;
+
+	w->task.style_job = index;
+	w->task.selector_generation = generation;
+	s = Widget_GetSelector(w);
+	if (s) {
+		i = s->hash % STYLE_MEMO_SIZE;
+		if (!memo->sheets[i] || memo->hashes[i] != s->hash) {
+			memo->sheets[i] = LCUI_GetCachedStyleSheet(s);
+			memo->hashes[i] = s->hash;
+		}
+		w->task.selector_hash = s->hash;
+		if (w->inherited_style != memo->sheets[i]) {
+			w->inherited_style = memo->sheets[i];
+			w->task.states[LCUI_WTASK_REFRESH_STYLE] = TRUE;
+			w->task.for_self = TRUE;
+		}
+		Selector_Delete(s);
+	}
+	Widget_ComputeLocalStyle(w, job);
+}
+
+/**
+ * 在多个线程上为将要更新的部件匹配样式表并计算样式
+ * 生成选择器和匹配样式表只需要读取部件树，而部件树在此期间不会被修改，
+ * 样式库的缓存由它自己的互斥锁保护，未命中的样式表在锁外合并。连续的部件
+ * 大都属于同一棵子树，按块分配给线程可以让兄弟部件在同一线程上命中线程
+ * 私有的记录。
+ * 样式的合并以及只依赖部件自身样式的计算也在这里完成，执行前的样式记录在
+ * 任务中，串行更新时用它判断是否需要重新布局。依赖父级部件的样式计算、
+ * 布局和重排仍然在主线程上按顺序进行。
+ */
+static void Widget_ResolveStyles(LCUI_Widget root)
+{
+	int i, n;
+	unsigned generation = self.style_generation;
+	LCUI_WidgetStyleJobsRec *jobs = &self.style_jobs;
+
+	jobs->length = 0;
+	if (self.style_threads < 1) {
+		return;
+	}
+	LCUITrace_Begin("widget", "resolve styles", NULL);
+	Widget_CollectStyleJobs(root, jobs);
+	n = (int)jobs->length;
+	if (n >= MIN_PARALLEL_STYLE_JOBS) {
+#ifdef USE_OPENMP
+#pragma omp parallel num_threads(self.style_threads) private(i)
+#endif
+		{
+			LCUI_StyleMemoRec memo;
+
+			memset(&memo, 0, sizeof(memo));
+#ifdef USE_OPENMP
+#pragma omp for schedule(dynamic, STYLE_JOB_CHUNK)
+#endif
+			for (i = 0; i < n; ++i) {
+				Widget_ResolveStyle(&jobs->jobs[i], i, &memo,
+						    generation);
+			}
+		}
+	} else {
+		jobs->length = 0;
+	}
+	LCUITrace_End();
+}
+
 size_t Widget_Update(LCUI_Widget w)
 {
 	size_t count;
 	LCUI_WidgetTaskContext ctx;
 
+	Widget_ResolveStyles(w);
 	ctx = Widget_BeginUpdate(w, NULL);
 	count = Widget_UpdateWithContext(w, ctx);
 	Widget_EndUpdate(ctx);
+	/* 本次更新结束后，部件记录的选择器哈希值全部失效 */
+	self.style_generation += 1;
 	return count;
 }
 
@@ -521,10 +811,12 @@ void Widget_UpdateWithProfile(LCUI_Widget w, LCUI_WidgetTasksProfile profile)
 {
 	LCUI_WidgetTaskContext ctx;
 
+	Widget_ResolveStyles(w);
 	ctx = Widget_BeginUpdate(w, NULL);
 	ctx->profile = profile;
 	Widget_UpdateWithContext(w, ctx);
 	Widget_EndUpdate(ctx);
+	self.style_generation += 1;
 }
 
 void LCUIWidget_UpdateWithProfile(LCUI_WidgetTasksProfile profile)
@@ -29,6 +29,8 @@
  */
 
 #include <assert.h>
+#include <errno.h>
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -36,6 +38,39 @@
 #include <LCUI/LCUI.h>
 #include <LCUI/gui/widget.h>
 
+/** 子部件少于这个数量时，直接遍历显示列表比查索引更快 */
+#define HIT_INDEX_MIN_CHILDREN 16
+
+/** 平均每个格子容纳的子部件数量 */
+#define HIT_INDEX_CELL_CHILDREN 2
+
+/**
+ * 子部件所占格子的总数超过子部件数量的这个倍数时不使用索引，
+ * 说明大部分子部件都很大或者互相重叠，索引筛选不掉多少子部件
+ */
+#define HIT_INDEX_MAX_SPAN 8
+
+/**
+ * 子部件的空间索引
+ * 用均匀网格划分子部件边框区域的外接矩形，每个格子记录与它相交的子部件，
+ * 子部件在格子中的顺序与 children_show 相同
+ */
+typedef struct LCUI_WidgetHitIndexRec_ {
+	LCUI_BOOL is_valid;
+
+	/** 索引不可用，需要遍历显示列表 */
+	LCUI_BOOL is_disabled;
+
+	float x, y, cell_width, cell_height;
+	int cols, rows;
+
+	/** 第 i 个格子的子部件是 children[offsets[i]] 至 children[offsets[i+1]-1] */
+	size_t *offsets;
+	size_t offsets_size;
+	LCUI_Widget *children;
+	size_t children_size;
+} LCUI_WidgetHitIndexRec;
+
 int Widget_Append(LCUI_Widget parent, LCUI_Widget widget)
 {
 	LCUI_WidgetEventRec ev = { 0 };
@@ -188,6 +223,7 @@ int Widget_Unlink(LCUI_Widget w)
 	Widget_TriggerEvent(w, &ev, NULL);
 	LinkedList_Unlink(&w->parent->children, node);
 	LinkedList_Unlink(&w->parent->children_show, &w->node_show);
+	Widget_InvalidateHitIndex(w->parent);
 	Widget_PostSurfaceEvent(w, LCUI_WEVENT_UNLINK, TRUE);
 	Widget_AddTask(w->parent, LCUI_WTASK_REFLOW);
 	w->parent = NULL;
@@ -231,6 +267,7 @@ void Widget_DestroyChildren(LCUI_Widget w)
 	/* 先释放显示列表，后销毁部件列表，因为部件在这两个链表中的节点是和它共用
 	 * 一块内存空间的，销毁部件列表会把部件释放掉，所以把这个操作放在后面 */
 	LinkedList_ClearData(&w->children_show, NULL);
+	Widget_InvalidateHitIndex(w);
 	LinkedList_ClearData(&w->children, Widget_OnDestroy);
 }
 
@@ -309,12 +346,226 @@ size_t Widget_Each(LCUI_Widget w, void (*callback)(LCUI_Widget, void *),
 	return count;
 }
 
+/** 获取子部件边框区域所在的格子范围 */
+static void WidgetHitIndex_GetCells(LCUI_WidgetHitIndex index,
+				    LCUI_RectF *rect, int *col, int *row,
+				    int *end_col, int *end_row)
+{
+	*col = (int)((rect->x - index->x) / index->cell_width);
+	*row = (int)((rect->y - index->y) / index->cell_height);
+	*end_col = (int)((rect->x + rect->width - index->x) / index->cell_width);
+	*end_row =
+	    (int)((rect->y + rect->height - index->y) / index->cell_height);
+	*col = max(0, *col);
+	*row = max(0, *row);
+	*end_col = min(index->cols - 1, *end_col);
+	*end_row = min(index->rows - 1, *end_row);
+}
+
+static int WidgetHitIndex_Reserve(LCUI_WidgetHitIndex index, size_t n_cells,
+				  size_t n_children)
+{
+	size_t *offsets;
+	LCUI_Widget *children;
+
+	if (index->offsets_size < n_cells + 1) {
+		offsets = realloc(index->offsets, sizeof(size_t) * (n_cells + 1));
+		if (!offsets) {
+			return -ENOMEM;
+		}
+		index->offsets = offsets;
+		index->offsets_size = n_cells + 1;
+	}
+	if (index->children_size < n_children) {
+		children =
+		    realloc(index->children, sizeof(LCUI_Widget) * n_children);
+		if (!children) {
+			return -ENOMEM;
+		}
+		index->children = children;
+		index->children_size = n_children;
+	}
+	return 0;
+}
+
+/** 按照子部件当前的边框区域重建索引 */
+static void WidgetHitIndex_Build(LCUI_WidgetHitIndex index, LCUI_Widget w)
+{
+	int col, row, end_col, end_row, i, j;
+	size_t n = 0, n_cells, total = 0;
+	float right = 0, bottom = 0;
+	LCUI_Widget child;
+	LinkedListNode *node;
+
+	index->is_valid = TRUE;
+	index->is_disabled = TRUE;
+	for (LinkedList_Each(node, &w->children_show)) {
+		child = node->data;
+		if (child->box.border.width <= 0 ||
+		    child->box.border.height <= 0) {
+			continue;
+		}
+		if (n == 0) {
+			index->x = child->box.border.x;
+			index->y = child->box.border.y;
+			right = index->x + child->box.border.width;
+			bottom = index->y + child->box.border.height;
+		}
+		index->x = min(index->x, child->box.border.x);
+		index->y = min(index->y, child->box.border.y);
+		right = max(right, child->box.border.x + child->box.border.width);
+		bottom =
+		    max(bottom, child->box.border.y + child->box.border.height);
+		++n;
+	}
+	if (n < HIT_INDEX_MIN_CHILDREN) {
+		return;
+	}
+	/* 让格子尽量接近正方形 */
+	n_cells = max(1, n / HIT_INDEX_CELL_CHILDREN);
+	index->cols = (int)ceil(
+	    sqrt(n_cells * (right - index->x) / (bottom - index->y)));
+	index->cols = max(1, min((int)n_cells, index->cols));
+	index->rows = (int)((n_cells + index->cols - 1) / index->cols);
+	index->cell_width = (right - index->x) / index->cols;
+	index->cell_height = (bottom - index->y) / index->rows;
+	n_cells = (size_t)index->cols * index->rows;
+	if (WidgetHitIndex_Reserve(index, n_cells, 0) != 0) {
+		return;
+	}
+	/* 统计每个格子的子部件数量 */
+	memset(index->offsets, 0, sizeof(size_t) * (n_cells + 1));
+	for (LinkedList_Each(node, &w->children_show)) {
+		child = node->data;
+		if (child->box.border.width <= 0 ||
+		    child->box.border.height <= 0) {
+			continue;
+		}
+		WidgetHitIndex_GetCells(index, &child->box.border, &col, &row,
+					&end_col, &end_row);
+		total += (size_t)(end_col - col + 1) * (end_row - row + 1);
+		if (total > n * HIT_INDEX_MAX_SPAN) {
+			return;
+		}
+		for (i = row; i <= end_row; ++i) {
+			for (j = col; j <= end_col; ++j) {
+				index->offsets[i * index->cols + j + 1] += 1;
+			}
+		}
+	}
+	if (WidgetHitIndex_Reserve(index, n_cells, total) != 0) {
+		return;
+	}
+	for (i = 1; i <= (int)n_cells; ++i) {
+		index->offsets[i] += index->offsets[i - 1];
+	}
+	/* 填充格子，offsets[i] 会从第 i 个格子的开头移到结尾 */
+	for (LinkedList_Each(node, &w->children_show)) {
+		child = node->data;
+		if (child->box.border.width <= 0 ||
+		    child->box.border.height <= 0) {
+			continue;
+		}
+		WidgetHitIndex_GetCells(index, &child->box.border, &col, &row,
+					&end_col, &end_row);
+		for (i = row; i <= end_row; ++i) {
+			for (j = col; j <= end_col; ++j) {
+				index->children[index->offsets[i * index->cols +
+							       j]++] = child;
+			}
+		}
+	}
+	for (i = (int)n_cells; i > 0; --i) {
+		index->offsets[i] = index->offsets[i - 1];
+	}
+	index->offsets[0] = 0;
+	index->is_disabled = FALSE;
+}
+
+/** 获取可用的空间索引，子部件太少或者索引不可用时返回 NULL */
+static LCUI_WidgetHitIndex Widget_GetHitIndex(LCUI_Widget w)
+{
+	if (w->children_show.length < HIT_INDEX_MIN_CHILDREN) {
+		return NULL;
+	}
+	if (!w->hit_index) {
+		w->hit_index = NEW(LCUI_WidgetHitIndexRec, 1);
+		if (!w->hit_index) {
+			return NULL;
+		}
+	}
+	if (!w->hit_index->is_valid) {
+		WidgetHitIndex_Build(w->hit_index, w);
+	}
+	return w->hit_index->is_disabled ? NULL : w->hit_index;
+}
+
+void Widget_InvalidateHitIndex(LCUI_Widget w)
+{
+	if (w->hit_index) {
+		w->hit_index->is_valid = FALSE;
+	}
+}
+
+void Widget_DestroyHitIndex(LCUI_Widget w)
+{
+	if (!w->hit_index) {
+		return;
+	}
+	free(w->hit_index->offsets);
+	free(w->hit_index->children);
+	free(w->hit_index);
+	w->hit_index = NULL;
+}
+
+LCUI_Widget Widget_GetNextChildAt(LCUI_Widget w, LCUI_Widget prev, float x,
+				  float y)
+{
+	int col, row;
+	size_t i, end;
+	LCUI_Widget child;
+	LinkedListNode *node;
+	LCUI_WidgetHitIndex index = Widget_GetHitIndex(w);
+
+	if (!index) {
+		node = prev ? prev->node_show.next : w->children_show.head.next;
+		for (; node; node = node->next) {
+			child = node->data;
+			if (LCUIRect_HasPoint(&child->box.border, x, y)) {
+				return child;
+			}
+		}
+		return NULL;
+	}
+	if (x < index->x || y < index->y) {
+		return NULL;
+	}
+	col = (int)((x - index->x) / index->cell_width);
+	row = (int)((y - index->y) / index->cell_height);
+	if (col >= index->cols || row >= index->rows) {
+		return NULL;
+	}
+	i = index->offsets[row * index->cols + col];
+	end = index->offsets[row * index->cols + col + 1];
+	if (prev) {
+		while (i < end && index->children[i] != prev) {
+			++i;
+		}
+		++i;
+	}
+	for (; i < end; ++i) {
+		child = index->children[i];
+		if (LCUIRect_HasPoint(&child->box.border, x, y)) {
+			return child;
+		}
+	}
+	return NULL;
+}
+
 LCUI_Widget Widget_At(LCUI_Widget widget, int ix, int iy)
 {
 	float x, y;
-	LCUI_BOOL is_hit;
-	LinkedListNode *node;
-	LCUI_Widget target = widget, c = NULL;
+	LCUI_Widget target = widget, c;
 
 	if (!widget) {
 		return NULL;
@@ -322,20 +573,15 @@ LCUI_Widget Widget_At(LCUI_Widget widget, int ix, int iy)
 	x = 1.0f * ix;
 	y = 1.0f * iy;
 	do {
-		is_hit = FALSE;
-		for (LinkedList_Each(node, &target->children_show)) {
-			c = node->data;
-			if (!c->computed_style.visible) {
-				continue;
-			}
-			if (LCUIRect_HasPoint(&c->box.border, x, y)) {
-				target = c;
-				x -= c->box.padding.x;
-				y -= c->box.padding.y;
-				is_hit = TRUE;
-				break;
-			}
+		c = Widget_GetNextChildAt(target, NULL, x, y);
+		while (c && !c->computed_style.visible) {
+			c = Widget_GetNextChildAt(target, c, x, y);
+		}
+		if (c) {
+			target = c;
+			x -= c->box.padding.x;
+			y -= c->box.padding.y;
 		}
-	} while (is_hit);
+	} while (c);
 	return target == widget ? NULL : target;
 }
@@ -253,6 +253,12 @@ int LCUI_ReadJPEG(LCUI_ImageReader reader, LCUI_Graph *graph)
 		}
 	}
 	cinfo = reader->data;
+	/* 让 libjpeg 在 IDCT 阶段直接输出缩小后的图像 */
+	if (reader->scale_denom == 2 || reader->scale_denom == 4 ||
+	    reader->scale_denom == 8) {
+		cinfo->scale_num = 1;
+		cinfo->scale_denom = reader->scale_denom;
+	}
 	jpeg_start_decompress(cinfo);
 	/* 暂时不处理其它色彩类型的图像 */
 	if (cinfo->num_components != 3) {
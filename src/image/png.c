@@ -52,6 +52,11 @@
 typedef struct LCUI_PNGReaderRec_ {
 	png_structp png_ptr;
 	png_infop info_ptr;
+
+	/* 缩小读取时的行缓存和像素累加值，libpng 出错时会 longjmp 跳过释放，
+	 * 所以由读取器持有，在销毁读取器时释放 */
+	png_bytep row;
+	unsigned *sums;
 } LCUI_PNGReaderRec, *LCUI_PNGReader;
 
 static void DestroyPNGReader(void *data)
@@ -61,6 +66,8 @@ static void DestroyPNGReader(void *data)
 		png_destroy_read_struct(&reader->png_ptr, &reader->info_ptr,
 					NULL);
 	}
+	free(reader->row);
+	free(reader->sums);
 	free(reader);
 }
 
@@ -88,6 +95,8 @@ int LCUI_InitPNGReader(LCUI_ImageReader reader)
 {
 #ifdef USE_LIBPNG
 	ASSIGN(png_reader, LCUI_PNGReader);
+	png_reader->row = NULL;
+	png_reader->sums = NULL;
 	png_reader->png_ptr =
 	    png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 	ASSERT(png_reader->png_ptr);
@@ -158,6 +167,81 @@ int LCUI_ReadPNGHeader(LCUI_ImageReader reader)
 #endif
 }
 
+#ifdef USE_LIBPNG
+/**
+ * 逐行读取图像，将每 scale × scale 个像素的平均值写入缩小后的图像
+ * PNG 的颜色值没有预乘透明度，带透明度的像素需要按透明度加权求颜色的平均值，
+ * 否则透明像素的颜色会混进缩小后的图像
+ */
+static int ReadPNGRowsWithScale(LCUI_ImageReader reader, LCUI_Graph *graph,
+				int scale)
+{
+	png_uint_32 x, y, i, n, width, height, rows = 0;
+	png_bytep row, bytep;
+	unsigned *sums, alpha;
+	int k, bpp = graph->bytes_per_pixel;
+	LCUI_PNGReader png_reader = reader->data;
+
+	width = reader->header.width;
+	height = reader->header.height;
+	png_reader->row = malloc(png_get_rowbytes(png_reader->png_ptr,
+						  png_reader->info_ptr));
+	png_reader->sums = calloc((size_t)graph->width * bpp, sizeof(unsigned));
+	if (!png_reader->row || !png_reader->sums) {
+		return -ENOMEM;
+	}
+	row = png_reader->row;
+	sums = png_reader->sums;
+	for (y = 0; y < height; ++y) {
+		png_read_row(png_reader->png_ptr, row, NULL);
+		for (x = 0, i = 0; x < width; ++x, i += bpp) {
+			bytep = row + i;
+			if (bpp < 4) {
+				for (k = 0; k < bpp; ++k) {
+					sums[x / scale * bpp + k] += bytep[k];
+				}
+				continue;
+			}
+			/* 按 BGRA 的顺序累加，颜色值乘以透明度 */
+			alpha = bytep[3];
+			sums[x / scale * bpp] += bytep[0] * alpha;
+			sums[x / scale * bpp + 1] += bytep[1] * alpha;
+			sums[x / scale * bpp + 2] += bytep[2] * alpha;
+			sums[x / scale * bpp + 3] += alpha;
+		}
+		if (++rows < (png_uint_32)scale && y + 1 < height) {
+			continue;
+		}
+		bytep = graph->bytes + y / scale * graph->bytes_per_row;
+		for (x = 0, i = 0; x < graph->width; ++x, i += bpp) {
+			n = min((png_uint_32)scale, width - x * scale) * rows;
+			if (bpp < 4) {
+				for (k = 0; k < bpp; ++k) {
+					*bytep++ = (uchar_t)((sums[i + k] +
+							      n / 2) / n);
+				}
+			} else {
+				alpha = sums[i + 3];
+				for (k = 0; k < 3; ++k) {
+					*bytep++ = (uchar_t)(alpha ?
+						(sums[i + k] + alpha / 2) /
+						alpha : 0);
+				}
+				*bytep++ = (uchar_t)((alpha + n / 2) / n);
+			}
+			for (k = 0; k < bpp; ++k) {
+				sums[i + k] = 0;
+			}
+		}
+		rows = 0;
+		if (reader->fn_prog) {
+			reader->fn_prog(reader->prog_arg, 100.0f * y / height);
+		}
+	}
+	return 0;
+}
+#endif
+
 int LCUI_ReadPNG(LCUI_ImageReader reader, LCUI_Graph *graph)
 {
 #ifdef USE_LIBPNG
@@ -167,7 +251,7 @@ int LCUI_ReadPNG(LCUI_ImageReader reader, LCUI_Graph *graph)
 	png_structp png_ptr;
 	LCUI_ImageHeader header;
 	LCUI_PNGReader png_reader;
-	int pass, number_passes, ret = 0;
+	int pass, number_passes, scale = 1, ret = 0;
 	float progress;
 
 	if (reader->type != LCUI_PNG_READER) {
@@ -186,19 +270,9 @@ int LCUI_ReadPNG(LCUI_ImageReader reader, LCUI_Graph *graph)
 	switch (header->color_type) {
 	case LCUI_COLOR_TYPE_ARGB:
 		graph->color_type = LCUI_COLOR_TYPE_ARGB;
-		ret = Graph_Create(graph, header->width, header->height);
-		if (ret != 0) {
-			ret = -ENOMEM;
-			break;
-		}
 		break;
 	case LCUI_COLOR_TYPE_RGB:
 		graph->color_type = LCUI_COLOR_TYPE_RGB;
-		ret = Graph_Create(graph, header->width, header->height);
-		if (ret != 0) {
-			ret = -ENOMEM;
-			break;
-		}
 		break;
 	default:
 		/* 其它色彩类型的图像就不处理了 */
@@ -208,6 +282,19 @@ int LCUI_ReadPNG(LCUI_ImageReader reader, LCUI_Graph *graph)
 	png_set_expand(png_ptr);
 	number_passes = png_set_interlace_handling(png_ptr);
 	png_read_update_info(png_ptr, info_ptr);
+	/* 隔行扫描的图像要读完所有轮次才能得到完整的行，只能按原尺寸读取 */
+	if (number_passes == 1 && (reader->scale_denom == 2 ||
+				   reader->scale_denom == 4 ||
+				   reader->scale_denom == 8)) {
+		scale = reader->scale_denom;
+	}
+	if (Graph_Create(graph, (header->width + scale - 1) / scale,
+			 (header->height + scale - 1) / scale) != 0) {
+		return -ENOMEM;
+	}
+	if (scale > 1) {
+		return ReadPNGRowsWithScale(reader, graph, scale);
+	}
 	for (pass = 0; pass < number_passes; ++pass) {
 		for (i = 0; i < graph->height; ++i) {
 			row = graph->bytes + i * graph->bytes_per_row;
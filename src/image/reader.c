@@ -163,12 +163,43 @@ int LCUI_ReadImage(LCUI_ImageReader reader, LCUI_Graph *out)
 	return -2;
 }
 
+/** 将按原尺寸解码的图像缩小到与按比例解码时相同的尺寸 */
+static int ShrinkImage(LCUI_Graph *graph, int scale_denom)
+{
+	int ret;
+	LCUI_Graph buff;
+
+	if (graph->width <= 1 && graph->height <= 1) {
+		return 0;
+	}
+	Graph_Init(&buff);
+	ret = Graph_ZoomMipmap(graph, &buff, FALSE,
+			       (graph->width + scale_denom - 1) / scale_denom,
+			       (graph->height + scale_denom - 1) / scale_denom);
+	if (ret != 0) {
+		return ret;
+	}
+	Graph_Free(graph);
+	*graph = buff;
+	return 0;
+}
+
 int LCUI_ReadImageFile(const char *filepath, LCUI_Graph *out)
+{
+	return LCUI_ReadImageFileWithScale(filepath, 1, out);
+}
+
+int LCUI_ReadImageFileWithScale(const char *filepath, int scale_denom,
+				LCUI_Graph *out)
 {
 	int ret;
 	FILE *fp;
 	LCUI_ImageReaderRec reader = { 0 };
 
+	if (scale_denom != 2 && scale_denom != 4 && scale_denom != 8) {
+		scale_denom = 1;
+	}
+
 	fp = fopen(filepath, "rb");
 	if (!fp) {
 		return -ENOENT;
@@ -184,11 +215,17 @@ int LCUI_ReadImageFile(const char *filepath, LCUI_Graph *out)
 			return -2;
 		}
 	}
+	reader.scale_denom = scale_denom;
 	if (LCUI_SetImageReaderJump(&reader)) {
 		ret = -2;
 	} else {
 		ret = LCUI_ReadImage(&reader, out);
 	}
+	if (ret == 0 && scale_denom > 1 &&
+	    (unsigned)out->width == reader.header.width &&
+	    (unsigned)out->height == reader.header.height) {
+		ret = ShrinkImage(out, scale_denom);
+	}
 	LCUI_DestroyImageReader(&reader);
 	fclose(fp);
 	return ret;
@@ -61,6 +61,12 @@
 #define STATE_ACTIVE 1
 #define STATE_KILLED 0
 
+/* 输入任务队列的容量，队列满时输入线程会等待主循环处理 */
+#define LCUI_INPUT_QUEUE_SIZE 256
+
+/** 帧耗时超过阈值时，时间线的导出文件 */
+#define LCUI_TRACE_FILE "lcui-trace.json"
+
 typedef struct LCUI_MainLoopRec_ {
 	int state;       /**< 主循环的状态 */
 	LCUI_Thread tid; /**< 当前运行该主循环的线程的ID */
@@ -92,10 +98,15 @@ static struct LCUI_System {
 		LCUI_EventTrigger trigger;	/**< 系统事件容器 */
 		LCUI_Mutex mutex;		/**< 互斥锁 */
 	} event;
+	struct {
+		LCUI_BOOL active;		/**< 是否已经初始化 */
+		LCUI_BOOL signaled;		/**< 是否有新的工作需要处理 */
+		LCUI_Mutex mutex;		/**< 互斥锁 */
+		LCUI_Cond cond;			/**< 条件变量，用于唤醒空闲的主循环 */
+		size_t wakeup_count;		/**< 从空闲等待中被唤醒的次数 */
+	} idle;
 } System;
 
-#define LCUI_WORKER_NUM 4
-
 /** LCUI 应用程序数据 */
 static struct LCUI_App {
 	LCUI_BOOL active;			/**< 是否已经初始化并处于活动状态 */
@@ -107,8 +118,8 @@ static struct LCUI_App {
 	LCUI_AppDriver driver;			/**< 程序事件驱动支持 */
 	LCUI_BOOL driver_ready;			/**< 事件驱动支持是否已经准备就绪 */
 	LCUI_Worker main_worker;		/**< 主工作线程 */
-	LCUI_Worker workers[LCUI_WORKER_NUM];	/**< 普通工作线程 */
-	int worker_next;			/**< 下一个工作线程编号 */
+	LCUI_WorkerPool workers;		/**< 异步任务的工作线程池 */
+	LCUI_TaskRing input_tasks;		/**< 输入任务队列 */
 	LCUI_SettingsRec settings;
 	LCUI_ProfileRec profile;
 	LCUI_FrameProfile frame;
@@ -126,9 +137,21 @@ static void LCUIProfile_Print(LCUI_Profile profile)
 {
 	unsigned i;
 	LCUI_FrameProfile frame;
+	LCUI_LatencyHistogramRec latency;
 
 	Logger_Debug("\nframes_count: %zu, time: %ld\n", profile->frames_count,
 		     profile->end_time - profile->start_time);
+	Logger_Debug("idle_wakeups: %u, idle_time: %ldms\n",
+		     profile->idle_wakeups, (long)profile->idle_time);
+	if (MainApp.input_tasks) {
+		TaskRing_GetLatency(MainApp.input_tasks, &latency);
+		Logger_Debug("input_tasks: %zu, latency p50: %ldus, "
+			     "p99: %ldus, max: %ldus\n",
+			     latency.count,
+			     (long)LatencyHistogram_GetPercentile(&latency, 50),
+			     (long)LatencyHistogram_GetPercentile(&latency, 99),
+			     (long)latency.max);
+	}
 	for (i = 0; i < profile->frames_count; ++i) {
 		frame = &profile->frames[i];
 		Logger_Debug("=== frame [%u/%u] ===\n", i + 1,
@@ -153,6 +176,63 @@ static void LCUIProfile_Print(LCUI_Profile profile)
 			     frame->widget_tasks.destroy_time);
 		Logger_Debug("render: %zu, %ldms, %ldms\n", frame->render_count,
 			     frame->render_time, frame->present_time);
+		Logger_Debug("present.bytes: %zu\n", frame->present_bytes);
+		Logger_Debug("widget_layers.hit_count: %zu\n"
+			     "widget_layers.miss_count: %zu\n"
+			     "widget_layers.eviction_count: %zu\n"
+			     "widget_layers.paint_area: %zu\n"
+			     "widget_layers.count: %zu\n"
+			     "widget_layers.memory_usage: %zu\n",
+			     frame->widget_layers.hit_count,
+			     frame->widget_layers.miss_count,
+			     frame->widget_layers.eviction_count,
+			     frame->widget_layers.paint_area,
+			     frame->widget_layers.count,
+			     frame->widget_layers.memory_usage);
+		Logger_Debug("widget_style_changes.changes_count: %zu\n"
+			     "widget_style_changes.refresh_count: %zu\n"
+			     "widget_style_changes.skip_count: %zu\n",
+			     frame->widget_style_changes.changes_count,
+			     frame->widget_style_changes.refresh_count,
+			     frame->widget_style_changes.skip_count);
+		Logger_Debug("frame_arena.alloc_count: %zu\n"
+			     "frame_arena.alloc_bytes: %zu\n"
+			     "frame_arena.memory_usage: %zu\n",
+			     frame->frame_arena.alloc_count,
+			     frame->frame_arena.alloc_bytes,
+			     frame->frame_arena.memory_usage);
+		Logger_Debug("glyph_cache.hit_count: %zu\n"
+			     "glyph_cache.miss_count: %zu\n"
+			     "glyph_cache.eviction_count: %zu\n"
+			     "glyph_cache.file_hit_count: %zu\n"
+			     "glyph_cache.count: %zu\n"
+			     "glyph_cache.memory_usage: %zu\n",
+			     frame->glyph_cache.hit_count,
+			     frame->glyph_cache.miss_count,
+			     frame->glyph_cache.eviction_count,
+			     frame->glyph_cache.file_hit_count,
+			     frame->glyph_cache.count,
+			     frame->glyph_cache.memory_usage);
+		Logger_Debug("scaled_image_cache.hit_count: %zu\n"
+			     "scaled_image_cache.miss_count: %zu\n"
+			     "scaled_image_cache.eviction_count: %zu\n"
+			     "scaled_image_cache.count: %zu\n"
+			     "scaled_image_cache.memory_usage: %zu\n",
+			     frame->scaled_image_cache.hit_count,
+			     frame->scaled_image_cache.miss_count,
+			     frame->scaled_image_cache.eviction_count,
+			     frame->scaled_image_cache.count,
+			     frame->scaled_image_cache.memory_usage);
+		Logger_Debug("image_cache.hit_count: %zu\n"
+			     "image_cache.miss_count: %zu\n"
+			     "image_cache.eviction_count: %zu\n"
+			     "image_cache.count: %zu\n"
+			     "image_cache.memory_usage: %zu\n",
+			     frame->image_cache.hit_count,
+			     frame->image_cache.miss_count,
+			     frame->image_cache.eviction_count,
+			     frame->image_cache.count,
+			     frame->image_cache.memory_usage);
 	}
 }
 
@@ -161,10 +241,12 @@ static LCUI_FrameProfile LCUIProfile_BeginFrame(LCUI_Profile profile,
 {
 	LCUI_FrameProfile frame;
 
-	frame = &profile->frames[profile->frames_count];
-	if (profile->frames_count > (unsigned)settings->frame_rate_cap) {
+	/* 无头显示时不限制帧率，一秒内的帧数可能超出记录的容量 */
+	if (profile->frames_count >= LCUI_MAX_FRAMES_PER_SEC ||
+	    profile->frames_count > (unsigned)settings->frame_rate_cap) {
 		profile->frames_count = 0;
 	}
+	frame = &profile->frames[profile->frames_count];
 	memset(frame, 0, sizeof(LCUI_FrameProfileRec));
 	return frame;
 }
@@ -178,7 +260,12 @@ static void LCUIProfile_EndFrame(LCUI_Profile profile, LCUI_Settings settings)
 			LCUIProfile_Print(profile);
 		}
 		profile->frames_count = 0;
+		profile->idle_wakeups = 0;
+		profile->idle_time = 0;
 		profile->start_time = profile->end_time;
+		if (MainApp.input_tasks) {
+			TaskRing_ResetLatency(MainApp.input_tasks);
+		}
 	}
 }
 
@@ -186,40 +273,101 @@ static void OnSettingsChangeEvent(LCUI_SysEvent e, void *arg)
 {
 	Settings_Init(&MainApp.settings);
 	StepTimer_SetFrameLimit(MainApp.timer, MainApp.settings.frame_rate_cap);
+	LCUITrace_Enable(MainApp.settings.trace_frames);
+}
+
+/** 开始记录一帧的时间线，如果没有启用时间线记录，则返回 0 */
+static int64_t LCUI_BeginFrameTrace(void)
+{
+	if (!LCUITrace_IsEnabled()) {
+		return 0;
+	}
+	LCUITrace_Begin("frame", "frame", NULL);
+	return LCUI_GetTimeUs();
+}
+
+static void LCUI_EndFrameTrace(int64_t start)
+{
+	int64_t threshold;
+
+	if (!start) {
+		return;
+	}
+	LCUITrace_End();
+	threshold = MainApp.settings.trace_frame_threshold * 1000;
+	if (threshold > 0 && LCUI_GetTimeUs() - start >= threshold) {
+		LCUITrace_DumpFile(LCUI_TRACE_FILE);
+	}
 }
 
 void LCUI_RunFrameWithProfile(LCUI_FrameProfile profile)
 {
+	int64_t start = LCUI_BeginFrameTrace();
+
+	LCUITrace_Begin("frame", "timers", NULL);
 	profile->timers_time = clock();
 	profile->timers_count = LCUI_ProcessTimers();
 	profile->timers_time = clock() - profile->timers_time;
+	LCUITrace_End();
 
+	LCUITrace_Begin("frame", "events", NULL);
 	profile->events_time = clock();
 	profile->events_count = LCUI_ProcessEvents();
 	profile->events_time = clock() - profile->events_time;
+	LCUITrace_End();
 
 	LCUICursor_Update();
+	LCUITrace_Begin("frame", "widget update", NULL);
 	LCUIWidget_UpdateWithProfile(&profile->widget_tasks);
+	LCUIWidget_GetStyleChangesProfile(&profile->widget_style_changes);
+	LCUITrace_End();
 
 	profile->render_time = clock();
+	LCUITrace_Begin("frame", "display update", NULL);
 	LCUIDisplay_Update();
+	LCUITrace_End();
+	LCUITrace_Begin("frame", "render", NULL);
 	profile->render_count = LCUIDisplay_Render();
+	LCUITrace_End();
 	profile->render_time = clock() - profile->render_time;
+	LCUIWidget_GetLayersProfile(&profile->widget_layers);
+	LCUIFrameArena_GetProfile(&profile->frame_arena);
+	LCUIFont_GetBitmapCacheProfile(&profile->glyph_cache);
+	LCUIWidget_GetScaledImageCacheProfile(&profile->scaled_image_cache);
+	LCUIWidget_GetImageCacheProfile(&profile->image_cache);
 
+	LCUITrace_Begin("frame", "present", NULL);
 	profile->present_time = clock();
-	LCUIDisplay_Present();
+	profile->present_bytes = LCUIDisplay_Present();
 	profile->present_time = clock() - profile->present_time;
+	LCUITrace_End();
+	LCUI_EndFrameTrace(start);
 }
 
 void LCUI_RunFrame(void)
 {
+	int64_t start = LCUI_BeginFrameTrace();
+
+	LCUITrace_Begin("frame", "timers", NULL);
 	LCUI_ProcessTimers();
+	LCUITrace_End();
+	LCUITrace_Begin("frame", "events", NULL);
 	LCUI_ProcessEvents();
+	LCUITrace_End();
 	LCUICursor_Update();
+	LCUITrace_Begin("frame", "widget update", NULL);
 	LCUIWidget_Update();
+	LCUITrace_End();
+	LCUITrace_Begin("frame", "display update", NULL);
 	LCUIDisplay_Update();
+	LCUITrace_End();
+	LCUITrace_Begin("frame", "render", NULL);
 	LCUIDisplay_Render();
+	LCUITrace_End();
+	LCUITrace_Begin("frame", "present", NULL);
 	LCUIDisplay_Present();
+	LCUITrace_End();
+	LCUI_EndFrameTrace(start);
 }
 
 static void LCUI_InitEvent(void)
@@ -235,6 +383,117 @@ static void LCUI_FreeEvent(void)
 	System.event.trigger = NULL;
 }
 
+static void LCUI_InitIdle(void)
+{
+	System.idle.signaled = FALSE;
+	System.idle.wakeup_count = 0;
+	LCUIMutex_Init(&System.idle.mutex);
+	LCUICond_Init(&System.idle.cond);
+	System.idle.active = TRUE;
+}
+
+static void LCUI_FreeIdle(void)
+{
+	System.idle.active = FALSE;
+	LCUICond_Destroy(&System.idle.cond);
+	LCUIMutex_Destroy(&System.idle.mutex);
+}
+
+void LCUI_Wakeup(void)
+{
+	if (!System.idle.active) {
+		return;
+	}
+	LCUIMutex_Lock(&System.idle.mutex);
+	System.idle.signaled = TRUE;
+	LCUICond_Signal(&System.idle.cond);
+	if (MainApp.driver_ready && MainApp.driver->Wakeup) {
+		MainApp.driver->Wakeup();
+	}
+	LCUIMutex_Unlock(&System.idle.mutex);
+}
+
+size_t LCUI_GetIdleWakeupCount(void)
+{
+	return System.idle.wakeup_count;
+}
+
+/**
+ * 在驱动的事件源上进行空闲等待
+ * LCUI_Wakeup() 会同时唤醒驱动的等待，所以在检查唤醒标记之后才调用
+ * LCUI_Wakeup() 也不会错过
+ */
+static int64_t LCUI_WaitForDriverEvent(long int timeout)
+{
+	int64_t start;
+	LCUI_BOOL signaled;
+
+	start = LCUI_GetTime();
+	LCUIMutex_Lock(&System.idle.mutex);
+	signaled = System.idle.signaled;
+	System.idle.signaled = FALSE;
+	LCUIMutex_Unlock(&System.idle.mutex);
+	if (signaled) {
+		return -1;
+	}
+	MainApp.driver->WaitEvent(timeout);
+	LCUIMutex_Lock(&System.idle.mutex);
+	System.idle.signaled = FALSE;
+	System.idle.wakeup_count += 1;
+	LCUIMutex_Unlock(&System.idle.mutex);
+	return LCUI_GetTimeDelta(start);
+}
+
+/**
+ * 在没有需要处理的工作时让主循环进入空闲等待
+ * 等待会在有新的输入、有新的工作产生或者下一个定时器到期时结束
+ * @return 等待的时长（单位：毫秒），未进入等待时返回 -1
+ */
+static int64_t LCUI_WaitForWork(void)
+{
+	int64_t start;
+	long int timeout;
+	LCUI_BOOL waited = FALSE;
+
+	if (LCUIWidget_HasPendingTasks() || LCUIDisplay_HasPendingPaint()) {
+		return -1;
+	}
+	timeout = LCUI_GetNextTimerDelay();
+	if (timeout == 0) {
+		return -1;
+	}
+	/*
+	 * X11 和 Windows 驱动能等待到它们的事件源有新的输入，Linux 帧缓冲驱动的
+	 * 输入设备由单独的线程读取，读到数据后会调用 LCUI_Wakeup()，这些驱动都
+	 * 能一直等待到有新的工作。UWP 的事件只能在主线程中轮询，所以最多只等待
+	 * 一帧，空闲时仍然会按帧率醒来检查事件。
+	 */
+	if (MainApp.driver_ready) {
+		if (MainApp.driver->WaitEvent) {
+			return LCUI_WaitForDriverEvent(timeout);
+		}
+		if (MainApp.driver->id != LCUI_APP_LINUX &&
+		    (timeout < 0 || timeout > LCUI_MAX_FRAME_MSEC)) {
+			timeout = LCUI_MAX_FRAME_MSEC;
+		}
+	}
+	start = LCUI_GetTime();
+	LCUIMutex_Lock(&System.idle.mutex);
+	if (!System.idle.signaled) {
+		if (timeout < 0) {
+			LCUICond_Wait(&System.idle.cond, &System.idle.mutex);
+		} else {
+			LCUICond_TimedWait(&System.idle.cond, &System.idle.mutex,
+					   (unsigned)timeout);
+		}
+		System.idle.wakeup_count += 1;
+		waited = TRUE;
+	}
+	System.idle.signaled = FALSE;
+	LCUIMutex_Unlock(&System.idle.mutex);
+	return waited ? LCUI_GetTimeDelta(start) : -1;
+}
+
 static void OnEvent(LCUI_Event e, void *arg)
 {
 	SysEventHandler handler = e->data;
@@ -291,12 +550,22 @@ int LCUI_TriggerEvent(LCUI_SysEvent e, void *arg)
 		return -1;
 	}
 	int ret;
+	char detail[LCUI_TRACE_DETAIL_LEN];
 	SysEventPackRec pack;
+	/* 跟踪可能在事件处理过程中被开启或关闭，结束时要以开始时的状态为准 */
+	LCUI_BOOL traced = LCUITrace_IsEnabled();
 	pack.arg = arg;
 	pack.event = e;
+	if (traced) {
+		snprintf(detail, LCUI_TRACE_DETAIL_LEN, "type %d", e->type);
+		LCUITrace_Begin("event", "dispatch", detail);
+	}
 	LCUIMutex_Lock(&System.event.mutex);
 	ret = EventTrigger_Trigger(System.event.trigger, e->type, &pack);
 	LCUIMutex_Unlock(&System.event.mutex);
+	if (traced) {
+		LCUITrace_End();
+	}
 	return ret;
 }
 
@@ -340,9 +609,23 @@ size_t LCUI_ProcessEvents(void)
 	size_t count = 0;
 
 	if (MainApp.driver_ready) {
+		LCUITrace_Begin("event", "driver events", NULL);
 		MainApp.driver->ProcessEvents();
+		LCUITrace_End();
 	}
-	while (LCUIWorker_RunTask(MainApp.main_worker)) {
+	if (MainApp.input_tasks) {
+		LCUITrace_Begin("event", "input tasks", NULL);
+		count += TaskRing_Run(MainApp.input_tasks,
+				      LCUI_INPUT_QUEUE_SIZE);
+		LCUITrace_End();
+	}
+	while (1) {
+		LCUITrace_Begin("event", "task", NULL);
+		if (!LCUIWorker_RunTask(MainApp.main_worker)) {
+			LCUITrace_End();
+			break;
+		}
+		LCUITrace_End();
 		++count;
 	}
 	return count;
@@ -354,33 +637,68 @@ LCUI_BOOL LCUI_PostTask(LCUI_Task task)
 		return FALSE;
 	}
 	LCUIWorker_PostTask(MainApp.main_worker, task);
+	LCUI_Wakeup();
 	return TRUE;
 }
 
 void LCUI_PostAsyncTaskTo(LCUI_Task task, int worker_id)
 {
-	int id = 0;
-	if (!MainApp.active) {
+	if (!MainApp.active || !MainApp.workers) {
 		LCUITask_Run(task);
 		LCUITask_Destroy(task);
 		return;
 	}
-	if (id >= LCUI_WORKER_NUM) {
-		id = 0;
+	LCUIWorkerPool_PostTaskTo(MainApp.workers, task, worker_id);
+}
+
+int LCUI_PostInputTask(LCUI_TaskFunc func, const void *data, size_t size)
+{
+	int ret;
+
+	if (!MainApp.input_tasks) {
+		return -1;
+	}
+	ret = TaskRing_Push(MainApp.input_tasks, func, data, size);
+	if (ret == 0) {
+		LCUI_Wakeup();
 	}
-	LCUIWorker_PostTask(MainApp.workers[id], task);
+	return ret;
 }
 
-int LCUI_PostAsyncTask(LCUI_Task task)
+void LCUI_GetInputLatency(LCUI_LatencyHistogram hist)
+{
+	if (MainApp.input_tasks) {
+		TaskRing_GetLatency(MainApp.input_tasks, hist);
+	} else {
+		memset(hist, 0, sizeof(LCUI_LatencyHistogramRec));
+	}
+}
+
+void LCUI_ResetInputLatency(void)
 {
-	int id;
-	if (MainApp.worker_next >= LCUI_WORKER_NUM) {
-		MainApp.worker_next = 0;
+	if (MainApp.input_tasks) {
+		TaskRing_ResetLatency(MainApp.input_tasks);
 	}
-	id = MainApp.worker_next;
-	LCUI_PostAsyncTaskTo(task, id);
-	MainApp.worker_next += 1;
-	return id;
+}
+
+int LCUI_PostAsyncTaskEx(LCUI_Task task, LCUI_TaskPriority priority,
+			 LCUI_Task callback)
+{
+	if (!MainApp.active || !MainApp.workers) {
+		LCUITask_Run(task);
+		LCUITask_Destroy(task);
+		if (callback && !LCUI_PostTask(callback)) {
+			LCUITask_Destroy(callback);
+		}
+		return 0;
+	}
+	return LCUIWorkerPool_PostTask(MainApp.workers, task, priority,
+				       callback);
+}
+
+int LCUI_PostAsyncTask(LCUI_Task task)
+{
+	return LCUI_PostAsyncTaskEx(task, LCUI_TASK_PRIORITY_NORMAL, NULL);
 }
 
 /* 新建一个主循环 */
@@ -396,6 +714,7 @@ LCUI_MainLoop LCUIMainLoop_New(void)
 /** 运行目标主循环 */
 int LCUIMainLoop_Run(LCUI_MainLoop loop)
 {
+	int64_t idle_time;
 	LCUI_BOOL at_same_thread = FALSE;
 	if (loop->state == STATE_RUNNING) {
 		DEBUG_MSG("error: main-loop already running.\n");
@@ -427,7 +746,18 @@ int LCUIMainLoop_Run(LCUI_MainLoop loop)
 			LCUI_RunFrame();
 		}
 
-		StepTimer_Remain(MainApp.timer);
+		idle_time = LCUI_WaitForWork();
+		if (idle_time >= 0 && MainApp.settings.record_profile) {
+			MainApp.profile.idle_wakeups += 1;
+			MainApp.profile.idle_time += idle_time;
+		}
+		/*
+		 * 无头显示没有垂直同步，不需要限制帧率。空闲等待超过一帧的时长
+		 * 后，这里会直接返回，不会再推迟对输入的响应
+		 */
+		if (!LCUIDisplay_IsHeadless()) {
+			StepTimer_Remain(MainApp.timer);
+		}
 		/* 如果当前运行的主循环不是自己 */
 		while (MainApp.loop != loop) {
 			loop->state = STATE_PAUSED;
@@ -450,6 +780,7 @@ int LCUIMainLoop_Run(LCUI_MainLoop loop)
 void LCUIMainLoop_Quit(LCUI_MainLoop loop)
 {
 	loop->state = STATE_EXITED;
+	LCUI_Wakeup();
 }
 
 void LCUIMainLoop_Destroy(LCUI_MainLoop loop)
@@ -464,7 +795,6 @@ int LCUI_GetFrameCount(void)
 
 void LCUI_InitApp(LCUI_AppDriver app)
 {
-	int i;
 	if (MainApp.driver_ready) {
 		return;
 	}
@@ -479,10 +809,8 @@ void LCUI_InitApp(LCUI_AppDriver app)
 	    LCUI_SETTINGS_CHANGE, OnSettingsChangeEvent, NULL, NULL);
 	Settings_Init(&MainApp.settings);
 	MainApp.main_worker = LCUIWorker_New();
-	for (i = 0; i < LCUI_WORKER_NUM; ++i) {
-		MainApp.workers[i] = LCUIWorker_New();
-		LCUIWorker_RunAsync(MainApp.workers[i]);
-	}
+	MainApp.workers = LCUIWorkerPool_New(0);
+	MainApp.input_tasks = TaskRing_New(LCUI_INPUT_QUEUE_SIZE);
 	StepTimer_SetFrameLimit(MainApp.timer, MainApp.settings.frame_rate_cap);
 	if (!app) {
 		app = LCUI_CreateAppDriver();
@@ -510,7 +838,6 @@ static void OnDeleteMainLoop(void *arg)
 
 static void LCUI_FreeApp(void)
 {
-	int i;
 	LCUI_MainLoop loop;
 	LinkedListNode *node;
 	MainApp.active = FALSE;
@@ -526,12 +853,22 @@ static void LCUI_FreeApp(void)
 	LCUICond_Destroy(&MainApp.loop_changed);
 	LinkedList_Clear(&MainApp.loops, OnDeleteMainLoop);
 	if (MainApp.driver_ready) {
+		/* 其它线程调用的 LCUI_Wakeup() 会访问驱动，需要先让它们停止访问 */
+		if (System.idle.active) {
+			LCUIMutex_Lock(&System.idle.mutex);
+			MainApp.driver_ready = FALSE;
+			LCUIMutex_Unlock(&System.idle.mutex);
+		}
 		LCUI_DestroyAppDriver(MainApp.driver);
 	}
 	MainApp.driver_ready = FALSE;
-	for (i = 0; i < LCUI_WORKER_NUM; ++i) {
-		LCUIWorker_Destroy(MainApp.workers[i]);
-		MainApp.workers[i] = NULL;
+	if (MainApp.workers) {
+		LCUIWorkerPool_Destroy(MainApp.workers);
+		MainApp.workers = NULL;
+	}
+	if (MainApp.input_tasks) {
+		TaskRing_Destroy(MainApp.input_tasks);
+		MainApp.input_tasks = NULL;
 	}
 	LCUIWorker_Destroy(MainApp.main_worker);
 	MainApp.main_worker = NULL;
@@ -573,6 +910,7 @@ static void LCUIApp_QuitAllMainLoop(void)
 			loop->state = STATE_EXITED;
 		}
 	}
+	LCUI_Wakeup();
 }
 
 static void LCUI_ShowCopyrightText(void)
@@ -650,12 +988,16 @@ void LCUI_InitBase(void)
 	System.state = STATE_ACTIVE;
 	System.thread = LCUIThread_SelfID();
 	LCUI_ShowCopyrightText();
+	LCUI_InitTrace();
+	LCUITrace_SetThreadName("main");
 	LCUI_InitEvent();
+	LCUI_InitIdle();
 	LCUI_InitFontLibrary();
 	LCUI_InitTimer();
 	LCUI_InitCursor();
 	LCUI_InitWidget();
 	LCUI_InitMetrics();
+	LCUI_InitFrameArena();
 }
 
 void LCUI_Init(void)
@@ -702,6 +1044,9 @@ int LCUI_Destroy(void)
 	LCUI_FreeTimer();
 	LCUI_FreeEvent();
 	LCUI_FreeMetrics();
+	LCUI_FreeFrameArena();
+	LCUI_FreeTrace();
+	LCUI_FreeIdle();
 	return System.exit_code;
 }
 
@@ -0,0 +1,352 @@
+/* headless_display.c -- in-memory display driver without a screen
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The surfaces are plain graphs: renderers paint on the canvas of a surface,
+ * and presenting copies the painted rects to its frame, which can be captured
+ * for pixel comparison. Nothing waits for a vertical blank, so the time of a
+ * frame is only the time spent by LCUI itself.
+ */
+
+#define LCUI_SURFACE_C
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/display.h>
+#include <LCUI/painter.h>
+
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+
+typedef struct LCUI_SurfaceRec_ {
+	int x, y;
+	int width, height;
+	LCUI_BOOL visible;
+
+	/** the canvas which the renderers paint on */
+	LCUI_Graph canvas;
+
+	/** the content presented last time */
+	LCUI_Graph frame;
+
+	LinkedListNode node;
+} LCUI_SurfaceRec;
+
+static struct LCUI_HeadlessDisplayModule {
+	LinkedList surfaces;
+	LCUI_EventTrigger trigger;
+
+	/** rects presented since the damage was cleared */
+	LCUI_Rect *damage;
+	size_t damage_length;
+	size_t damage_capacity;
+
+	size_t present_count;
+} display;
+
+static void HeadlessSurface_Delete(LCUI_Surface surface)
+{
+	if (!surface) {
+		return;
+	}
+	LinkedList_Unlink(&display.surfaces, &surface->node);
+	Graph_Free(&surface->canvas);
+	Graph_Free(&surface->frame);
+	free(surface);
+}
+
+static LCUI_Surface HeadlessSurface_New(void)
+{
+	ASSIGN(surface, LCUI_Surface);
+
+	Graph_Init(&surface->canvas);
+	Graph_Init(&surface->frame);
+	surface->canvas.color_type = LCUI_COLOR_TYPE_ARGB;
+	surface->frame.color_type = LCUI_COLOR_TYPE_ARGB;
+	surface->node.data = surface;
+	LinkedList_AppendNode(&display.surfaces, &surface->node);
+	return surface;
+}
+
+static LCUI_BOOL HeadlessSurface_IsReady(LCUI_Surface surface)
+{
+	return surface && surface->width > 0 && surface->height > 0;
+}
+
+static void HeadlessSurface_Show(LCUI_Surface surface)
+{
+	if (surface) {
+		surface->visible = TRUE;
+	}
+}
+
+static void HeadlessSurface_Hide(LCUI_Surface surface)
+{
+	if (surface) {
+		surface->visible = FALSE;
+	}
+}
+
+static void HeadlessSurface_Move(LCUI_Surface surface, int x, int y)
+{
+	if (surface) {
+		surface->x = x;
+		surface->y = y;
+	}
+}
+
+static void HeadlessSurface_Resize(LCUI_Surface surface, int width,
+				   int height)
+{
+	if (!surface || (surface->width == width && surface->height == height)) {
+		return;
+	}
+	surface->width = max(width, 0);
+	surface->height = max(height, 0);
+	Graph_Create(&surface->canvas, surface->width, surface->height);
+	Graph_Create(&surface->frame, surface->width, surface->height);
+}
+
+static void HeadlessSurface_SetCaptionW(LCUI_Surface surface,
+					const wchar_t *wstr)
+{
+}
+
+static void HeadlessSurface_SetOpacity(LCUI_Surface surface, float opacity)
+{
+}
+
+static void HeadlessSurface_SetRenderMode(LCUI_Surface surface, int mode)
+{
+}
+
+static void HeadlessSurface_Update(LCUI_Surface surface)
+{
+}
+
+static void *HeadlessSurface_GetHandle(LCUI_Surface surface)
+{
+	return surface;
+}
+
+static int HeadlessSurface_GetWidth(LCUI_Surface surface)
+{
+	return surface ? surface->width : 0;
+}
+
+static int HeadlessSurface_GetHeight(LCUI_Surface surface)
+{
+	return surface ? surface->height : 0;
+}
+
+static LCUI_PaintContext HeadlessSurface_BeginPaint(LCUI_Surface surface,
+						    LCUI_Rect *rect)
+{
+	LCUI_PaintContext paint;
+	LCUI_Rect actual_rect = *rect;
+
+	LCUIRect_ValidateArea(&actual_rect, surface->width, surface->height);
+	if (actual_rect.width < 1 || actual_rect.height < 1) {
+		return NULL;
+	}
+	paint = LCUIPainter_Begin(&surface->canvas, &actual_rect);
+	Graph_FillRect(&paint->canvas, RGB(255, 255, 255), NULL, TRUE);
+	return paint;
+}
+
+static void HeadlessSurface_EndPaint(LCUI_Surface surface,
+				     LCUI_PaintContext paint)
+{
+	LCUIPainter_End(paint);
+}
+
+static void HeadlessDisplay_AddDamage(const LCUI_Rect *rect)
+{
+	LCUI_Rect *rects;
+	size_t capacity;
+
+	if (display.damage_length >= display.damage_capacity) {
+		capacity = max(display.damage_capacity * 2, 16);
+		rects = realloc(display.damage, sizeof(LCUI_Rect) * capacity);
+		if (!rects) {
+			return;
+		}
+		display.damage = rects;
+		display.damage_capacity = capacity;
+	}
+	display.damage[display.damage_length++] = *rect;
+}
+
+static size_t HeadlessSurface_PresentRects(LCUI_Surface surface,
+					   const LCUI_Rect *rects,
+					   size_t n_rects)
+{
+	size_t i, bytes = 0;
+	LCUI_Graph canvas;
+	LCUI_Rect rect;
+
+	if (!HeadlessSurface_IsReady(surface)) {
+		return 0;
+	}
+	for (i = 0; i < n_rects; ++i) {
+		rect = rects[i];
+		LCUIRect_ValidateArea(&rect, surface->width, surface->height);
+		if (rect.width < 1 || rect.height < 1) {
+			continue;
+		}
+		Graph_Init(&canvas);
+		Graph_Quote(&canvas, &surface->canvas, &rect);
+		Graph_Replace(&surface->frame, &canvas, rect.x, rect.y);
+		HeadlessDisplay_AddDamage(&rect);
+		bytes += (size_t)rect.width * rect.height *
+			 surface->frame.bytes_per_pixel;
+	}
+	display.present_count += 1;
+	return bytes;
+}
+
+static void HeadlessSurface_Present(LCUI_Surface surface)
+{
+	LCUI_Rect rect;
+
+	if (!surface) {
+		return;
+	}
+	rect.x = 0;
+	rect.y = 0;
+	rect.width = surface->width;
+	rect.height = surface->height;
+	HeadlessSurface_PresentRects(surface, &rect, 1);
+}
+
+static int HeadlessDisplay_BindEvent(int event_id, LCUI_EventFunc func,
+				     void *data, void (*destroy_data)(void *))
+{
+	return EventTrigger_Bind(display.trigger, event_id, func, data,
+				 destroy_data);
+}
+
+static int HeadlessDisplay_GetWidth(void)
+{
+	return SCREEN_WIDTH;
+}
+
+static int HeadlessDisplay_GetHeight(void)
+{
+	return SCREEN_HEIGHT;
+}
+
+int LCUIHeadlessDisplay_CaptureFrame(LCUI_Graph *out)
+{
+	LCUI_Surface surface;
+	LinkedListNode *node;
+
+	node = LinkedList_GetNode(&display.surfaces, 0);
+	if (!node) {
+		return -1;
+	}
+	surface = node->data;
+	if (!Graph_IsValid(&surface->frame)) {
+		return -1;
+	}
+	Graph_Copy(out, &surface->frame);
+	return 0;
+}
+
+size_t LCUIHeadlessDisplay_GetDamage(LCUI_Rect *rects, size_t max_rects)
+{
+	size_t n = min(max_rects, display.damage_length);
+
+	if (rects && n > 0) {
+		memcpy(rects, display.damage, sizeof(LCUI_Rect) * n);
+	}
+	return display.damage_length;
+}
+
+void LCUIHeadlessDisplay_ClearDamage(void)
+{
+	display.damage_length = 0;
+}
+
+size_t LCUIHeadlessDisplay_GetPresentCount(void)
+{
+	return display.present_count;
+}
+
+LCUI_DisplayDriver LCUI_CreateHeadlessDisplayDriver(void)
+{
+	ASSIGN(driver, LCUI_DisplayDriver);
+
+	strcpy(driver->name, "headless");
+	driver->getWidth = HeadlessDisplay_GetWidth;
+	driver->getHeight = HeadlessDisplay_GetHeight;
+	driver->create = HeadlessSurface_New;
+	driver->destroy = HeadlessSurface_Delete;
+	driver->close = HeadlessSurface_Delete;
+	driver->isReady = HeadlessSurface_IsReady;
+	driver->show = HeadlessSurface_Show;
+	driver->hide = HeadlessSurface_Hide;
+	driver->move = HeadlessSurface_Move;
+	driver->resize = HeadlessSurface_Resize;
+	driver->update = HeadlessSurface_Update;
+	driver->present = HeadlessSurface_Present;
+	driver->presentRects = HeadlessSurface_PresentRects;
+	driver->setCaptionW = HeadlessSurface_SetCaptionW;
+	driver->setRenderMode = HeadlessSurface_SetRenderMode;
+	driver->setOpacity = HeadlessSurface_SetOpacity;
+	driver->getHandle = HeadlessSurface_GetHandle;
+	driver->getSurfaceWidth = HeadlessSurface_GetWidth;
+	driver->getSurfaceHeight = HeadlessSurface_GetHeight;
+	driver->beginPaint = HeadlessSurface_BeginPaint;
+	driver->endPaint = HeadlessSurface_EndPaint;
+	driver->bindEvent = HeadlessDisplay_BindEvent;
+	LinkedList_Init(&display.surfaces);
+	display.trigger = EventTrigger();
+	display.damage = NULL;
+	display.damage_length = 0;
+	display.damage_capacity = 0;
+	display.present_count = 0;
+	return driver;
+}
+
+void LCUI_DestroyHeadlessDisplayDriver(LCUI_DisplayDriver driver)
+{
+	LinkedListNode *node;
+
+	while ((node = LinkedList_GetNode(&display.surfaces, 0))) {
+		HeadlessSurface_Delete(node->data);
+	}
+	EventTrigger_Destroy(display.trigger);
+	free(display.damage);
+	display.damage = NULL;
+	display.damage_length = 0;
+	display.damage_capacity = 0;
+	free(driver);
+}
@@ -73,7 +73,6 @@ typedef struct LCUI_SurfaceRec_ {
 	LCUI_Rect actual_rect;
 	LCUI_Mutex mutex;
 	LCUI_Graph canvas;
-	LinkedList rects;
 	LCUI_SurfaceTasks tasks;
 } LCUI_SurfaceRec;
 
@@ -198,7 +197,6 @@ static LCUI_PaintContext FBSurface_BeginPaint(LCUI_Surface surface,
 	actual_rect.y -= surface->rect.y;
 	paint = LCUIPainter_Begin(&surface->canvas, &actual_rect);
 	Graph_FillRect(&paint->canvas, RGB(255, 255, 255), NULL, TRUE);
-	RectList_Add(&surface->rects, rect);
 	return paint;
 }
 
@@ -217,10 +215,10 @@ static void FBDisplay_SyncRect16(LCUI_Graph *canvas, int x, int y)
 	Graph_GetValidRect(canvas, &rect);
 	pixel_row = canvas->argb + rect.y * canvas->width + rect.x;
 	dst_row = display.fb.mem + y * display.canvas.bytes_per_row + x * 2;
-	for (iy = 0; iy < rect.width; ++iy) {
+	for (iy = 0; iy < rect.height; ++iy) {
 		dst = dst_row;
 		pixel = pixel_row;
-		for (ix = 0; ix < rect.width; ++ix) {
+		for (ix = 0; ix < rect.width; ++ix, ++pixel, dst += 2) {
 			dst[0] = (pixel->r & 0xF8) | (pixel->b >> 5);
 			dst[1] = ((pixel->g & 0x1C) << 3) | (pixel->b >> 3);
 		}
@@ -284,7 +282,8 @@ static void FBDisplay_SyncRect32(LCUI_Graph *canvas, int x, int y)
 	Graph_Replace(&display.canvas, canvas, x, y);
 }
 
-static void FBDisplay_SyncRect(LCUI_Surface surface, LCUI_Rect *rect)
+/** 将 surface 中的矩形区域写入帧缓冲，仅会写入该区域所在的扫描行片段 */
+static size_t FBDisplay_SyncRect(LCUI_Surface surface, const LCUI_Rect *rect)
 {
 	int x, y;
 	LCUI_Graph canvas;
@@ -295,6 +294,11 @@ static void FBDisplay_SyncRect(LCUI_Surface surface, LCUI_Rect *rect)
 	actual_rect.width = rect->width;
 	actual_rect.height = rect->height;
 	LCUIRect_ValidateArea(&actual_rect, display.width, display.height);
+	LCUIRect_GetOverlayRect(&actual_rect, &surface->actual_rect,
+				&actual_rect);
+	if (actual_rect.width < 1 || actual_rect.height < 1) {
+		return 0;
+	}
 	/* Convert this rectangle to surface canvas related rectangle */
 	x = actual_rect.x;
 	y = actual_rect.y;
@@ -318,19 +322,35 @@ static void FBDisplay_SyncRect(LCUI_Surface surface, LCUI_Rect *rect)
 		FBDisplay_SyncRect8(&canvas, x, y);
 		break;
 	default:
-		break;
+		return 0;
 	}
+	return (size_t)actual_rect.width * actual_rect.height *
+	       (display.fb.var_info.bits_per_pixel / 8);
 }
 
-static void FBSurface_Present(LCUI_Surface surface)
+static size_t FBSurface_PresentRects(LCUI_Surface surface,
+				     const LCUI_Rect *rects, size_t n_rects)
 {
-	LinkedListNode *node;
+	size_t i;
+	size_t bytes = 0;
+
 	LCUIMutex_Lock(&surface->mutex);
-	for (LinkedList_Each(node, &surface->rects)) {
-		FBDisplay_SyncRect(surface, node->data);
+	for (i = 0; i < n_rects; ++i) {
+		bytes += FBDisplay_SyncRect(surface, &rects[i]);
 	}
-	LinkedList_Clear(&surface->rects, free);
 	LCUIMutex_Unlock(&surface->mutex);
+	return bytes;
+}
+
+static void FBSurface_Present(LCUI_Surface surface)
+{
+	LCUI_Rect rect;
+
+	rect.x = 0;
+	rect.y = 0;
+	rect.width = surface->width;
+	rect.height = surface->height;
+	FBSurface_PresentRects(surface, &rect, 1);
 }
 
 /** 更新 surface，应用缓存的变更 */
@@ -467,7 +487,6 @@ static void FBDisplay_InitSurface(void)
 
 	Graph_Init(&surface->canvas);
 	LCUIMutex_Init(&surface->mutex);
-	LinkedList_Init(&surface->rects);
 	display.surface_count = 0;
 	surface->canvas.color_type = LCUI_COLOR_TYPE_ARGB;
 	FBSurface_Resize(surface, display.width, display.height);
@@ -521,6 +540,7 @@ LCUI_DisplayDriver LCUI_CreateLinuxFBDisplayDriver(void)
 	driver->resize = FBSurface_Resize;
 	driver->update = FBSurface_Update;
 	driver->present = FBSurface_Present;
+	driver->presentRects = FBSurface_PresentRects;
 	driver->setCaptionW = FBSurface_SetCaptionW;
 	driver->setRenderMode = FBSurface_SetRenderMode;
 	driver->setOpacity = FBSurface_SetOpacity;
@@ -35,6 +35,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <fcntl.h>
 #ifdef USE_LINUX_INPUT_EVENT
 #include <linux/input.h>
@@ -212,10 +213,7 @@ static void on_signal(int signal)
 static void LinuxKeybnoardThread(void *arg)
 {
 	int key;
-	LCUI_TaskRec task = { 0 };
 
-	task.func = DispatchKeyboardEvent;
-	task.destroy_arg[0] = free;
 	while (keyboard.active) {
 		key = getch();
 		if (key == EOF) {
@@ -224,13 +222,11 @@ static void LinuxKeybnoardThread(void *arg)
 		while (kbhit()) {
 			key += getch();
 		}
-		task.arg[0] = malloc(sizeof(int));
-		if (!task.arg[0]) {
-			perror("[input] keyboard driver");
-			continue;
+		while (LCUI_PostInputTask(DispatchKeyboardEvent, &key,
+					  sizeof(key)) == -EAGAIN &&
+		       keyboard.active) {
+			LCUI_MSleep(1);
 		}
-		memcpy(task.arg[0], &key, sizeof(int));
-		LCUI_PostTask(&task);
 	}
 }
 
@@ -47,6 +47,7 @@
 #include <LCUI/display.h>
 #include LCUI_EVENTS_H
 #include LCUI_MOUSE_H
+#include "../../atomic.h"
 
 enum MouseButtonId { MOUSE_BUTTON_LEFT = 1, MOUSE_BUTTON_RIGHT = 1 << 1 };
 
@@ -55,6 +56,11 @@ static struct LCUI_LinuxMouseDriver {
 	int y;
 	int button_state[2];
 
+	/** 已投递但还未处理的数据包数量，由输入线程和主线程原子地更新 */
+	volatile long pending;
+	/** 被合并的移动事件的累计位移 */
+	int xrel, yrel;
+
 	int dev_fd;
 	const char *dev_path;
 
@@ -89,20 +95,35 @@ static void DispathMouseButtonEvent(int button, int state)
 static void DispatchMouseEvent(void *arg1, void *arg2)
 {
 	char *buf = arg1;
+	long pending;
 	int state = buf[0] & 0x07;
 	LCUI_SysEventRec ev = { 0 };
 
+	pending = AtomicDecrement(&mouse.pending);
 	mouse.x += buf[1];
 	mouse.y -= buf[2];
 	mouse.x = max(0, mouse.x);
 	mouse.y = max(0, mouse.y);
 	mouse.x = min(LCUIDisplay_GetWidth(), mouse.x);
 	mouse.y = min(LCUIDisplay_GetHeight(), mouse.y);
+	mouse.xrel += buf[1];
+	mouse.yrel -= buf[2];
+	/*
+	 * 后面还有数据包时，先不触发移动事件，只在最后一个数据包或者按键状态变化
+	 * 时触发一次，以减少命中测试次数
+	 */
+	if (pending > 0 &&
+	    !!(state & MOUSE_BUTTON_LEFT) == mouse.button_state[0] &&
+	    !!(state & MOUSE_BUTTON_RIGHT) == mouse.button_state[1]) {
+		return;
+	}
 	ev.type = LCUI_MOUSEMOVE;
 	ev.motion.x = mouse.x;
 	ev.motion.y = mouse.y;
-	ev.motion.xrel = buf[1];
-	ev.motion.yrel = -buf[2];
+	ev.motion.xrel = mouse.xrel;
+	ev.motion.yrel = mouse.yrel;
+	mouse.xrel = 0;
+	mouse.yrel = 0;
 	LCUI_TriggerEvent(&ev, NULL);
 	LCUI_DestroyEvent(&ev);
 	DispathMouseButtonEvent(MOUSE_BUTTON_LEFT, state);
@@ -111,14 +132,12 @@ static void DispatchMouseEvent(void *arg1, void *arg2)
 
 static void LinuxMouseThread(void *arg)
 {
+	int ret;
 	char buf[6];
 	fd_set readfds;
 	struct timeval tv;
-	LCUI_TaskRec task = { 0 };
 
 	mouse.active = TRUE;
-	task.func = DispatchMouseEvent;
-	task.destroy_arg[0] = free;
 	while (mouse.active) {
 		tv.tv_sec = 0;
 		tv.tv_usec = 500000;
@@ -130,13 +149,18 @@ static void LinuxMouseThread(void *arg)
 			if (read(mouse.dev_fd, buf, 6) <= 0) {
 				continue;
 			}
-			task.arg[0] = malloc(sizeof(char) * 6);
-			if (!task.arg[0]) {
-				perror("[input] mouse driver");
-				continue;
+			AtomicIncrement(&mouse.pending);
+			ret = LCUI_PostInputTask(DispatchMouseEvent, buf,
+						 sizeof(buf));
+			/* 队列满时等待主循环处理，不丢弃按键状态的变化 */
+			while (ret == -EAGAIN && mouse.active) {
+				LCUI_MSleep(1);
+				ret = LCUI_PostInputTask(DispatchMouseEvent,
+							 buf, sizeof(buf));
+			}
+			if (ret != 0) {
+				AtomicDecrement(&mouse.pending);
 			}
-			memcpy(task.arg[0], buf, sizeof(char) * 6);
-			LCUI_PostTask(&task);
 		}
 	}
 }
@@ -145,6 +169,9 @@ static int InitLinuxMouse(void)
 {
 	mouse.x = LCUIDisplay_GetWidth() / 2;
 	mouse.y = LCUIDisplay_GetHeight() / 2;
+	mouse.pending = 0;
+	mouse.xrel = 0;
+	mouse.yrel = 0;
 	mouse.dev_path = getenv("LCUI_MOUSE_DEVICE");
 	if (!mouse.dev_path) {
 		mouse.dev_path = "/dev/input/mice";
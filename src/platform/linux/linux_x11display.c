@@ -39,6 +39,11 @@
 #include <LCUI/platform.h>
 #include LCUI_DISPLAY_H
 #include LCUI_EVENTS_H
+#ifdef LCUI_VIDEO_DRIVER_X11_SHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif
 
 #define MIN_WIDTH 320
 #define MIN_HEIGHT 240
@@ -77,16 +82,21 @@ typedef struct LCUI_SurfaceRec_ {
 	GC gc;          /**< 图形操作上下文 */
 	Window window;  /**< 对应的 X11 窗口 */
 	XImage *ximage; /**< 适用于 X11 的图像数据 */
+#ifdef LCUI_VIDEO_DRIVER_X11_SHM
+	/** 共享内存段，使用 MIT-SHM 时帧缓存位于其中 */
+	XShmSegmentInfo shminfo;
+#endif
 	LCUI_BOOL is_ready; /**< 标志，标识当前的表面是否已经准备好 */
 	LCUI_Graph fb; /**< 帧缓存，它里面的数据会映射到窗口中 */
 	LCUI_Mutex mutex; /**< 互斥锁 */
 	LCUI_SurfaceTasks tasks;
-	LinkedList rects;    /**< 列表，记录当前需要重绘的区域 */
 	LinkedListNode node; /**< 在表面列表中的结点 */
 } LCUI_SurfaceRec;
 
 static struct X11_Display {
 	LCUI_BOOL is_inited; /**< 标记，标识当前模块是否已经初始化 */
+	LCUI_BOOL shm_enabled; /**< 标记，标识是否可使用 MIT-SHM 扩展 */
+	LCUI_BOOL shm_error; /**< 标记，标识共享内存段是否附加失败 */
 	LinkedList surfaces;       /**< 表面列表 */
 	LCUI_X11AppDriver app;     /**< X11 应用驱动 */
 	LCUI_EventTrigger trigger; /**< 事件触发器 */
@@ -120,6 +130,104 @@ static LCUI_Surface GetSurfaceByWindow(Window win)
 	return NULL;
 }
 
+static void X11Surface_DestroyImage(LCUI_Surface s)
+{
+	if (!s->ximage) {
+		return;
+	}
+#ifdef LCUI_VIDEO_DRIVER_X11_SHM
+	if (s->shminfo.shmaddr) {
+		XShmDetach(x11.app->display, &s->shminfo);
+		XSync(x11.app->display, False);
+		shmdt(s->shminfo.shmaddr);
+		s->shminfo.shmaddr = NULL;
+		/* the frame buffer is in the shared memory, not owned by us */
+		s->ximage->data = NULL;
+	}
+#endif
+	XDestroyImage(s->ximage);
+	s->ximage = NULL;
+}
+
+#ifdef LCUI_VIDEO_DRIVER_X11_SHM
+static int OnShmAttachError(Display *dpy, XErrorEvent *ev)
+{
+	x11.shm_error = TRUE;
+	return 0;
+}
+#endif
+
+/**
+ * 使用 MIT-SHM 扩展创建图像，帧缓存将位于共享内存中，呈现时 X 服务器可直接
+ * 读取像素数据而无需经过套接字传输
+ */
+static LCUI_BOOL X11Surface_CreateShmImage(LCUI_Surface s, Visual *visual,
+					   int depth)
+{
+#ifdef LCUI_VIDEO_DRIVER_X11_SHM
+	XImage *ximage;
+	int (*handler)(Display *, XErrorEvent *);
+	Display *dpy = x11.app->display;
+
+	if (!x11.shm_enabled) {
+		return FALSE;
+	}
+	ximage = XShmCreateImage(dpy, visual, depth, ZPixmap, NULL,
+				 &s->shminfo, s->width, s->height);
+	if (!ximage) {
+		return FALSE;
+	}
+	if (ximage->bytes_per_line != s->width * 4) {
+		XDestroyImage(ximage);
+		return FALSE;
+	}
+	s->shminfo.shmid = shmget(IPC_PRIVATE,
+				  ximage->bytes_per_line * ximage->height,
+				  IPC_CREAT | 0600);
+	if (s->shminfo.shmid < 0) {
+		XDestroyImage(ximage);
+		return FALSE;
+	}
+	s->shminfo.shmaddr = shmat(s->shminfo.shmid, NULL, 0);
+	if (s->shminfo.shmaddr == (char *)-1) {
+		shmctl(s->shminfo.shmid, IPC_RMID, NULL);
+		s->shminfo.shmaddr = NULL;
+		XDestroyImage(ximage);
+		return FALSE;
+	}
+	s->shminfo.readOnly = False;
+	ximage->data = s->shminfo.shmaddr;
+	/* attaching fails on a remote X server, catch the error instead of
+	 * exiting and use XPutImage() */
+	x11.shm_error = FALSE;
+	handler = XSetErrorHandler(OnShmAttachError);
+	XShmAttach(dpy, &s->shminfo);
+	XSync(dpy, False);
+	XSetErrorHandler(handler);
+	/* the segment is removed after both sides detach from it */
+	shmctl(s->shminfo.shmid, IPC_RMID, NULL);
+	if (x11.shm_error) {
+		Logger_Warning("[x11display] MIT-SHM is not available.\n");
+		x11.shm_enabled = FALSE;
+		shmdt(s->shminfo.shmaddr);
+		s->shminfo.shmaddr = NULL;
+		ximage->data = NULL;
+		XDestroyImage(ximage);
+		return FALSE;
+	}
+	s->ximage = ximage;
+	s->fb.width = s->width;
+	s->fb.height = s->height;
+	s->fb.bytes_per_pixel = 4;
+	s->fb.bytes_per_row = ximage->bytes_per_line;
+	s->fb.mem_size = s->fb.bytes_per_row * s->height;
+	s->fb.bytes = (uchar_t *)ximage->data;
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
 static void X11Surface_OnResize(LCUI_Surface s, int width, int height)
 {
 	int depth;
@@ -128,10 +236,7 @@ static void X11Surface_OnResize(LCUI_Surface s, int width, int height)
 	if (width == s->width && height == s->height && s->ximage && s->gc) {
 		return;
 	}
-	if (s->ximage) {
-		XDestroyImage(s->ximage);
-		s->ximage = NULL;
-	}
+	X11Surface_DestroyImage(s);
 	if (s->gc) {
 		XFreeGC(x11.app->display, s->gc);
 		s->gc = NULL;
@@ -149,14 +254,17 @@ static void X11Surface_OnResize(LCUI_Surface s, int width, int height)
 		Logger_Error("[x11display] unsupport depth: %d.\n", depth);
 		break;
 	}
-	Graph_Create(&s->fb, width, height);
 	visual = DefaultVisual(x11.app->display, x11.app->screen);
-	s->ximage = XCreateImage(x11.app->display, visual, depth, ZPixmap, 0,
+	if (!X11Surface_CreateShmImage(s, visual, depth)) {
+		Graph_Create(&s->fb, width, height);
+		s->ximage =
+		    XCreateImage(x11.app->display, visual, depth, ZPixmap, 0,
 				 (char *)(s->fb.bytes), width, height, 32, 0);
-	if (!s->ximage) {
-		Graph_Free(&s->fb);
-		Logger_Error("[x11display] create XImage faild.\n");
-		return;
+		if (!s->ximage) {
+			Graph_Free(&s->fb);
+			Logger_Error("[x11display] create XImage faild.\n");
+			return;
+		}
 	}
 	gcv.graphics_exposures = False;
 	s->gc =
@@ -240,10 +348,7 @@ static void OnDestroySurface(void *data)
 	LCUI_Surface s = data;
 
 	X11Surface_ClearTasks(s);
-	LinkedList_Clear(&s->rects, free);
-	if (s->ximage) {
-		XDestroyImage(s->ximage);
-	}
+	X11Surface_DestroyImage(s);
 	if (s->gc) {
 		XFreeGC(x11.app->display, s->gc);
 	}
@@ -275,7 +380,6 @@ static LCUI_Surface X11Surface_New(void)
 	surface->height = MIN_HEIGHT;
 	Graph_Init(&surface->fb);
 	LCUIMutex_Init(&surface->mutex);
-	LinkedList_Init(&surface->rects);
 	surface->fb.color_type = LCUI_COLOR_TYPE_ARGB;
 	LinkedList_AppendNode(&x11.surfaces, &surface->node);
 	LCUI_PostSimpleTask(X11Surface_OnCreate, surface, NULL);
@@ -354,27 +458,66 @@ static LCUI_PaintContext X11Surface_BeginPaint(LCUI_Surface surface,
 
 static void X11Surface_EndPaint(LCUI_Surface surface, LCUI_PaintContext paint)
 {
-	LCUI_Rect *r;
-	r = NEW(LCUI_Rect, 1);
-	*r = paint->rect;
-	LinkedList_Append(&surface->rects, r);
 	free(paint);
 	LCUIMutex_Unlock(&surface->mutex);
 }
 
-/** 将帧缓存中的数据呈现至Surface的窗口内 */
-static void X11Surface_Present(LCUI_Surface surface)
+/** 将帧缓存中指定区域内的数据呈现至 Surface 的窗口内 */
+static size_t X11Surface_PresentRects(LCUI_Surface surface,
+				      const LCUI_Rect *rects, size_t n_rects)
 {
-	LinkedListNode *node;
+	size_t i;
+	size_t bytes = 0;
+	LCUI_Rect rect;
+	Display *dpy = x11.app->display;
+
 	LCUIMutex_Lock(&surface->mutex);
-	for (LinkedList_Each(node, &surface->rects)) {
-		LCUI_Rect *rect = node->data;
-		XPutImage(x11.app->display, surface->window, surface->gc,
-			  surface->ximage, rect->x, rect->y, rect->x, rect->y,
-			  rect->width, rect->height);
+	if (!surface->ximage || !surface->gc) {
+		LCUIMutex_Unlock(&surface->mutex);
+		return 0;
 	}
-	LinkedList_Clear(&surface->rects, free);
+	for (i = 0; i < n_rects; ++i) {
+		rect = rects[i];
+		LCUIRect_ValidateArea(&rect, surface->width, surface->height);
+		if (rect.width < 1 || rect.height < 1) {
+			continue;
+		}
+#ifdef LCUI_VIDEO_DRIVER_X11_SHM
+		if (surface->shminfo.shmaddr) {
+			XShmPutImage(dpy, surface->window, surface->gc,
+				     surface->ximage, rect.x, rect.y, rect.x,
+				     rect.y, rect.width, rect.height, False);
+		} else
+#endif
+		{
+			XPutImage(dpy, surface->window, surface->gc,
+				  surface->ximage, rect.x, rect.y, rect.x,
+				  rect.y, rect.width, rect.height);
+		}
+		bytes += (size_t)rect.width * rect.height *
+			 (surface->ximage->bits_per_pixel / 8);
+	}
+#ifdef LCUI_VIDEO_DRIVER_X11_SHM
+	/* the shared frame buffer must not be painted until the X server has
+	 * read it */
+	if (bytes > 0 && surface->shminfo.shmaddr) {
+		XSync(dpy, False);
+	}
+#endif
 	LCUIMutex_Unlock(&surface->mutex);
+	return bytes;
+}
+
+/** 将帧缓存中的数据呈现至Surface的窗口内 */
+static void X11Surface_Present(LCUI_Surface surface)
+{
+	LCUI_Rect rect;
+
+	rect.x = 0;
+	rect.y = 0;
+	rect.width = surface->width;
+	rect.height = surface->height;
+	X11Surface_PresentRects(surface, &rect, 1);
 }
 
 /** 更新 surface，应用缓存的变更 */
@@ -481,6 +624,7 @@ LCUI_DisplayDriver LCUI_CreateLinuxX11DisplayDriver(void)
 	driver->resize = X11Surface_Resize;
 	driver->update = X11Surface_Update;
 	driver->present = X11Surface_Present;
+	driver->presentRects = X11Surface_PresentRects;
 	driver->setCaptionW = X11Surface_SetCaptionW;
 	driver->setRenderMode = X11Surface_SetRenderMode;
 	driver->setOpacity = X11Surface_SetOpacity;
@@ -490,6 +634,9 @@ LCUI_DisplayDriver LCUI_CreateLinuxX11DisplayDriver(void)
 	driver->bindEvent = X11Display_BindEvent;
 	driver->getSurfaceWidth = X11Surface_GetWidth;
 	driver->getSurfaceHeight = X11Surface_GetHeight;
+#ifdef LCUI_VIDEO_DRIVER_X11_SHM
+	x11.shm_enabled = XShmQueryExtension(x11.app->display);
+#endif
 	LinkedList_Init(&x11.surfaces);
 	LCUI_BindSysEvent(Expose, OnExpose, NULL, NULL);
 	LCUI_BindSysEvent(ConfigureNotify, OnConfigureNotify, NULL, NULL);
@@ -33,6 +33,9 @@
 #include <stdlib.h>
 #include <LCUI_Build.h>
 #if defined(LCUI_BUILD_IN_LINUX) && defined(LCUI_VIDEO_DRIVER_X11)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/select.h>
 #include <LCUI/LCUI.h>
 #include <LCUI/display.h>
 #include <LCUI/platform.h>
@@ -53,33 +56,84 @@ void LCUI_SetLinuxX11MainWindow(Window win)
 	XFlush(x11.display);
 }
 
-static LCUI_BOOL X11_WaitEvent(void)
+/**
+ * 等待 X11 连接上有新的事件、管道被写入或者超时
+ * 管道只在等待结束后清空，在等待前写入的数据也能结束这次等待
+ */
+static LCUI_BOOL X11_WaitEvent(long int timeout)
 {
-	int fd;
+	int fd, ret;
+	char buf[64];
 	fd_set fdset;
-	struct timeval tv;
+	struct timeval tv, *tvp = NULL;
+
 	XFlush(x11.display);
-	fd = ConnectionNumber(x11.display);
 	if (XEventsQueued(x11.display, QueuedAlready)) {
 		return TRUE;
 	}
+	fd = ConnectionNumber(x11.display);
 	FD_ZERO(&fdset);
 	FD_SET(fd, &fdset);
-	tv.tv_sec = 0;
-	tv.tv_usec = 10000;
-	if (select(fd + 1, &fdset, NULL, NULL, &tv) == 1) {
-		return XPending(x11.display);
+	FD_SET(x11.wakeup_fds[0], &fdset);
+	if (timeout >= 0) {
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = timeout % 1000 * 1000;
+		tvp = &tv;
+	}
+	ret = select(max(fd, x11.wakeup_fds[0]) + 1, &fdset, NULL, NULL, tvp);
+	if (ret < 1) {
+		return FALSE;
+	}
+	if (FD_ISSET(x11.wakeup_fds[0], &fdset)) {
+		while (read(x11.wakeup_fds[0], buf, sizeof(buf)) > 0);
 	}
-	return FALSE;
+	return FD_ISSET(fd, &fdset) ? TRUE : FALSE;
+}
+
+static void X11_Wakeup(void)
+{
+	char c = 0;
+
+	/* 管道已满时说明已经有未处理的唤醒，不需要再写入 */
+	if (write(x11.wakeup_fds[1], &c, 1) < 0) {
+		return;
+	}
+}
+
+/** 新建非阻塞的唤醒管道，失败时主循环只能按帧率轮询 X11 事件 */
+static LCUI_BOOL X11_InitWakeupPipe(void)
+{
+	int i;
+
+	x11.wakeup_fds[0] = x11.wakeup_fds[1] = -1;
+	if (pipe(x11.wakeup_fds) != 0) {
+		x11.wakeup_fds[0] = x11.wakeup_fds[1] = -1;
+		return FALSE;
+	}
+	for (i = 0; i < 2; ++i) {
+		fcntl(x11.wakeup_fds[i], F_SETFL,
+		      fcntl(x11.wakeup_fds[i], F_GETFL) | O_NONBLOCK);
+		fcntl(x11.wakeup_fds[i], F_SETFD, FD_CLOEXEC);
+	}
+	return TRUE;
 }
 
 static LCUI_BOOL X11_DispatchEvent(void)
 {
-	XEvent xevent;
+	XEvent xevent, next;
 	if (!XEventsQueued(x11.display, QueuedAlready)) {
 		return FALSE;
 	}
 	XNextEvent(x11.display, &xevent);
+	/* 只处理连续的鼠标移动事件中的最后一个，以减少命中测试次数 */
+	if (xevent.type == MotionNotify &&
+	    XEventsQueued(x11.display, QueuedAlready)) {
+		XPeekEvent(x11.display, &next);
+		if (next.type == MotionNotify &&
+		    next.xmotion.window == xevent.xmotion.window) {
+			return TRUE;
+		}
+	}
 	EventTrigger_Trigger(x11.trigger, xevent.type, &xevent);
 	if (xevent.type == ClientMessage) {
 		if (xevent.xclient.data.l[0] == x11.wm_delete) {
@@ -92,7 +146,9 @@ static LCUI_BOOL X11_DispatchEvent(void)
 static void X11_ProcessEvents(void)
 {
 	int i;
-	if (!X11_WaitEvent()) {
+	/* 主循环会在空闲时等待事件，这里只处理已经到达的事件 */
+	XFlush(x11.display);
+	if (!XPending(x11.display)) {
 		return;
 	}
 	for (i = 0; X11_DispatchEvent() && i < 100; ++i);
@@ -142,6 +198,12 @@ LCUI_AppDriver LCUI_CreateLinuxX11AppDriver(void)
 	app->UnbindSysEvent = X11_UnbindSysEvent;
 	app->UnbindSysEvent2 = X11_UnbindSysEvent2;
 	app->GetData = X11_GetData;
+	app->WaitEvent = NULL;
+	app->Wakeup = NULL;
+	if (X11_InitWakeupPipe()) {
+		app->WaitEvent = X11_WaitEvent;
+		app->Wakeup = X11_Wakeup;
+	}
 	app->id = LCUI_APP_LINUX_X11;
 	x11.trigger = EventTrigger();
 	return app;
@@ -151,6 +213,10 @@ void LCUI_DestroyLinuxX11AppDriver(LCUI_AppDriver app)
 {
 	EventTrigger_Destroy(x11.trigger);
 	XCloseDisplay(x11.display);
+	if (x11.wakeup_fds[0] >= 0) {
+		close(x11.wakeup_fds[0]);
+		close(x11.wakeup_fds[1]);
+	}
 	x11.trigger = NULL;
 	free(app);
 }
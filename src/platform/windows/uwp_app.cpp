@@ -90,6 +90,8 @@ static LCUI_AppDriver LCUI_CreateUWPAppDriver(App^ app)
 	driver->UnbindSysEvent2 = UWPApp_UnbindSysEvent2;
 	driver->ProcessEvents = UWPApp_ProcessEvents;
 	driver->GetData = UWPApp_GetData;
+	driver->WaitEvent = NULL;
+	driver->Wakeup = NULL;
 	UWPApp.core = app;
 	return driver;
 }
@@ -47,6 +47,7 @@ static struct WindowsDriver {
 	HINSTANCE dll_instance;		/**< 动态库中的资源句柄 */
 	LCUI_EventTrigger trigger;
 	const wchar_t *class_name;
+	HANDLE wakeup_event;		/**< 用于唤醒空闲等待的事件对象 */
 } win;
 
 static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg,
@@ -90,6 +91,23 @@ static void WIN_ProcessEvents(void)
 	}
 }
 
+/** 等待消息队列中有新的消息、事件对象被触发或者超时 */
+static LCUI_BOOL WIN_WaitEvent(long int timeout)
+{
+	DWORD ret;
+
+	/* MWMO_INPUTAVAILABLE 使已经在队列中但未被读取的消息也能结束等待 */
+	ret = MsgWaitForMultipleObjectsEx(1, &win.wakeup_event,
+					  timeout < 0 ? INFINITE : (DWORD)timeout,
+					  QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+	return ret == WAIT_OBJECT_0 + 1;
+}
+
+static void WIN_Wakeup(void)
+{
+	SetEvent(win.wakeup_event);
+}
+
 static int WIN_BindSysEvent(int event_id, LCUI_EventFunc func,
 			    void *data, void(*destroy_data)(void*))
 {
@@ -166,6 +184,14 @@ LCUI_AppDriver LCUI_CreateWinAppDriver(void)
 	app->BindSysEvent = WIN_BindSysEvent;
 	app->UnbindSysEvent = WIN_UnbindSysEvent;
 	app->UnbindSysEvent2 = WIN_UnbindSysEvent2;
+	app->WaitEvent = NULL;
+	app->Wakeup = NULL;
+	/* 自动重置的事件对象，每次唤醒只结束一次等待 */
+	win.wakeup_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if (win.wakeup_event) {
+		app->WaitEvent = WIN_WaitEvent;
+		app->Wakeup = WIN_Wakeup;
+	}
 	win.trigger = EventTrigger();
 	win.active = TRUE;
 	return app;
@@ -176,6 +202,10 @@ void LCUI_DestroyWinAppDriver(LCUI_AppDriver app)
 	win.active = FALSE;
 	UnregisterClassW(win.class_name, win.main_instance);
 	EventTrigger_Destroy(win.trigger);
+	if (win.wakeup_event) {
+		CloseHandle(win.wakeup_event);
+		win.wakeup_event = NULL;
+	}
 	free(app);
 }
 
@@ -54,6 +54,14 @@ void LCUI_ApplySettings(LCUI_Settings settings)
 	self.frame_rate_cap = max(self.frame_rate_cap, 1);
 	self.parallel_rendering_threads =
 	    max(self.parallel_rendering_threads, 1);
+	if (self.parallel_rendering_mode != LCUI_PARALLEL_RENDERING_STRIPS) {
+		self.parallel_rendering_mode = LCUI_PARALLEL_RENDERING_TILES;
+	}
+	self.trace_frame_threshold = max(self.trace_frame_threshold, 0);
+	self.glyph_cache_size = max(self.glyph_cache_size, 64);
+	self.scaled_image_cache_size = max(self.scaled_image_cache_size, 0);
+	self.image_cache_size = max(self.image_cache_size, 0);
+	self.widget_layer_cache_size = max(self.widget_layer_cache_size, 0);
 	TriggerSettingsChangedEvent();
 }
 
@@ -62,8 +70,18 @@ void LCUI_ResetSettings(void)
 {
 	self.frame_rate_cap = LCUI_MAX_FRAMES_PER_SEC;
 	self.parallel_rendering_threads = 4;
+	self.parallel_rendering_mode = LCUI_PARALLEL_RENDERING_TILES;
 	self.record_profile = FALSE;
 	self.fps_meter = FALSE;
 	self.paint_flashing = FALSE;
+	self.premultiplied_alpha = FALSE;
+	self.parallel_style_computation = FALSE;
+	self.trace_frames = FALSE;
+	self.trace_frame_threshold = 0;
+	self.glyph_cache_size = 4096;
+	self.scaled_image_cache_size = 16384;
+	self.image_cache_size = 65536;
+	self.retain_translucent_layers = FALSE;
+	self.widget_layer_cache_size = 32768;
 	TriggerSettingsChangedEvent();
 }
@@ -30,6 +30,7 @@
 #include "config.h"
 #include <stdlib.h>
 #include <errno.h>
+#include <unistd.h>
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
 #include <LCUI/thread.h>
@@ -143,4 +144,14 @@ int LCUIThread_Join(LCUI_Thread thread, void **retval)
 {
 	return pthread_join(thread, retval);
 }
+
+int LCUIThread_GetProcessorCount(void)
+{
+	long n = -1;
+
+#ifdef _SC_NPROCESSORS_ONLN
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return n > 0 ? (int)n : 1;
+}
 #endif
@@ -197,4 +197,13 @@ int LCUIThread_Join(LCUI_Thread thread, void **retval)
 	return -1;
 }
 
+int LCUIThread_GetProcessorCount(void)
+{
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors
+					     : 1;
+}
+
 #endif
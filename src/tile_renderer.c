@@ -0,0 +1,436 @@
+/* tile_renderer.c -- tile-based parallel renderer
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The dirty region is recorded on a grid of TILE_SIZE x TILE_SIZE tiles. A
+ * bitmap tells which tiles are dirty, and each dirty tile keeps the bounding
+ * box of the rectangles that touched it, so small updates are not rounded up
+ * to whole tiles.
+ *
+ * Rendering a rectangle walks the whole widget tree, so adjacent dirty tiles
+ * of a row whose dirty boxes line up exactly are rendered as one job. Runs
+ * are capped to leave every thread several jobs to share.
+ *
+ * Jobs are dealt out to the queues of the rendering threads in contiguous
+ * runs, which keeps neighbouring tiles on the same thread. A thread pops jobs
+ * from the head of its own queue, and when it runs out it steals from the
+ * tail of the other queues, so one busy area does not stall the rest of the
+ * frame.
+ *
+ * The helper threads are borrowed from the async task pool: each frame posts
+ * one high priority task per extra queue. The calling thread never waits for
+ * a helper that has not started, it steals the jobs of that queue instead and
+ * only waits for the helpers that are still rendering. A helper that starts
+ * after the frame has finished returns at once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <LCUI_Build.h>
+#include <LCUI/types.h>
+#include <LCUI/util.h>
+#include <LCUI/main.h>
+#include <LCUI/thread.h>
+#include "tile_renderer.h"
+
+#define BITS_PER_WORD (sizeof(unsigned) * 8)
+#define JOBS_PER_THREAD 4
+
+#define TileRenderer_IsDirty(R, I) \
+	((R)->bitmap[(I) / BITS_PER_WORD] & (1u << ((I) % BITS_PER_WORD)))
+
+#define TileRenderer_MarkDirty(R, I) \
+	(R)->bitmap[(I) / BITS_PER_WORD] |= 1u << ((I) % BITS_PER_WORD)
+
+typedef struct LCUI_TileQueueRec_ {
+	LCUI_Mutex mutex;
+	int head;
+	int tail;
+} LCUI_TileQueueRec, *LCUI_TileQueue;
+
+typedef struct LCUI_TileRendererRec_ {
+	int cols, rows;
+
+	/** dirty bitmap, one bit per tile */
+	unsigned *bitmap;
+
+	/** dirty bounding box of each tile */
+	LCUI_Rect *rects;
+
+	/** rectangles to render, shared by all queues */
+	LCUI_Rect *jobs;
+
+	/** the number of threads to use on the next render */
+	int threads;
+
+	/** tile queues, queue 0 belongs to the calling thread */
+	int n_queues;
+	LCUI_TileQueueRec *queues;
+
+	/** whether a frame is being rendered, helpers only join while it is */
+	LCUI_BOOL rendering;
+
+	/** the number of helpers rendering the current frame */
+	int running;
+
+	/** the number of helper tasks posted but not yet destroyed */
+	int helpers;
+
+	size_t count;
+	LCUI_TileRenderFunc func;
+	void *arg;
+	LCUI_Mutex mutex;
+	LCUI_Cond done_cond;
+} LCUI_TileRendererRec;
+
+static int TileQueue_Pop(LCUI_TileQueue queue)
+{
+	int job = -1;
+
+	LCUIMutex_Lock(&queue->mutex);
+	if (queue->head < queue->tail) {
+		job = queue->head++;
+	}
+	LCUIMutex_Unlock(&queue->mutex);
+	return job;
+}
+
+static int TileQueue_Steal(LCUI_TileQueue queue)
+{
+	int job = -1;
+
+	LCUIMutex_Lock(&queue->mutex);
+	if (queue->head < queue->tail) {
+		job = --queue->tail;
+	}
+	LCUIMutex_Unlock(&queue->mutex);
+	return job;
+}
+
+static size_t TileRenderer_Work(LCUI_TileRenderer renderer, int index)
+{
+	int i, job;
+	int n = renderer->n_queues;
+	size_t count = 0;
+	LCUI_Rect rect;
+
+	while (1) {
+		job = TileQueue_Pop(&renderer->queues[index]);
+		for (i = 1; job < 0 && i < n; ++i) {
+			job = TileQueue_Steal(
+			    &renderer->queues[(index + i) % n]);
+		}
+		if (job < 0) {
+			break;
+		}
+		rect = renderer->jobs[job];
+		count += renderer->func(renderer->arg, &rect);
+	}
+	return count;
+}
+
+static void TileRenderer_RunHelper(void *arg1, void *arg2)
+{
+	size_t count;
+	int index = (int)(size_t)arg2;
+	LCUI_TileRenderer renderer = arg1;
+
+	LCUIMutex_Lock(&renderer->mutex);
+	if (!renderer->rendering || index >= renderer->n_queues) {
+		LCUIMutex_Unlock(&renderer->mutex);
+		return;
+	}
+	renderer->running += 1;
+	LCUIMutex_Unlock(&renderer->mutex);
+	count = TileRenderer_Work(renderer, index);
+	LCUIMutex_Lock(&renderer->mutex);
+	renderer->count += count;
+	renderer->running -= 1;
+	LCUICond_Signal(&renderer->done_cond);
+	LCUIMutex_Unlock(&renderer->mutex);
+}
+
+/** Called when the helper task is destroyed, whether it has run or not */
+static void TileRenderer_OnHelperDone(void *arg)
+{
+	LCUI_TileRenderer renderer = arg;
+
+	LCUIMutex_Lock(&renderer->mutex);
+	renderer->helpers -= 1;
+	LCUICond_Signal(&renderer->done_cond);
+	LCUIMutex_Unlock(&renderer->mutex);
+}
+
+static void TileRenderer_PostHelper(LCUI_TileRenderer renderer, int index)
+{
+	LCUI_TaskRec task = { 0 };
+
+	LCUIMutex_Lock(&renderer->mutex);
+	renderer->helpers += 1;
+	LCUIMutex_Unlock(&renderer->mutex);
+	task.func = TileRenderer_RunHelper;
+	task.arg[0] = renderer;
+	task.arg[1] = (void *)(size_t)index;
+	task.destroy_arg[0] = TileRenderer_OnHelperDone;
+	LCUI_PostAsyncTaskEx(&task, LCUI_TASK_PRIORITY_HIGH, NULL);
+}
+
+static void TileRenderer_FreeQueues(LCUI_TileRenderer renderer)
+{
+	int i;
+
+	for (i = 0; i < renderer->n_queues; ++i) {
+		LCUIMutex_Destroy(&renderer->queues[i].mutex);
+	}
+	free(renderer->queues);
+	renderer->queues = NULL;
+	renderer->n_queues = 0;
+}
+
+static int TileRenderer_UpdateQueues(LCUI_TileRenderer renderer)
+{
+	int i;
+
+	if (renderer->queues && renderer->n_queues == renderer->threads) {
+		return 0;
+	}
+	TileRenderer_FreeQueues(renderer);
+	renderer->queues = NEW(LCUI_TileQueueRec, renderer->threads);
+	if (!renderer->queues) {
+		return -ENOMEM;
+	}
+	for (i = 0; i < renderer->threads; ++i) {
+		LCUIMutex_Init(&renderer->queues[i].mutex);
+	}
+	renderer->n_queues = renderer->threads;
+	return 0;
+}
+
+static int TileRenderer_Resize(LCUI_TileRenderer renderer, int cols, int rows)
+{
+	int i, x, y;
+	size_t words = (cols * rows + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	unsigned *bitmap = calloc(words, sizeof(unsigned));
+	LCUI_Rect *rects = malloc(sizeof(LCUI_Rect) * cols * rows);
+	LCUI_Rect *jobs = malloc(sizeof(LCUI_Rect) * cols * rows);
+
+	if (!bitmap || !rects || !jobs) {
+		free(bitmap);
+		free(rects);
+		free(jobs);
+		return -ENOMEM;
+	}
+	/* keep the dirty tiles on the new grid */
+	for (y = 0; y < renderer->rows; ++y) {
+		for (x = 0; x < renderer->cols; ++x) {
+			i = y * renderer->cols + x;
+			if (!TileRenderer_IsDirty(renderer, i)) {
+				continue;
+			}
+			rects[y * cols + x] = renderer->rects[i];
+			bitmap[(y * cols + x) / BITS_PER_WORD] |=
+			    1u << ((y * cols + x) % BITS_PER_WORD);
+		}
+	}
+	free(renderer->bitmap);
+	free(renderer->rects);
+	free(renderer->jobs);
+	renderer->bitmap = bitmap;
+	renderer->rects = rects;
+	renderer->jobs = jobs;
+	renderer->cols = cols;
+	renderer->rows = rows;
+	return 0;
+}
+
+LCUI_TileRenderer TileRenderer_New(void)
+{
+	LCUI_TileRenderer renderer = NEW(LCUI_TileRendererRec, 1);
+
+	renderer->threads = 1;
+	LCUIMutex_Init(&renderer->mutex);
+	LCUICond_Init(&renderer->done_cond);
+	return renderer;
+}
+
+void TileRenderer_Destroy(LCUI_TileRenderer renderer)
+{
+	/* the helper tasks still in the pool hold the renderer */
+	LCUIMutex_Lock(&renderer->mutex);
+	while (renderer->helpers > 0) {
+		LCUICond_Wait(&renderer->done_cond, &renderer->mutex);
+	}
+	LCUIMutex_Unlock(&renderer->mutex);
+	TileRenderer_FreeQueues(renderer);
+	LCUIMutex_Destroy(&renderer->mutex);
+	LCUICond_Destroy(&renderer->done_cond);
+	free(renderer->bitmap);
+	free(renderer->rects);
+	free(renderer->jobs);
+	free(renderer);
+}
+
+void TileRenderer_SetThreads(LCUI_TileRenderer renderer, int n)
+{
+	renderer->threads = max(n, 1);
+}
+
+void TileRenderer_AddDirtyRect(LCUI_TileRenderer renderer,
+			       const LCUI_Rect *rect)
+{
+	int i, x, y;
+	int left = max(rect->x, 0);
+	int top = max(rect->y, 0);
+	int right = rect->x + rect->width;
+	int bottom = rect->y + rect->height;
+	LCUI_Rect tile_rect, dirty_rect;
+
+	if (right <= left || bottom <= top) {
+		return;
+	}
+	x = (right + TILE_SIZE - 1) / TILE_SIZE;
+	y = (bottom + TILE_SIZE - 1) / TILE_SIZE;
+	if (x > renderer->cols || y > renderer->rows) {
+		if (TileRenderer_Resize(renderer, max(x, renderer->cols),
+					max(y, renderer->rows)) != 0) {
+			return;
+		}
+	}
+	tile_rect.width = TILE_SIZE;
+	tile_rect.height = TILE_SIZE;
+	for (y = top / TILE_SIZE; y * TILE_SIZE < bottom; ++y) {
+		for (x = left / TILE_SIZE; x * TILE_SIZE < right; ++x) {
+			tile_rect.x = x * TILE_SIZE;
+			tile_rect.y = y * TILE_SIZE;
+			LCUIRect_GetOverlayRect(&tile_rect, rect, &dirty_rect);
+			i = y * renderer->cols + x;
+			if (TileRenderer_IsDirty(renderer, i)) {
+				LCUIRect_MergeRect(&renderer->rects[i],
+						   &renderer->rects[i],
+						   &dirty_rect);
+				continue;
+			}
+			TileRenderer_MarkDirty(renderer, i);
+			renderer->rects[i] = dirty_rect;
+		}
+	}
+}
+
+/**
+ * Turn the dirty tiles into jobs, joining runs of up to max_run tiles
+ * @returns the number of jobs
+ */
+static int TileRenderer_CollectJobs(LCUI_TileRenderer renderer, int max_run)
+{
+	int i, x, y;
+	int n = 0, run = 0;
+	LCUI_Rect *rect, *job;
+
+	for (y = 0; y < renderer->rows; ++y) {
+		job = NULL;
+		for (x = 0; x < renderer->cols; ++x) {
+			i = y * renderer->cols + x;
+			if (!TileRenderer_IsDirty(renderer, i)) {
+				job = NULL;
+				continue;
+			}
+			rect = &renderer->rects[i];
+			if (job && run < max_run && job->y == rect->y &&
+			    job->height == rect->height &&
+			    job->x + job->width == rect->x) {
+				job->width += rect->width;
+				++run;
+				continue;
+			}
+			job = &renderer->jobs[n++];
+			*job = *rect;
+			run = 1;
+		}
+	}
+	return n;
+}
+
+size_t TileRenderer_Render(LCUI_TileRenderer renderer,
+			   LCUI_TileRenderFunc func, void *arg)
+{
+	int i, n, nq;
+	size_t w, words;
+	size_t count = 0;
+	unsigned bits;
+
+	words = (renderer->cols * renderer->rows + BITS_PER_WORD - 1) /
+		BITS_PER_WORD;
+	for (n = 0, w = 0; w < words; ++w) {
+		for (bits = renderer->bitmap[w]; bits; bits &= bits - 1) {
+			++n;
+		}
+	}
+	if (n < 1) {
+		return 0;
+	}
+	if (TileRenderer_UpdateQueues(renderer) != 0) {
+		return 0;
+	}
+	nq = renderer->n_queues;
+	if (nq > 1) {
+		n = TileRenderer_CollectJobs(
+		    renderer, max(1, n / (nq * JOBS_PER_THREAD)));
+	} else {
+		n = TileRenderer_CollectJobs(renderer, renderer->cols);
+	}
+	for (i = 0; i < nq; ++i) {
+		renderer->queues[i].head = n * i / nq;
+		renderer->queues[i].tail = n * (i + 1) / nq;
+	}
+	renderer->func = func;
+	renderer->arg = arg;
+	if (nq < 2 || n < 2) {
+		count = TileRenderer_Work(renderer, 0);
+	} else {
+		LCUIMutex_Lock(&renderer->mutex);
+		renderer->count = 0;
+		renderer->rendering = TRUE;
+		LCUIMutex_Unlock(&renderer->mutex);
+		for (i = 1; i < nq; ++i) {
+			TileRenderer_PostHelper(renderer, i);
+		}
+		count = TileRenderer_Work(renderer, 0);
+		LCUIMutex_Lock(&renderer->mutex);
+		renderer->rendering = FALSE;
+		while (renderer->running > 0) {
+			LCUICond_Wait(&renderer->done_cond, &renderer->mutex);
+		}
+		count += renderer->count;
+		LCUIMutex_Unlock(&renderer->mutex);
+	}
+	memset(renderer->bitmap, 0, words * sizeof(unsigned));
+	return count;
+}
@@ -0,0 +1,63 @@
+/* tile_renderer.h -- tile-based parallel renderer
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LCUI_TILE_RENDERER_H
+#define LCUI_TILE_RENDERER_H
+
+#define TILE_SIZE 64
+
+typedef struct LCUI_TileRendererRec_ *LCUI_TileRenderer;
+
+/** Render a dirty rectangle, it may be called from any thread */
+typedef size_t (*LCUI_TileRenderFunc)(void *, LCUI_Rect *);
+
+LCUI_TileRenderer TileRenderer_New(void);
+
+void TileRenderer_Destroy(LCUI_TileRenderer renderer);
+
+/**
+ * Set the number of rendering threads, including the thread that calls
+ * TileRenderer_Render(). The other threads are borrowed from the async task
+ * pool on each render.
+ */
+void TileRenderer_SetThreads(LCUI_TileRenderer renderer, int n);
+
+/** Mark the tiles covered by the rectangle as dirty */
+void TileRenderer_AddDirtyRect(LCUI_TileRenderer renderer,
+			       const LCUI_Rect *rect);
+
+/**
+ * Render all dirty tiles and wait for them to finish. Each tile is rendered
+ * with the bounding box of its dirty rectangles.
+ * @returns the sum of the values returned by func
+ */
+size_t TileRenderer_Render(LCUI_TileRenderer renderer,
+			   LCUI_TileRenderFunc func, void *arg);
+
+#endif
@@ -27,8 +27,10 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <LCUI_Build.h>
 #include <LCUI/LCUI.h>
 #include <LCUI/thread.h>
@@ -37,66 +39,173 @@
 #define STATE_RUN 1
 #define STATE_PAUSE 0
 
+/** 定时器不在队列中时的索引 */
+#define TIMER_NOT_QUEUED ((size_t)-1)
+
 /*----------------------------- Timer --------------------------------*/
 
 typedef struct TimerRec_ {
 	int state;			/**< 状态 */
-	long int id;			/**< 定时器ID */
+	int id;				/**< 定时器ID */
 	LCUI_BOOL reuse;		/**< 是否重复使用该定时器 */
 
-	int64_t start_time;		/**< 定时器启动时的时间 */
+	int64_t deadline;		/**< 到期时间 */
 	int64_t pause_time;		/**< 定时器暂停时的时间 */
 	long int total_ms;		/**< 定时时间（单位：毫秒） */
-	long int pause_ms;		/**< 定时器处于暂停状态的时长（单位：毫秒） */
 
 	void (*callback)(void *);	/**< 回调函数 */
 	void *arg;			/**< 函数的参数 */
 
-	LinkedListNode node;		/**< 位于定时器列表中的节点 */
+	size_t index;			/**< 在队列中的位置 */
 } TimerRec, *Timer;
 
 static struct TimerModule {
 	int id_count;         /**< 定时器ID计数 */
 	LCUI_BOOL active;     /**< 定时器线程是否正在运行 */
 	LCUI_Mutex mutex;     /**< 定时器记录操作互斥锁 */
-	LinkedList timers;    /**< 定时器数据记录 */
+
+	/** 以到期时间排序的最小堆，只包含正在计时的定时器 */
+	Timer *queue;
+	size_t queue_length;
+	size_t queue_capacity;
+
+	/** 以 ID 为键的定时器表，包含所有定时器 */
+	Dict *timers;
+	DictType timers_dict;
+
+	/** 正在执行回调的定时器，它在回调中被释放时会置为 NULL */
+	Timer current;
 } self;
 
 /*----------------------------- Private ------------------------------*/
 
-/** 更新定时器在定时器列表中的位置 */
-static void TimerList_AddNode(LinkedListNode *node)
+static LCUI_BOOL TimerQueue_Less(Timer a, Timer b)
 {
-	Timer timer;
-	int64_t t, tt;
-	LinkedListNode *cur;
-	/* 计算该定时器的剩余定时时长 */
-	timer = node->data;
-	t = LCUI_GetTimeDelta(timer->start_time);
-	t = timer->total_ms - t + timer->pause_ms;
-	for (LinkedList_Each(cur, &self.timers)) {
-		timer = cur->data;
-		tt = LCUI_GetTimeDelta(timer->start_time);
-		tt = timer->total_ms - tt + timer->pause_ms;
-		if (t <= tt) {
-			LinkedList_Link(&self.timers, cur->prev, node);
-			return;
+	if (a->deadline != b->deadline) {
+		return a->deadline < b->deadline;
+	}
+	return a->id < b->id;
+}
+
+static void TimerQueue_Set(size_t i, Timer timer)
+{
+	self.queue[i] = timer;
+	timer->index = i;
+}
+
+static void TimerQueue_SiftUp(size_t i)
+{
+	size_t parent;
+	Timer timer = self.queue[i];
+
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (!TimerQueue_Less(timer, self.queue[parent])) {
+			break;
 		}
+		TimerQueue_Set(i, self.queue[parent]);
+		i = parent;
 	}
-	LinkedList_AppendNode(&self.timers, node);
+	TimerQueue_Set(i, timer);
 }
 
-static Timer FindTimer(int timer_id)
+static void TimerQueue_SiftDown(size_t i)
 {
-	Timer timer;
-	LinkedListNode *node;
-	for (LinkedList_Each(node, &self.timers)) {
-		timer = node->data;
-		if (timer && timer->id == timer_id) {
-			return timer;
+	size_t child;
+	Timer timer = self.queue[i];
+
+	while ((child = i * 2 + 1) < self.queue_length) {
+		if (child + 1 < self.queue_length &&
+		    TimerQueue_Less(self.queue[child + 1], self.queue[child])) {
+			child += 1;
+		}
+		if (!TimerQueue_Less(self.queue[child], timer)) {
+			break;
+		}
+		TimerQueue_Set(i, self.queue[child]);
+		i = child;
+	}
+	TimerQueue_Set(i, timer);
+}
+
+static int TimerQueue_Push(Timer timer)
+{
+	size_t capacity;
+	Timer *queue;
+
+	if (self.queue_length >= self.queue_capacity) {
+		capacity = max(self.queue_capacity * 2, 16);
+		queue = realloc(self.queue, sizeof(Timer) * capacity);
+		if (!queue) {
+			return -ENOMEM;
 		}
+		self.queue = queue;
+		self.queue_capacity = capacity;
+	}
+	TimerQueue_Set(self.queue_length++, timer);
+	TimerQueue_SiftUp(timer->index);
+	return 0;
+}
+
+static void TimerQueue_Remove(Timer timer)
+{
+	size_t i = timer->index;
+	Timer last;
+
+	if (i == TIMER_NOT_QUEUED) {
+		return;
+	}
+	timer->index = TIMER_NOT_QUEUED;
+	last = self.queue[--self.queue_length];
+	if (last == timer) {
+		return;
+	}
+	TimerQueue_Set(i, last);
+	TimerQueue_SiftUp(i);
+	TimerQueue_SiftDown(last->index);
+}
+
+/** 在定时器的到期时间改变后，更新它在队列中的位置 */
+static void TimerQueue_Update(Timer timer)
+{
+	if (timer->index == TIMER_NOT_QUEUED) {
+		return;
+	}
+	TimerQueue_SiftUp(timer->index);
+	TimerQueue_SiftDown(timer->index);
+}
+
+static unsigned int TimerDict_HashFunction(const void *key)
+{
+	return Dict_IntHashFunction(*(const unsigned int *)key);
+}
+
+static int TimerDict_KeyCompare(void *privdata, const void *key1,
+				const void *key2)
+{
+	return *(const int *)key1 == *(const int *)key2;
+}
+
+static void TimerDict_ValDestructor(void *privdata, void *val)
+{
+	free(val);
+}
+
+static Timer FindTimer(int timer_id)
+{
+	return Dict_FetchValue(self.timers, &timer_id);
+}
+
+static void DeleteTimer(Timer timer)
+{
+	TimerQueue_Remove(timer);
+	Dict_DeleteNoFree(self.timers, &timer->id);
+	/* 在回调中释放的定时器需要等回调返回后再释放内存 */
+	if (self.current == timer) {
+		self.current = NULL;
+		return;
 	}
-	return NULL;
+	free(timer);
 }
 
 int LCUITimer_Set(long int n_ms, void(*func)(void *), void *arg,
@@ -106,23 +215,29 @@ int LCUITimer_Set(long int n_ms, void(*func)(void *), void *arg,
 	if (!self.active) {
 		return -1;
 	}
-	LCUIMutex_Lock(&self.mutex);
 	timer = malloc(sizeof(TimerRec));
+	if (!timer) {
+		return -ENOMEM;
+	}
+	LCUIMutex_Lock(&self.mutex);
 	timer->arg = arg;
 	timer->callback = func;
 	timer->reuse = reuse;
-	timer->pause_ms = 0;
 	timer->total_ms = n_ms;
 	timer->state = STATE_RUN;
 	timer->id = ++self.id_count;
-	timer->start_time = LCUI_GetTime();
-	timer->node.next = NULL;
-	timer->node.prev = NULL;
-	timer->node.data = timer;
-	TimerList_AddNode(&timer->node);
+	timer->deadline = LCUI_GetTime() + n_ms;
+	timer->pause_time = 0;
+	timer->index = TIMER_NOT_QUEUED;
+	if (TimerQueue_Push(timer) != 0) {
+		LCUIMutex_Unlock(&self.mutex);
+		free(timer);
+		return -ENOMEM;
+	}
+	Dict_Add(self.timers, &timer->id, timer);
 	LCUIMutex_Unlock(&self.mutex);
-	DEBUG_MSG("set timer, id: %ld, total_ms: %ld\n", timer->id,
-		  timer->total_ms);
+	LCUI_Wakeup();
+	DEBUG_MSG("set timer, id: %d, total_ms: %ld\n", timer->id, n_ms);
 	return timer->id;
 }
 
@@ -138,8 +253,7 @@ int LCUITimer_Free(int timer_id)
 		LCUIMutex_Unlock(&self.mutex);
 		return -1;
 	}
-	LinkedList_Unlink(&self.timers, &timer->node);
-	free(timer);
+	DeleteTimer(timer);
 	LCUIMutex_Unlock(&self.mutex);
 	return 0;
 }
@@ -152,10 +266,11 @@ int LCUITimer_Pause(int timer_id)
 	}
 	LCUIMutex_Lock(&self.mutex);
 	timer = FindTimer(timer_id);
-	if (timer) {
+	if (timer && timer->state == STATE_RUN) {
 		/* 记录暂停时的时间 */
 		timer->pause_time = LCUI_GetTime();
 		timer->state = STATE_PAUSE;
+		TimerQueue_Remove(timer);
 	}
 	LCUIMutex_Unlock(&self.mutex);
 	return timer ? 0 : -1;
@@ -163,20 +278,35 @@ int LCUITimer_Pause(int timer_id)
 
 int LCUITimer_Continue(int timer_id)
 {
+	int ret = 0;
 	Timer timer;
+	int64_t deadline;
+
 	if (!self.active) {
 		return -2;
 	}
 	LCUIMutex_Lock(&self.mutex);
 	timer = FindTimer(timer_id);
-	if (timer) {
-		/* 计算处于暂停状态的时长 */
-		timer->pause_ms +=
-		    (long int)LCUI_GetTimeDelta(timer->pause_time);
+	if (!timer) {
+		ret = -1;
+	} else if (timer->state == STATE_PAUSE) {
+		deadline = timer->deadline;
+		/* 将到期时间推迟处于暂停状态的时长 */
+		timer->deadline += LCUI_GetTimeDelta(timer->pause_time);
 		timer->state = STATE_RUN;
+		/* 正在执行回调的定时器会在回调返回后重新加入队列 */
+		if (timer != self.current && TimerQueue_Push(timer) != 0) {
+			/* 加入队列失败时保持暂停状态，以免定时器永远不会到期 */
+			timer->deadline = deadline;
+			timer->state = STATE_PAUSE;
+			ret = -ENOMEM;
+		}
 	}
 	LCUIMutex_Unlock(&self.mutex);
-	return timer ? 0 : -1;
+	if (ret == 0) {
+		LCUI_Wakeup();
+	}
+	return ret;
 }
 
 int LCUITimer_Reset(int timer_id, long int n_ms)
@@ -188,11 +318,13 @@ int LCUITimer_Reset(int timer_id, long int n_ms)
 	LCUIMutex_Lock(&self.mutex);
 	timer = FindTimer(timer_id);
 	if (timer) {
-		timer->pause_ms = 0;
 		timer->total_ms = n_ms;
-		timer->start_time = LCUI_GetTime();
+		timer->pause_time = LCUI_GetTime();
+		timer->deadline = timer->pause_time + n_ms;
+		TimerQueue_Update(timer);
 	}
 	LCUIMutex_Unlock(&self.mutex);
+	LCUI_Wakeup();
 	return timer ? 0 : -1;
 }
 
@@ -206,40 +338,73 @@ int LCUI_SetInterval(long int n_ms, void(*callback)(void *), void *arg)
 	return LCUITimer_Set(n_ms, callback, arg, TRUE);
 }
 
+long int LCUI_GetNextTimerDelay(void)
+{
+	long int ms = -1;
+
+	if (!self.active) {
+		return -1;
+	}
+	LCUIMutex_Lock(&self.mutex);
+	if (self.queue_length > 0) {
+		ms = (long)(self.queue[0]->deadline - LCUI_GetTime());
+		ms = max(ms, 0);
+	}
+	LCUIMutex_Unlock(&self.mutex);
+	return ms;
+}
+
 size_t LCUI_ProcessTimers(void)
 {
 	size_t count = 0;
-	long lost_ms;
-
-	Timer timer = NULL;
-	LinkedListNode *node;
+	int64_t now;
+	Timer timer;
 
 	LCUIMutex_Lock(&self.mutex);
-	while(self.active) {
-		for (LinkedList_Each(node, &self.timers)) {
-			timer = node->data;
-			if (timer && timer->state == STATE_RUN) {
-				break;
-			}
-		}
-		if (!node) {
+	now = LCUI_GetTime();
+	/* 只处理在这之前到期的定时器，重复的定时器在下面重新计时 */
+	while (self.active && self.queue_length > 0) {
+		timer = self.queue[0];
+		if (timer->deadline > now) {
 			break;
 		}
 		count += 1;
-		lost_ms = (long)LCUI_GetTimeDelta(timer->start_time);
-		/* 若流失的时间未达到总定时时长 */
-		if (lost_ms - timer->pause_ms < timer->total_ms) {
-			break;
+		TimerQueue_Remove(timer);
+		/* 一次性的定时器在回调前移除，使回调中对它的操作无效 */
+		if (!timer->reuse) {
+			Dict_DeleteNoFree(self.timers, &timer->id);
 		}
-		/* 若需要重复使用，则重置剩余等待时间 */
-		LinkedList_Unlink(&self.timers, node);
+		self.current = timer;
+		LCUITrace_Begin("timer", "timer", NULL);
 		timer->callback(timer->arg);
-		if (timer->reuse) {
-			timer->pause_ms = 0;
-			timer->start_time = LCUI_GetTime();
-			TimerList_AddNode(node);
-		} else {
+		LCUITrace_End();
+		if (!self.current) {
+			free(timer);
+			continue;
+		}
+		self.current = NULL;
+		if (!timer->reuse) {
 			free(timer);
+			continue;
+		}
+		/*
+		 * 若需要重复使用，则重置剩余等待时间
+		 * 间隔为 0 的定时器在同一毫秒内重新计时后仍然是到期的，将它推迟到
+		 * 下一毫秒，使它每次最多执行一次，不会阻塞主循环
+		 */
+		if (timer->state == STATE_RUN) {
+			timer->deadline = LCUI_GetTime() + timer->total_ms;
+			if (timer->deadline <= now) {
+				timer->deadline = now + 1;
+			}
+			if (TimerQueue_Push(timer) == 0) {
+				continue;
+			}
+			/* 加入队列失败时暂停定时器，让调用者可以继续它 */
+			timer->pause_time = LCUI_GetTime();
+			timer->state = STATE_PAUSE;
+		} else {
+			timer->deadline = timer->pause_time + timer->total_ms;
 		}
 	}
 	LCUIMutex_Unlock(&self.mutex);
@@ -248,10 +413,20 @@ size_t LCUI_ProcessTimers(void)
 
 void LCUI_InitTimer(void)
 {
+	DictType *dt = &self.timers_dict;
+
 	self.active = TRUE;
+	self.current = NULL;
+	self.queue = NULL;
+	self.queue_length = 0;
+	self.queue_capacity = 0;
+	memset(dt, 0, sizeof(DictType));
+	dt->hashFunction = TimerDict_HashFunction;
+	dt->keyCompare = TimerDict_KeyCompare;
+	dt->valDestructor = TimerDict_ValDestructor;
+	self.timers = Dict_Create(dt, NULL);
 	LCUITime_Init();
 	LCUIMutex_Init(&self.mutex);
-	LinkedList_Init(&self.timers);
 }
 
 void LCUI_FreeTimer(void)
@@ -262,6 +437,11 @@ void LCUI_FreeTimer(void)
 	self.active = FALSE;
 	LCUIMutex_Lock(&self.mutex);
 	LCUIMutex_Unlock(&self.mutex);
-	LinkedList_ClearData(&self.timers, free);
+	Dict_Release(self.timers);
+	free(self.queue);
+	self.timers = NULL;
+	self.queue = NULL;
+	self.queue_length = 0;
+	self.queue_capacity = 0;
 	LCUIMutex_Destroy(&self.mutex);
 }
@@ -0,0 +1,260 @@
+/* arena.c -- bump allocator for short-lived memory
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/thread.h>
+#include <LCUI/util/arena.h>
+
+#define ARENA_ALIGN(SIZE) (((SIZE) + 15) & ~(size_t)15)
+#define FRAME_ARENA_BLOCK_SIZE (1024 * 1024)
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+struct LCUI_ArenaBlockRec_ {
+	size_t size;
+	size_t used;
+
+	/* whether the block is used since the last reset */
+	LCUI_BOOL active;
+	LCUI_ArenaBlock next;
+	uchar_t *data;
+};
+
+static struct LCUI_FrameArenaModule {
+	LCUI_BOOL active;
+	LCUI_Mutex mutex;
+
+	/* all frame arenas, one for each thread */
+	LinkedList arenas;
+
+	/* it is increased when the module is freed, so that the threads
+	 * can find that their arenas are no longer valid */
+	unsigned generation;
+	LCUI_FrameArenaProfileRec profile;
+} self;
+
+static THREAD_LOCAL LCUI_Arena frame_arena;
+static THREAD_LOCAL unsigned frame_arena_generation;
+
+static LCUI_ArenaBlock ArenaBlock_New(size_t size)
+{
+	LCUI_ArenaBlock block;
+
+	block = malloc(ARENA_ALIGN(sizeof(LCUI_ArenaBlockRec)) + size);
+	if (!block) {
+		return NULL;
+	}
+	block->size = size;
+	block->used = 0;
+	block->active = TRUE;
+	block->next = NULL;
+	block->data = (uchar_t *)block + ARENA_ALIGN(sizeof(LCUI_ArenaBlockRec));
+	return block;
+}
+
+void Arena_Init(LCUI_Arena arena, size_t block_size)
+{
+	arena->head = NULL;
+	arena->current = NULL;
+	arena->block_size = block_size;
+	arena->alloc_count = 0;
+	arena->alloc_bytes = 0;
+	arena->memory_usage = 0;
+	arena->node.data = arena;
+	arena->node.prev = arena->node.next = NULL;
+}
+
+void Arena_Destroy(LCUI_Arena arena)
+{
+	LCUI_ArenaBlock block, next;
+
+	for (block = arena->head; block; block = next) {
+		next = block->next;
+		free(block);
+	}
+	arena->head = NULL;
+	arena->current = NULL;
+	arena->memory_usage = 0;
+}
+
+void *Arena_Alloc(LCUI_Arena arena, size_t size)
+{
+	void *ptr;
+	LCUI_ArenaBlock block = arena->current;
+
+	size = ARENA_ALIGN(size);
+	if (!block || block->size - block->used < size) {
+		/* try the next block, it is left by the last reset or rewind */
+		if (block && block->next && block->next->size >= size) {
+			block = block->next;
+			block->used = 0;
+		} else {
+			block = ArenaBlock_New(max(size, arena->block_size));
+			if (!block) {
+				return NULL;
+			}
+			arena->memory_usage += block->size;
+			if (arena->current) {
+				block->next = arena->current->next;
+				arena->current->next = block;
+			} else {
+				block->next = arena->head;
+				arena->head = block;
+			}
+		}
+		block->active = TRUE;
+		arena->current = block;
+	}
+	ptr = block->data + block->used;
+	block->used += size;
+	arena->alloc_count += 1;
+	arena->alloc_bytes += size;
+	return ptr;
+}
+
+void Arena_GetMark(LCUI_Arena arena, LCUI_ArenaMark mark)
+{
+	mark->block = arena->current;
+	mark->used = arena->current ? arena->current->used : 0;
+}
+
+void Arena_Rewind(LCUI_Arena arena, LCUI_ArenaMark mark)
+{
+	if (mark->block) {
+		arena->current = mark->block;
+		arena->current->used = mark->used;
+	} else if (arena->head) {
+		arena->current = arena->head;
+		arena->current->used = 0;
+	}
+}
+
+void Arena_Reset(LCUI_Arena arena)
+{
+	LCUI_ArenaBlock block, prev = NULL, next;
+
+	for (block = arena->head; block; block = next) {
+		next = block->next;
+		if (block->active || block == arena->head) {
+			block->used = 0;
+			block->active = FALSE;
+			prev = block;
+			continue;
+		}
+		if (prev) {
+			prev->next = next;
+		}
+		arena->memory_usage -= block->size;
+		free(block);
+	}
+	arena->current = arena->head;
+	arena->alloc_count = 0;
+	arena->alloc_bytes = 0;
+}
+
+LCUI_Arena LCUIFrameArena_Get(void)
+{
+	LCUI_Arena arena;
+
+	if (!self.active) {
+		return NULL;
+	}
+	if (frame_arena && frame_arena_generation == self.generation) {
+		return frame_arena;
+	}
+	arena = NEW(LCUI_ArenaRec, 1);
+	Arena_Init(arena, FRAME_ARENA_BLOCK_SIZE);
+	LCUIMutex_Lock(&self.mutex);
+	LinkedList_AppendNode(&self.arenas, &arena->node);
+	LCUIMutex_Unlock(&self.mutex);
+	frame_arena = arena;
+	frame_arena_generation = self.generation;
+	return arena;
+}
+
+void LCUIFrameArena_Reset(void)
+{
+	LCUI_Arena arena;
+	LinkedListNode *node;
+	LCUI_FrameArenaProfileRec profile = { 0 };
+
+	if (!self.active) {
+		return;
+	}
+	LCUIMutex_Lock(&self.mutex);
+	for (LinkedList_Each(node, &self.arenas)) {
+		arena = node->data;
+		profile.alloc_count += arena->alloc_count;
+		profile.alloc_bytes += arena->alloc_bytes;
+		Arena_Reset(arena);
+		profile.memory_usage += arena->memory_usage;
+	}
+	self.profile = profile;
+	LCUIMutex_Unlock(&self.mutex);
+}
+
+void LCUIFrameArena_GetProfile(LCUI_FrameArenaProfile profile)
+{
+	if (!self.active) {
+		memset(profile, 0, sizeof(LCUI_FrameArenaProfileRec));
+		return;
+	}
+	LCUIMutex_Lock(&self.mutex);
+	*profile = self.profile;
+	LCUIMutex_Unlock(&self.mutex);
+}
+
+static void OnDestroyArena(void *arg)
+{
+	Arena_Destroy(arg);
+	free(arg);
+}
+
+void LCUI_InitFrameArena(void)
+{
+	LCUIMutex_Init(&self.mutex);
+	LinkedList_Init(&self.arenas);
+	memset(&self.profile, 0, sizeof(self.profile));
+	self.active = TRUE;
+}
+
+void LCUI_FreeFrameArena(void)
+{
+	self.active = FALSE;
+	self.generation += 1;
+	LinkedList_ClearData(&self.arenas, OnDestroyArena);
+	LCUIMutex_Destroy(&self.mutex);
+}
@@ -0,0 +1,412 @@
+/* dirtyregion.c -- dirty region of a frame
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Rectangles are indexed by a uniform grid. The grid has no bounds, cells
+ * are hashed into a fixed number of buckets, so a rect which is found in a
+ * bucket is checked again for intersection. A rect which intersects too
+ * many cells is kept in a separate list and checked by every lookup.
+ *
+ * When a rect is added, the rects nearby are checked:
+ * - if one of them contains the new rect, the new rect is dropped.
+ * - if the new rect contains one of them, that one is removed.
+ * - if the bounding rect of the two paints no more than rect_cost pixels in
+ *   addition, they are merged and the merged rect is added again.
+ * When there are too many rects, the new rect is merged with the rect which
+ * costs least, so the number of rects is bounded.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/util/dirtyregion.h>
+
+/* Rects farther apart are not merged unless there are too many rects */
+#define MERGE_DISTANCE 32
+
+/* Rects intersect more cells than it are kept in the large rect list */
+#define MAX_RECT_CELLS 32
+
+#define CELL_SIZE LCUI_DIRTY_REGION_CELL_SIZE
+
+typedef enum DirtyRectRelation {
+	DIRTY_RECT_NONE,
+	DIRTY_RECT_COVERED,
+	DIRTY_RECT_CONTAINED,
+	DIRTY_RECT_MERGEABLE
+} DirtyRectRelation;
+
+typedef struct CellRangeRec_ {
+	int left, top, right, bottom;
+} CellRangeRec, *CellRange;
+
+static int GetCell(int value)
+{
+	if (value >= 0) {
+		return value / CELL_SIZE;
+	}
+	return -((-value - 1) / CELL_SIZE) - 1;
+}
+
+static void GetCellRange(const LCUI_Rect *rect, int margin, CellRange range)
+{
+	range->left = GetCell(rect->x - margin);
+	range->top = GetCell(rect->y - margin);
+	range->right = GetCell(rect->x + rect->width - 1 + margin);
+	range->bottom = GetCell(rect->y + rect->height - 1 + margin);
+}
+
+static LCUI_BOOL CellRange_IsLarge(CellRange range)
+{
+	return (int64_t)(range->right - range->left + 1) *
+		   (range->bottom - range->top + 1) >
+	       MAX_RECT_CELLS;
+}
+
+static LCUI_DirtyRegionBucket DirtyRegion_GetBucket(LCUI_DirtyRegion region,
+						    int x, int y)
+{
+	unsigned hash = ((unsigned)x * 73856093u) ^ ((unsigned)y * 19349663u);
+
+	return &region->buckets[hash % LCUI_DIRTY_REGION_BUCKETS];
+}
+
+static LCUI_BOOL Bucket_Push(LCUI_DirtyRegionBucket bucket, unsigned item)
+{
+	size_t size;
+	unsigned *items;
+
+	if (bucket->length >= bucket->size) {
+		size = bucket->size < 8 ? 8 : bucket->size * 2;
+		items = realloc(bucket->items, sizeof(unsigned) * size);
+		if (!items) {
+			return FALSE;
+		}
+		bucket->items = items;
+		bucket->size = size;
+	}
+	bucket->items[bucket->length++] = item;
+	return TRUE;
+}
+
+static void Bucket_Remove(LCUI_DirtyRegionBucket bucket, unsigned item)
+{
+	size_t i;
+
+	for (i = 0; i < bucket->length; ++i) {
+		if (bucket->items[i] == item) {
+			bucket->items[i] = bucket->items[--bucket->length];
+			return;
+		}
+	}
+}
+
+static void Bucket_Destroy(LCUI_DirtyRegionBucket bucket)
+{
+	free(bucket->items);
+	bucket->items = NULL;
+	bucket->length = 0;
+	bucket->size = 0;
+}
+
+/** Add the rect at index i to the index, or remove it from the index */
+static void DirtyRegion_Index(LCUI_DirtyRegion region, unsigned i,
+			      LCUI_BOOL add)
+{
+	int x, y;
+	CellRangeRec range;
+	LCUI_DirtyRegionBucket bucket;
+
+	GetCellRange(&region->rects[i], 0, &range);
+	if (CellRange_IsLarge(&range)) {
+		if (add) {
+			Bucket_Push(&region->large_rects, i);
+		} else {
+			Bucket_Remove(&region->large_rects, i);
+		}
+		return;
+	}
+	for (y = range.top; y <= range.bottom; ++y) {
+		for (x = range.left; x <= range.right; ++x) {
+			bucket = DirtyRegion_GetBucket(region, x, y);
+			if (add) {
+				Bucket_Push(bucket, i);
+			} else {
+				Bucket_Remove(bucket, i);
+			}
+		}
+	}
+}
+
+static void DirtyRegion_Remove(LCUI_DirtyRegion region, unsigned i)
+{
+	unsigned last = (unsigned)region->length - 1;
+
+	DirtyRegion_Index(region, i, FALSE);
+	if (i != last) {
+		DirtyRegion_Index(region, last, FALSE);
+		region->rects[i] = region->rects[last];
+		region->marks[i] = region->marks[last];
+		DirtyRegion_Index(region, i, TRUE);
+	}
+	region->length -= 1;
+}
+
+static LCUI_BOOL DirtyRegion_Append(LCUI_DirtyRegion region,
+				    const LCUI_Rect *rect)
+{
+	size_t size;
+	unsigned *marks;
+	LCUI_Rect *rects;
+
+	if (region->length >= region->size) {
+		size = region->size < 16 ? 16 : region->size * 2;
+		rects = realloc(region->rects, sizeof(LCUI_Rect) * size);
+		if (!rects) {
+			return FALSE;
+		}
+		region->rects = rects;
+		marks = realloc(region->marks, sizeof(unsigned) * size);
+		if (!marks) {
+			return FALSE;
+		}
+		region->marks = marks;
+		region->size = size;
+	}
+	region->rects[region->length] = *rect;
+	region->marks[region->length] = 0;
+	DirtyRegion_Index(region, (unsigned)region->length, TRUE);
+	region->length += 1;
+	return TRUE;
+}
+
+static int64_t GetRectArea(const LCUI_Rect *rect)
+{
+	return (int64_t)rect->width * rect->height;
+}
+
+/** Get the area painted in addition if a and b are merged */
+static int64_t GetMergeCost(const LCUI_Rect *a, const LCUI_Rect *b)
+{
+	int64_t cost;
+	LCUI_Rect rect;
+
+	LCUIRect_MergeRect(&rect, a, b);
+	cost = GetRectArea(&rect) - GetRectArea(a) - GetRectArea(b);
+	if (LCUIRect_GetOverlayRect(a, b, &rect)) {
+		cost += GetRectArea(&rect);
+	}
+	return cost;
+}
+
+static DirtyRectRelation DirtyRegion_Test(LCUI_DirtyRegion region,
+					  const LCUI_Rect *rect, unsigned i)
+{
+	LCUI_Rect *target = &region->rects[i];
+
+	if (LCUIRect_IsIncludeRect(target, rect)) {
+		return DIRTY_RECT_COVERED;
+	}
+	if (LCUIRect_IsIncludeRect(rect, target)) {
+		return DIRTY_RECT_CONTAINED;
+	}
+	if (GetMergeCost(rect, target) <= region->rect_cost) {
+		return DIRTY_RECT_MERGEABLE;
+	}
+	return DIRTY_RECT_NONE;
+}
+
+static void DirtyRegion_NextMark(LCUI_DirtyRegion region)
+{
+	region->mark += 1;
+	if (region->mark == 0) {
+		memset(region->marks, 0, sizeof(unsigned) * region->size);
+		region->mark = 1;
+	}
+}
+
+static int DirtyRegion_TestBucket(LCUI_DirtyRegion region,
+				  const LCUI_Rect *rect,
+				  LCUI_DirtyRegionBucket bucket,
+				  DirtyRectRelation *relation)
+{
+	size_t k;
+	unsigned i;
+
+	for (k = 0; k < bucket->length; ++k) {
+		i = bucket->items[k];
+		if (region->marks[i] == region->mark) {
+			continue;
+		}
+		region->marks[i] = region->mark;
+		*relation = DirtyRegion_Test(region, rect, i);
+		if (*relation != DIRTY_RECT_NONE) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+/** Find a rect nearby which is related to the given rect */
+static int DirtyRegion_Find(LCUI_DirtyRegion region, const LCUI_Rect *rect,
+			    DirtyRectRelation *relation)
+{
+	int i, x, y;
+	CellRangeRec range;
+
+	GetCellRange(rect, MERGE_DISTANCE, &range);
+	if (CellRange_IsLarge(&range)) {
+		for (i = 0; i < (int)region->length; ++i) {
+			*relation = DirtyRegion_Test(region, rect, i);
+			if (*relation != DIRTY_RECT_NONE) {
+				return i;
+			}
+		}
+		return -1;
+	}
+	DirtyRegion_NextMark(region);
+	for (y = range.top; y <= range.bottom; ++y) {
+		for (x = range.left; x <= range.right; ++x) {
+			i = DirtyRegion_TestBucket(
+			    region, rect, DirtyRegion_GetBucket(region, x, y),
+			    relation);
+			if (i >= 0) {
+				return i;
+			}
+		}
+	}
+	return DirtyRegion_TestBucket(region, rect, &region->large_rects,
+				      relation);
+}
+
+static unsigned DirtyRegion_FindCheapest(LCUI_DirtyRegion region,
+					 const LCUI_Rect *rect)
+{
+	unsigned i, target = 0;
+	int64_t cost, min_cost = -1;
+
+	for (i = 0; i < (unsigned)region->length; ++i) {
+		cost = GetMergeCost(rect, &region->rects[i]);
+		if (min_cost < 0 || cost < min_cost) {
+			min_cost = cost;
+			target = i;
+		}
+	}
+	return target;
+}
+
+void DirtyRegion_Init(LCUI_DirtyRegion region)
+{
+	memset(region, 0, sizeof(LCUI_DirtyRegionRec));
+	region->rect_cost = LCUI_DIRTY_REGION_RECT_COST;
+	region->max_rects = LCUI_DIRTY_REGION_MAX_RECTS;
+}
+
+void DirtyRegion_Destroy(LCUI_DirtyRegion region)
+{
+	int i;
+
+	for (i = 0; i < LCUI_DIRTY_REGION_BUCKETS; ++i) {
+		Bucket_Destroy(&region->buckets[i]);
+	}
+	Bucket_Destroy(&region->large_rects);
+	free(region->rects);
+	free(region->marks);
+	region->rects = NULL;
+	region->marks = NULL;
+	region->length = 0;
+	region->size = 0;
+}
+
+void DirtyRegion_Clear(LCUI_DirtyRegion region)
+{
+	int i;
+
+	if (region->length < 1) {
+		return;
+	}
+	for (i = 0; i < LCUI_DIRTY_REGION_BUCKETS; ++i) {
+		region->buckets[i].length = 0;
+	}
+	region->large_rects.length = 0;
+	region->length = 0;
+}
+
+LCUI_BOOL DirtyRegion_Add(LCUI_DirtyRegion region, const LCUI_Rect *in_rect)
+{
+	int i;
+	LCUI_Rect rect = *in_rect;
+	LCUI_BOOL changed = FALSE;
+	DirtyRectRelation relation;
+
+	if (rect.width < 1 || rect.height < 1) {
+		return FALSE;
+	}
+	while (1) {
+		i = DirtyRegion_Find(region, &rect, &relation);
+		if (i < 0) {
+			if (region->length < region->max_rects ||
+			    region->length < 1) {
+				break;
+			}
+			i = DirtyRegion_FindCheapest(region, &rect);
+			relation = DIRTY_RECT_MERGEABLE;
+		}
+		if (relation == DIRTY_RECT_COVERED) {
+			return changed;
+		}
+		if (relation == DIRTY_RECT_MERGEABLE) {
+			LCUIRect_MergeRect(&rect, &rect, &region->rects[i]);
+		}
+		DirtyRegion_Remove(region, i);
+		changed = TRUE;
+	}
+	return DirtyRegion_Append(region, &rect) || changed;
+}
+
+void DirtyRegion_Concat(LCUI_DirtyRegion dst, LCUI_DirtyRegion src)
+{
+	size_t i;
+
+	for (i = 0; i < src->length; ++i) {
+		DirtyRegion_Add(dst, &src->rects[i]);
+	}
+	DirtyRegion_Clear(src);
+}
+
+size_t DirtyRegion_GetArea(LCUI_DirtyRegion region)
+{
+	size_t i, area = 0;
+
+	for (i = 0; i < region->length; ++i) {
+		area += (size_t)GetRectArea(&region->rects[i]);
+	}
+	return area;
+}
@@ -0,0 +1,203 @@
+/* taskring.c -- bounded lock-free task queue with inline data
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This is a bounded multi-producer queue in the style of Dmitry Vyukov's
+ * MPMC queue, with a single consumer. Each cell has a sequence number: a
+ * producer may fill the cell at position pos when its sequence is pos, and
+ * the consumer may take it when its sequence is pos + 1. Producers claim a
+ * position by a compare-and-swap on the tail and publish the cell by
+ * storing the next sequence after a memory fence. The consumer owns the
+ * head and frees a cell by moving its sequence one lap ahead.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/util/taskring.h>
+#include "../atomic.h"
+
+typedef struct LCUI_TaskCellRec_ {
+	volatile unsigned long sequence;
+	LCUI_TaskFunc func;
+	int64_t time;
+	union {
+		char bytes[LCUI_TASK_RING_DATA_SIZE];
+		int64_t align_int;
+		double align_double;
+		void *align_pointer;
+	} data;
+} LCUI_TaskCellRec, *LCUI_TaskCell;
+
+typedef struct LCUI_TaskRingRec_ {
+	LCUI_TaskCellRec *cells;
+	unsigned long mask;
+
+	/** next position to push, shared by producers */
+	volatile unsigned long tail;
+
+	/** next position to run, only used by the consumer */
+	unsigned long head;
+
+	LCUI_LatencyHistogramRec latency;
+} LCUI_TaskRingRec;
+
+LCUI_TaskRing TaskRing_New(size_t capacity)
+{
+	unsigned long i, size = 2;
+	LCUI_TaskRing ring;
+
+	while (size < capacity) {
+		size *= 2;
+	}
+	ring = NEW(LCUI_TaskRingRec, 1);
+	if (!ring) {
+		return NULL;
+	}
+	ring->cells = NEW(LCUI_TaskCellRec, size);
+	if (!ring->cells) {
+		free(ring);
+		return NULL;
+	}
+	for (i = 0; i < size; ++i) {
+		ring->cells[i].sequence = i;
+	}
+	ring->mask = size - 1;
+	return ring;
+}
+
+void TaskRing_Destroy(LCUI_TaskRing ring)
+{
+	free(ring->cells);
+	free(ring);
+}
+
+int TaskRing_Push(LCUI_TaskRing ring, LCUI_TaskFunc func, const void *data,
+		  size_t size)
+{
+	long diff;
+	unsigned long pos;
+	LCUI_TaskCell cell;
+
+	if (size > LCUI_TASK_RING_DATA_SIZE) {
+		return -EINVAL;
+	}
+	pos = ring->tail;
+	while (1) {
+		cell = &ring->cells[pos & ring->mask];
+		MemoryFence();
+		diff = (long)(cell->sequence - pos);
+		if (diff == 0) {
+			if (AtomicCompareExchange(&ring->tail, pos, pos + 1)) {
+				break;
+			}
+		} else if (diff < 0) {
+			return -EAGAIN;
+		}
+		pos = ring->tail;
+	}
+	cell->func = func;
+	cell->time = LCUI_GetTimeUs();
+	if (size > 0) {
+		memcpy(cell->data.bytes, data, size);
+	}
+	MemoryFence();
+	cell->sequence = pos + 1;
+	return 0;
+}
+
+size_t TaskRing_Run(LCUI_TaskRing ring, size_t max_tasks)
+{
+	size_t count;
+	LCUI_TaskCell cell;
+	LCUI_TaskCellRec task;
+
+	for (count = 0; count < max_tasks; ++count) {
+		cell = &ring->cells[ring->head & ring->mask];
+		if (cell->sequence != ring->head + 1) {
+			break;
+		}
+		MemoryFence();
+		task = *cell;
+		MemoryFence();
+		/* free the cell before running, the task may push again */
+		cell->sequence = ring->head + ring->mask + 1;
+		ring->head += 1;
+		LatencyHistogram_Add(&ring->latency,
+				     LCUI_GetTimeUs() - task.time);
+		task.func(task.data.bytes, NULL);
+	}
+	return count;
+}
+
+void TaskRing_GetLatency(LCUI_TaskRing ring, LCUI_LatencyHistogram hist)
+{
+	*hist = ring->latency;
+}
+
+void TaskRing_ResetLatency(LCUI_TaskRing ring)
+{
+	memset(&ring->latency, 0, sizeof(ring->latency));
+}
+
+void LatencyHistogram_Add(LCUI_LatencyHistogram hist, int64_t latency)
+{
+	int i = 0;
+
+	latency = max(latency, 0);
+	while (i < LCUI_LATENCY_BUCKETS - 1 && ((int64_t)1 << i) <= latency) {
+		++i;
+	}
+	hist->buckets[i] += 1;
+	hist->count += 1;
+	hist->total += latency;
+	hist->max = max(hist->max, latency);
+}
+
+int64_t LatencyHistogram_GetPercentile(LCUI_LatencyHistogram hist,
+				       double percentile)
+{
+	int i;
+	size_t count = 0;
+	size_t target = (size_t)(hist->count * percentile / 100.0 + 0.5);
+
+	if (hist->count < 1) {
+		return 0;
+	}
+	target = max(1, min(target, hist->count));
+	for (i = 0; i < LCUI_LATENCY_BUCKETS - 1; ++i) {
+		count += hist->buckets[i];
+		if (count >= target) {
+			return min((int64_t)1 << i, hist->max);
+		}
+	}
+	return hist->max;
+}
@@ -64,6 +64,21 @@ int64_t LCUI_GetTime(void)
 	return time / 1000 - 11644473600000;
 }
 
+int64_t LCUI_GetTimeUs(void)
+{
+	int64_t time;
+	LARGE_INTEGER hires_now;
+	FILETIME *ft = (FILETIME*)&time;
+	if (hires_timer_available) {
+		QueryPerformanceCounter(&hires_now);
+		time = hires_now.QuadPart / hires_ticks_per_second * 1000000;
+		return time + hires_now.QuadPart % hires_ticks_per_second *
+			      1000000 / hires_ticks_per_second;
+	}
+	GetSystemTimeAsFileTime(ft);
+	return time / 10 - 11644473600000000;
+}
+
 #elif defined LCUI_BUILD_IN_LINUX
 #include <unistd.h>
 #include <sys/time.h>
@@ -84,6 +99,14 @@ int64_t LCUI_GetTime(void)
 	return t;
 }
 
+int64_t LCUI_GetTimeUs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 #endif
 
 int64_t LCUI_GetTimeDelta(int64_t start)
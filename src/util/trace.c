@@ -0,0 +1,402 @@
+/* trace.c -- frame timeline tracing
+ *
+ * Copyright (c) 2020, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of LCUI nor the names of its contributors may be used
+ *     to endorse or promote products derived from this software without
+ *     specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Each thread records spans into its own ring buffer, so recording takes no
+ * lock. The owner thread writes a span and then increases the count, with
+ * a memory fence between them. A dump reads the count, copies the buffer
+ * and reads the count again, also with fences, and drops the spans which
+ * may have been overwritten while copying.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/thread.h>
+#include <LCUI/util/trace.h>
+#include "../atomic.h"
+
+#define TRACE_STACK_SIZE 64
+#define TRACE_THREAD_NAME_LEN 32
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+typedef struct LCUI_TraceBufferRec_ {
+	int id;
+	char name[TRACE_THREAD_NAME_LEN];
+
+	/* total number of spans written by the owner thread */
+	volatile size_t count;
+
+	/* spans before it are cleared */
+	size_t start;
+	LCUI_TraceSpanRec spans[LCUI_TRACE_BUFFER_SIZE];
+
+	/* spans which have begun but not ended */
+	size_t depth;
+	LCUI_TraceSpanRec stack[TRACE_STACK_SIZE];
+	LinkedListNode node;
+} LCUI_TraceBufferRec, *LCUI_TraceBuffer;
+
+/* spans copied from a trace buffer, which can be written without the lock */
+typedef struct LCUI_TraceSnapshotRec_ {
+	int id;
+	char name[TRACE_THREAD_NAME_LEN];
+	size_t count;
+	LCUI_TraceSpanRec *spans;
+} LCUI_TraceSnapshotRec, *LCUI_TraceSnapshot;
+
+static struct LCUI_TraceModule {
+	LCUI_BOOL active;
+	volatile LCUI_BOOL enabled;
+	LCUI_Mutex mutex;
+
+	/* all trace buffers, one for each thread */
+	LinkedList buffers;
+
+	/* it is increased when the module is freed, so that the threads
+	 * can find that their buffers are no longer valid */
+	unsigned generation;
+} self;
+
+static THREAD_LOCAL LCUI_TraceBuffer trace_buffer;
+static THREAD_LOCAL unsigned trace_buffer_generation;
+
+static LCUI_TraceBuffer LCUITrace_GetBuffer(void)
+{
+	LCUI_TraceBuffer buffer;
+
+	if (trace_buffer && trace_buffer_generation == self.generation) {
+		return trace_buffer;
+	}
+	buffer = NEW(LCUI_TraceBufferRec, 1);
+	if (!buffer) {
+		return NULL;
+	}
+	buffer->node.data = buffer;
+	LCUIMutex_Lock(&self.mutex);
+	buffer->id = (int)self.buffers.length + 1;
+	snprintf(buffer->name, TRACE_THREAD_NAME_LEN, "thread %d", buffer->id);
+	LinkedList_AppendNode(&self.buffers, &buffer->node);
+	LCUIMutex_Unlock(&self.mutex);
+	trace_buffer = buffer;
+	trace_buffer_generation = self.generation;
+	return buffer;
+}
+
+void LCUITrace_Enable(LCUI_BOOL enable)
+{
+	self.enabled = self.active && enable;
+}
+
+LCUI_BOOL LCUITrace_IsEnabled(void)
+{
+	return self.enabled;
+}
+
+void LCUITrace_SetThreadName(const char *name)
+{
+	LCUI_TraceBuffer buffer;
+
+	if (!self.active) {
+		return;
+	}
+	buffer = LCUITrace_GetBuffer();
+	if (buffer) {
+		LCUIMutex_Lock(&self.mutex);
+		strncpy(buffer->name, name, TRACE_THREAD_NAME_LEN - 1);
+		LCUIMutex_Unlock(&self.mutex);
+	}
+}
+
+void LCUITrace_Begin(const char *category, const char *name,
+		     const char *detail)
+{
+	LCUI_TraceSpan span;
+	LCUI_TraceBuffer buffer;
+
+	if (!self.enabled) {
+		return;
+	}
+	buffer = LCUITrace_GetBuffer();
+	if (!buffer) {
+		return;
+	}
+	/* spans deeper than the stack are counted but not recorded */
+	if (buffer->depth++ >= TRACE_STACK_SIZE) {
+		return;
+	}
+	span = &buffer->stack[buffer->depth - 1];
+	span->category = category;
+	span->name = name;
+	if (detail) {
+		strncpy(span->detail, detail, LCUI_TRACE_DETAIL_LEN - 1);
+		span->detail[LCUI_TRACE_DETAIL_LEN - 1] = 0;
+	} else {
+		span->detail[0] = 0;
+	}
+	span->begin = LCUI_GetTimeUs();
+}
+
+void LCUITrace_End(void)
+{
+	LCUI_TraceSpan span;
+	LCUI_TraceBuffer buffer;
+
+	if (!self.enabled) {
+		/* drop unfinished spans, they can not be ended correctly
+		 * after tracing is enabled again */
+		if (trace_buffer && trace_buffer_generation == self.generation) {
+			trace_buffer->depth = 0;
+		}
+		return;
+	}
+	buffer = LCUITrace_GetBuffer();
+	if (!buffer || buffer->depth < 1) {
+		return;
+	}
+	if (--buffer->depth >= TRACE_STACK_SIZE) {
+		return;
+	}
+	span = &buffer->spans[buffer->count % LCUI_TRACE_BUFFER_SIZE];
+	*span = buffer->stack[buffer->depth];
+	span->duration = LCUI_GetTimeUs() - span->begin;
+	/* the span must be visible before it is counted */
+	MemoryFence();
+	buffer->count += 1;
+}
+
+static void LCUITrace_WriteString(FILE *fp, const char *str)
+{
+	fputc('"', fp);
+	for (; *str; ++str) {
+		if (*str == '"' || *str == '\\') {
+			fputc('\\', fp);
+			fputc(*str, fp);
+		} else if ((unsigned char)*str < 0x20) {
+			fprintf(fp, "\\u%04x", *str);
+		} else {
+			fputc(*str, fp);
+		}
+	}
+	fputc('"', fp);
+}
+
+/**
+ * Copy the spans which are still valid after copying
+ * @returns the number of copied spans
+ */
+static size_t TraceBuffer_Copy(LCUI_TraceBuffer buffer,
+			       LCUI_TraceSpanRec *spans)
+{
+	size_t i, n, start, end, count;
+	size_t writing = 1;
+
+	/* the owner thread may be writing the span after the end, which
+	 * overwrites one more, unless it is the current thread */
+	if (buffer == trace_buffer &&
+	    trace_buffer_generation == self.generation) {
+		writing = 0;
+	}
+
+	count = buffer->count;
+	/* do not read the spans before the count */
+	MemoryFence();
+	start = count > LCUI_TRACE_BUFFER_SIZE ? count - LCUI_TRACE_BUFFER_SIZE
+					       : 0;
+	start = max(start, buffer->start);
+	for (i = start; i < count; ++i) {
+		spans[i - start] = buffer->spans[i % LCUI_TRACE_BUFFER_SIZE];
+	}
+	MemoryFence();
+	end = buffer->count;
+	n = count - start;
+	/* the owner thread may have overwritten the oldest spans */
+	if (end + writing - start > LCUI_TRACE_BUFFER_SIZE) {
+		i = end + writing - start - LCUI_TRACE_BUFFER_SIZE;
+		if (i >= n) {
+			return 0;
+		}
+		memmove(spans, spans + i, sizeof(LCUI_TraceSpanRec) * (n - i));
+		n -= i;
+	}
+	return n;
+}
+
+/**
+ * Copy the spans of all threads, so that the file can be written after
+ * unlocking and the other threads are not blocked by the file writing
+ * @returns the number of snapshots, or -1 if there is not enough memory
+ */
+static int LCUITrace_TakeSnapshots(LCUI_TraceSnapshot *out)
+{
+	int i = 0;
+	size_t n;
+	LCUI_TraceSpanRec *spans;
+	LCUI_TraceSnapshot snapshots;
+	LCUI_TraceBuffer buffer;
+	LinkedListNode *node;
+
+	spans = malloc(sizeof(LCUI_TraceSpanRec) * LCUI_TRACE_BUFFER_SIZE);
+	if (!spans) {
+		return -1;
+	}
+	LCUIMutex_Lock(&self.mutex);
+	snapshots = NEW(LCUI_TraceSnapshotRec, self.buffers.length + 1);
+	if (!snapshots) {
+		LCUIMutex_Unlock(&self.mutex);
+		free(spans);
+		return -1;
+	}
+	for (LinkedList_Each(node, &self.buffers)) {
+		buffer = node->data;
+		n = TraceBuffer_Copy(buffer, spans);
+		snapshots[i].id = buffer->id;
+		strcpy(snapshots[i].name, buffer->name);
+		if (n > 0) {
+			snapshots[i].spans = malloc(sizeof(LCUI_TraceSpanRec) * n);
+			if (!snapshots[i].spans) {
+				n = 0;
+			} else {
+				memcpy(snapshots[i].spans, spans,
+				       sizeof(LCUI_TraceSpanRec) * n);
+			}
+		}
+		snapshots[i].count = n;
+		++i;
+	}
+	LCUIMutex_Unlock(&self.mutex);
+	free(spans);
+	*out = snapshots;
+	return i;
+}
+
+int LCUITrace_Dump(FILE *fp)
+{
+	int count = 0;
+	int t, n_snapshots;
+	size_t i;
+	LCUI_TraceSpan span;
+	LCUI_TraceSnapshot snapshot, snapshots;
+
+	if (!self.active) {
+		return -1;
+	}
+	n_snapshots = LCUITrace_TakeSnapshots(&snapshots);
+	if (n_snapshots < 0) {
+		return -1;
+	}
+	fputs("{\"traceEvents\":[\n", fp);
+	for (t = 0; t < n_snapshots; ++t) {
+		snapshot = &snapshots[t];
+		fprintf(fp,
+			"%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+			"\"tid\":%d,\"args\":{\"name\":",
+			t == 0 ? "" : ",\n", snapshot->id);
+		LCUITrace_WriteString(fp, snapshot->name);
+		fputs("}}", fp);
+		for (i = 0; i < snapshot->count; ++i) {
+			span = &snapshot->spans[i];
+			fputs(",\n{\"name\":", fp);
+			LCUITrace_WriteString(fp, span->name);
+			fputs(",\"cat\":", fp);
+			LCUITrace_WriteString(fp, span->category);
+			fprintf(fp,
+				",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%lld,\"dur\":%lld",
+				snapshot->id, (long long)span->begin,
+				(long long)span->duration);
+			if (span->detail[0]) {
+				fputs(",\"args\":{\"detail\":", fp);
+				LCUITrace_WriteString(fp, span->detail);
+				fputc('}', fp);
+			}
+			fputc('}', fp);
+		}
+		count += (int)snapshot->count;
+		free(snapshot->spans);
+	}
+	fputs("\n]}\n", fp);
+	free(snapshots);
+	return count;
+}
+
+int LCUITrace_DumpFile(const char *path)
+{
+	int count;
+	FILE *fp;
+
+	fp = fopen(path, "w");
+	if (!fp) {
+		return -1;
+	}
+	count = LCUITrace_Dump(fp);
+	fclose(fp);
+	return count;
+}
+
+void LCUITrace_Clear(void)
+{
+	LinkedListNode *node;
+	LCUI_TraceBuffer buffer;
+
+	if (!self.active) {
+		return;
+	}
+	LCUIMutex_Lock(&self.mutex);
+	for (LinkedList_Each(node, &self.buffers)) {
+		buffer = node->data;
+		buffer->start = buffer->count;
+	}
+	LCUIMutex_Unlock(&self.mutex);
+}
+
+void LCUI_InitTrace(void)
+{
+	LCUIMutex_Init(&self.mutex);
+	LinkedList_Init(&self.buffers);
+	self.enabled = FALSE;
+	self.active = TRUE;
+}
+
+void LCUI_FreeTrace(void)
+{
+	self.enabled = FALSE;
+	self.active = FALSE;
+	self.generation += 1;
+	LinkedList_ClearData(&self.buffers, free);
+	LCUIMutex_Destroy(&self.mutex);
+}
@@ -30,14 +30,15 @@
 #define LCUI_WORKER_C
 
 #include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <LCUI_Build.h>
-#include <LCUI/types.h>
-#include <LCUI/util/task.h>
-#include <LCUI/util/logger.h>
-#include <LCUI/util/linkedlist.h>
+#include <LCUI/LCUI.h>
 #include <LCUI/thread.h>
 #include <LCUI/worker.h>
+#include "atomic.h"
+
+#define TASK_PRIORITY_NUM (LCUI_TASK_PRIORITY_HIGH + 1)
 
 typedef struct LCUI_WorkerRec_ {
 	LCUI_BOOL active;		/**< 是否处于活动状态 */
@@ -47,6 +48,82 @@ typedef struct LCUI_WorkerRec_ {
 	LCUI_Thread thread;		/**< 所在的线程 */
 } LCUI_WorkerRec;
 
+/** 线程池中的任务 */
+typedef struct LCUI_PoolTaskRec_ {
+	LCUI_TaskRec task;
+	LCUI_TaskRec callback;		/**< 任务完成后在主线程中执行的任务 */
+	LCUI_BOOL has_callback;
+} LCUI_PoolTaskRec, *LCUI_PoolTask;
+
+/** 任务队列，用环形缓冲区存储任务，需要加锁访问 */
+typedef struct LCUI_TaskDequeRec_ {
+	LCUI_PoolTaskRec *tasks;
+	size_t head;
+	size_t length;
+	size_t capacity;
+} LCUI_TaskDequeRec, *LCUI_TaskDeque;
+
+/**
+ * 工作窃取队列的缓冲区
+ * 扩容后旧的缓冲区会保留到线程池销毁时才释放，因为窃取任务的线程可能还在读它
+ */
+typedef struct LCUI_TaskArrayRec_ {
+	unsigned long mask;
+	struct LCUI_TaskArrayRec_ *prev;
+	LCUI_PoolTaskRec tasks[1];
+} LCUI_TaskArrayRec, *LCUI_TaskArray;
+
+/**
+ * 工作窃取队列 (Chase-Lev deque)
+ * 只有所属的线程会在底部添加和取出任务，其它线程通过比较并交换顶部下标来窃
+ * 取任务，都不需要加锁
+ */
+typedef struct LCUI_WorkDequeRec_ {
+	volatile unsigned long top;
+	volatile unsigned long bottom;
+	LCUI_TaskArray volatile array;
+} LCUI_WorkDequeRec, *LCUI_WorkDeque;
+
+typedef struct LCUI_InboxNodeRec_ {
+	struct LCUI_InboxNodeRec_ *volatile next;
+	LCUI_PoolTaskRec task;
+} LCUI_InboxNodeRec, *LCUI_InboxNode;
+
+/**
+ * 收件队列，存放不在线程池中的线程添加的任务
+ * 添加任务时只需交换头部指针，不需要加锁；取出任务的线程需要持有互斥锁，
+ * 所以同一时刻只有一个线程在取任务，空闲的线程可以尝试加锁来窃取任务
+ */
+typedef struct LCUI_TaskInboxRec_ {
+	LCUI_InboxNode volatile head;	/**< 最后添加的任务 */
+	LCUI_InboxNode tail;		/**< 下一个取出的任务 */
+	LCUI_InboxNodeRec stub;		/**< 队列为空时的占位节点 */
+	LCUI_Mutex mutex;
+} LCUI_TaskInboxRec, *LCUI_TaskInbox;
+
+typedef struct LCUI_PoolWorkerRec_ {
+	int index;			/**< 在线程池中的编号 */
+	LCUI_BOOL sleeping;		/**< 是否在等待新任务 */
+	volatile long pinned_count;	/**< 还未取出的专属任务数量 */
+	LCUI_Mutex mutex;		/**< 专属任务队列的互斥锁 */
+	LCUI_Cond cond;			/**< 条件变量，用于唤醒该线程 */
+	LCUI_TaskDequeRec pinned;	/**< 专属任务队列，不会被其它线程窃取 */
+	LCUI_WorkDequeRec tasks[TASK_PRIORITY_NUM];	/**< 该线程添加的任务 */
+	LCUI_TaskInboxRec inbox[TASK_PRIORITY_NUM];	/**< 其它线程添加的任务 */
+	LCUI_Thread thread;
+	struct LCUI_WorkerPoolRec_ *pool;
+} LCUI_PoolWorkerRec, *LCUI_PoolWorker;
+
+typedef struct LCUI_WorkerPoolRec_ {
+	volatile LCUI_BOOL active;
+	int n_workers;
+	volatile long next;		/**< 用于轮流选择接收任务的线程 */
+	volatile long pending;		/**< 还未取出的普通任务数量 */
+	volatile long sleeping_count;	/**< 准备等待或正在等待的线程数量 */
+	LCUI_Mutex mutex;		/**< 互斥锁，保护线程的等待状态 */
+	LCUI_PoolWorkerRec *workers;
+} LCUI_WorkerPoolRec;
+
 LCUI_Worker LCUIWorker_New(void)
 {
 	LCUI_Worker worker = NEW(LCUI_WorkerRec, 1);
@@ -166,3 +243,530 @@ void LCUIWorker_Destroy(LCUI_Worker worker)
 	}
 	LCUIWorker_ExecDestroy(worker);
 }
+
+static int TaskDeque_Push(LCUI_TaskDeque deque, LCUI_PoolTask task)
+{
+	size_t i, capacity;
+	LCUI_PoolTaskRec *tasks;
+
+	if (deque->length >= deque->capacity) {
+		capacity = deque->capacity > 0 ? deque->capacity * 2 : 8;
+		tasks = malloc(sizeof(LCUI_PoolTaskRec) * capacity);
+		if (!tasks) {
+			return -ENOMEM;
+		}
+		for (i = 0; i < deque->length; ++i) {
+			tasks[i] = deque->tasks[(deque->head + i) %
+						deque->capacity];
+		}
+		free(deque->tasks);
+		deque->tasks = tasks;
+		deque->head = 0;
+		deque->capacity = capacity;
+	}
+	i = (deque->head + deque->length) % deque->capacity;
+	deque->tasks[i] = *task;
+	deque->length += 1;
+	return 0;
+}
+
+static LCUI_BOOL TaskDeque_PopFront(LCUI_TaskDeque deque, LCUI_PoolTask task)
+{
+	if (deque->length < 1) {
+		return FALSE;
+	}
+	*task = deque->tasks[deque->head];
+	deque->head = (deque->head + 1) % deque->capacity;
+	deque->length -= 1;
+	return TRUE;
+}
+
+static void LCUIPoolTask_Destroy(LCUI_PoolTask task)
+{
+	LCUITask_Destroy(&task->task);
+	if (task->has_callback) {
+		LCUITask_Destroy(&task->callback);
+	}
+}
+
+static void TaskDeque_Destroy(LCUI_TaskDeque deque)
+{
+	LCUI_PoolTaskRec task;
+
+	while (TaskDeque_PopFront(deque, &task)) {
+		LCUIPoolTask_Destroy(&task);
+	}
+	free(deque->tasks);
+	deque->tasks = NULL;
+	deque->capacity = 0;
+}
+
+static LCUI_TaskArray TaskArray_New(unsigned long capacity)
+{
+	LCUI_TaskArray array;
+
+	array = malloc(sizeof(LCUI_TaskArrayRec) +
+		       sizeof(LCUI_PoolTaskRec) * (capacity - 1));
+	if (!array) {
+		return NULL;
+	}
+	array->mask = capacity - 1;
+	array->prev = NULL;
+	return array;
+}
+
+/** 在底部添加任务，只能在队列所属的线程中调用 */
+static int WorkDeque_Push(LCUI_WorkDeque deque, LCUI_PoolTask task)
+{
+	unsigned long i;
+	unsigned long b = deque->bottom;
+	unsigned long t = deque->top;
+	LCUI_TaskArray array = deque->array;
+	LCUI_TaskArray new_array;
+
+	if (!array || b - t > array->mask) {
+		new_array = TaskArray_New(array ? (array->mask + 1) * 2 : 8);
+		if (!new_array) {
+			return -ENOMEM;
+		}
+		for (i = t; array && i != b; ++i) {
+			new_array->tasks[i & new_array->mask] =
+			    array->tasks[i & array->mask];
+		}
+		new_array->prev = array;
+		array = new_array;
+		deque->array = array;
+	}
+	array->tasks[b & array->mask] = *task;
+	/* 任务和缓冲区要在底部下标更新之前对窃取任务的线程可见 */
+	MemoryFence();
+	deque->bottom = b + 1;
+	return 0;
+}
+
+/** 从底部取出任务，只能在队列所属的线程中调用 */
+static LCUI_BOOL WorkDeque_Pop(LCUI_WorkDeque deque, LCUI_PoolTask task)
+{
+	long size;
+	unsigned long b, t;
+	LCUI_BOOL found;
+	LCUI_TaskArray array = deque->array;
+
+	if (!array) {
+		return FALSE;
+	}
+	b = deque->bottom - 1;
+	deque->bottom = b;
+	/* 先更新底部再读取顶部，窃取任务的线程则相反，这样两边不会取到同一
+	 * 个任务 */
+	MemoryFence();
+	t = deque->top;
+	size = (long)(b - t);
+	if (size < 0) {
+		deque->bottom = b + 1;
+		return FALSE;
+	}
+	*task = array->tasks[b & array->mask];
+	if (size > 0) {
+		return TRUE;
+	}
+	/* 只剩最后一个任务，需要和窃取任务的线程竞争 */
+	found = AtomicCompareExchange(&deque->top, t, t + 1);
+	deque->bottom = b + 1;
+	return found;
+}
+
+/** 从顶部窃取任务，可以在任意线程中调用 */
+static LCUI_BOOL WorkDeque_Steal(LCUI_WorkDeque deque, LCUI_PoolTask task)
+{
+	unsigned long b, t;
+	LCUI_TaskArray array;
+
+	t = deque->top;
+	MemoryFence();
+	b = deque->bottom;
+	if ((long)(b - t) <= 0) {
+		return FALSE;
+	}
+	MemoryFence();
+	array = deque->array;
+	*task = array->tasks[t & array->mask];
+	/* 如果顶部下标已经变了，说明该任务已被取走，读到的数据作废 */
+	return AtomicCompareExchange(&deque->top, t, t + 1);
+}
+
+static void WorkDeque_Destroy(LCUI_WorkDeque deque)
+{
+	LCUI_PoolTaskRec task;
+	LCUI_TaskArray array;
+
+	while (WorkDeque_Pop(deque, &task)) {
+		LCUIPoolTask_Destroy(&task);
+	}
+	while (deque->array) {
+		array = deque->array;
+		deque->array = array->prev;
+		free(array);
+	}
+}
+
+static void TaskInbox_Init(LCUI_TaskInbox inbox)
+{
+	inbox->stub.next = NULL;
+	inbox->head = &inbox->stub;
+	inbox->tail = &inbox->stub;
+	LCUIMutex_Init(&inbox->mutex);
+}
+
+static void TaskInbox_PushNode(LCUI_TaskInbox inbox, LCUI_InboxNode node)
+{
+	LCUI_InboxNode prev;
+
+	node->next = NULL;
+	prev = (LCUI_InboxNode)AtomicExchangePointer(&inbox->head, node);
+	/* 在此之前取任务的线程会认为队列为空，稍后重试即可 */
+	prev->next = node;
+}
+
+/** 在尾部添加任务，可以在任意线程中调用 */
+static int TaskInbox_Push(LCUI_TaskInbox inbox, LCUI_PoolTask task)
+{
+	LCUI_InboxNode node;
+
+	node = malloc(sizeof(LCUI_InboxNodeRec));
+	if (!node) {
+		return -ENOMEM;
+	}
+	node->task = *task;
+	TaskInbox_PushNode(inbox, node);
+	return 0;
+}
+
+/** 从头部取出任务，调用前需要持有队列的互斥锁 */
+static LCUI_BOOL TaskInbox_Pop(LCUI_TaskInbox inbox, LCUI_PoolTask task)
+{
+	LCUI_InboxNode tail = inbox->tail;
+	LCUI_InboxNode next = tail->next;
+
+	if (tail == &inbox->stub) {
+		if (!next) {
+			return FALSE;
+		}
+		inbox->tail = next;
+		tail = next;
+		next = next->next;
+	}
+	if (!next) {
+		/* 最后一个任务，需要先放回占位节点才能把它取出 */
+		if (tail != inbox->head) {
+			return FALSE;
+		}
+		TaskInbox_PushNode(inbox, &inbox->stub);
+		next = tail->next;
+		if (!next) {
+			return FALSE;
+		}
+	}
+	/* 读取任务数据之前要先看到添加任务的线程写入的数据 */
+	MemoryFence();
+	inbox->tail = next;
+	*task = tail->task;
+	free(tail);
+	return TRUE;
+}
+
+static void TaskInbox_Destroy(LCUI_TaskInbox inbox)
+{
+	LCUI_PoolTaskRec task;
+
+	while (TaskInbox_Pop(inbox, &task)) {
+		LCUIPoolTask_Destroy(&task);
+	}
+	LCUIMutex_Destroy(&inbox->mutex);
+}
+
+static void LCUIPoolTask_Run(LCUI_PoolTask task)
+{
+	LCUITask_Run(&task->task);
+	LCUITask_Destroy(&task->task);
+	if (task->has_callback && !LCUI_PostTask(&task->callback)) {
+		LCUITask_Destroy(&task->callback);
+	}
+}
+
+/** 尝试从其它线程的收件队列中窃取任务，队列正被其它线程读取时跳过 */
+static LCUI_BOOL TaskInbox_Steal(LCUI_TaskInbox inbox, LCUI_PoolTask task)
+{
+	LCUI_BOOL found;
+
+	if (inbox->tail == &inbox->stub && !inbox->stub.next) {
+		return FALSE;
+	}
+	if (LCUIMutex_TryLock(&inbox->mutex) != 0) {
+		return FALSE;
+	}
+	found = TaskInbox_Pop(inbox, task);
+	LCUIMutex_Unlock(&inbox->mutex);
+	return found;
+}
+
+/**
+ * 取出一个任务
+ * 按优先级从高到低查找，先从自己队列的底部取，然后是自己的收件队列，最后从
+ * 其它线程的队列中窃取，这样线程自己添加的任务大都留在该线程中执行
+ */
+static LCUI_BOOL LCUIWorkerPool_TakeTask(LCUI_WorkerPool pool,
+					 LCUI_PoolWorker worker,
+					 LCUI_PoolTask task)
+{
+	int i, p;
+	LCUI_BOOL found, pinned = FALSE;
+	LCUI_PoolWorker other;
+
+	for (p = TASK_PRIORITY_NUM - 1; p >= 0; --p) {
+		if (p == LCUI_TASK_PRIORITY_NORMAL && worker->pinned_count > 0) {
+			LCUIMutex_Lock(&worker->mutex);
+			pinned = TaskDeque_PopFront(&worker->pinned, task);
+			LCUIMutex_Unlock(&worker->mutex);
+		}
+		found = pinned || WorkDeque_Pop(&worker->tasks[p], task);
+		if (!found) {
+			LCUIMutex_Lock(&worker->inbox[p].mutex);
+			found = TaskInbox_Pop(&worker->inbox[p], task);
+			LCUIMutex_Unlock(&worker->inbox[p].mutex);
+		}
+		for (i = 1; !found && i < pool->n_workers; ++i) {
+			other = &pool->workers[(worker->index + i) %
+					       pool->n_workers];
+			found = WorkDeque_Steal(&other->tasks[p], task) ||
+				TaskInbox_Steal(&other->inbox[p], task);
+		}
+		if (!found) {
+			continue;
+		}
+		if (pinned) {
+			AtomicDecrement(&worker->pinned_count);
+		} else {
+			AtomicDecrement(&pool->pending);
+		}
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static void LCUIWorkerPool_Thread(void *arg)
+{
+	char name[32];
+	LCUI_PoolTaskRec task;
+	LCUI_PoolWorker worker = arg;
+	LCUI_WorkerPool pool = worker->pool;
+
+	snprintf(name, sizeof(name), "worker %d", worker->index);
+	LCUITrace_SetThreadName(name);
+	/* 等待线程池记录完所有线程的编号 */
+	LCUIMutex_Lock(&pool->mutex);
+	LCUIMutex_Unlock(&pool->mutex);
+	while (pool->active) {
+		if (LCUIWorkerPool_TakeTask(pool, worker, &task)) {
+			LCUIPoolTask_Run(&task);
+			continue;
+		}
+		LCUIMutex_Lock(&pool->mutex);
+		/* 先登记再检查任务数量，添加任务的线程则相反，这样至少有一
+		 * 边能看到另一边 */
+		AtomicIncrement(&pool->sleeping_count);
+		if (pool->active && pool->pending < 1 &&
+		    worker->pinned_count < 1) {
+			worker->sleeping = TRUE;
+			LCUICond_Wait(&worker->cond, &pool->mutex);
+			worker->sleeping = FALSE;
+		}
+		AtomicDecrement(&pool->sleeping_count);
+		LCUIMutex_Unlock(&pool->mutex);
+	}
+	LCUIThread_Exit(NULL);
+}
+
+/** 唤醒一个空闲的线程，优先唤醒接收任务的线程 */
+static void LCUIWorkerPool_Wakeup(LCUI_WorkerPool pool, LCUI_PoolWorker worker)
+{
+	int i;
+
+	for (i = 0; !worker->sleeping && i < pool->n_workers; ++i) {
+		worker = &pool->workers[i];
+	}
+	if (worker->sleeping) {
+		worker->sleeping = FALSE;
+		LCUICond_Signal(&worker->cond);
+	}
+}
+
+/**
+ * 获取当前线程在线程池中的编号，不是线程池中的线程则返回 -1
+ * 线程编号在创建线程池时就已记录好，读取时不需要加锁
+ */
+static int LCUIWorkerPool_GetCurrentWorker(LCUI_WorkerPool pool)
+{
+	int i;
+	LCUI_Thread tid = LCUIThread_SelfID();
+
+	for (i = 0; i < pool->n_workers; ++i) {
+		if (pool->workers[i].thread == tid) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+LCUI_WorkerPool LCUIWorkerPool_New(int n)
+{
+	int i, p;
+	LCUI_PoolWorker worker;
+	LCUI_WorkerPool pool = NEW(LCUI_WorkerPoolRec, 1);
+
+	if (!pool) {
+		return NULL;
+	}
+	if (n < 1) {
+		/* 至少要有两个线程，避免耗时的任务阻塞其它任务 */
+		n = max(LCUIThread_GetProcessorCount(), 2);
+	}
+	pool->workers = NEW(LCUI_PoolWorkerRec, n);
+	if (!pool->workers) {
+		free(pool);
+		return NULL;
+	}
+	pool->active = TRUE;
+	LCUIMutex_Init(&pool->mutex);
+	/* 线程编号在锁内记录，线程开始取任务前会等待解锁 */
+	LCUIMutex_Lock(&pool->mutex);
+	for (i = 0; i < n; ++i) {
+		worker = &pool->workers[i];
+		worker->index = i;
+		worker->pool = pool;
+		LCUIMutex_Init(&worker->mutex);
+		LCUICond_Init(&worker->cond);
+		for (p = 0; p < TASK_PRIORITY_NUM; ++p) {
+			TaskInbox_Init(&worker->inbox[p]);
+		}
+		if (LCUIThread_Create(&worker->thread, LCUIWorkerPool_Thread,
+				      worker) != 0) {
+			for (p = 0; p < TASK_PRIORITY_NUM; ++p) {
+				TaskInbox_Destroy(&worker->inbox[p]);
+			}
+			LCUIMutex_Destroy(&worker->mutex);
+			LCUICond_Destroy(&worker->cond);
+			break;
+		}
+	}
+	pool->n_workers = i;
+	LCUIMutex_Unlock(&pool->mutex);
+	if (pool->n_workers < 1) {
+		LCUIWorkerPool_Destroy(pool);
+		return NULL;
+	}
+	Logger_Debug("[worker] %d pool workers are running\n", pool->n_workers);
+	return pool;
+}
+
+int LCUIWorkerPool_PostTask(LCUI_WorkerPool pool, LCUI_Task task,
+			    LCUI_TaskPriority priority, LCUI_Task callback)
+{
+	int id, ret;
+	LCUI_PoolTaskRec item = { 0 };
+	LCUI_PoolWorker worker;
+
+	item.task = *task;
+	if (callback) {
+		item.callback = *callback;
+		item.has_callback = TRUE;
+	}
+	if (priority > LCUI_TASK_PRIORITY_HIGH) {
+		priority = LCUI_TASK_PRIORITY_HIGH;
+	}
+	/* 先计数再添加任务，否则任务可能在计数前就被其它线程取走了 */
+	AtomicIncrement(&pool->pending);
+	id = LCUIWorkerPool_GetCurrentWorker(pool);
+	if (id >= 0) {
+		worker = &pool->workers[id];
+		ret = WorkDeque_Push(&worker->tasks[priority], &item);
+	} else {
+		id = (int)((unsigned long)AtomicIncrement(&pool->next) %
+			   pool->n_workers);
+		worker = &pool->workers[id];
+		ret = TaskInbox_Push(&worker->inbox[priority], &item);
+	}
+	if (ret != 0) {
+		AtomicDecrement(&pool->pending);
+		LCUIPoolTask_Destroy(&item);
+		return ret;
+	}
+	/* 只有在有线程等待时才需要加锁唤醒它 */
+	if (pool->sleeping_count > 0) {
+		LCUIMutex_Lock(&pool->mutex);
+		LCUIWorkerPool_Wakeup(pool, worker);
+		LCUIMutex_Unlock(&pool->mutex);
+	}
+	return worker->index;
+}
+
+int LCUIWorkerPool_PostTaskTo(LCUI_WorkerPool pool, LCUI_Task task,
+			      int worker_id)
+{
+	int ret;
+	LCUI_PoolTaskRec item = { 0 };
+	LCUI_PoolWorker worker;
+
+	item.task = *task;
+	worker = &pool->workers[abs(worker_id) % pool->n_workers];
+	AtomicIncrement(&worker->pinned_count);
+	LCUIMutex_Lock(&worker->mutex);
+	ret = TaskDeque_Push(&worker->pinned, &item);
+	LCUIMutex_Unlock(&worker->mutex);
+	if (ret != 0) {
+		AtomicDecrement(&worker->pinned_count);
+		LCUIPoolTask_Destroy(&item);
+		return ret;
+	}
+	LCUIMutex_Lock(&pool->mutex);
+	if (worker->sleeping) {
+		worker->sleeping = FALSE;
+		LCUICond_Signal(&worker->cond);
+	}
+	LCUIMutex_Unlock(&pool->mutex);
+	return worker->index;
+}
+
+int LCUIWorkerPool_GetThreads(LCUI_WorkerPool pool)
+{
+	return pool->n_workers;
+}
+
+void LCUIWorkerPool_Destroy(LCUI_WorkerPool pool)
+{
+	int i, p;
+	LCUI_PoolWorker worker;
+
+	LCUIMutex_Lock(&pool->mutex);
+	pool->active = FALSE;
+	for (i = 0; i < pool->n_workers; ++i) {
+		LCUICond_Signal(&pool->workers[i].cond);
+	}
+	LCUIMutex_Unlock(&pool->mutex);
+	for (i = 0; i < pool->n_workers; ++i) {
+		LCUIThread_Join(pool->workers[i].thread, NULL);
+	}
+	for (i = 0; i < pool->n_workers; ++i) {
+		worker = &pool->workers[i];
+		TaskDeque_Destroy(&worker->pinned);
+		for (p = 0; p < TASK_PRIORITY_NUM; ++p) {
+			WorkDeque_Destroy(&worker->tasks[p]);
+			TaskInbox_Destroy(&worker->inbox[p]);
+		}
+		LCUIMutex_Destroy(&worker->mutex);
+		LCUICond_Destroy(&worker->cond);
+	}
+	LCUIMutex_Destroy(&pool->mutex);
+	free(pool->workers);
+	free(pool);
+}
@@ -15,14 +15,27 @@ int main(void)
 	describe("test linkedlist", test_linkedlist);
 	describe("test string", test_string);
 	describe("test strpool", test_strpool);
+	describe("test arena", test_arena);
 	describe("test settings", test_settings);
 	describe("test object", test_object);
 	describe("test thread", test_thread);
 	describe("test font load", test_font_load);
 	describe("test image reader", test_image_reader);
+	describe("test graph mix", test_graph_mix);
 	describe("test xml parser", test_xml_parser);
 	describe("test widget event", test_widget_event);
 	describe("test widget opacity", test_widget_opacity);
+	describe("test widget layer", test_widget_layer);
+	describe("test widget style", test_widget_style);
+	describe("test trace", test_trace);
+	describe("test dirty region", test_dirty_region);
+	describe("test glyph cache", test_glyph_cache);
+	describe("test textlayer", test_textlayer);
+	describe("test widget background", test_widget_background);
+	describe("test headless display", test_headless_display);
+	describe("test timer", test_timer);
+	describe("test worker pool", test_worker_pool);
+	describe("test task ring", test_task_ring);
 	describe("test textview resize", test_textview_resize);
 	describe("test textedit", test_textedit);
 	describe("test scrollbar", test_scrollbar);
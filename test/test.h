@@ -17,6 +17,19 @@ void test_textview_resize(void);
 void test_textedit(void);
 void test_scrollbar(void);
 void test_image_reader(void);
+void test_graph_mix(void);
+void test_widget_layer(void);
+void test_arena(void);
+void test_widget_style(void);
+void test_trace(void);
+void test_dirty_region(void);
+void test_glyph_cache(void);
+void test_textlayer(void);
+void test_widget_background(void);
+void test_headless_display(void);
+void test_timer(void);
+void test_worker_pool(void);
+void test_task_ring(void);
 
 void test_css_parser(void);
 void test_mainloop(void);
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/util/arena.h>
+#include "test.h"
+#include "libtest.h"
+
+static void test_arena_alloc(void)
+{
+	char *p1, *p2, *p3;
+	LCUI_ArenaRec arena;
+	LCUI_ArenaMarkRec mark;
+
+	Arena_Init(&arena, 256);
+	p1 = Arena_Alloc(&arena, 10);
+	it_b("check Arena_Alloc", p1 != NULL, TRUE);
+	it_b("check alignment", ((size_t)p1 & 15) == 0, TRUE);
+	Arena_GetMark(&arena, &mark);
+	p2 = Arena_Alloc(&arena, 100);
+	it_b("check bump allocation", p2 == p1 + 16, TRUE);
+	p3 = Arena_Alloc(&arena, 1000);
+	it_b("check large allocation", p3 != NULL, TRUE);
+	it_i("check alloc_count", (int)arena.alloc_count, 3);
+	it_i("check alloc_bytes", (int)arena.alloc_bytes, 16 + 112 + 1008);
+	it_i("check memory_usage", (int)arena.memory_usage, 256 + 1008);
+	Arena_Rewind(&arena, &mark);
+	it_b("check Arena_Rewind", Arena_Alloc(&arena, 100) == p2, TRUE);
+	Arena_Reset(&arena);
+	it_b("check Arena_Reset", Arena_Alloc(&arena, 10) == p1, TRUE);
+	it_i("check alloc_count after reset", (int)arena.alloc_count, 1);
+	Arena_Reset(&arena);
+	Arena_Reset(&arena);
+	it_i("check unused blocks are released", (int)arena.memory_usage,
+	     256);
+	Arena_Destroy(&arena);
+}
+
+static void test_frame_arena(void)
+{
+	LCUI_Graph graph;
+	LCUI_FrameArenaProfileRec profile;
+
+	it_b("check LCUIFrameArena_Get() before initialization",
+	     LCUIFrameArena_Get() == NULL, TRUE);
+	LCUI_InitFrameArena();
+	it_b("check LCUIFrameArena_Get()", LCUIFrameArena_Get() != NULL, TRUE);
+	Graph_Init(&graph);
+	graph.color_type = LCUI_COLOR_TYPE_ARGB;
+	it_i("check Graph_CreateScratch()",
+	     Graph_CreateScratch(&graph, 20, 10), 0);
+	it_b("check graph is scratch", graph.is_scratch, TRUE);
+	it_b("check graph is cleared",
+	     graph.argb[0].value == 0 && graph.argb[199].value == 0, TRUE);
+	Graph_Free(&graph);
+	it_b("check Graph_Free() detaches the graph",
+	     graph.bytes == NULL && !graph.is_scratch, TRUE);
+	LCUIFrameArena_Reset();
+	LCUIFrameArena_GetProfile(&profile);
+	it_i("check profile.alloc_count", (int)profile.alloc_count, 1);
+	it_i("check profile.alloc_bytes", (int)profile.alloc_bytes, 800);
+	LCUI_FreeFrameArena();
+}
+
+void test_arena(void)
+{
+	describe("test arena alloc", test_arena_alloc);
+	describe("test frame arena", test_frame_arena);
+}
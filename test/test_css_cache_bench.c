@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/gui/widget.h>
+#include <LCUI/gui/css_parser.h>
+#include <LCUI/settings.h>
+
+#define BENCH_GROUPS 100
+#define BENCH_ITEMS 100
+#define BENCH_RULES 2000
+#define BENCH_INJECTIONS 100
+
+static void build_widgets(void)
+{
+	int i, j;
+	char str[64];
+	LCUI_Widget group, item;
+	LCUI_Widget root = LCUIWidget_GetRoot();
+
+	for (i = 0; i < BENCH_GROUPS; ++i) {
+		group = LCUIWidget_New(NULL);
+		sprintf(str, "group group-%d", i);
+		Widget_AddClass(group, str);
+		for (j = 0; j < BENCH_ITEMS; ++j) {
+			item = LCUIWidget_New(NULL);
+			sprintf(str, "item item-%d",
+				(i * BENCH_ITEMS + j) % BENCH_RULES);
+			Widget_AddClass(item, str);
+			Widget_Append(group, item);
+		}
+		Widget_Append(root, group);
+	}
+}
+
+static char *create_css(void)
+{
+	int i;
+	char *css, *p;
+
+	p = css = malloc(BENCH_RULES * 128);
+	for (i = 0; i < BENCH_RULES; ++i) {
+		p += sprintf(p, ".item-%d { width: %dpx; height: 10px; }\n", i,
+			     i % 200);
+		if (i % 4 == 0) {
+			p += sprintf(p, ".group-%d .item-%d { margin: 2px; }\n",
+				     i % BENCH_GROUPS, i);
+		}
+	}
+	return css;
+}
+
+static int64_t restyle(void)
+{
+	int64_t t = LCUI_GetTime();
+
+	LCUIWidget_RefreshStyle();
+	LCUIWidget_Update();
+	return LCUI_GetTimeDelta(t);
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+	char rule[128];
+	char *css = create_css();
+	int64_t t, load_time, restyle_time;
+
+	LCUI_InitBase();
+	LCUI_ResetSettings();
+	build_widgets();
+	LCUIWidget_Update();
+	Logger_Info("%d widgets, %d rules\n", BENCH_GROUPS * BENCH_ITEMS,
+		    BENCH_RULES);
+
+	t = LCUI_GetTime();
+	LCUI_LoadCSSString(css, __FILE__);
+	load_time = LCUI_GetTimeDelta(t);
+	restyle_time = restyle();
+	Logger_Info("load stylesheet: %ldms, restyle: %ldms\n",
+		    (long)load_time, (long)restyle_time);
+
+	/* restyle again with a warm cache */
+	restyle_time = restyle();
+	Logger_Info("restyle with warm cache: %ldms\n", (long)restyle_time);
+
+	/* inject rules one by one, each followed by a restyle */
+	load_time = 0;
+	restyle_time = 0;
+	for (i = 0; i < BENCH_INJECTIONS; ++i) {
+		sprintf(rule, ".item-%d { height: 20px; }", i * 7 % BENCH_RULES);
+		t = LCUI_GetTime();
+		LCUI_LoadCSSString(rule, NULL);
+		load_time += LCUI_GetTimeDelta(t);
+		restyle_time += restyle();
+	}
+	Logger_Info("inject %d rules: %ldms, restyle: %ldms\n",
+		    BENCH_INJECTIONS, (long)load_time, (long)restyle_time);
+	free(css);
+	return 0;
+}
@@ -3,6 +3,7 @@
 #include <LCUI/LCUI.h>
 #include <LCUI/display.h>
 #include <LCUI/gui/builder.h>
+#include <LCUI/gui/css_parser.h>
 #include "test.h"
 #include "libtest.h"
 
@@ -111,6 +112,39 @@ static void test_parse_flex_0_0_100px(void)
 	it_i("<flex-basis>", (int)s[key_flex_basis].val_px, 100);
 }
 
+static void test_style_sheet_cache(void)
+{
+	LCUI_CachedStyleSheet ss1, ss2;
+	LCUI_Selector s1 = Selector("textview.cache-a");
+	LCUI_Selector s2 = Selector("textview.cache-b");
+
+	ss1 = LCUI_GetCachedStyleSheet(s1);
+	ss2 = LCUI_GetCachedStyleSheet(s2);
+	LCUI_LoadCSSString(".cache-a { width: 10px; }", NULL);
+	it_b("unmatched cache should be kept",
+	     LCUI_GetCachedStyleSheet(s2) == ss2, TRUE);
+	ss1 = LCUI_GetCachedStyleSheet(s1);
+	it_i("matched cache should be updated",
+	     (int)ss1->sheet[key_width].val_px, 10);
+	LCUI_LoadCSSString("textview:hover { width: 20px; }", NULL);
+	it_b("cache should be kept when status is not matched",
+	     LCUI_GetCachedStyleSheet(s1) == ss1, TRUE);
+	LCUI_LoadCSSString("* { height: 5px; }", NULL);
+	ss2 = LCUI_GetCachedStyleSheet(s2);
+	it_i("all caches should be updated by universal selector",
+	     (int)ss2->sheet[key_height].val_px, 5);
+	LCUI_BeginStyleSheetBatch();
+	LCUI_LoadCSSString(".cache-b { width: 30px; }", NULL);
+	it_b("cache should not be updated in batch",
+	     LCUI_GetCachedStyleSheet(s2) == ss2, TRUE);
+	LCUI_EndStyleSheetBatch();
+	ss2 = LCUI_GetCachedStyleSheet(s2);
+	it_i("cache should be updated after batch",
+	     (int)ss2->sheet[key_width].val_px, 30);
+	Selector_Delete(s1);
+	Selector_Delete(s2);
+}
+
 void test_css_parser(void)
 {
 	LCUI_Widget root, box, btn;
@@ -141,5 +175,6 @@ void test_css_parser(void)
 	describe("parse 'flex: 100px;'", test_parse_flex_100px);
 	describe("parse 'flex: 1 100px;'", test_parse_flex_1_100px);
 	describe("parse 'flex: 0 0 100px;'", test_parse_flex_0_0_100px);
+	describe("style sheet cache", test_style_sheet_cache);
 	LCUI_Destroy();
 }
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/util/dirtyregion.h>
+#include "test.h"
+#include "libtest.h"
+
+#define MAP_WIDTH 640
+#define MAP_HEIGHT 480
+
+static LCUI_BOOL add_rect(LCUI_DirtyRegion region, int x, int y, int width,
+			  int height)
+{
+	LCUI_Rect rect;
+
+	rect.x = x;
+	rect.y = y;
+	rect.width = width;
+	rect.height = height;
+	return DirtyRegion_Add(region, &rect);
+}
+
+static void fill_map(unsigned char *map, const LCUI_Rect *rect,
+		     unsigned char value)
+{
+	int x, y;
+	LCUI_Rect r = *rect;
+
+	LCUIRect_ValidateArea(&r, MAP_WIDTH, MAP_HEIGHT);
+	for (y = r.y; y < r.y + r.height; ++y) {
+		for (x = r.x; x < r.x + r.width; ++x) {
+			map[y * MAP_WIDTH + x] |= value;
+		}
+	}
+}
+
+/* Check whether every pixel of the added rects is covered by the region */
+static LCUI_BOOL check_coverage(size_t max_rects)
+{
+	int i;
+	size_t k;
+	LCUI_Rect rect;
+	LCUI_BOOL ok = TRUE;
+	LCUI_DirtyRegionRec region;
+	unsigned char *map = calloc(MAP_WIDTH * MAP_HEIGHT, 1);
+
+	srand(1);
+	DirtyRegion_Init(&region);
+	region.max_rects = max_rects;
+	for (i = 0; i < 500; ++i) {
+		rect.x = rand() % MAP_WIDTH - 20;
+		rect.y = rand() % MAP_HEIGHT - 20;
+		rect.width = rand() % 80 + 1;
+		rect.height = rand() % 60 + 1;
+		fill_map(map, &rect, 1);
+		DirtyRegion_Add(&region, &rect);
+		if (region.length > max_rects) {
+			ok = FALSE;
+		}
+	}
+	for (k = 0; k < region.length; ++k) {
+		fill_map(map, &region.rects[k], 2);
+	}
+	for (i = 0; i < MAP_WIDTH * MAP_HEIGHT; ++i) {
+		if (map[i] == 1) {
+			ok = FALSE;
+			break;
+		}
+	}
+	DirtyRegion_Destroy(&region);
+	free(map);
+	return ok;
+}
+
+static void test_dirty_region_add(void)
+{
+	LCUI_Rect expected;
+	LCUI_DirtyRegionRec region;
+
+	DirtyRegion_Init(&region);
+	it_b("adding an empty rect should be ignored",
+	     add_rect(&region, 10, 10, 0, 20), FALSE);
+	it_b("adding a rect should change the region",
+	     add_rect(&region, 10, 10, 100, 100), TRUE);
+	it_b("adding a covered rect should not change the region",
+	     add_rect(&region, 20, 20, 30, 30), FALSE);
+	it_i("covered rect should be dropped", (int)region.length, 1);
+
+	add_rect(&region, 0, 0, 200, 200);
+	expected = Rect(0, 0, 200, 200);
+	it_i("contained rect should be removed", (int)region.length, 1);
+	it_rect("region.rects[0]", &region.rects[0], &expected);
+
+	add_rect(&region, 200, 0, 20, 200);
+	expected = Rect(0, 0, 220, 200);
+	it_i("adjacent rect should be merged", (int)region.length, 1);
+	it_rect("region.rects[0]", &region.rects[0], &expected);
+
+	add_rect(&region, 600, 400, 20, 20);
+	add_rect(&region, -300, -300, 20, 20);
+	it_i("distant rects should not be merged", (int)region.length, 3);
+	it_i("area should be the sum of rects",
+	     (int)DirtyRegion_GetArea(&region), 220 * 200 + 400 * 2);
+
+	DirtyRegion_Clear(&region);
+	it_i("clear should remove all rects", (int)region.length, 0);
+	add_rect(&region, 0, 0, 10, 10);
+	add_rect(&region, 12, 0, 10, 10);
+	expected = Rect(0, 0, 22, 10);
+	it_i("rects should be merged after clearing", (int)region.length, 1);
+	it_rect("region.rects[0]", &region.rects[0], &expected);
+
+	region.rect_cost = 0;
+	add_rect(&region, 100, 0, 10, 10);
+	add_rect(&region, 100, 11, 10, 10);
+	it_i("rects should not be merged without cost", (int)region.length,
+	     3);
+	DirtyRegion_Destroy(&region);
+}
+
+static void test_dirty_region_concat(void)
+{
+	LCUI_Rect expected;
+	LCUI_DirtyRegionRec a, b;
+
+	DirtyRegion_Init(&a);
+	DirtyRegion_Init(&b);
+	add_rect(&a, 0, 0, 100, 100);
+	add_rect(&b, 50, 50, 20, 20);
+	add_rect(&b, 1000, 1000, 200, 100);
+	DirtyRegion_Concat(&a, &b);
+	expected = Rect(1000, 1000, 200, 100);
+	it_i("source should be cleared", (int)b.length, 0);
+	it_i("covered rects should be dropped", (int)a.length, 2);
+	it_rect("a.rects[1]", &a.rects[1], &expected);
+	DirtyRegion_Destroy(&a);
+	DirtyRegion_Destroy(&b);
+}
+
+static void test_dirty_region_coverage(void)
+{
+	it_b("region should cover all added rects",
+	     check_coverage(LCUI_DIRTY_REGION_MAX_RECTS), TRUE);
+	it_b("region with limited rects should cover all added rects",
+	     check_coverage(8), TRUE);
+}
+
+void test_dirty_region(void)
+{
+	describe("test dirty region add", test_dirty_region_add);
+	describe("test dirty region concat", test_dirty_region_concat);
+	describe("test dirty region coverage", test_dirty_region_coverage);
+}
@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/util/dirtyregion.h>
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_FRAMES 200
+#define BENCH_SPRITES 60
+
+typedef void (*add_func_t)(void *list, LCUI_Rect *rect);
+
+typedef struct bench_result_t {
+	int64_t time;
+	size_t rects;
+	size_t area;
+} bench_result_t;
+
+/* Invalidation patterns, each frame calls add() for its dirty rects */
+
+typedef void (*pattern_func_t)(int frame, add_func_t add, void *list);
+
+static void add_rect(add_func_t add, void *list, int x, int y, int width,
+		     int height)
+{
+	LCUI_Rect rect;
+
+	rect.x = x;
+	rect.y = y;
+	rect.width = width;
+	rect.height = height;
+	add(list, &rect);
+}
+
+static void pattern_random(int frame, add_func_t add, void *list)
+{
+	int i;
+
+	for (i = 0; i < 200; ++i) {
+		add_rect(add, list, rand() % BENCH_WIDTH,
+			 rand() % BENCH_HEIGHT, rand() % 120 + 1,
+			 rand() % 80 + 1);
+	}
+}
+
+/* Sprites move a few pixels each frame, old and new positions are dirty */
+static void pattern_animation(int frame, add_func_t add, void *list)
+{
+	int i, x, y;
+
+	for (i = 0; i < BENCH_SPRITES; ++i) {
+		x = (i * 97 + frame * (i % 5 + 1)) % (BENCH_WIDTH - 64);
+		y = (i * 53 + frame * (i % 3 + 1)) % (BENCH_HEIGHT - 64);
+		add_rect(add, list, x, y, 64, 64);
+		add_rect(add, list, x + i % 5 + 1, y + i % 3 + 1, 64, 64);
+	}
+}
+
+/* Text is typed into a few lines, each character invalidates a cell */
+static void pattern_typing(int frame, add_func_t add, void *list)
+{
+	int i, x;
+
+	for (i = 0; i < 20; ++i) {
+		x = (frame * 20 + i) * 9 % 1800;
+		add_rect(add, list, 40 + x, 100 + i * 24, 9, 18);
+		add_rect(add, list, 40 + x + 9, 100 + i * 24, 2, 18);
+	}
+}
+
+static void rect_list_add(void *list, LCUI_Rect *rect)
+{
+	RectList_Add(list, rect);
+}
+
+static void dirty_region_add(void *region, LCUI_Rect *rect)
+{
+	DirtyRegion_Add(region, rect);
+}
+
+static void bench_rect_list(pattern_func_t pattern, bench_result_t *result)
+{
+	int i;
+	int64_t t;
+	LinkedList list;
+	LinkedListNode *node;
+	LCUI_Rect *rect;
+
+	srand(42);
+	memset(result, 0, sizeof(bench_result_t));
+	LinkedList_Init(&list);
+	for (i = 0; i < BENCH_FRAMES; ++i) {
+		t = LCUI_GetTimeUs();
+		pattern(i, rect_list_add, &list);
+		result->time += LCUI_GetTimeUs() - t;
+		result->rects += list.length;
+		for (LinkedList_Each(node, &list)) {
+			rect = node->data;
+			result->area += rect->width * rect->height;
+		}
+		RectList_Clear(&list);
+	}
+}
+
+static void bench_dirty_region(pattern_func_t pattern, bench_result_t *result)
+{
+	int i;
+	int64_t t;
+	LCUI_DirtyRegionRec region;
+
+	srand(42);
+	memset(result, 0, sizeof(bench_result_t));
+	DirtyRegion_Init(&region);
+	for (i = 0; i < BENCH_FRAMES; ++i) {
+		t = LCUI_GetTimeUs();
+		pattern(i, dirty_region_add, &region);
+		result->time += LCUI_GetTimeUs() - t;
+		result->rects += region.length;
+		result->area += DirtyRegion_GetArea(&region);
+		DirtyRegion_Clear(&region);
+	}
+	DirtyRegion_Destroy(&region);
+}
+
+static void print_result(const char *pattern, const char *name,
+			 bench_result_t *result)
+{
+	Logger_Info("%-12s%-14s%10.1fus%10lu%14lu\n", pattern, name,
+		    (double)result->time / BENCH_FRAMES,
+		    (unsigned long)(result->rects / BENCH_FRAMES),
+		    (unsigned long)(result->area / BENCH_FRAMES));
+}
+
+static struct {
+	const char *name;
+	pattern_func_t func;
+} patterns[] = { { "random", pattern_random },
+		 { "animation", pattern_animation },
+		 { "typing", pattern_typing } };
+
+int main(int argc, char **argv)
+{
+	size_t i;
+	bench_result_t result;
+
+	Logger_Info("%d frames of %dx%d, average per frame:\n", BENCH_FRAMES,
+		    BENCH_WIDTH, BENCH_HEIGHT);
+	Logger_Info("%-12s%-14s%12s%10s%14s\n", "pattern", "engine", "time",
+		    "rects", "area");
+	for (i = 0; i < sizeof(patterns) / sizeof(patterns[0]); ++i) {
+		bench_rect_list(patterns[i].func, &result);
+		print_result(patterns[i].name, "RectList", &result);
+		bench_dirty_region(patterns[i].func, &result);
+		print_result(patterns[i].name, "DirtyRegion", &result);
+	}
+	return 0;
+}
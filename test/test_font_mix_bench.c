@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/font.h>
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_FRAMES 20
+#define FONT_SIZE 14
+#define LINE_HEIGHT 18
+#define MAX_GLYPHS 512
+
+static const char *mixer_names[] = { "scalar", "sse2", "avx2", "neon" };
+
+static const wchar_t *text =
+    L"The quick brown fox jumps over the lazy dog. 0123456789 ";
+
+static struct {
+	size_t count;
+	LCUI_Pos pos[MAX_GLYPHS];
+	const LCUI_FontBitmap *bitmaps[MAX_GLYPHS];
+} row;
+
+/** Lay out a row of glyphs which fills the width of the graph */
+static void layout_row(void)
+{
+	int x = 0;
+	size_t i;
+	const LCUI_FontBitmap *bmp;
+
+	for (i = 0; row.count < MAX_GLYPHS; ++i) {
+		LCUIFont_GetBitmap(text[i % wcslen(text)], -1, FONT_SIZE, &bmp);
+		if (x + bmp->advance.x > BENCH_WIDTH) {
+			break;
+		}
+		row.pos[row.count].x = x + bmp->left;
+		row.pos[row.count].y = LINE_HEIGHT * 4 / 5 - bmp->top;
+		row.bitmaps[row.count] = bmp;
+		x += bmp->advance.x;
+		++row.count;
+	}
+}
+
+static int64_t bench(LCUI_Graph *graph, LCUI_BOOL batch)
+{
+	int i, y;
+	size_t j;
+	LCUI_Pos pos[MAX_GLYPHS];
+	const LCUI_FontBitmap *bitmaps[MAX_GLYPHS];
+	LCUI_Color color = RGB(40, 40, 40);
+	int64_t t = LCUI_GetTime();
+
+	for (i = 0; i < BENCH_FRAMES; ++i) {
+		/* the pixels may have been evicted since the row was laid out */
+		for (j = 0; j < row.count; ++j) {
+			bitmaps[j] = LCUIFont_LoadBitmap(row.bitmaps[j]);
+		}
+		for (y = 0; y + LINE_HEIGHT <= BENCH_HEIGHT; y += LINE_HEIGHT) {
+			for (j = 0; j < row.count; ++j) {
+				pos[j].x = row.pos[j].x;
+				pos[j].y = row.pos[j].y + y;
+			}
+			if (batch) {
+				FontBitmap_MixRow(graph, pos, bitmaps,
+						  row.count, color);
+				continue;
+			}
+			for (j = 0; j < row.count; ++j) {
+				FontBitmap_Mix(graph, pos[j], bitmaps[j],
+					       color);
+			}
+		}
+		LCUIFont_EndFrame();
+	}
+	return LCUI_GetTimeDelta(t);
+}
+
+int main(int argc, char **argv)
+{
+	int type;
+	char s_t[4][32];
+	LCUI_Graph argb, pargb, rgb;
+
+	Graph_Init(&argb);
+	Graph_Init(&pargb);
+	Graph_Init(&rgb);
+	argb.color_type = LCUI_COLOR_TYPE_ARGB;
+	pargb.color_type = LCUI_COLOR_TYPE_ARGB;
+	rgb.color_type = LCUI_COLOR_TYPE_RGB;
+	if (Graph_Create(&argb, BENCH_WIDTH, BENCH_HEIGHT) != 0 ||
+	    Graph_Create(&pargb, BENCH_WIDTH, BENCH_HEIGHT) != 0 ||
+	    Graph_Create(&rgb, BENCH_WIDTH, BENCH_HEIGHT) != 0) {
+		return -2;
+	}
+	Graph_FillRect(&argb, RGB(255, 255, 255), NULL, FALSE);
+	Graph_FillRect(&pargb, RGB(255, 255, 255), NULL, FALSE);
+	Graph_FillRect(&rgb, RGB(255, 255, 255), NULL, FALSE);
+	Graph_SetColorType(&pargb, LCUI_COLOR_TYPE_PARGB);
+	LCUITime_Init();
+	LCUI_InitFontLibrary();
+	layout_row();
+	Logger_Info("%d frames of %dx%d, %zu glyphs of %dpx per row\n",
+		    BENCH_FRAMES, BENCH_WIDTH, BENCH_HEIGHT, row.count,
+		    FONT_SIZE);
+	Logger_Info("%-10s%-14s%-14s%-14s%-14s\n", "mixer", "argb", "argb row",
+		    "pargb row", "rgb row");
+	for (type = LCUI_PIXEL_MIXER_SCALAR; type <= LCUI_PIXEL_MIXER_NEON;
+	     ++type) {
+		if (Graph_SetMixerType(type) != 0) {
+			continue;
+		}
+		sprintf(s_t[0], "%ldms", (long)bench(&argb, FALSE));
+		sprintf(s_t[1], "%ldms", (long)bench(&argb, TRUE));
+		sprintf(s_t[2], "%ldms", (long)bench(&pargb, TRUE));
+		sprintf(s_t[3], "%ldms", (long)bench(&rgb, TRUE));
+		Logger_Info("%-10s%-14s%-14s%-14s%-14s\n", mixer_names[type],
+			    s_t[0], s_t[1], s_t[2], s_t[3]);
+	}
+	LCUI_FreeFontLibrary();
+	Graph_Free(&argb);
+	Graph_Free(&pargb);
+	Graph_Free(&rgb);
+	return 0;
+}
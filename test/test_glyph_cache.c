@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/font.h>
+#include <LCUI/thread.h>
+#include <LCUI/settings.h>
+#include "test.h"
+#include "libtest.h"
+
+/* the in-core font has bitmaps of printable ASCII characters in 12~18px */
+#define MIN_SIZE 12
+#define MAX_SIZE 18
+#define MIN_CHAR '!'
+#define MAX_CHAR '~'
+#define SIZES (MAX_SIZE - MIN_SIZE + 1)
+#define CHARS (MAX_CHAR - MIN_CHAR + 1)
+#define THREADS 4
+#define FRAMES 4
+
+/* glyphs of digits in test_font_load.ttf */
+#define FILE_GLYPHS 10
+#define FILE_GLYPH_SIZE 16
+#define CACHE_FILE "test_glyph_cache.bin"
+
+/* glyphs which are added to exceed the budget */
+#define FILLER_CHAR 0xE000
+#define FILLER_COUNT 128
+#define FILLER_SIZE 32
+
+static struct {
+	int font_id;
+	const LCUI_FontBitmap *glyphs[SIZES][CHARS];
+	int errors[THREADS];
+	LCUI_FontBitmap file_glyphs[FILE_GLYPHS];
+} self;
+
+static void load_glyphs(void)
+{
+	int i, j;
+
+	for (i = 0; i < SIZES; ++i) {
+		for (j = 0; j < CHARS; ++j) {
+			LCUIFont_GetBitmap(MIN_CHAR + j, self.font_id,
+					   MIN_SIZE + i, &self.glyphs[i][j]);
+		}
+	}
+}
+
+static void add_filler_glyphs(void)
+{
+	int i;
+	LCUI_FontBitmap bmp;
+
+	for (i = 0; i < FILLER_COUNT; ++i) {
+		FontBitmap_Init(&bmp);
+		bmp.width = FILLER_SIZE;
+		bmp.rows = FILLER_SIZE;
+		bmp.pitch = FILLER_SIZE;
+		bmp.advance.x = FILLER_SIZE;
+		bmp.advance.y = FILLER_SIZE;
+		bmp.buffer = calloc(FILLER_SIZE * FILLER_SIZE, 1);
+		LCUIFont_AddBitmap(FILLER_CHAR + i, self.font_id, FILLER_SIZE,
+				   &bmp);
+	}
+}
+
+static int check_glyph(int i, int j)
+{
+	int ret = 0;
+	size_t size;
+	LCUI_FontBitmap expected;
+	const LCUI_FontBitmap *bmp;
+
+	bmp = LCUIFont_LoadBitmap(self.glyphs[i][j]);
+	if (!bmp) {
+		return -1;
+	}
+	FontBitmap_Init(&expected);
+	FontInconsolata_GetBitmap(&expected, MIN_CHAR + j, MIN_SIZE + i);
+	size = (size_t)expected.width * expected.rows;
+	if (bmp->width != expected.width || bmp->rows != expected.rows ||
+	    memcmp(bmp->buffer, expected.buffer, size) != 0) {
+		ret = -1;
+	}
+	FontBitmap_Free(&expected);
+	return ret;
+}
+
+static int check_glyphs(void)
+{
+	int i, j, errors = 0;
+
+	for (i = 0; i < SIZES; ++i) {
+		for (j = 0; j < CHARS; ++j) {
+			if (check_glyph(i, j) != 0) {
+				++errors;
+			}
+		}
+	}
+	return errors;
+}
+
+static void test_glyph_cache_lookup(void)
+{
+	const LCUI_FontBitmap *a, *b;
+	LCUI_GlyphCacheProfileRec profile;
+
+	LCUIFont_GetBitmapCacheProfile(&profile);
+	LCUIFont_GetBitmap('A', self.font_id, 14, &a);
+	LCUIFont_GetBitmapCacheProfile(&profile);
+	it_i("first lookup should be a miss", (int)profile.miss_count, 1);
+	it_i("first lookup should not be a hit", (int)profile.hit_count, 0);
+	it_b("memory usage should be counted", profile.memory_usage > 0, TRUE);
+
+	LCUIFont_GetBitmap('A', self.font_id, 14, &b);
+	LCUIFont_GetBitmapCacheProfile(&profile);
+	it_i("second lookup should be a hit", (int)profile.hit_count, 1);
+	it_b("cached bitmap should be the same", a == b, TRUE);
+	it_b("pixels of a new glyph should be resident",
+	     LCUIFont_LoadBitmap(a) == a, TRUE);
+}
+
+static void test_glyph_cache_eviction(void)
+{
+	const LCUI_FontBitmap *bmp;
+	LCUI_SettingsRec settings;
+	LCUI_GlyphCacheProfileRec profile;
+
+	Settings_Init(&settings);
+	settings.glyph_cache_size = 64;
+	LCUI_ApplySettings(&settings);
+	load_glyphs();
+	add_filler_glyphs();
+	LCUIFont_GetBitmapCacheProfile(&profile);
+	it_b("budget can be exceeded within a frame",
+	     profile.memory_usage > 64 * 1024, TRUE);
+
+	LCUIFont_EndFrame();
+	LCUIFont_GetBitmapCacheProfile(&profile);
+	it_b("glyphs should be evicted at the end of a frame",
+	     profile.eviction_count > 0, TRUE);
+	it_b("memory usage should be within the budget",
+	     profile.memory_usage <= 64 * 1024, TRUE);
+
+	LCUIFont_GetBitmap(MAX_CHAR, self.font_id, MAX_SIZE, &bmp);
+	LCUIFont_GetBitmapCacheProfile(&profile);
+	it_b("evicted glyph should keep its address",
+	     bmp == self.glyphs[SIZES - 1][CHARS - 1], TRUE);
+	it_i("looking up an evicted glyph should be a miss",
+	     (int)profile.miss_count, 1);
+	it_b("looking up an evicted glyph should reload its pixels",
+	     LCUIFont_LoadBitmap(bmp) == bmp, TRUE);
+	it_i("evicted glyphs should be reloaded", check_glyphs(), 0);
+	LCUIFont_EndFrame();
+}
+
+static void glyph_cache_thread(void *arg)
+{
+	int i, j, k;
+	int id = *(int *)arg;
+
+	/* threads start at different glyphs to race on reloading */
+	for (i = 0; i < SIZES; ++i) {
+		for (j = 0; j < CHARS; ++j) {
+			k = (j + id * CHARS / THREADS) % CHARS;
+			if (check_glyph((i + id) % SIZES, k) != 0) {
+				++self.errors[id];
+			}
+		}
+	}
+	LCUIThread_Exit(NULL);
+}
+
+static void test_glyph_cache_threads(void)
+{
+	int i, frame, errors = 0;
+	int ids[THREADS];
+	LCUI_Thread threads[THREADS];
+	LCUI_GlyphCacheProfileRec profile;
+
+	LCUIFont_GetBitmapCacheProfile(&profile);
+	for (frame = 0; frame < FRAMES; ++frame) {
+		add_filler_glyphs();
+		for (i = 0; i < THREADS; ++i) {
+			ids[i] = i;
+			self.errors[i] = 0;
+			LCUIThread_Create(&threads[i], glyph_cache_thread,
+					  &ids[i]);
+		}
+		for (i = 0; i < THREADS; ++i) {
+			LCUIThread_Join(threads[i], NULL);
+			errors += self.errors[i];
+		}
+		LCUIFont_EndFrame();
+	}
+	LCUIFont_GetBitmapCacheProfile(&profile);
+	it_i("pixels read by threads should be correct", errors, 0);
+	it_b("glyphs should be evicted while threads are reading",
+	     profile.eviction_count > 0, TRUE);
+	it_b("memory usage should be within the budget",
+	     profile.memory_usage <= 64 * 1024, TRUE);
+}
+
+/**
+ * Load glyphs of digits with the cache file opened
+ * @returns the number of glyphs loaded from the file, or -1 if the pixels
+ * are different from the saved ones
+ */
+static int load_file_glyphs(LCUI_BOOL save)
+{
+	int i, id, ret;
+	size_t size;
+	const LCUI_FontBitmap *bmp;
+	LCUI_FontBitmap *saved;
+	LCUI_GlyphCacheProfileRec profile;
+
+	LCUI_InitFontLibrary();
+	if (LCUIFont_OpenCacheFile(CACHE_FILE) != 0) {
+		LCUI_FreeFontLibrary();
+		return -1;
+	}
+	LCUIFont_LoadFile("test_font_load.ttf");
+	id = LCUIFont_GetId("icomoon", 0, 0);
+	LCUIFont_GetBitmapCacheProfile(&profile);
+	for (i = 0; i < FILE_GLYPHS; ++i) {
+		saved = &self.file_glyphs[i];
+		LCUIFont_GetBitmap('0' + i, id, FILE_GLYPH_SIZE, &bmp);
+		size = (size_t)bmp->width * bmp->rows;
+		if (save) {
+			*saved = *bmp;
+			saved->buffer = malloc(size + 1);
+			memcpy(saved->buffer, bmp->buffer, size);
+		} else if (bmp->width != saved->width ||
+			   bmp->rows != saved->rows || bmp->top != saved->top ||
+			   bmp->advance.x != saved->advance.x ||
+			   memcmp(bmp->buffer, saved->buffer, size) != 0) {
+			LCUI_FreeFontLibrary();
+			return -1;
+		}
+	}
+	LCUIFont_GetBitmapCacheProfile(&profile);
+	ret = (int)profile.file_hit_count;
+	LCUI_FreeFontLibrary();
+	return ret;
+}
+
+static void test_glyph_cache_file(void)
+{
+	int i;
+	long size;
+	FILE *fp;
+
+	remove(CACHE_FILE);
+	it_i("glyphs should be rendered without the cache file",
+	     load_file_glyphs(TRUE), 0);
+	it_i("glyphs should be loaded from the cache file",
+	     load_file_glyphs(FALSE), FILE_GLYPHS);
+
+	fp = fopen(CACHE_FILE, "ab");
+	size = ftell(fp);
+	fwrite("torn record", 1, 11, fp);
+	fclose(fp);
+	it_i("torn record should be discarded", load_file_glyphs(FALSE),
+	     FILE_GLYPHS);
+	fp = fopen(CACHE_FILE, "rb");
+	fseek(fp, 0, SEEK_END);
+	it_i("the file should be replaced by its valid part", (int)ftell(fp),
+	     (int)size);
+	fclose(fp);
+
+	fp = fopen(CACHE_FILE, "wb");
+	fwrite("invalid header", 1, 14, fp);
+	fclose(fp);
+	it_i("invalid cache file should be reset", load_file_glyphs(FALSE),
+	     0);
+	it_i("glyphs should be saved to the reset file",
+	     load_file_glyphs(FALSE), FILE_GLYPHS);
+
+	for (i = 0; i < FILE_GLYPHS; ++i) {
+		free(self.file_glyphs[i].buffer);
+	}
+	remove(CACHE_FILE);
+}
+
+void test_glyph_cache(void)
+{
+	LCUI_Init();
+	self.font_id = LCUIFont_GetId("inconsolata", 0, 0);
+	describe("check glyph cache lookup", test_glyph_cache_lookup);
+	describe("check glyph cache eviction", test_glyph_cache_eviction);
+	describe("check glyph cache threads", test_glyph_cache_threads);
+	LCUI_Destroy();
+	describe("check glyph cache file", test_glyph_cache_file);
+}
@@ -0,0 +1,91 @@
+/*
+ * Pre-warm a glyph cache file with the glyphs of a text file. Run it twice
+ * to compare a cold start with a warm start:
+ *
+ *   test_glyph_cache_warm <cache file> <text file> [<font file> <family>
+ *                         [pixel size ...]]
+ *
+ * The default font is used if no font file is given.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/font.h>
+
+#define MAX_SIZES 16
+#define MAX_LINE_LEN 1024
+
+int main(int argc, char **argv)
+{
+	FILE *fp;
+	int64_t t;
+	int i, font_id = -1, n_sizes = 0;
+	int sizes[MAX_SIZES] = { 14 };
+	size_t j, len, count = 0;
+	char line[MAX_LINE_LEN];
+	wchar_t wline[MAX_LINE_LEN];
+	const LCUI_FontBitmap *bmp;
+	LCUI_GlyphCacheProfileRec profile;
+
+	if (argc < 3) {
+		Logger_Error("usage: %s <cache file> <text file> "
+			     "[<font file> <family> [pixel size ...]]\n",
+			     argv[0]);
+		return 1;
+	}
+	for (i = 5; i < argc && n_sizes < MAX_SIZES; ++i) {
+		sizes[n_sizes++] = atoi(argv[i]);
+	}
+	n_sizes = n_sizes > 0 ? n_sizes : 1;
+	fp = fopen(argv[2], "r");
+	if (!fp) {
+		Logger_Error("cannot open text file: %s\n", argv[2]);
+		return 1;
+	}
+	t = LCUI_GetTime();
+	LCUI_InitFontLibrary();
+	if (LCUIFont_OpenCacheFile(argv[1]) != 0) {
+		Logger_Error("cannot open cache file: %s\n", argv[1]);
+		fclose(fp);
+		return 1;
+	}
+	if (argc > 4) {
+		LCUIFont_LoadFile(argv[3]);
+		font_id = LCUIFont_GetId(argv[4], 0, 0);
+		if (font_id < 0) {
+			Logger_Error("cannot find font family: %s\n", argv[4]);
+			LCUI_FreeFontLibrary();
+			fclose(fp);
+			return 1;
+		}
+	}
+	LCUIFont_GetBitmapCacheProfile(&profile);
+	Logger_Info("font library initialized in %ldms\n",
+		    (long)LCUI_GetTimeDelta(t));
+
+	t = LCUI_GetTime();
+	while (fgets(line, MAX_LINE_LEN, fp)) {
+		len = LCUI_DecodeUTF8String(wline, line, MAX_LINE_LEN - 1);
+		for (j = 0; j < len; ++j) {
+			if (wline[j] == '\r' || wline[j] == '\n') {
+				continue;
+			}
+			for (i = 0; i < n_sizes; ++i) {
+				LCUIFont_GetBitmap(wline[j], font_id, sizes[i],
+						   &bmp);
+				++count;
+			}
+		}
+	}
+	t = LCUI_GetTimeDelta(t);
+	LCUIFont_GetBitmapCacheProfile(&profile);
+	Logger_Info("%zu lookups in %ldms, %zu glyphs loaded from the cache "
+		    "file, %zu rendered\n",
+		    count, (long)t, profile.file_hit_count,
+		    profile.miss_count - profile.file_hit_count);
+	LCUI_FreeFontLibrary();
+	fclose(fp);
+	return 0;
+}
@@ -0,0 +1,415 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/font.h>
+#include "test.h"
+#include "libtest.h"
+
+#define GRAPH_WIDTH 67
+#define GRAPH_HEIGHT 31
+#define GLYPH_COUNT 12
+
+static const char *mixer_names[] = { "scalar", "sse2", "avx2", "neon" };
+
+typedef struct test_case_t {
+	const char *name;
+	int fore_color_type;
+	int back_color_type;
+	LCUI_BOOL with_alpha;
+	float opacity;
+	int max_diff;
+} test_case_t;
+
+static test_case_t test_cases[] = {
+	{ "ARGB -> ARGB", LCUI_COLOR_TYPE_ARGB, LCUI_COLOR_TYPE_ARGB, FALSE,
+	  1.0f, 0 },
+	{ "ARGB -> ARGB with opacity", LCUI_COLOR_TYPE_ARGB,
+	  LCUI_COLOR_TYPE_ARGB, FALSE, 0.6f, 0 },
+	{ "ARGB -> RGB", LCUI_COLOR_TYPE_ARGB, LCUI_COLOR_TYPE_RGB, FALSE, 1.0f,
+	  0 },
+	{ "ARGB -> RGB with opacity", LCUI_COLOR_TYPE_ARGB, LCUI_COLOR_TYPE_RGB,
+	  FALSE, 0.3f, 0 },
+	{ "ARGB over ARGB", LCUI_COLOR_TYPE_ARGB, LCUI_COLOR_TYPE_ARGB, TRUE,
+	  1.0f, 1 },
+	{ "ARGB over ARGB with opacity", LCUI_COLOR_TYPE_ARGB,
+	  LCUI_COLOR_TYPE_ARGB, TRUE, 0.6f, 1 },
+	{ "PARGB over PARGB", LCUI_COLOR_TYPE_PARGB, LCUI_COLOR_TYPE_PARGB,
+	  TRUE, 1.0f, 0 },
+	{ "PARGB over PARGB with opacity", LCUI_COLOR_TYPE_PARGB,
+	  LCUI_COLOR_TYPE_PARGB, TRUE, 0.6f, 0 },
+	{ "PARGB -> ARGB", LCUI_COLOR_TYPE_PARGB, LCUI_COLOR_TYPE_ARGB, FALSE,
+	  1.0f, 0 },
+	{ "PARGB -> ARGB with opacity", LCUI_COLOR_TYPE_PARGB,
+	  LCUI_COLOR_TYPE_ARGB, FALSE, 0.6f, 0 },
+	{ "PARGB -> RGB", LCUI_COLOR_TYPE_PARGB, LCUI_COLOR_TYPE_RGB, FALSE,
+	  1.0f, 0 },
+	{ "PARGB -> RGB with opacity", LCUI_COLOR_TYPE_PARGB,
+	  LCUI_COLOR_TYPE_RGB, FALSE, 0.3f, 0 },
+	{ "ARGB over PARGB", LCUI_COLOR_TYPE_ARGB, LCUI_COLOR_TYPE_PARGB, TRUE,
+	  1.0f, 0 },
+	{ "ARGB over PARGB with opacity", LCUI_COLOR_TYPE_ARGB,
+	  LCUI_COLOR_TYPE_PARGB, TRUE, 0.6f, 0 }
+};
+
+static uchar_t random_alpha(int y)
+{
+	/* some rows are fully transparent or opaque to cover fast paths */
+	switch (y % 4) {
+	case 0:
+		return 0;
+	case 1:
+		return 255;
+	default:
+		break;
+	}
+	switch (rand() % 4) {
+	case 0:
+		return 0;
+	case 1:
+		return 255;
+	default:
+		break;
+	}
+	return (uchar_t)(rand() % 256);
+}
+
+static void fill_random(LCUI_Graph *graph, LCUI_BOOL with_alpha_rows)
+{
+	unsigned x, y;
+	LCUI_Color color;
+
+	for (y = 0; y < graph->height; ++y) {
+		for (x = 0; x < graph->width; ++x) {
+			color.r = (uchar_t)(rand() % 256);
+			color.g = (uchar_t)(rand() % 256);
+			color.b = (uchar_t)(rand() % 256);
+			if (with_alpha_rows) {
+				color.a = random_alpha(y);
+			} else {
+				color.a = (uchar_t)(rand() % 256);
+			}
+			Graph_SetPixel(graph, x, y, color);
+		}
+	}
+}
+
+/**
+ * Get the maximum channel difference of two graphs, colors of fully
+ * transparent ARGB pixels are ignored.
+ */
+static int compare_graph(const LCUI_Graph *a, const LCUI_Graph *b)
+{
+	int d, diff = 0;
+	unsigned x, y;
+	LCUI_Color ca, cb;
+
+	for (y = 0; y < a->height; ++y) {
+		for (x = 0; x < a->width; ++x) {
+			Graph_GetPixel(a, x, y, ca);
+			Graph_GetPixel(b, x, y, cb);
+			d = abs(ca.a - cb.a);
+			diff = d > diff ? d : diff;
+			if (a->color_type == LCUI_COLOR_TYPE_ARGB &&
+			    ca.a == 0) {
+				continue;
+			}
+			d = abs(ca.r - cb.r);
+			diff = d > diff ? d : diff;
+			d = abs(ca.g - cb.g);
+			diff = d > diff ? d : diff;
+			d = abs(ca.b - cb.b);
+			diff = d > diff ? d : diff;
+		}
+	}
+	return diff;
+}
+
+static void create_random_graph(LCUI_Graph *graph, int color_type,
+				unsigned width, unsigned height,
+				LCUI_BOOL with_alpha_rows)
+{
+	Graph_Init(graph);
+	if (color_type == LCUI_COLOR_TYPE_PARGB) {
+		graph->color_type = LCUI_COLOR_TYPE_ARGB;
+	} else {
+		graph->color_type = color_type;
+	}
+	Graph_Create(graph, width, height);
+	fill_random(graph, with_alpha_rows);
+	Graph_SetColorType(graph, color_type);
+}
+
+static int test_mixer(LCUI_PixelMixerType type, int fore_color_type,
+		      int back_color_type, LCUI_BOOL with_alpha, float opacity)
+{
+	int diff;
+	LCUI_Graph fore, back, expected, actual;
+
+	Graph_Init(&expected);
+	Graph_Init(&actual);
+	create_random_graph(&fore, fore_color_type, GRAPH_WIDTH, GRAPH_HEIGHT,
+			    TRUE);
+	create_random_graph(&back, back_color_type, GRAPH_WIDTH + 5,
+			    GRAPH_HEIGHT + 5, FALSE);
+	fore.opacity = opacity;
+	Graph_Copy(&expected, &back);
+	Graph_Copy(&actual, &back);
+	Graph_SetMixerType(LCUI_PIXEL_MIXER_SCALAR);
+	Graph_Mix(&expected, &fore, 3, 2, with_alpha);
+	Graph_SetMixerType(type);
+	Graph_Mix(&actual, &fore, 3, 2, with_alpha);
+	diff = compare_graph(&expected, &actual);
+	Graph_Free(&fore);
+	Graph_Free(&back);
+	Graph_Free(&expected);
+	Graph_Free(&actual);
+	return diff;
+}
+
+/**
+ * Mix a straight graph and its premultiplied copy into the same RGB graph,
+ * get the maximum channel difference of the results.
+ */
+static int test_premultiplied_alpha(float opacity)
+{
+	int diff;
+	LCUI_Graph fore, pm_fore, back, expected, actual;
+
+	Graph_Init(&pm_fore);
+	Graph_Init(&expected);
+	Graph_Init(&actual);
+	create_random_graph(&fore, LCUI_COLOR_TYPE_ARGB, GRAPH_WIDTH,
+			    GRAPH_HEIGHT, TRUE);
+	create_random_graph(&back, LCUI_COLOR_TYPE_RGB, GRAPH_WIDTH,
+			    GRAPH_HEIGHT, FALSE);
+	Graph_Copy(&pm_fore, &fore);
+	Graph_SetColorType(&pm_fore, LCUI_COLOR_TYPE_PARGB);
+	fore.opacity = opacity;
+	pm_fore.opacity = opacity;
+	Graph_Copy(&expected, &back);
+	Graph_Copy(&actual, &back);
+	Graph_Mix(&expected, &fore, 0, 0, FALSE);
+	Graph_Mix(&actual, &pm_fore, 0, 0, FALSE);
+	diff = compare_graph(&expected, &actual);
+	Graph_Free(&fore);
+	Graph_Free(&pm_fore);
+	Graph_Free(&back);
+	Graph_Free(&expected);
+	Graph_Free(&actual);
+	return diff;
+}
+
+/** Replace RGB with PARGB, compare it with the unpremultiplied graph */
+static int test_premultiplied_replace(void)
+{
+	int diff;
+	unsigned y;
+	LCUI_Graph fore, pm_fore, expected, actual;
+
+	Graph_Init(&pm_fore);
+	Graph_Init(&expected);
+	create_random_graph(&fore, LCUI_COLOR_TYPE_ARGB, GRAPH_WIDTH,
+			    GRAPH_HEIGHT, TRUE);
+	create_random_graph(&actual, LCUI_COLOR_TYPE_RGB, GRAPH_WIDTH,
+			    GRAPH_HEIGHT, FALSE);
+	Graph_Copy(&pm_fore, &fore);
+	Graph_SetColorType(&pm_fore, LCUI_COLOR_TYPE_PARGB);
+	Graph_Copy(&fore, &pm_fore);
+	Graph_SetColorType(&fore, LCUI_COLOR_TYPE_ARGB);
+	expected.color_type = LCUI_COLOR_TYPE_RGB;
+	Graph_Create(&expected, GRAPH_WIDTH, GRAPH_HEIGHT);
+	for (y = 0; y < fore.height; ++y) {
+		PixelsFormat(fore.bytes + y * fore.bytes_per_row,
+			     LCUI_COLOR_TYPE_ARGB,
+			     expected.bytes + y * expected.bytes_per_row,
+			     LCUI_COLOR_TYPE_RGB, fore.width);
+	}
+	Graph_Replace(&actual, &pm_fore, 0, 0);
+	diff = compare_graph(&expected, &actual);
+	Graph_Free(&fore);
+	Graph_Free(&pm_fore);
+	Graph_Free(&expected);
+	Graph_Free(&actual);
+	return diff;
+}
+
+static struct {
+	LCUI_Pos pos[GLYPH_COUNT];
+	LCUI_FontBitmap bitmaps[GLYPH_COUNT];
+	const LCUI_FontBitmap *bitmap_list[GLYPH_COUNT];
+} glyphs;
+
+/** Create glyphs of random sizes, some of them are partly out of the graph */
+static void create_random_glyphs(void)
+{
+	int i, j, size;
+	LCUI_FontBitmap *bmp;
+
+	for (i = 0; i < GLYPH_COUNT; ++i) {
+		bmp = &glyphs.bitmaps[i];
+		FontBitmap_Init(bmp);
+		FontBitmap_Create(bmp, 1 + rand() % 40, 1 + rand() % 20);
+		size = bmp->width * bmp->rows;
+		for (j = 0; j < size; ++j) {
+			bmp->buffer[j] = random_alpha(j / bmp->width);
+		}
+		glyphs.pos[i].x = rand() % (GRAPH_WIDTH + 20) - 20;
+		glyphs.pos[i].y = rand() % (GRAPH_HEIGHT + 10) - 10;
+		glyphs.bitmap_list[i] = bmp;
+	}
+}
+
+static void free_glyphs(void)
+{
+	int i;
+
+	for (i = 0; i < GLYPH_COUNT; ++i) {
+		FontBitmap_Free(&glyphs.bitmaps[i]);
+	}
+}
+
+static int test_glyph_mixer(LCUI_PixelMixerType type, int color_type,
+			    LCUI_Color color)
+{
+	int diff;
+	LCUI_Graph back, expected, actual;
+
+	Graph_Init(&expected);
+	Graph_Init(&actual);
+	create_random_glyphs();
+	create_random_graph(&back, color_type, GRAPH_WIDTH, GRAPH_HEIGHT,
+			    FALSE);
+	Graph_Copy(&expected, &back);
+	Graph_Copy(&actual, &back);
+	Graph_SetMixerType(LCUI_PIXEL_MIXER_SCALAR);
+	FontBitmap_MixRow(&expected, glyphs.pos, glyphs.bitmap_list,
+			  GLYPH_COUNT, color);
+	Graph_SetMixerType(type);
+	FontBitmap_MixRow(&actual, glyphs.pos, glyphs.bitmap_list,
+			  GLYPH_COUNT, color);
+	diff = compare_graph(&expected, &actual);
+	free_glyphs();
+	Graph_Free(&back);
+	Graph_Free(&expected);
+	Graph_Free(&actual);
+	return diff;
+}
+
+/**
+ * Draw glyphs into a quote of a graph one by one and in a row, get the
+ * maximum channel difference of the results.
+ */
+static int test_glyph_row(int color_type)
+{
+	int i, diff;
+	LCUI_Graph back, expected, actual, quote;
+	LCUI_Rect rect = { 5, 3, GRAPH_WIDTH - 10, GRAPH_HEIGHT - 6 };
+
+	Graph_Init(&expected);
+	Graph_Init(&actual);
+	create_random_glyphs();
+	create_random_graph(&back, color_type, GRAPH_WIDTH, GRAPH_HEIGHT,
+			    FALSE);
+	Graph_Copy(&expected, &back);
+	Graph_Copy(&actual, &back);
+	Graph_Quote(&quote, &expected, &rect);
+	for (i = 0; i < GLYPH_COUNT; ++i) {
+		FontBitmap_Mix(&quote, glyphs.pos[i], &glyphs.bitmaps[i],
+			       RGB(255, 0, 0));
+	}
+	Graph_Quote(&quote, &actual, &rect);
+	FontBitmap_MixRow(&quote, glyphs.pos, glyphs.bitmap_list, GLYPH_COUNT,
+			  RGB(255, 0, 0));
+	diff = compare_graph(&expected, &actual);
+	free_glyphs();
+	Graph_Free(&back);
+	Graph_Free(&expected);
+	Graph_Free(&actual);
+	return diff;
+}
+
+static void test_glyph_mixers(void)
+{
+	int type;
+	char str[256];
+	LCUI_Color color = ARGB(160, 40, 80, 200);
+
+	for (type = LCUI_PIXEL_MIXER_SSE2; type <= LCUI_PIXEL_MIXER_NEON;
+	     ++type) {
+		if (Graph_SetMixerType(type) != 0) {
+			continue;
+		}
+		sprintf(str, "%s: glyphs over ARGB should be within 1",
+			mixer_names[type]);
+		it_b(str,
+		     test_glyph_mixer(type, LCUI_COLOR_TYPE_ARGB,
+				      RGB(40, 80, 200)) <= 1,
+		     TRUE);
+		sprintf(str, "%s: translucent glyphs over ARGB should be "
+			     "within 1",
+			mixer_names[type]);
+		it_b(str,
+		     test_glyph_mixer(type, LCUI_COLOR_TYPE_ARGB, color) <= 1,
+		     TRUE);
+		sprintf(str, "%s: glyphs over PARGB should be pixel-exact",
+			mixer_names[type]);
+		it_i(str, test_glyph_mixer(type, LCUI_COLOR_TYPE_PARGB, color),
+		     0);
+		sprintf(str, "%s: glyphs -> RGB should be pixel-exact",
+			mixer_names[type]);
+		it_i(str, test_glyph_mixer(type, LCUI_COLOR_TYPE_RGB, color), 0);
+	}
+	it_i("a row of glyphs should be the same as single glyphs",
+	     test_glyph_row(LCUI_COLOR_TYPE_ARGB), 0);
+	it_i("a row of glyphs -> RGB should be the same as single glyphs",
+	     test_glyph_row(LCUI_COLOR_TYPE_RGB), 0);
+}
+
+void test_graph_mix(void)
+{
+	int type;
+	size_t i;
+	char str[256];
+	test_case_t *c;
+	LCUI_PixelMixerType default_type = Graph_GetMixerType();
+
+	srand(42);
+	for (type = LCUI_PIXEL_MIXER_SSE2; type <= LCUI_PIXEL_MIXER_NEON;
+	     ++type) {
+		if (Graph_SetMixerType(type) != 0) {
+			continue;
+		}
+		for (i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]);
+		     ++i) {
+			c = &test_cases[i];
+			if (c->max_diff == 0) {
+				sprintf(str, "%s: %s should be pixel-exact",
+					mixer_names[type], c->name);
+				it_i(str,
+				     test_mixer(type, c->fore_color_type,
+						c->back_color_type,
+						c->with_alpha, c->opacity),
+				     0);
+				continue;
+			}
+			sprintf(str, "%s: %s should be within %d",
+				mixer_names[type], c->name, c->max_diff);
+			it_b(str,
+			     test_mixer(type, c->fore_color_type,
+					c->back_color_type, c->with_alpha,
+					c->opacity) <= c->max_diff,
+			     TRUE);
+		}
+	}
+	test_glyph_mixers();
+	Graph_SetMixerType(default_type);
+	/* PIXEL_BLEND() divides by 256, so the results may differ by 2 */
+	it_b("PARGB -> RGB should be within 2 of ARGB -> RGB",
+	     test_premultiplied_alpha(1.0f) <= 2, TRUE);
+	it_b("PARGB -> RGB with opacity should be within 2 of ARGB -> RGB",
+	     test_premultiplied_alpha(0.6f) <= 2, TRUE);
+	it_i("replacing RGB with PARGB should be pixel-exact",
+	     test_premultiplied_replace(), 0);
+}
@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_FRAMES 20
+
+static const char *mixer_names[] = { "scalar", "sse2", "avx2", "neon" };
+
+static void fill_random(LCUI_Graph *graph)
+{
+	size_t i, n = graph->width * graph->height;
+
+	for (i = 0; i < n; ++i) {
+		graph->argb[i].r = (uchar_t)(rand() % 256);
+		graph->argb[i].g = (uchar_t)(rand() % 256);
+		graph->argb[i].b = (uchar_t)(rand() % 256);
+		graph->argb[i].a = (uchar_t)(rand() % 256);
+	}
+}
+
+static int64_t bench(LCUI_Graph *back, LCUI_Graph *fore, LCUI_BOOL with_alpha)
+{
+	int i;
+	int64_t t = LCUI_GetTime();
+
+	for (i = 0; i < BENCH_FRAMES; ++i) {
+		Graph_Mix(back, fore, 0, 0, with_alpha);
+	}
+	return LCUI_GetTimeDelta(t);
+}
+
+int main(int argc, char **argv)
+{
+	int type;
+	char s_t[7][32];
+	LCUI_Graph fore, pm_fore, back_argb, back_pargb, back_rgb;
+
+	Graph_Init(&fore);
+	Graph_Init(&pm_fore);
+	Graph_Init(&back_argb);
+	Graph_Init(&back_pargb);
+	Graph_Init(&back_rgb);
+	fore.color_type = LCUI_COLOR_TYPE_ARGB;
+	back_argb.color_type = LCUI_COLOR_TYPE_ARGB;
+	back_rgb.color_type = LCUI_COLOR_TYPE_RGB;
+	if (Graph_Create(&fore, BENCH_WIDTH, BENCH_HEIGHT) != 0 ||
+	    Graph_Create(&back_argb, BENCH_WIDTH, BENCH_HEIGHT) != 0 ||
+	    Graph_Create(&back_rgb, BENCH_WIDTH, BENCH_HEIGHT) != 0) {
+		return -2;
+	}
+	LCUITime_Init();
+	fill_random(&fore);
+	fill_random(&back_argb);
+	Graph_Copy(&pm_fore, &fore);
+	Graph_Copy(&back_pargb, &back_argb);
+	Graph_SetColorType(&pm_fore, LCUI_COLOR_TYPE_PARGB);
+	Graph_SetColorType(&back_pargb, LCUI_COLOR_TYPE_PARGB);
+	Logger_Info("%d frames of %dx%d\n", BENCH_FRAMES, BENCH_WIDTH,
+		    BENCH_HEIGHT);
+	Logger_Info("%-10s%-14s%-14s%-14s%-14s%-14s%-14s%-14s\n", "mixer",
+		    "argb", "argb+opacity", "over", "over+opacity", "rgb",
+		    "pargb over", "pargb rgb");
+	for (type = LCUI_PIXEL_MIXER_SCALAR; type <= LCUI_PIXEL_MIXER_NEON;
+	     ++type) {
+		if (Graph_SetMixerType(type) != 0) {
+			continue;
+		}
+		fore.opacity = 1.0f;
+		sprintf(s_t[0], "%ldms", (long)bench(&back_argb, &fore, FALSE));
+		sprintf(s_t[2], "%ldms", (long)bench(&back_argb, &fore, TRUE));
+		sprintf(s_t[4], "%ldms", (long)bench(&back_rgb, &fore, FALSE));
+		sprintf(s_t[5], "%ldms",
+			(long)bench(&back_pargb, &pm_fore, TRUE));
+		sprintf(s_t[6], "%ldms",
+			(long)bench(&back_rgb, &pm_fore, FALSE));
+		fore.opacity = 0.5f;
+		sprintf(s_t[1], "%ldms", (long)bench(&back_argb, &fore, FALSE));
+		sprintf(s_t[3], "%ldms", (long)bench(&back_argb, &fore, TRUE));
+		Logger_Info("%-10s%-14s%-14s%-14s%-14s%-14s%-14s%-14s\n",
+			    mixer_names[type], s_t[0], s_t[1], s_t[2], s_t[3],
+			    s_t[4], s_t[5], s_t[6]);
+	}
+	Graph_Free(&fore);
+	Graph_Free(&pm_fore);
+	Graph_Free(&back_argb);
+	Graph_Free(&back_pargb);
+	Graph_Free(&back_rgb);
+	return 0;
+}
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/display.h>
+#include <LCUI/gui/widget.h>
+#include "test.h"
+#include "libtest.h"
+
+#define SCREEN_WIDTH 320
+#define SCREEN_HEIGHT 240
+#define MAX_DAMAGE 16
+
+static struct {
+	LCUI_Widget red;
+	LCUI_Widget blue;
+} self;
+
+static size_t render_frame(void)
+{
+	LCUIWidget_Update();
+	LCUIDisplay_Update();
+	LCUIDisplay_Render();
+	return LCUIDisplay_Present();
+}
+
+static LCUI_Widget create_block(const char *color, float x, float y)
+{
+	LCUI_Widget w = LCUIWidget_New(NULL);
+
+	Widget_SetStyle(w, key_position, SV_ABSOLUTE, style);
+	Widget_SetStyleString(w, "background-color", color);
+	Widget_Move(w, x, y);
+	Widget_Resize(w, 40, 30);
+	Widget_Append(LCUIWidget_GetRoot(), w);
+	return w;
+}
+
+static LCUI_BOOL check_pixel(LCUI_Graph *frame, int x, int y,
+			     LCUI_Color expected)
+{
+	LCUI_Color color;
+
+	Graph_GetPixel(frame, x, y, color);
+	return color.r == expected.r && color.g == expected.g &&
+	       color.b == expected.b;
+}
+
+static void test_frame_capture(void)
+{
+	LCUI_Graph frame;
+
+	Graph_Init(&frame);
+	it_b("the headless display driver should be used",
+	     LCUIDisplay_IsHeadless(), TRUE);
+	LCUIDisplay_SetMode(LCUI_DMODE_WINDOWED);
+	LCUIDisplay_SetSize(SCREEN_WIDTH, SCREEN_HEIGHT);
+	Widget_SetStyleString(LCUIWidget_GetRoot(), "background-color", "#fff");
+	self.red = create_block("#f00", 10, 20);
+	self.blue = create_block("#00f", 200, 100);
+	it_b("the first frame should be presented", render_frame() > 0, TRUE);
+	it_i("the frame should be captured",
+	     LCUIHeadlessDisplay_CaptureFrame(&frame), 0);
+	it_i("the captured frame width", frame.width, SCREEN_WIDTH);
+	it_i("the captured frame height", frame.height, SCREEN_HEIGHT);
+	it_b("the red block should be painted",
+	     check_pixel(&frame, 10, 20, RGB(255, 0, 0)) &&
+		 check_pixel(&frame, 49, 49, RGB(255, 0, 0)),
+	     TRUE);
+	it_b("the blue block should be painted",
+	     check_pixel(&frame, 239, 129, RGB(0, 0, 255)), TRUE);
+	it_b("the background should be painted",
+	     check_pixel(&frame, 50, 50, RGB(255, 255, 255)) &&
+		 check_pixel(&frame, 9, 20, RGB(255, 255, 255)),
+	     TRUE);
+	Graph_Free(&frame);
+}
+
+static void test_frame_damage(void)
+{
+	size_t i, n, count;
+	LCUI_BOOL contained = TRUE;
+	LCUI_Rect damage[MAX_DAMAGE];
+	LCUI_Rect area = { 200, 100, 40, 30 };
+	LCUI_Graph frame;
+
+	Graph_Init(&frame);
+	LCUIHeadlessDisplay_ClearDamage();
+	count = LCUIHeadlessDisplay_GetPresentCount();
+	it_i("nothing should be presented if nothing has changed",
+	     (int)render_frame(), 0);
+	it_i("the empty frame should not be counted",
+	     (int)LCUIHeadlessDisplay_GetPresentCount(), (int)count);
+	it_i("the empty frame should not have damage",
+	     (int)LCUIHeadlessDisplay_GetDamage(NULL, 0), 0);
+
+	Widget_SetStyleString(self.blue, "background-color", "#0f0");
+	it_b("the changed block should be presented", render_frame() > 0, TRUE);
+	it_i("the present count should be increased",
+	     (int)LCUIHeadlessDisplay_GetPresentCount(), (int)count + 1);
+	n = LCUIHeadlessDisplay_GetDamage(damage, MAX_DAMAGE);
+	it_b("the damage should be recorded", n > 0 && n <= MAX_DAMAGE, TRUE);
+	for (i = 0; i < n && i < MAX_DAMAGE; ++i) {
+		if (damage[i].x < area.x || damage[i].y < area.y ||
+		    damage[i].x + damage[i].width > area.x + area.width ||
+		    damage[i].y + damage[i].height > area.y + area.height) {
+			contained = FALSE;
+		}
+	}
+	it_b("the damage should only cover the changed block", contained, TRUE);
+	LCUIHeadlessDisplay_CaptureFrame(&frame);
+	it_b("the changed block should be repainted",
+	     check_pixel(&frame, 220, 110, RGB(0, 255, 0)), TRUE);
+	it_b("the other block should be kept",
+	     check_pixel(&frame, 30, 30, RGB(255, 0, 0)), TRUE);
+	LCUIHeadlessDisplay_ClearDamage();
+	it_i("the damage should be cleared",
+	     (int)LCUIHeadlessDisplay_GetDamage(NULL, 0), 0);
+	Graph_Free(&frame);
+}
+
+void test_headless_display(void)
+{
+	LCUI_InitBase();
+	LCUI_InitDisplay(LCUI_CreateHeadlessDisplayDriver());
+	LCUI_Init();
+	describe("check frame capture", test_frame_capture);
+	describe("check frame damage", test_frame_damage);
+	LCUI_Destroy();
+	it_b("the headless display driver should be released",
+	     LCUIDisplay_IsHeadless(), FALSE);
+}
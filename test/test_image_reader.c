@@ -7,6 +7,54 @@
 #include "test.h"
 #include "libtest.h"
 
+static void test_image_reader_with_scale(void)
+{
+	LCUI_Graph img;
+	LCUI_Color color;
+	LCUI_Rect rect = { 0, 0, 2, 2 };
+	int i;
+	char file[256], *formats[] = { "png", "bmp", "jpg" };
+
+	for (i = 0; i < 3; ++i) {
+		Graph_Init(&img);
+		snprintf(file, 255, "test_image_reader.%s", formats[i]);
+		it_i("check LCUI_ReadImageFileWithScale",
+		     LCUI_ReadImageFileWithScale(file, 2, &img), 0);
+		it_i("check image width with scale 1/2", img.width, 46);
+		it_i("check image height with scale 1/2", img.height, 35);
+		Graph_Free(&img);
+		LCUI_ReadImageFileWithScale(file, 8, &img);
+		it_i("check image width with scale 1/8", img.width, 12);
+		it_i("check image height with scale 1/8", img.height, 9);
+		Graph_Free(&img);
+	}
+
+	/* non-interlaced PNG images are downsampled while reading rows */
+	img.color_type = LCUI_COLOR_TYPE_ARGB;
+	Graph_Create(&img, 5, 4);
+	Graph_FillRect(&img, ARGB(255, 255, 255, 255), NULL, TRUE);
+	Graph_FillRect(&img, ARGB(255, 0, 0, 0), &rect, TRUE);
+	/* a transparent pixel should not darken the second block */
+	rect.x = 2;
+	rect.width = rect.height = 1;
+	Graph_FillRect(&img, ARGB(0, 0, 0, 0), &rect, TRUE);
+	LCUI_WritePNGFile("test_image_reader_scale.png", &img);
+	Graph_Free(&img);
+	it_i("check LCUI_ReadImageFileWithScale with a non-interlaced PNG",
+	     LCUI_ReadImageFileWithScale("test_image_reader_scale.png", 2,
+					 &img),
+	     0);
+	it_i("check image width", img.width, 3);
+	it_i("check image height", img.height, 2);
+	Graph_GetPixel(&img, 0, 0, color);
+	it_i("check the average of the first block", color.r, 0);
+	Graph_GetPixel(&img, 1, 0, color);
+	it_i("check the average of the second block", color.r, 255);
+	it_i("check the average alpha of the second block", color.a, 191);
+	Graph_Free(&img);
+	remove("test_image_reader_scale.png");
+}
+
 void test_image_reader(void)
 {
 	LCUI_Graph img;
@@ -29,4 +77,5 @@ void test_image_reader(void)
 		it_i("check image height with GetImageSize", height, 69);
 		Graph_Free(&img);
 	}
+	test_image_reader_with_scale();
 }
@@ -0,0 +1,112 @@
+/*
+ * Post input reports from several threads while the main thread processes
+ * events, compare the main worker queue with the input task queue:
+ *
+ *   test_input_queue_bench [number of reports per thread]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/thread.h>
+
+#define PRODUCERS 4
+#define DEFAULT_REPORTS 100000
+
+/* a mouse report and the time it is read */
+typedef struct ReportRec_ {
+	int64_t time;
+	char buf[6];
+} ReportRec, *Report;
+
+static struct {
+	int reports;
+	volatile LCUI_BOOL use_input_queue;
+	size_t count;
+	LCUI_LatencyHistogramRec latency;
+} self;
+
+static void OnReport(void *arg1, void *arg2)
+{
+	Report report = arg1;
+
+	if (!self.use_input_queue) {
+		LatencyHistogram_Add(&self.latency,
+				     LCUI_GetTimeUs() - report->time);
+	}
+	self.count += 1;
+}
+
+static void ProducerThread(void *arg)
+{
+	int i;
+	ReportRec report = { 0 };
+	LCUI_TaskRec task = { 0 };
+
+	task.func = OnReport;
+	task.destroy_arg[0] = free;
+	for (i = 0; i < self.reports; ++i) {
+		report.buf[1] = (char)i;
+		if (self.use_input_queue) {
+			while (LCUI_PostInputTask(OnReport, &report,
+						  sizeof(report)) == -EAGAIN) {
+				LCUI_MSleep(0);
+			}
+			continue;
+		}
+		report.time = LCUI_GetTimeUs();
+		task.arg[0] = malloc(sizeof(ReportRec));
+		memcpy(task.arg[0], &report, sizeof(ReportRec));
+		LCUI_PostTask(&task);
+	}
+}
+
+static void Run(const char *name, LCUI_BOOL use_input_queue)
+{
+	int i;
+	int64_t t;
+	LCUI_Thread threads[PRODUCERS];
+
+	self.count = 0;
+	self.use_input_queue = use_input_queue;
+	memset(&self.latency, 0, sizeof(self.latency));
+	LCUI_ResetInputLatency();
+	t = LCUI_GetTime();
+	for (i = 0; i < PRODUCERS; ++i) {
+		LCUIThread_Create(&threads[i], ProducerThread, NULL);
+	}
+	while (self.count < (size_t)self.reports * PRODUCERS) {
+		if (LCUI_ProcessEvents() < 1) {
+			LCUI_MSleep(0);
+		}
+	}
+	for (i = 0; i < PRODUCERS; ++i) {
+		LCUIThread_Join(threads[i], NULL);
+	}
+	t = LCUI_GetTimeDelta(t);
+	if (use_input_queue) {
+		LCUI_GetInputLatency(&self.latency);
+	}
+	Logger_Info("%-14s %lu reports in %ldms, latency p50: %ldus, "
+		    "p99: %ldus, max: %ldus\n",
+		    name, (unsigned long)self.count, (long)t,
+		    (long)LatencyHistogram_GetPercentile(&self.latency, 50),
+		    (long)LatencyHistogram_GetPercentile(&self.latency, 99),
+		    (long)self.latency.max);
+}
+
+int main(int argc, char **argv)
+{
+	self.reports = DEFAULT_REPORTS;
+	if (argc > 1) {
+		self.reports = atoi(argv[1]);
+	}
+	LCUI_Init();
+	Run("worker queue", FALSE);
+	Run("input queue", TRUE);
+	LCUI_Destroy();
+	return 0;
+}
@@ -58,7 +58,7 @@ static void ObserverThread(void *arg)
 	LCUIThread_Exit(NULL);
 }
 
-void test_mainloop(void)
+static void test_mainloop_nesting(void)
 {
 	LCUI_Thread tid;
 	LCUI_Widget root, btn;
@@ -78,3 +78,55 @@ void test_mainloop(void)
 	exited = TRUE;
 	LCUIThread_Join(tid, NULL);
 }
+
+static struct {
+	int64_t post_time;
+	long latency;
+	size_t wakeup_count;
+} idle;
+
+static void OnWakeupTask(void *arg1, void *arg2)
+{
+	idle.latency = (long)LCUI_GetTimeDelta(idle.post_time);
+	idle.wakeup_count = LCUI_GetIdleWakeupCount() - idle.wakeup_count;
+	LCUI_Quit();
+}
+
+static void PostTaskThread(void *arg)
+{
+	LCUI_TaskRec task = { 0 };
+
+	LCUI_MSleep(200);
+	task.func = OnWakeupTask;
+	idle.post_time = LCUI_GetTime();
+	LCUI_PostTask(&task);
+	LCUIThread_Exit(NULL);
+}
+
+static void test_mainloop_idle(void)
+{
+	LCUI_Thread tid;
+	LCUI_AppDriverId app_id;
+
+	LCUI_Init();
+	app_id = LCUI_GetAppId();
+	idle.latency = -1;
+	idle.wakeup_count = LCUI_GetIdleWakeupCount();
+	LCUI_SetTimeout(1000, OnQuit, NULL);
+	LCUIThread_Create(&tid, PostTaskThread, NULL);
+	LCUI_Main();
+	LCUIThread_Join(tid, NULL);
+	it_b("the idle main loop should be woken up by the posted task",
+	     idle.latency >= 0 && idle.latency < 50, TRUE);
+	/* 其它平台的事件需要在主线程中轮询，空闲时仍会按帧率醒来 */
+	if (app_id == LCUI_APP_LINUX) {
+		it_b("the main loop should sleep until there is work to do",
+		     idle.wakeup_count > 0 && idle.wakeup_count < 10, TRUE);
+	}
+}
+
+void test_mainloop(void)
+{
+	describe("check nested main loop", test_mainloop_nesting);
+	describe("check idle main loop", test_mainloop_idle);
+}
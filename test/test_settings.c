@@ -3,6 +3,7 @@
 #include <LCUI/settings.h>
 #include <LCUI/main.h>
 #include <LCUI/timer.h>
+#include <LCUI/display.h>
 #include "test.h"
 #include "libtest.h"
 
@@ -13,6 +14,12 @@ static void on_settings_change(LCUI_SysEvent object, void *data)
 	++settings_change_count;
 }
 
+/* 主循环在空闲时会停止出帧，需要持续刷新屏幕才能测出帧率 */
+static void keep_rendering(void *arg)
+{
+	LCUIDisplay_InvalidateArea(NULL);
+}
+
 static void check_settings_frame_rate_cap(void *arg)
 {
 	char str[256];
@@ -36,9 +43,24 @@ static void test_default_settings(void)
 	it_i("check default frame rate cap", settings.frame_rate_cap, 120);
 	it_i("check default parallel rendering threads",
 	     settings.parallel_rendering_threads, 4);
+	it_i("check default parallel rendering mode",
+	     settings.parallel_rendering_mode, LCUI_PARALLEL_RENDERING_TILES);
 	it_b("check default record profile", settings.record_profile, FALSE);
 	it_b("check default fps meter", settings.fps_meter, FALSE);
 	it_b("check default paint flashing", settings.paint_flashing, FALSE);
+	it_b("check default premultiplied alpha", settings.premultiplied_alpha,
+	     FALSE);
+	it_b("check default parallel style computation",
+	     settings.parallel_style_computation, FALSE);
+	it_b("check default trace frames", settings.trace_frames, FALSE);
+	it_i("check default trace frame threshold",
+	     settings.trace_frame_threshold, 0);
+	it_i("check default glyph cache size", settings.glyph_cache_size,
+	     4096);
+	it_i("check default scaled image cache size",
+	     settings.scaled_image_cache_size, 16384);
+	it_i("check default image cache size", settings.image_cache_size,
+	     65536);
 	LCUI_Destroy();
 }
 
@@ -51,29 +73,62 @@ static void test_apply_settings(void)
 
 	settings.frame_rate_cap = 60;
 	settings.parallel_rendering_threads = 2;
+	settings.parallel_rendering_mode = LCUI_PARALLEL_RENDERING_STRIPS;
 	settings.record_profile = TRUE;
 	settings.fps_meter = TRUE;
 	settings.paint_flashing = TRUE;
+	settings.premultiplied_alpha = TRUE;
+	settings.parallel_style_computation = TRUE;
+	settings.trace_frames = TRUE;
+	settings.trace_frame_threshold = 50;
+	settings.glyph_cache_size = 1024;
+	settings.scaled_image_cache_size = 2048;
+	settings.image_cache_size = 4096;
 
 	LCUI_ApplySettings(&settings);
 	Settings_Init(&settings);
 	it_i("check frame rate cap", settings.frame_rate_cap, 60);
 	it_i("check parallel rendering threads",
 	     settings.parallel_rendering_threads, 2);
+	it_i("check parallel rendering mode", settings.parallel_rendering_mode,
+	     LCUI_PARALLEL_RENDERING_STRIPS);
 	it_b("check record profile", settings.record_profile, TRUE);
 	it_b("check fps meter", settings.fps_meter, TRUE);
 	it_b("check paint flashing", settings.paint_flashing, TRUE);
+	it_b("check premultiplied alpha", settings.premultiplied_alpha, TRUE);
+	it_b("check parallel style computation",
+	     settings.parallel_style_computation, TRUE);
+	it_b("check trace frames", settings.trace_frames, TRUE);
+	it_i("check trace frame threshold", settings.trace_frame_threshold,
+	     50);
+	it_i("check glyph cache size", settings.glyph_cache_size, 1024);
+	it_i("check scaled image cache size", settings.scaled_image_cache_size,
+	     2048);
+	it_i("check image cache size", settings.image_cache_size, 4096);
 
 	it_i("check settings change count", settings_change_count, 1);
 
 	settings.frame_rate_cap = -1;
 	settings.parallel_rendering_threads = -1;
+	settings.parallel_rendering_mode = -1;
+	settings.trace_frame_threshold = -1;
+	settings.glyph_cache_size = 0;
+	settings.scaled_image_cache_size = -1;
+	settings.image_cache_size = -1;
 
 	LCUI_ApplySettings(&settings);
 	Settings_Init(&settings);
 	it_i("check frame rate cap minimum", settings.frame_rate_cap, 1);
 	it_i("check parallel rendering threads minimum",
 	     settings.parallel_rendering_threads, 1);
+	it_i("check parallel rendering mode fallback",
+	     settings.parallel_rendering_mode, LCUI_PARALLEL_RENDERING_TILES);
+	it_i("check trace frame threshold minimum",
+	     settings.trace_frame_threshold, 0);
+	it_i("check glyph cache size minimum", settings.glyph_cache_size, 64);
+	it_i("check scaled image cache size minimum",
+	     settings.scaled_image_cache_size, 0);
+	it_i("check image cache size minimum", settings.image_cache_size, 0);
 	it_i("check settings change count", settings_change_count, 2);
 
 	LCUI_ResetSettings();
@@ -90,6 +145,7 @@ void test_settings_frame_rate_cap(void)
 
 	settings.frame_rate_cap = 30;
 	LCUI_ApplySettings(&settings);
+	LCUI_SetInterval(1, keep_rendering, NULL);
 	LCUI_SetTimeout(1000, check_settings_frame_rate_cap,
 			&settings.frame_rate_cap);
 	LCUI_Main();
@@ -97,6 +153,7 @@ void test_settings_frame_rate_cap(void)
 	LCUI_Init();
 	settings.frame_rate_cap = 5;
 	LCUI_ApplySettings(&settings);
+	LCUI_SetInterval(1, keep_rendering, NULL);
 	LCUI_SetTimeout(1000, check_settings_frame_rate_cap,
 			&settings.frame_rate_cap);
 	LCUI_Main();
@@ -104,6 +161,7 @@ void test_settings_frame_rate_cap(void)
 	LCUI_Init();
 	settings.frame_rate_cap = 90;
 	LCUI_ApplySettings(&settings);
+	LCUI_SetInterval(1, keep_rendering, NULL);
 	LCUI_SetTimeout(1000, check_settings_frame_rate_cap,
 			&settings.frame_rate_cap);
 	LCUI_Main();
@@ -111,6 +169,7 @@ void test_settings_frame_rate_cap(void)
 	LCUI_Init();
 	settings.frame_rate_cap = 25;
 	LCUI_ApplySettings(&settings);
+	LCUI_SetInterval(1, keep_rendering, NULL);
 	LCUI_SetTimeout(1000, check_settings_frame_rate_cap,
 			&settings.frame_rate_cap);
 	LCUI_Main();
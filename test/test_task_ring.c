@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/thread.h>
+#include "test.h"
+#include "libtest.h"
+
+#define PRODUCERS 4
+#define TASKS_PER_PRODUCER 10000
+
+typedef struct InputDataRec_ {
+	int producer;
+	int sequence;
+} InputDataRec;
+
+static struct {
+	LCUI_TaskRing ring;
+	char order[16];
+	size_t length;
+	int count;
+	int sequences[PRODUCERS];
+	LCUI_BOOL in_order;
+} self;
+
+static void OnChar(void *arg1, void *arg2)
+{
+	self.order[self.length++] = *(char *)arg1;
+	self.order[self.length] = 0;
+}
+
+static void OnInput(void *arg1, void *arg2)
+{
+	InputDataRec *data = arg1;
+
+	if (self.sequences[data->producer] != data->sequence) {
+		self.in_order = FALSE;
+	}
+	self.sequences[data->producer] = data->sequence + 1;
+	self.count += 1;
+}
+
+static void OnCount(void *arg1, void *arg2)
+{
+	self.count += 1;
+}
+
+static void ProducerThread(void *arg)
+{
+	InputDataRec data;
+
+	data.producer = (int)(size_t)arg;
+	for (data.sequence = 0; data.sequence < TASKS_PER_PRODUCER;
+	     ++data.sequence) {
+		while (TaskRing_Push(self.ring, OnInput, &data, sizeof(data)) ==
+		       -EAGAIN) {
+			LCUI_MSleep(0);
+		}
+	}
+}
+
+static void test_task_ring_push(void)
+{
+	int i;
+	char c = 'a';
+	char data[LCUI_TASK_RING_DATA_SIZE + 1] = { 0 };
+	LCUI_LatencyHistogramRec latency;
+	LCUI_TaskRing ring = TaskRing_New(5);
+
+	self.length = 0;
+	for (i = 0; i < 8; ++i, ++c) {
+		if (TaskRing_Push(ring, OnChar, &c, 1) != 0) {
+			break;
+		}
+	}
+	it_i("the capacity should be rounded up to a power of two", i, 8);
+	c = 'x';
+	it_i("pushing to a full ring should fail",
+	     TaskRing_Push(ring, OnChar, &c, 1), -EAGAIN);
+	it_i("pushing too much data should fail",
+	     TaskRing_Push(ring, OnChar, data, sizeof(data)), -EINVAL);
+	it_i("run 3 tasks", (int)TaskRing_Run(ring, 3), 3);
+	it_s("the data should be copied into the ring", self.order, "abc");
+	it_i("push after running", TaskRing_Push(ring, OnChar, &c, 1), 0);
+	it_i("run the rest tasks", (int)TaskRing_Run(ring, 100), 6);
+	it_s("the tasks should be run in the order of pushing", self.order,
+	     "abcdefghx");
+	it_i("run the empty ring", (int)TaskRing_Run(ring, 100), 0);
+	TaskRing_GetLatency(ring, &latency);
+	it_i("the latency of each task should be recorded", (int)latency.count,
+	     9);
+	TaskRing_ResetLatency(ring);
+	TaskRing_GetLatency(ring, &latency);
+	it_i("the latency should be reset", (int)latency.count, 0);
+	TaskRing_Destroy(ring);
+}
+
+static void test_task_ring_producers(void)
+{
+	int i;
+	LCUI_Thread threads[PRODUCERS];
+
+	self.count = 0;
+	self.in_order = TRUE;
+	memset(self.sequences, 0, sizeof(self.sequences));
+	self.ring = TaskRing_New(64);
+	for (i = 0; i < PRODUCERS; ++i) {
+		LCUIThread_Create(&threads[i], ProducerThread,
+				  (void *)(size_t)i);
+	}
+	while (self.count < PRODUCERS * TASKS_PER_PRODUCER) {
+		if (TaskRing_Run(self.ring, 16) < 1) {
+			LCUI_MSleep(0);
+		}
+	}
+	for (i = 0; i < PRODUCERS; ++i) {
+		LCUIThread_Join(threads[i], NULL);
+	}
+	it_i("all tasks should be run", self.count,
+	     PRODUCERS * TASKS_PER_PRODUCER);
+	it_b("the tasks of each producer should be run in order",
+	     self.in_order, TRUE);
+	TaskRing_Destroy(self.ring);
+}
+
+static void test_latency_histogram(void)
+{
+	int i;
+	LCUI_LatencyHistogramRec hist = { 0 };
+
+	it_i("the percentile of an empty histogram",
+	     (int)LatencyHistogram_GetPercentile(&hist, 50), 0);
+	for (i = 0; i < 90; ++i) {
+		LatencyHistogram_Add(&hist, 3);
+	}
+	for (i = 0; i < 10; ++i) {
+		LatencyHistogram_Add(&hist, 1000);
+	}
+	it_i("3us should be counted in the bucket [2, 4)", (int)hist.buckets[2],
+	     90);
+	it_i("p50 should be the upper bound of its bucket",
+	     (int)LatencyHistogram_GetPercentile(&hist, 50), 4);
+	it_i("p99 should not exceed the max latency",
+	     (int)LatencyHistogram_GetPercentile(&hist, 99), 1000);
+	it_i("the max latency", (int)hist.max, 1000);
+}
+
+static void test_input_task(void)
+{
+	int i;
+	LCUI_LatencyHistogramRec latency;
+
+	LCUI_Init();
+	LCUI_ResetInputLatency();
+	self.count = 0;
+	for (i = 0; i < 10; ++i) {
+		LCUI_PostInputTask(OnCount, NULL, 0);
+	}
+	it_i("the input tasks should not be run before processing events",
+	     self.count, 0);
+	LCUI_ProcessEvents();
+	it_i("the input tasks should be run in one batch", self.count, 10);
+	LCUI_GetInputLatency(&latency);
+	it_i("the input latency should be recorded", (int)latency.count, 10);
+	LCUI_Destroy();
+	it_b("posting input tasks after destroying should fail",
+	     LCUI_PostInputTask(OnCount, NULL, 0) != 0, TRUE);
+}
+
+void test_task_ring(void)
+{
+	describe("check task ring push", test_task_ring_push);
+	describe("check task ring producers", test_task_ring_producers);
+	describe("check latency histogram", test_latency_histogram);
+	describe("check input task", test_input_task);
+}
@@ -1,24 +1,453 @@
 #include <wchar.h>
+#include <stdlib.h>
 #include <string.h>
 #include <LCUI_Build.h>
-#include <LCUI/util/logger.h>
-#include <LCUI/font/textlayer.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/font.h>
 #include "test.h"
+#include "libtest.h"
 
-static int test_textlayer_wordbreak(void)
+#define LAYER_WIDTH 120
+#define LAYER_HEIGHT 400
+
+static const wchar_t *test_text =
+    L"hello, world!\n"
+    L"[size=24px]large row[/size]\n"
+    L"short\n"
+    L"[size=12px]the longest row of this text, it will be wrapped[/size]\n"
+    L"\n"
+    L"[size=30px]big[/size] and small\n"
+    L"last row";
+
+/** 以逐行累加的方式计算文本行的 Y 轴坐标 */
+static int get_row_y(LCUI_TextLayer layer, int row)
+{
+	int i, y;
+
+	for (i = 0, y = 0; i < row; ++i) {
+		y += layer->text_rows.rows[i]->height;
+	}
+	return y;
+}
+
+static int get_max_row_width(LCUI_TextLayer layer)
+{
+	int i, w;
+
+	for (i = 0, w = 0; i < layer->text_rows.length; ++i) {
+		if (layer->text_rows.rows[i]->width > w) {
+			w = layer->text_rows.rows[i]->width;
+		}
+	}
+	return w;
+}
+
+/**
+ * Compare the results of the row index with the ones calculated row by row
+ * @returns the number of mismatches
+ */
+static int check_row_index(LCUI_TextLayer layer)
+{
+	int row, y, errors = 0;
+	LCUI_Pos pos;
+	LCUI_TextRow txtrow;
+
+	if (TextLayer_GetHeight(layer) !=
+	    get_row_y(layer, layer->text_rows.length)) {
+		++errors;
+	}
+	if (TextLayer_GetWidth(layer) != get_max_row_width(layer)) {
+		++errors;
+	}
+	for (row = 0; row < layer->text_rows.length; ++row) {
+		txtrow = layer->text_rows.rows[row];
+		y = get_row_y(layer, row);
+		if (TextLayer_GetCharPixelPos(layer, row, 0, &pos) != 0 ||
+		    pos.y != y) {
+			++errors;
+		}
+		if (txtrow->height < 1) {
+			continue;
+		}
+		TextLayer_SetCaretPosByPixelPos(layer, 0, y + 1);
+		if (layer->insert_y != row) {
+			++errors;
+		}
+		TextLayer_SetCaretPosByPixelPos(layer, 0, y + txtrow->height);
+		if (layer->insert_y != row) {
+			++errors;
+		}
+	}
+	return errors;
+}
+
+static void test_textlayer_row_index(void)
+{
+	const wchar_t *long_row =
+	    L"a very very very very very very very very long first row\n";
+	int width;
+	LCUI_TextLayer layer;
+
+	layer = TextLayer_New();
+	TextLayer_SetMultiline(layer, TRUE);
+	TextLayer_EnableStyleTag(layer, TRUE);
+	TextLayer_SetTextW(layer, test_text, NULL);
+	TextLayer_Update(layer, NULL);
+	it_b("text should have multiple rows", layer->text_rows.length > 5,
+	     TRUE);
+	it_i("row index should be correct after setting text",
+	     check_row_index(layer), 0);
+
+	TextLayer_SetCaretPos(layer, 2, 0);
+	TextLayer_InsertTextW(layer, L"[size=40px]inserted\nrows[/size]\n",
+			      NULL);
+	TextLayer_Update(layer, NULL);
+	it_i("row index should be correct after inserting rows",
+	     check_row_index(layer), 0);
+
+	TextLayer_SetCaretPos(layer, 1, 3);
+	TextLayer_TextDelete(layer, 20);
+	TextLayer_Update(layer, NULL);
+	it_i("row index should be correct after deleting rows",
+	     check_row_index(layer), 0);
+
+	TextLayer_SetCaretPos(layer, layer->text_rows.length - 1, 0);
+	TextLayer_TextBackspace(layer, 3);
+	TextLayer_Update(layer, NULL);
+	it_i("row index should be correct after backspacing",
+	     check_row_index(layer), 0);
+
+	TextLayer_SetCaretPos(layer, 0, 0);
+	TextLayer_InsertTextW(layer, long_row, NULL);
+	TextLayer_Update(layer, NULL);
+	width = TextLayer_GetWidth(layer);
+	it_i("width should be the one of the longest row", width,
+	     layer->text_rows.rows[0]->width);
+	TextLayer_SetCaretPos(layer, 0, 0);
+	TextLayer_TextDelete(layer, (int)wcslen(long_row));
+	TextLayer_Update(layer, NULL);
+	it_b("width should shrink after deleting the longest row",
+	     TextLayer_GetWidth(layer) < width, TRUE);
+	it_i("row index should be correct after deleting the longest row",
+	     check_row_index(layer), 0);
+
+	TextLayer_ClearText(layer);
+	TextLayer_Update(layer, NULL);
+	it_i("height should be zero after clearing text",
+	     TextLayer_GetHeight(layer), 0);
+	TextLayer_Destroy(layer);
+}
+
+/* the text layer flattened into characters and their styles */
+typedef struct text_model_t {
+	size_t length;
+	wchar_t codes[256];
+	LCUI_TextStyle styles[256];
+} text_model_t;
+
+static void get_text_model(LCUI_TextLayer layer, text_model_t *model)
+{
+	int row, col, run;
+	LCUI_TextRow txtrow;
+
+	model->length = 0;
+	for (row = 0; row < layer->text_rows.length; ++row) {
+		txtrow = layer->text_rows.rows[row];
+		for (col = 0, run = -1; col < txtrow->length; ++col) {
+			while (run + 1 < txtrow->styles_length &&
+			       txtrow->styles[run + 1].start <= col) {
+				++run;
+			}
+			model->codes[model->length] = txtrow->codes[col];
+			model->styles[model->length] =
+			    run < 0 ? NULL : txtrow->styles[run].style;
+			++model->length;
+		}
+		if (txtrow->eol != LCUI_EOL_NONE) {
+			model->codes[model->length] = '\n';
+			model->styles[model->length] = NULL;
+			++model->length;
+		}
+	}
+}
+
+static size_t get_model_pos(LCUI_TextLayer layer, int row, int col)
+{
+	int i;
+	size_t pos = col;
+
+	for (i = 0; i < row; ++i) {
+		pos += layer->text_rows.rows[i]->length;
+		if (layer->text_rows.rows[i]->eol != LCUI_EOL_NONE) {
+			++pos;
+		}
+	}
+	return pos;
+}
+
+static void text_model_delete(text_model_t *model, size_t pos, size_t n)
+{
+	n = min(n, model->length - pos);
+	memmove(model->codes + pos, model->codes + pos + n,
+		sizeof(wchar_t) * (model->length - pos - n));
+	memmove(model->styles + pos, model->styles + pos + n,
+		sizeof(LCUI_TextStyle) * (model->length - pos - n));
+	model->length -= n;
+}
+
+static void text_model_insert(text_model_t *model, size_t pos,
+			      const wchar_t *wstr)
 {
+	size_t n = wcslen(wstr);
+
+	memmove(model->codes + pos + n, model->codes + pos,
+		sizeof(wchar_t) * (model->length - pos));
+	memmove(model->styles + pos + n, model->styles + pos,
+		sizeof(LCUI_TextStyle) * (model->length - pos));
+	memcpy(model->codes + pos, wstr, sizeof(wchar_t) * n);
+	memset(model->styles + pos, 0, sizeof(LCUI_TextStyle) * n);
+	model->length += n;
+}
+
+/**
+ * Check whether the text layer has the same characters and styles as the
+ * model, and whether the style runs are well formed
+ */
+static LCUI_BOOL check_text_model(LCUI_TextLayer layer, text_model_t *model)
+{
+	int row, i;
+	text_model_t actual;
+	LCUI_TextRow txtrow;
+
+	for (row = 0; row < layer->text_rows.length; ++row) {
+		txtrow = layer->text_rows.rows[row];
+		if (txtrow->styles_length == 1 && !txtrow->styles[0].style) {
+			return FALSE;
+		}
+		for (i = 0; i < txtrow->styles_length; ++i) {
+			if ((i == 0 && txtrow->styles[i].start != 0) ||
+			    txtrow->styles[i].start >= txtrow->length) {
+				return FALSE;
+			}
+			if (i > 0 && (txtrow->styles[i].start <=
+					  txtrow->styles[i - 1].start ||
+				      txtrow->styles[i].style ==
+					  txtrow->styles[i - 1].style)) {
+				return FALSE;
+			}
+		}
+	}
+	get_text_model(layer, &actual);
+	return actual.length == model->length &&
+	       memcmp(actual.codes, model->codes,
+		      sizeof(wchar_t) * model->length) == 0 &&
+	       memcmp(actual.styles, model->styles,
+		      sizeof(LCUI_TextStyle) * model->length) == 0;
+}
+
+static void test_textlayer_style_runs(void)
+{
+	size_t pos;
+	text_model_t model;
 	LCUI_TextLayer layer;
 
 	layer = TextLayer_New();
+	TextLayer_SetMultiline(layer, TRUE);
+	TextLayer_EnableStyleTag(layer, TRUE);
 	TextLayer_SetTextW(layer,
-			   L"hello, world! "
-			   L"long long long texttexttext, test word break",
+			   L"ab[color=#f00]cd[/color]ef[color=#00f]gh[/color]\n"
+			   L"[color=#0f0]ijkl[/color]mn\n"
+			   L"op[color=#f00]qr[/color]",
 			   NULL);
-	TextLayer_SetFixedSize(layer, )
 	TextLayer_Update(layer, NULL);
+	get_text_model(layer, &model);
+	it_b("styled characters should have styles",
+	     model.styles[2] && model.styles[6] && model.styles[9], TRUE);
+	it_b("plain characters should have no style",
+	     !model.styles[0] && !model.styles[4] && !model.styles[13], TRUE);
+
+	TextLayer_SetCaretPos(layer, 0, 3);
+	TextLayer_TextDelete(layer, 2);
+	text_model_delete(&model, 3, 2);
+	it_b("deleting across style runs should keep styles",
+	     check_text_model(layer, &model), TRUE);
+
+	TextLayer_SetCaretPos(layer, 0, 2);
+	TextLayer_TextDelete(layer, 1);
+	text_model_delete(&model, 2, 1);
+	it_b("deleting a whole style run should merge its neighbors",
+	     check_text_model(layer, &model), TRUE);
+
+	pos = get_model_pos(layer, 1, 2);
+	TextLayer_SetCaretPos(layer, 1, 2);
+	TextLayer_InsertTextW(layer, L"xy\nz", NULL);
+	text_model_insert(&model, pos, L"xy\nz");
+	it_b("inserting into a style run should split it",
+	     check_text_model(layer, &model), TRUE);
+
+	pos = get_model_pos(layer, 1, 0);
+	TextLayer_SetCaretPos(layer, 1, 0);
+	TextLayer_TextBackspace(layer, 2);
+	text_model_delete(&model, pos - 2, 2);
+	it_b("backspacing across rows should keep styles",
+	     check_text_model(layer, &model), TRUE);
+
+	TextLayer_SetCaretPos(layer, 0, 1);
+	TextLayer_TextDelete(layer, 100);
+	text_model_delete(&model, 1, 100);
+	it_b("deleting to the end should keep styles",
+	     check_text_model(layer, &model), TRUE);
+	TextLayer_Destroy(layer);
+}
+
+static void test_textlayer_wordbreak(void)
+{
+	int row, overflow = 0;
+	LCUI_TextLayer layer;
+
+	layer = TextLayer_New();
+	TextLayer_SetMultiline(layer, TRUE);
+	TextLayer_SetAutoWrap(layer, TRUE);
+	TextLayer_SetWordBreak(layer, LCUI_WORD_BREAK_BREAK_ALL);
+	TextLayer_EnableStyleTag(layer, TRUE);
+	TextLayer_SetFixedSize(layer, LAYER_WIDTH, LAYER_HEIGHT);
+	TextLayer_SetTextW(layer, test_text, NULL);
+	TextLayer_Update(layer, NULL);
+	for (row = 0; row < layer->text_rows.length; ++row) {
+		if (layer->text_rows.rows[row]->width > LAYER_WIDTH) {
+			++overflow;
+		}
+	}
+	it_b("long rows should be wrapped", layer->text_rows.length > 7, TRUE);
+	it_i("rows should fit within the fixed width", overflow, 0);
+	it_i("row index should be correct after wrapping",
+	     check_row_index(layer), 0);
+	TextLayer_Destroy(layer);
+}
+
+/** 新建一个自动换行的文本层，每个段落都会被换成多行 */
+static LCUI_TextLayer create_wrapped_layer(const wchar_t *wstr)
+{
+	LCUI_TextLayer layer;
+
+	layer = TextLayer_New();
+	TextLayer_SetMultiline(layer, TRUE);
+	TextLayer_SetAutoWrap(layer, TRUE);
+	TextLayer_SetWordBreak(layer, LCUI_WORD_BREAK_BREAK_ALL);
+	TextLayer_SetFixedSize(layer, LAYER_WIDTH, 0);
+	TextLayer_SetTextW(layer, wstr, NULL);
+	TextLayer_Update(layer, NULL);
+	TextLayer_ClearInvalidRect(layer);
+	return layer;
+}
+
+/** Check whether the rows of two text layers are broken at the same places */
+static LCUI_BOOL check_same_rows(LCUI_TextLayer a, LCUI_TextLayer b)
+{
+	int row;
+
+	if (a->text_rows.length != b->text_rows.length) {
+		return FALSE;
+	}
+	for (row = 0; row < a->text_rows.length; ++row) {
+		if (a->text_rows.rows[row]->length !=
+			b->text_rows.rows[row]->length ||
+		    a->text_rows.rows[row]->eol != b->text_rows.rows[row]->eol) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** Get the bottom of the dirty rects, or -1 if there are no dirty rects */
+static int get_dirty_rects_bottom(LCUI_TextLayer layer)
+{
+	int bottom = -1;
+	LinkedList rects;
+	LinkedListNode *node;
+	LCUI_Rect *rect;
+
+	LinkedList_Init(&rects);
+	TextLayer_Update(layer, &rects);
+	for (LinkedList_Each(node, &rects)) {
+		rect = node->data;
+		bottom = max(bottom, rect->y + rect->height);
+	}
+	RectList_Clear(&rects);
+	return bottom;
+}
+
+static void test_textlayer_typeset(void)
+{
+	int i, row, bottom;
+	wchar_t wstr[1024];
+	size_t len = 0;
+	const wchar_t *para = L"the paragraph %d will be wrapped into rows\n";
+	LCUI_TextLayer layer, expected;
+
+	for (i = 0; i < 10; ++i) {
+		len += swprintf(wstr + len, 64, para, i);
+	}
+	layer = create_wrapped_layer(wstr);
+	for (row = 0; layer->text_rows.rows[row]->eol == LCUI_EOL_NONE; ++row)
+		;
+	/* 第一个段落的最后一行 */
+	bottom = get_row_y(layer, row + 1);
+
+	TextLayer_SetCaretPos(layer, 0, 4);
+	TextLayer_InsertTextW(layer, L"xyz", NULL);
+	wmemmove(wstr + 7, wstr + 4, len - 4 + 1);
+	wmemcpy(wstr + 4, L"xyz", 3);
+	it_b("dirty rects should be within the edited paragraph",
+	     get_dirty_rects_bottom(layer) <= bottom, TRUE);
+	expected = create_wrapped_layer(wstr);
+	it_b("rows should be the same as the full typesetting after inserting",
+	     check_same_rows(layer, expected), TRUE);
+	TextLayer_Destroy(expected);
+
+	TextLayer_SetCaretPos(layer, 0, 4);
+	TextLayer_InsertTextW(layer, L" and it will have more rows than before",
+			      NULL);
+	TextLayer_Update(layer, NULL);
+	TextLayer_SetCaretPos(layer, 0, 4);
+	TextLayer_TextDelete(layer, 39);
+	it_b("dirty rects should cover the rows moved by the paragraph",
+	     get_dirty_rects_bottom(layer) >= TextLayer_GetHeight(layer),
+	     TRUE);
+	expected = create_wrapped_layer(wstr);
+	it_b("rows should be the same as the full typesetting after deleting",
+	     check_same_rows(layer, expected), TRUE);
+	it_i("row index should be correct after typesetting",
+	     check_row_index(layer), 0);
+	TextLayer_Destroy(expected);
+	TextLayer_Destroy(layer);
+
+	/* 第二行有空余的宽度，在这行插入一个字符不会改变其它行 */
+	len = 0;
+	for (i = 0; i < 20; ++i) {
+		len += swprintf(wstr + len, 64, L"word%d ", i);
+	}
+	layer = create_wrapped_layer(wstr);
+	TextLayer_SetWordBreak(layer, LCUI_WORD_BREAK_NORMAL);
+	TextLayer_Update(layer, NULL);
+	TextLayer_ClearInvalidRect(layer);
+	bottom = get_row_y(layer, 2);
+	row = layer->text_rows.length;
+	TextLayer_SetCaretPos(layer, 1, 0);
+	TextLayer_InsertTextW(layer, L"a", NULL);
+	it_i("inserting a char should not change the number of rows",
+	     layer->text_rows.length, row);
+	it_b("dirty rects should only cover the edited row",
+	     get_dirty_rects_bottom(layer) <= bottom, TRUE);
+	TextLayer_Destroy(layer);
 }
 
-int test_textlayer(void)
+void test_textlayer(void)
 {
-	return test_textlayer_wordbreak();
+	LCUI_Init();
+	describe("check textlayer row index", test_textlayer_row_index);
+	describe("check textlayer style runs", test_textlayer_style_runs);
+	describe("check textlayer word break", test_textlayer_wordbreak);
+	describe("check textlayer typeset", test_textlayer_typeset);
+	LCUI_Destroy();
 }
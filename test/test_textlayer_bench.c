@@ -0,0 +1,150 @@
+/*
+ * Scroll through a long document in a text layer, the time of each step
+ * should not grow with the number of rows:
+ *
+ *   test_textlayer_bench [number of rows]
+ *
+ * The heap usage of the text is also reported when built with glibc, and
+ * the time of typing near the beginning of the wrapped document should not
+ * grow with the number of rows after the caret.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <wchar.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/font.h>
+
+#define VIEW_WIDTH 800
+#define VIEW_HEIGHT 600
+#define DEFAULT_ROWS 100000
+#define SCROLL_STEPS 2000
+#define HIT_TESTS 10
+#define KEYSTROKES 100
+
+static size_t get_heap_usage(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	return mallinfo2().uordblks;
+#else
+	return 0;
+#endif
+}
+
+static wchar_t *make_document(int rows)
+{
+	int i;
+	size_t len = 0;
+	wchar_t *wstr = malloc(sizeof(wchar_t) * ((size_t)rows * 64 + 1));
+
+	for (i = 0; i < rows; ++i) {
+		len += swprintf(wstr + len, 64, L"%d: the quick brown fox %ls\n",
+				i, i % 10 == 0 ? L"jumps over the lazy dog" : L"");
+	}
+	wstr[len] = 0;
+	return wstr;
+}
+
+int main(int argc, char **argv)
+{
+	int i, j, y, step, rows = DEFAULT_ROWS;
+	int64_t t, t_render = 0, t_query = 0;
+	size_t heap_usage;
+	wchar_t *wstr;
+	LCUI_Pos pos = { 0, 0 }, caret;
+	LCUI_Graph canvas;
+	LCUI_Rect area = { 0, 0, VIEW_WIDTH, VIEW_HEIGHT };
+	LCUI_TextLayer layer;
+
+	if (argc > 1) {
+		rows = atoi(argv[1]);
+	}
+	LCUI_InitFontLibrary();
+	wstr = make_document(rows);
+	layer = TextLayer_New();
+	TextLayer_SetMultiline(layer, TRUE);
+	TextLayer_SetMaxSize(layer, VIEW_WIDTH, VIEW_HEIGHT);
+
+	heap_usage = get_heap_usage();
+	t = LCUI_GetTime();
+	TextLayer_SetTextW(layer, wstr, NULL);
+	TextLayer_Update(layer, NULL);
+	t = LCUI_GetTimeDelta(t);
+	heap_usage = get_heap_usage() - heap_usage;
+	Logger_Info("%d rows loaded in %ldms, size: %dx%d\n",
+		    layer->text_rows.length, (long)t, TextLayer_GetWidth(layer),
+		    TextLayer_GetHeight(layer));
+	if (heap_usage > 0) {
+		Logger_Info("%lu chars use %.1fMB, %.1f bytes per char\n",
+			    (unsigned long)layer->length,
+			    heap_usage / 1048576.0,
+			    heap_usage * 1.0 / layer->length);
+	}
+
+	Graph_Init(&canvas);
+	canvas.color_type = LCUI_COLOR_TYPE_ARGB;
+	Graph_Create(&canvas, VIEW_WIDTH, VIEW_HEIGHT);
+	step = TextLayer_GetHeight(layer) / SCROLL_STEPS;
+	for (i = 0, y = 0; i < SCROLL_STEPS; ++i, y += step) {
+		t = LCUI_GetTime();
+		TextLayer_SetOffset(layer, 0, -y);
+		TextLayer_Update(layer, NULL);
+		TextLayer_ClearInvalidRect(layer);
+		Graph_FillRect(&canvas, ARGB(0, 0, 0, 0), NULL, TRUE);
+		TextLayer_RenderTo(layer, area, pos, &canvas);
+		t_render += LCUI_GetTimeDelta(t);
+
+		t = LCUI_GetTime();
+		for (j = 0; j < HIT_TESTS; ++j) {
+			TextLayer_GetWidth(layer);
+			TextLayer_GetHeight(layer);
+			TextLayer_SetCaretPosByPixelPos(
+			    layer, 0, j * VIEW_HEIGHT / HIT_TESTS);
+			TextLayer_GetCaretPixelPos(layer, &caret);
+		}
+		t_query += LCUI_GetTimeDelta(t);
+	}
+	Logger_Info("%d scroll steps: %ldms rendering, %ldms for %d queries\n",
+		    SCROLL_STEPS, (long)t_render, (long)t_query,
+		    SCROLL_STEPS * HIT_TESTS * 4);
+
+	t = LCUI_GetTime();
+	for (i = 0; i < 100; ++i) {
+		TextLayer_SetCaretPos(layer, layer->text_rows.length / 2, 0);
+		TextLayer_InsertTextW(layer, L"inserted row\n", NULL);
+		TextLayer_Update(layer, NULL);
+		TextLayer_GetHeight(layer);
+		TextLayer_ClearInvalidRect(layer);
+	}
+	Logger_Info("100 rows inserted in the middle in %ldms\n",
+		    (long)LCUI_GetTimeDelta(t));
+
+	t = LCUI_GetTime();
+	TextLayer_SetAutoWrap(layer, TRUE);
+	TextLayer_SetMaxSize(layer, VIEW_WIDTH / 4, VIEW_HEIGHT);
+	TextLayer_Update(layer, NULL);
+	TextLayer_ClearInvalidRect(layer);
+	Logger_Info("wrapped into %d rows in %ldms\n", layer->text_rows.length,
+		    (long)LCUI_GetTimeDelta(t));
+
+	t = LCUI_GetTime();
+	TextLayer_SetCaretPos(layer, 1, 0);
+	for (i = 0; i < KEYSTROKES; ++i) {
+		TextLayer_InsertTextW(layer, L"x", NULL);
+		TextLayer_Update(layer, NULL);
+		TextLayer_ClearInvalidRect(layer);
+	}
+	Logger_Info("%d keystrokes typed in %ldms\n", KEYSTROKES,
+		    (long)LCUI_GetTimeDelta(t));
+
+	Graph_Free(&canvas);
+	TextLayer_Destroy(layer);
+	LCUI_FreeFontLibrary();
+	free(wstr);
+	return 0;
+}
@@ -0,0 +1,306 @@
+#define LCUI_SURFACE_C
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/gui/widget.h>
+#include <LCUI/gui/widget/textview.h>
+#include <LCUI/gui/css_parser.h>
+#include <LCUI/display.h>
+#include <LCUI/settings.h>
+#include <LCUI/painter.h>
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_FRAMES 60
+#define BENCH_COLS 16
+#define BENCH_ROWS 12
+
+/* clang-format off */
+
+static const char *css = CodeToString(
+
+.card {
+	position: absolute;
+	width: 110px;
+	height: 80px;
+	padding: 8px;
+	border: 1px solid #ccc;
+	border-radius: 4px;
+	box-shadow: 0 2px 4px rgba(0,0,0,0.3);
+	background-color: rgba(255,255,255,0.9);
+}
+
+);
+
+/* clang-format on */
+
+/* A display driver that renders into memory */
+
+struct LCUI_SurfaceRec_ {
+	LCUI_Graph fb;
+};
+
+static LCUI_Surface bench_create(void)
+{
+	LCUI_Surface surface = NEW(struct LCUI_SurfaceRec_, 1);
+
+	Graph_Init(&surface->fb);
+	surface->fb.color_type = LCUI_COLOR_TYPE_ARGB;
+	return surface;
+}
+
+static void bench_destroy(LCUI_Surface surface)
+{
+	Graph_Free(&surface->fb);
+	free(surface);
+}
+
+static void bench_resize(LCUI_Surface surface, int width, int height)
+{
+	Graph_Create(&surface->fb, width, height);
+}
+
+static LCUI_BOOL bench_is_ready(LCUI_Surface surface)
+{
+	return Graph_IsValid(&surface->fb);
+}
+
+static LCUI_PaintContext bench_begin_paint(LCUI_Surface surface,
+					   LCUI_Rect *rect)
+{
+	LCUI_PaintContext paint = LCUIPainter_Begin(&surface->fb, rect);
+
+	Graph_FillRect(&paint->canvas, RGB(255, 255, 255), NULL, TRUE);
+	return paint;
+}
+
+static void bench_end_paint(LCUI_Surface surface, LCUI_PaintContext paint)
+{
+	LCUIPainter_End(paint);
+}
+
+static size_t bench_present_rects(LCUI_Surface surface, const LCUI_Rect *rects,
+				  size_t n_rects)
+{
+	size_t i, bytes = 0;
+
+	for (i = 0; i < n_rects; ++i) {
+		bytes += rects[i].width * rects[i].height * sizeof(LCUI_ARGB);
+	}
+	return bytes;
+}
+
+static int bench_get_width(void)
+{
+	return BENCH_WIDTH;
+}
+
+static int bench_get_height(void)
+{
+	return BENCH_HEIGHT;
+}
+
+static int bench_get_surface_width(LCUI_Surface surface)
+{
+	return surface->fb.width;
+}
+
+static int bench_get_surface_height(LCUI_Surface surface)
+{
+	return surface->fb.height;
+}
+
+static int bench_bind_event(int type, LCUI_EventFunc func, void *data,
+			    void (*destroy_data)(void *))
+{
+	return 0;
+}
+
+static void bench_nop(LCUI_Surface surface)
+{
+}
+
+static void bench_move(LCUI_Surface surface, int x, int y)
+{
+}
+
+static void bench_set_caption(LCUI_Surface surface, const wchar_t *str)
+{
+}
+
+static void bench_set_render_mode(LCUI_Surface surface, int mode)
+{
+}
+
+static void *bench_get_handle(LCUI_Surface surface)
+{
+	return NULL;
+}
+
+static void bench_set_opacity(LCUI_Surface surface, float opacity)
+{
+}
+
+static void init_driver(LCUI_DisplayDriver driver)
+{
+	strcpy(driver->name, "memory");
+	driver->getWidth = bench_get_width;
+	driver->getHeight = bench_get_height;
+	driver->create = bench_create;
+	driver->destroy = bench_destroy;
+	driver->close = bench_nop;
+	driver->resize = bench_resize;
+	driver->move = bench_move;
+	driver->show = bench_nop;
+	driver->hide = bench_nop;
+	driver->update = bench_nop;
+	driver->present = bench_nop;
+	driver->presentRects = bench_present_rects;
+	driver->isReady = bench_is_ready;
+	driver->beginPaint = bench_begin_paint;
+	driver->endPaint = bench_end_paint;
+	driver->setCaptionW = bench_set_caption;
+	driver->setRenderMode = bench_set_render_mode;
+	driver->getHandle = bench_get_handle;
+	driver->getSurfaceWidth = bench_get_surface_width;
+	driver->getSurfaceHeight = bench_get_surface_height;
+	driver->setOpacity = bench_set_opacity;
+	driver->bindEvent = bench_bind_event;
+}
+
+/* Dirty patterns */
+
+typedef void (*pattern_func_t)(int frame);
+
+static void invalidate(int x, int y, int width, int height)
+{
+	LCUI_Rect rect;
+
+	rect.x = x;
+	rect.y = y;
+	rect.width = width;
+	rect.height = height;
+	LCUIDisplay_InvalidateArea(&rect);
+}
+
+static void pattern_full_screen(int frame)
+{
+	invalidate(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+}
+
+static void pattern_scattered(int frame)
+{
+	int i;
+
+	for (i = 0; i < 40; ++i) {
+		invalidate(rand() % (BENCH_WIDTH - 48),
+			   rand() % (BENCH_HEIGHT - 32), 48, 32);
+	}
+}
+
+static void pattern_busy_region(int frame)
+{
+	invalidate(40, 40 + frame % 8, 640, 360);
+}
+
+static void pattern_cursor(int frame)
+{
+	invalidate(frame * 7 % BENCH_WIDTH, frame * 5 % BENCH_HEIGHT, 16, 24);
+}
+
+static struct {
+	const char *name;
+	pattern_func_t func;
+} patterns[] = { { "full screen", pattern_full_screen },
+		 { "scattered", pattern_scattered },
+		 { "busy region", pattern_busy_region },
+		 { "cursor", pattern_cursor } };
+
+static void build_widgets(void)
+{
+	int x, y;
+	char str[64];
+	LCUI_Widget w, text;
+	LCUI_Widget root = LCUIWidget_GetRoot();
+
+	LCUI_LoadCSSString(css, __FILE__);
+	Widget_SetStyleString(root, "background-color", "#f0f0f0");
+	for (y = 0; y < BENCH_ROWS; ++y) {
+		for (x = 0; x < BENCH_COLS; ++x) {
+			w = LCUIWidget_New(NULL);
+			text = LCUIWidget_New("textview");
+			Widget_AddClass(w, "card");
+			Widget_SetStyle(w, key_left, x * 120.0f, px);
+			Widget_SetStyle(w, key_top, y * 90.0f, px);
+			sprintf(str, "card %d, %d", x, y);
+			TextView_SetText(text, str);
+			Widget_Append(w, text);
+			Widget_Append(root, w);
+		}
+	}
+	LCUIWidget_Update();
+	LCUIDisplay_Update();
+	LCUIDisplay_Render();
+}
+
+static int bench_threads = 4;
+static size_t bench_present_bytes;
+
+static int64_t bench(LCUI_ParallelRenderingMode mode, pattern_func_t func)
+{
+	int i;
+	int64_t t;
+	LCUI_SettingsRec settings;
+
+	Settings_Init(&settings);
+	settings.parallel_rendering_mode = mode;
+	settings.parallel_rendering_threads = bench_threads;
+	LCUI_ApplySettings(&settings);
+	srand(42);
+	bench_present_bytes = 0;
+	t = LCUI_GetTime();
+	for (i = 0; i < BENCH_FRAMES; ++i) {
+		func(i);
+		LCUIDisplay_Update();
+		LCUIDisplay_Render();
+		bench_present_bytes += LCUIDisplay_Present();
+	}
+	return LCUI_GetTimeDelta(t);
+}
+
+int main(int argc, char **argv)
+{
+	size_t i;
+	char s_strips[32], s_tiles[32], s_present[32];
+	LCUI_DisplayDriverRec driver = { 0 };
+
+	if (argc > 1) {
+		bench_threads = atoi(argv[1]);
+	}
+	init_driver(&driver);
+	LCUI_InitBase();
+	LCUI_ResetSettings();
+	LCUI_InitDisplay(&driver);
+	LCUIDisplay_SetSize(BENCH_WIDTH, BENCH_HEIGHT);
+	build_widgets();
+	Logger_Info("%d frames of %dx%d, %d threads\n", BENCH_FRAMES,
+		    BENCH_WIDTH, BENCH_HEIGHT, bench_threads);
+	Logger_Info("%-14s%-14s%-14s%-14s\n", "pattern", "strips", "tiles",
+		    "present");
+	for (i = 0; i < sizeof(patterns) / sizeof(patterns[0]); ++i) {
+		sprintf(s_strips, "%ldms",
+			(long)bench(LCUI_PARALLEL_RENDERING_STRIPS,
+				    patterns[i].func));
+		sprintf(s_tiles, "%ldms",
+			(long)bench(LCUI_PARALLEL_RENDERING_TILES,
+				    patterns[i].func));
+		sprintf(s_present, "%luKB/frame",
+			(unsigned long)(bench_present_bytes / BENCH_FRAMES /
+					1024));
+		Logger_Info("%-14s%-14s%-14s%-14s\n", patterns[i].name,
+			    s_strips, s_tiles, s_present);
+	}
+	return 0;
+}
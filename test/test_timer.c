@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/timer.h>
+#include "test.h"
+#include "libtest.h"
+
+static struct {
+	char order[16];
+	size_t length;
+	int interval_id;
+	int interval_count;
+} self;
+
+static void OnTimer(void *arg)
+{
+	self.order[self.length++] = *(char *)arg;
+	self.order[self.length] = 0;
+}
+
+static void OnInterval(void *arg)
+{
+	self.interval_count += 1;
+	if (self.interval_count >= 3) {
+		LCUITimer_Free(self.interval_id);
+	}
+}
+
+static void OnZeroInterval(void *arg)
+{
+	self.interval_count += 1;
+}
+
+static void wait_timers(long int ms)
+{
+	LCUI_MSleep(ms);
+	LCUI_ProcessTimers();
+}
+
+static void test_timer_order(void)
+{
+	self.length = 0;
+	self.order[0] = 0;
+	LCUI_SetTimeout(30, OnTimer, "c");
+	LCUI_SetTimeout(10, OnTimer, "a");
+	LCUI_SetTimeout(20, OnTimer, "b");
+	LCUI_SetTimeout(10, OnTimer, "A");
+	it_b("the next timer should expire within 10ms",
+	     LCUI_GetNextTimerDelay() <= 10, TRUE);
+	wait_timers(50);
+	it_s("timers should be called in the order of expiration", self.order,
+	     "aAbc");
+	it_i("there should be no timer left", (int)LCUI_GetNextTimerDelay(),
+	     -1);
+}
+
+static void test_timer_control(void)
+{
+	int a, b, c;
+
+	self.length = 0;
+	self.order[0] = 0;
+	a = LCUI_SetTimeout(20, OnTimer, "a");
+	b = LCUI_SetTimeout(40, OnTimer, "b");
+	c = LCUI_SetTimeout(60, OnTimer, "c");
+	it_i("free the timer", LCUITimer_Free(b), 0);
+	it_i("free the timer again", LCUITimer_Free(b), -1);
+	it_i("pause the timer", LCUITimer_Pause(a), 0);
+	it_i("reset the timer", LCUITimer_Reset(c, 10), 0);
+	wait_timers(30);
+	it_s("the reset timer should be called earlier", self.order, "c");
+	it_i("continue the timer", LCUITimer_Continue(a), 0);
+	it_b("the paused time should not be counted",
+	     LCUI_GetNextTimerDelay() > 10, TRUE);
+	wait_timers(30);
+	it_s("the continued timer should be called", self.order, "ca");
+	it_i("the called timer should be released", LCUITimer_Free(a), -1);
+
+	self.interval_count = 0;
+	self.interval_id = LCUI_SetInterval(1, OnInterval, NULL);
+	wait_timers(2);
+	wait_timers(2);
+	wait_timers(2);
+	wait_timers(2);
+	it_i("the interval timer should be freed in its callback",
+	     self.interval_count, 3);
+	it_i("the freed interval timer should not exist",
+	     LCUITimer_Free(self.interval_id), -1);
+
+	self.interval_count = 0;
+	self.interval_id = LCUI_SetInterval(0, OnZeroInterval, NULL);
+	it_i("the zero interval timer should be called once per processing",
+	     (int)LCUI_ProcessTimers(), 1);
+	it_i("check the count of calls", self.interval_count, 1);
+	wait_timers(2);
+	it_i("the zero interval timer should be called again",
+	     self.interval_count, 2);
+	LCUITimer_Free(self.interval_id);
+}
+
+void test_timer(void)
+{
+	LCUI_InitTimer();
+	describe("check timer order", test_timer_order);
+	describe("check timer control", test_timer_control);
+	LCUI_FreeTimer();
+}
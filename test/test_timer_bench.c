@@ -0,0 +1,84 @@
+/*
+ * Set, reset, pause and free thousands of timers, the time of each
+ * operation should not grow with the number of timers:
+ *
+ *   test_timer_bench [number of timers]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/timer.h>
+
+#define DEFAULT_TIMERS 10000
+#define MAX_DELAY 200
+
+static size_t fired_count = 0;
+
+static void OnTimer(void *arg)
+{
+	++fired_count;
+}
+
+int main(int argc, char **argv)
+{
+	int i, n = DEFAULT_TIMERS;
+	int *ids;
+	int64_t t;
+	clock_t c;
+
+	if (argc > 1) {
+		n = atoi(argv[1]);
+	}
+	ids = malloc(sizeof(int) * n);
+	LCUI_InitTimer();
+	srand(1);
+
+	t = LCUI_GetTime();
+	for (i = 0; i < n; ++i) {
+		ids[i] = LCUI_SetTimeout(rand() % MAX_DELAY, OnTimer, NULL);
+	}
+	Logger_Info("%d timers set in %ldms\n", n, (long)LCUI_GetTimeDelta(t));
+
+	/* the caret blinks and per-row timeouts are restarted constantly */
+	t = LCUI_GetTime();
+	for (i = 0; i < n; ++i) {
+		LCUITimer_Reset(ids[rand() % n], rand() % MAX_DELAY);
+	}
+	Logger_Info("%d timers reset in %ldms\n", n,
+		    (long)LCUI_GetTimeDelta(t));
+
+	t = LCUI_GetTime();
+	for (i = 0; i < n; i += 2) {
+		LCUITimer_Pause(ids[i]);
+	}
+	for (i = 0; i < n; i += 2) {
+		LCUITimer_Continue(ids[i]);
+	}
+	Logger_Info("%d timers paused and continued in %ldms\n", n / 2,
+		    (long)LCUI_GetTimeDelta(t));
+
+	t = LCUI_GetTime();
+	for (i = 0; i < n; i += 4) {
+		LCUITimer_Free(ids[i]);
+	}
+	Logger_Info("%d timers freed in %ldms\n", (n + 3) / 4,
+		    (long)LCUI_GetTimeDelta(t));
+
+	/* the sleeping time is not counted in the processor time */
+	c = clock();
+	while (LCUI_GetNextTimerDelay() >= 0) {
+		LCUI_ProcessTimers();
+		LCUI_MSleep(1);
+	}
+	c = clock() - c;
+	Logger_Info("%lu timers fired, %ldms processor time\n",
+		    (unsigned long)fired_count,
+		    (long)(c * 1000 / CLOCKS_PER_SEC));
+
+	LCUI_FreeTimer();
+	free(ids);
+	return 0;
+}
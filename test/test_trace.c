@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/thread.h>
+#include <LCUI/settings.h>
+#include <LCUI/display.h>
+#include <LCUI/gui/widget.h>
+#include <LCUI/util/trace.h>
+#include "test.h"
+#include "libtest.h"
+
+#define TRACE_FILE "test_trace.json"
+#define TRACE_FRAMES 5
+#define MAX_SPANS 1024
+
+typedef struct SpanRec_ {
+	char name[32];
+	int tid;
+	long long ts;
+	long long dur;
+} SpanRec, *Span;
+
+static void trace_thread(void *arg)
+{
+	LCUITrace_SetThreadName("test worker");
+	LCUITrace_Begin("test", "worker span", "a \"quoted\" detail");
+	LCUITrace_End();
+	LCUIThread_Exit(NULL);
+}
+
+static char *read_file(const char *path)
+{
+	long size;
+	char *str;
+	FILE *fp = fopen(path, "rb");
+
+	if (!fp) {
+		return NULL;
+	}
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	str = calloc(size + 1, 1);
+	if (fread(str, 1, size, fp) != (size_t)size) {
+		str[0] = 0;
+	}
+	fclose(fp);
+	return str;
+}
+
+static int count_str(const char *str, const char *substr)
+{
+	int count = 0;
+
+	while ((str = strstr(str, substr))) {
+		count += 1;
+		str += strlen(substr);
+	}
+	return count;
+}
+
+/* parse the complete events of a trace file, return the number of spans */
+static int parse_spans(const char *json, Span spans, int max_spans)
+{
+	int n = 0;
+	size_t len;
+	const char *p, *end, *ph;
+	const char *fmt = "\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,"
+			  "\"dur\":%lld";
+
+	for (p = json; n < max_spans && (p = strstr(p, "{\"name\":\""));) {
+		p += 9;
+		end = strchr(p, '"');
+		ph = strstr(p, "\"ph\":");
+		if (!end || !ph || sscanf(ph, fmt, &spans[n].tid,
+					  &spans[n].ts, &spans[n].dur) != 3) {
+			continue;
+		}
+		len = end - p;
+		if (len >= sizeof(spans[n].name)) {
+			len = sizeof(spans[n].name) - 1;
+		}
+		strncpy(spans[n].name, p, len);
+		spans[n].name[len] = 0;
+		n += 1;
+	}
+	return n;
+}
+
+static LCUI_BOOL span_contains(Span outer, Span inner)
+{
+	return outer->ts <= inner->ts &&
+	       inner->ts + inner->dur <= outer->ts + outer->dur;
+}
+
+static LCUI_BOOL span_overlaps(Span a, Span b)
+{
+	return a->ts < b->ts + b->dur && b->ts < a->ts + a->dur;
+}
+
+static int count_spans(Span spans, int n, const char *name)
+{
+	int i, count = 0;
+
+	for (i = 0; i < n; ++i) {
+		if (strcmp(spans[i].name, name) == 0) {
+			count += 1;
+		}
+	}
+	return count;
+}
+
+/* check if each span with the given name is inside a span of the parent */
+static LCUI_BOOL check_parent(Span spans, int n, const char *name,
+			      const char *parent)
+{
+	int i, j;
+
+	for (i = 0; i < n; ++i) {
+		if (strcmp(spans[i].name, name) != 0) {
+			continue;
+		}
+		for (j = 0; j < n; ++j) {
+			if (strcmp(spans[j].name, parent) == 0 &&
+			    span_contains(&spans[j], &spans[i])) {
+				break;
+			}
+		}
+		if (j >= n) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/* spans on the same thread should be nested or disjoint */
+static LCUI_BOOL check_nesting(Span spans, int n)
+{
+	int i, j;
+
+	for (i = 0; i < n; ++i) {
+		for (j = i + 1; j < n; ++j) {
+			if (spans[i].tid != spans[j].tid ||
+			    !span_overlaps(&spans[i], &spans[j])) {
+				continue;
+			}
+			if (!span_contains(&spans[i], &spans[j]) &&
+			    !span_contains(&spans[j], &spans[i])) {
+				return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+static void test_trace_spans(void)
+{
+	int i;
+	char *json;
+	LCUI_Thread tid;
+
+	LCUITrace_Enable(FALSE);
+	LCUITrace_Begin("test", "disabled span", NULL);
+	LCUITrace_End();
+	LCUITrace_Enable(TRUE);
+	LCUITrace_Clear();
+	LCUITrace_Begin("test", "outer span", NULL);
+	LCUITrace_Begin("test", "inner span", "detail");
+	LCUITrace_End();
+	LCUITrace_End();
+	/* unbalanced end should be ignored */
+	LCUITrace_End();
+	LCUIThread_Create(&tid, trace_thread, NULL);
+	LCUIThread_Join(tid, NULL);
+	it_i("check dumped spans", LCUITrace_DumpFile(TRACE_FILE), 3);
+	json = read_file(TRACE_FILE);
+	it_b("check trace file", json != NULL, TRUE);
+	if (!json) {
+		return;
+	}
+	it_b("check trace event header",
+	     strncmp(json, "{\"traceEvents\":[", 16) == 0, TRUE);
+	it_i("check complete events", count_str(json, "\"ph\":\"X\""), 3);
+	it_b("check disabled span", strstr(json, "disabled span") == NULL,
+	     TRUE);
+	it_b("check main thread name", strstr(json, "\"main\"") != NULL,
+	     TRUE);
+	it_b("check worker thread name",
+	     strstr(json, "\"test worker\"") != NULL, TRUE);
+	it_b("check escaped detail",
+	     strstr(json, "\"a \\\"quoted\\\" detail\"") != NULL, TRUE);
+	free(json);
+	remove(TRACE_FILE);
+
+	for (i = 0; i < LCUI_TRACE_BUFFER_SIZE + 100; ++i) {
+		LCUITrace_Begin("test", "span", NULL);
+		LCUITrace_End();
+	}
+	/* the oldest spans are overwritten, the worker span is kept */
+	it_i("check ring buffer overflow", LCUITrace_DumpFile(TRACE_FILE),
+	     LCUI_TRACE_BUFFER_SIZE + 1);
+	LCUITrace_Clear();
+	it_i("check LCUITrace_Clear", LCUITrace_DumpFile(TRACE_FILE), 0);
+	remove(TRACE_FILE);
+	LCUITrace_Enable(FALSE);
+}
+
+static void test_trace_frames(void)
+{
+	char *json;
+	LCUI_SettingsRec settings;
+
+	Settings_Init(&settings);
+	settings.trace_frames = TRUE;
+	LCUI_ApplySettings(&settings);
+	it_b("check trace_frames setting", LCUITrace_IsEnabled(), TRUE);
+	LCUITrace_Clear();
+	LCUI_RunFrame();
+	LCUITrace_DumpFile(TRACE_FILE);
+	json = read_file(TRACE_FILE);
+	it_b("check frame span", json && strstr(json, "\"frame\"") != NULL,
+	     TRUE);
+	it_b("check widget update span",
+	     json && strstr(json, "\"widget update\"") != NULL, TRUE);
+	it_b("check present span", json && strstr(json, "\"present\"") != NULL,
+	     TRUE);
+	free(json);
+	remove(TRACE_FILE);
+	LCUI_ResetSettings();
+	it_b("check disabling trace_frames", LCUITrace_IsEnabled(), FALSE);
+}
+
+static void test_trace_render_spans(void)
+{
+	int i, n;
+	char *json;
+	Span spans;
+	LCUI_Widget box;
+	LCUI_SettingsRec settings;
+
+	Settings_Init(&settings);
+	settings.trace_frames = TRUE;
+	LCUI_ApplySettings(&settings);
+	LCUIDisplay_SetMode(LCUI_DMODE_WINDOWED);
+	LCUIDisplay_SetSize(320, 240);
+	box = LCUIWidget_New(NULL);
+	Widget_SetStyleString(box, "width", "100px");
+	Widget_SetStyleString(box, "height", "100px");
+	Widget_Append(LCUIWidget_GetRoot(), box);
+	LCUI_RunFrame();
+	LCUITrace_Clear();
+	for (i = 0; i < TRACE_FRAMES; ++i) {
+		Widget_SetStyleString(box, "background-color",
+				      i % 2 ? "#f00" : "#00f");
+		LCUI_RunFrame();
+	}
+	LCUITrace_DumpFile(TRACE_FILE);
+	json = read_file(TRACE_FILE);
+	spans = malloc(sizeof(SpanRec) * MAX_SPANS);
+	n = json ? parse_spans(json, spans, MAX_SPANS) : 0;
+	it_i("check frame spans", count_spans(spans, n, "frame"),
+	     TRACE_FRAMES);
+	it_i("check render spans", count_spans(spans, n, "render"),
+	     TRACE_FRAMES);
+	it_b("check render rect spans",
+	     count_spans(spans, n, "render rect") >= TRACE_FRAMES, TRUE);
+	it_b("check spans are nested", check_nesting(spans, n), TRUE);
+	it_b("check render rect spans are inside render spans",
+	     check_parent(spans, n, "render rect", "render"), TRUE);
+	it_b("check render spans are inside frame spans",
+	     check_parent(spans, n, "render", "frame"), TRUE);
+	free(spans);
+	free(json);
+	remove(TRACE_FILE);
+	Widget_Destroy(box);
+	LCUI_RunFrame();
+	LCUI_ResetSettings();
+}
+
+void test_trace(void)
+{
+	LCUI_Init();
+	describe("test trace spans", test_trace_spans);
+	describe("test trace frames", test_trace_frames);
+	LCUI_Destroy();
+
+	LCUI_InitBase();
+	LCUI_InitDisplay(LCUI_CreateHeadlessDisplayDriver());
+	LCUI_Init();
+	describe("test trace render spans", test_trace_render_spans);
+	LCUI_Destroy();
+}
@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/graph.h>
+#include <LCUI/settings.h>
+#include <LCUI/thread.h>
+#include <LCUI/gui/widget.h>
+#include "test.h"
+#include "libtest.h"
+
+#define CANVAS_WIDTH 200
+#define CANVAS_HEIGHT 150
+#define RENDER_THREADS 4
+
+static LCUI_Widget create_widget(const char *size)
+{
+	LCUI_Widget w = LCUIWidget_New(NULL);
+
+	Widget_SetStyleString(w, "position", "absolute");
+	Widget_SetStyleString(w, "width", "200px");
+	Widget_SetStyleString(w, "height", "150px");
+	Widget_SetStyleString(w, "background-color", "#fff");
+	Widget_SetStyleString(w, "background-image",
+			      "url(test_image_reader.png)");
+	Widget_SetStyleString(w, "background-size", size);
+	Widget_Append(LCUIWidget_GetRoot(), w);
+	return w;
+}
+
+static LCUI_BOOL wait_image_width(LCUI_Widget w, int width)
+{
+	int i;
+	LCUI_Graph *image = &w->computed_style.background.image;
+
+	for (i = 0; i < 200; ++i) {
+		LCUI_ProcessEvents();
+		LCUIWidget_Update();
+		if (Graph_IsValid(image) && (width == 0 || image->width == width)) {
+			return TRUE;
+		}
+		LCUI_MSleep(10);
+	}
+	return FALSE;
+}
+
+static LCUI_BOOL wait_image(LCUI_Widget w)
+{
+	return wait_image_width(w, 0);
+}
+
+static void render(LCUI_Widget w, LCUI_ImageCacheProfile profile)
+{
+	LCUI_Graph canvas;
+	LCUI_PaintContextRec paint;
+	LCUI_Rect rect = { 0, 0, CANVAS_WIDTH, CANVAS_HEIGHT };
+
+	LCUIWidget_Update();
+	LCUIWidget_GetScaledImageCacheProfile(profile);
+	Graph_Init(&canvas);
+	Graph_Create(&canvas, CANVAS_WIDTH, CANVAS_HEIGHT);
+	paint.with_alpha = FALSE;
+	paint.rect = rect;
+	Graph_Quote(&paint.canvas, &canvas, &rect);
+	Widget_Render(w, &paint);
+	Graph_Free(&canvas);
+	LCUIWidget_GetScaledImageCacheProfile(profile);
+}
+
+static void render_thread(void *arg)
+{
+	LCUI_Graph canvas;
+	LCUI_PaintContextRec paint;
+	LCUI_Rect rect = { 0, 0, CANVAS_WIDTH, CANVAS_HEIGHT };
+
+	Graph_Init(&canvas);
+	Graph_Create(&canvas, CANVAS_WIDTH, CANVAS_HEIGHT);
+	paint.with_alpha = FALSE;
+	paint.rect = rect;
+	Graph_Quote(&paint.canvas, &canvas, &rect);
+	Widget_Render(arg, &paint);
+	Graph_Free(&canvas);
+	LCUIThread_Exit(NULL);
+}
+
+static void set_cache_size(int size)
+{
+	LCUI_SettingsRec settings;
+
+	Settings_Init(&settings);
+	settings.scaled_image_cache_size = size;
+	LCUI_ApplySettings(&settings);
+}
+
+static void set_image_cache_size(int size)
+{
+	LCUI_SettingsRec settings;
+
+	Settings_Init(&settings);
+	settings.image_cache_size = size;
+	LCUI_ApplySettings(&settings);
+}
+
+static void test_image_zooming(void)
+{
+	LCUI_Graph src, dst;
+	LCUI_Color color;
+	LCUI_Rect top = { 0, 0, 8, 4 };
+
+	Graph_Init(&src);
+	Graph_Init(&dst);
+	src.color_type = LCUI_COLOR_TYPE_ARGB;
+	Graph_Create(&src, 2, 1);
+	Graph_FillRect(&src, ARGB(255, 0, 0, 0), NULL, FALSE);
+	color = ARGB(255, 255, 255, 255);
+	Graph_SetPixel(&src, 1, 0, color);
+	Graph_ZoomBilinear(&src, &dst, FALSE, 4, 1);
+	Graph_GetPixel(&dst, 3, 0, color);
+	it_i("the edge pixel should not be mixed with the other side",
+	     color.r, 255);
+	Graph_Free(&dst);
+	Graph_Free(&src);
+
+	src.color_type = LCUI_COLOR_TYPE_ARGB;
+	Graph_Create(&src, 8, 8);
+	Graph_FillRect(&src, ARGB(255, 255, 255, 255), NULL, FALSE);
+	Graph_FillRect(&src, ARGB(255, 0, 0, 0), &top, FALSE);
+	Graph_ZoomMipmap(&src, &dst, FALSE, 1, 1);
+	it_i("mipmap width", dst.width, 1);
+	it_i("mipmap height", dst.height, 1);
+	Graph_GetPixel(&dst, 0, 0, color);
+	it_b("mipmap should average all pixels",
+	     color.r >= 127 && color.r <= 128, TRUE);
+	Graph_Free(&dst);
+	Graph_Free(&src);
+}
+
+static void test_scaled_image_cache(void)
+{
+	int i;
+	LCUI_Widget a, b, c;
+	LCUI_Thread threads[RENDER_THREADS];
+	LCUI_ImageCacheProfileRec profile;
+
+	set_cache_size(128);
+	a = create_widget("200px 150px");
+	it_b("the background image should be loaded", wait_image(a), TRUE);
+	render(a, &profile);
+	it_i("the first paint should resample the image",
+	     (int)profile.miss_count, 1);
+	it_i("the resampled image should be cached", (int)profile.count, 1);
+	it_i("the cached image should use width * height * 4 bytes",
+	     (int)profile.memory_usage, 200 * 150 * 4);
+	render(a, &profile);
+	it_b("the second paint should use the cached image",
+	     profile.hit_count > 0 && profile.miss_count == 0, TRUE);
+
+	b = create_widget("200px 150px");
+	wait_image(b);
+	render(b, &profile);
+	it_b("widgets with the same image size should share the cache",
+	     profile.hit_count > 0 && profile.miss_count == 0, TRUE);
+
+	c = create_widget("20px 15px");
+	wait_image(c);
+	render(c, &profile);
+	it_i("the downscaled image should be cached", (int)profile.count, 2);
+
+	Widget_SetStyleString(c, "background-size", "100px 80px");
+	render(c, &profile);
+	it_i("the least recently used image should be evicted",
+	     (int)profile.eviction_count, 1);
+	it_b("the cached images should not exceed the limit",
+	     profile.memory_usage <= 128 * 1024, TRUE);
+	render(a, &profile);
+	it_i("the evicted image should be resampled again",
+	     (int)profile.miss_count, 1);
+
+	Widget_SetStyleString(b, "background-size", "180px 120px");
+	LCUIWidget_Update();
+	LCUIWidget_GetScaledImageCacheProfile(&profile);
+	for (i = 0; i < RENDER_THREADS; ++i) {
+		LCUIThread_Create(&threads[i], render_thread, b);
+	}
+	for (i = 0; i < RENDER_THREADS; ++i) {
+		LCUIThread_Join(threads[i], NULL);
+	}
+	LCUIWidget_GetScaledImageCacheProfile(&profile);
+	it_i("the image should be resampled once by concurrent painters",
+	     (int)profile.miss_count, 1);
+	it_i("the other painters should wait for the resampled image",
+	     (int)profile.hit_count, RENDER_THREADS - 1);
+
+	set_cache_size(0);
+	LCUIWidget_GetScaledImageCacheProfile(&profile);
+	it_i("all images should be evicted if the cache is disabled",
+	     (int)profile.count, 0);
+	render(a, &profile);
+	it_i("the image should not be cached if the cache is disabled",
+	     (int)profile.count, 0);
+	Widget_Destroy(a);
+	Widget_Destroy(b);
+	Widget_Destroy(c);
+	LCUI_ResetSettings();
+}
+
+static void test_image_cache(void)
+{
+	LCUI_Widget w;
+	LCUI_Graph *image;
+	LCUI_ImageCacheProfileRec profile;
+
+	LCUIWidget_Update();
+	set_image_cache_size(0);
+	LCUIWidget_GetImageCacheProfile(&profile);
+	it_i("unused images should be evicted if the cache is disabled",
+	     (int)profile.count, 0);
+
+	w = create_widget("20px 15px");
+	image = &w->computed_style.background.image;
+	it_b("the background image should be loaded", wait_image(w), TRUE);
+	it_i("the image should be decoded at 1/4 scale", image->width, 23);
+	it_i("the natural size should be used to compute the background",
+	     w->computed_style.background.size.width.value, 20);
+	LCUIWidget_GetImageCacheProfile(&profile);
+	it_i("the decoded image should be cached", (int)profile.count, 1);
+	it_b("the memory usage should be counted",
+	     profile.memory_usage > 0 && profile.memory_usage < 91 * 69 * 4,
+	     TRUE);
+	it_i("the image in use should not be evicted",
+	     (int)profile.eviction_count, 0);
+
+	Widget_SetStyleString(w, "background-size", "200px 150px");
+	render(w, &profile);
+	it_b("the image should be decoded again at a larger scale",
+	     wait_image_width(w, 91), TRUE);
+
+	Widget_Hide(w);
+	LCUIWidget_Update();
+	set_image_cache_size(0);
+	LCUIWidget_GetImageCacheProfile(&profile);
+	it_i("the image of the hidden widget should be evicted",
+	     (int)profile.eviction_count, 1);
+	it_i("the evicted image should be released", (int)profile.count, 0);
+	it_b("the background image should be invalid", Graph_IsValid(image),
+	     FALSE);
+
+	Widget_Show(w);
+	render(w, &profile);
+	it_b("the evicted image should be decoded again when it is painted",
+	     wait_image(w), TRUE);
+	LCUIWidget_GetImageCacheProfile(&profile);
+	it_i("the image should be decoded once", (int)profile.miss_count, 1);
+	it_i("the image should be cached again", (int)profile.count, 1);
+
+	Widget_Destroy(w);
+	LCUIWidget_Update();
+	LCUIWidget_GetImageCacheProfile(&profile);
+	it_i("the unused image should be removed", (int)profile.count, 0);
+	LCUI_ResetSettings();
+}
+
+void test_widget_background(void)
+{
+	LCUI_Init();
+	describe("check image zooming", test_image_zooming);
+	describe("check scaled image cache", test_scaled_image_cache);
+	describe("check image cache", test_image_cache);
+	LCUI_Destroy();
+}
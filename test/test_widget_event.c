@@ -104,7 +104,107 @@ void test_widget_mouse_event(void)
 	LCUI_Destroy();
 }
 
+#define GRID_COLS 12
+#define GRID_ROWS 10
+#define GRID_PITCH 20
+#define CELL_SIZE 30
+
+/** Find the widget at the point by walking through all children */
+static LCUI_Widget find_widget_at(LCUI_Widget w, float x, float y)
+{
+	LCUI_Widget child, target;
+	LinkedListNode *node;
+
+	for (LinkedList_Each(node, &w->children_show)) {
+		child = node->data;
+		if (!child->computed_style.visible ||
+		    !LCUIRect_HasPoint(&child->box.border, x, y)) {
+			continue;
+		}
+		target = find_widget_at(child, x - child->box.padding.x,
+					y - child->box.padding.y);
+		return target ? target : child;
+	}
+	return NULL;
+}
+
+/** @returns the number of points where Widget_At() gets a wrong widget */
+static int check_widget_at(LCUI_Widget root)
+{
+	int x, y, errors = 0;
+
+	for (y = -5; y < GRID_ROWS * GRID_PITCH + CELL_SIZE; y += 3) {
+		for (x = -5; x < GRID_COLS * GRID_PITCH + CELL_SIZE; x += 3) {
+			if (Widget_At(root, x, y) !=
+			    find_widget_at(root, 1.f * x, 1.f * y)) {
+				++errors;
+			}
+		}
+	}
+	return errors;
+}
+
+void test_widget_hit_index(void)
+{
+	int i;
+	LCUI_Widget root, w, cells[GRID_COLS * GRID_ROWS];
+	LCUI_SysEventRec ev = { 0 };
+
+	LCUI_Init();
+	root = LCUIWidget_GetRoot();
+	Widget_Resize(root, 400, 400);
+	for (i = 0; i < GRID_COLS * GRID_ROWS; ++i) {
+		w = LCUIWidget_New(NULL);
+		Widget_SetStyle(w, key_position, SV_ABSOLUTE, style);
+		/* cells overlap with their neighbors and some of them are on
+		 * the top of others */
+		if (i % 7 == 0) {
+			Widget_SetStyle(w, key_z_index, 1, int);
+		}
+		if (i % 11 == 0) {
+			Widget_Hide(w);
+		}
+		Widget_Move(w, (float)(i % GRID_COLS * GRID_PITCH),
+			    (float)(i / GRID_COLS * GRID_PITCH));
+		Widget_Resize(w, CELL_SIZE, CELL_SIZE);
+		Widget_Append(root, w);
+		cells[i] = w;
+	}
+	w = LCUIWidget_New(NULL);
+	Widget_Resize(w, 10, 10);
+	Widget_Append(cells[GRID_COLS + 1], w);
+	LCUIWidget_Update();
+	it_i("hit-testing should find the same widgets as walking children",
+	     check_widget_at(root), 0);
+	it_b("spatial index should be built for many children",
+	     root->hit_index != NULL, TRUE);
+
+	Widget_Move(cells[7], 100, 100);
+	Widget_Resize(cells[1], 80, 60);
+	LCUIWidget_Update();
+	it_i("hit-testing should be correct after moving children",
+	     check_widget_at(root), 0);
+
+	Widget_Destroy(cells[2]);
+	Widget_Show(cells[GRID_COLS * 2 + 2]);
+	LCUIWidget_Update();
+	it_i("hit-testing should be correct after removing children",
+	     check_widget_at(root), 0);
+
+	ev.type = LCUI_MOUSEMOVE;
+	ev.motion.x = GRID_PITCH + 5;
+	ev.motion.y = GRID_PITCH + 5;
+	LCUI_TriggerEvent(&ev, NULL);
+	it_b("mousemove event should hover the widget found by the index",
+	     Widget_HasStatus(find_widget_at(root, GRID_PITCH + 5.f,
+					     GRID_PITCH + 5.f),
+			      "hover"),
+	     TRUE);
+	LCUI_Destroy();
+}
+
 void test_widget_event(void)
 {
 	describe("test widget mouse event", test_widget_mouse_event);
+	describe("test widget hit index", test_widget_hit_index);
 }
@@ -0,0 +1,75 @@
+/*
+ * Move the mouse over a grid with thousands of cells, the time of each
+ * hit test should not grow with the number of cells:
+ *
+ *   test_widget_hit_bench [number of columns]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/gui/widget.h>
+
+#define DEFAULT_COLS 100
+#define CELL_SIZE 8
+#define HIT_TESTS 100000
+#define FRAMES 200
+#define MOVES_PER_FRAME 10
+
+int main(int argc, char **argv)
+{
+	int i, j, x, y, cols = DEFAULT_COLS;
+	int64_t t;
+	size_t hits = 0;
+	LCUI_Widget root, w;
+	LCUI_SysEventRec ev = { 0 };
+
+	if (argc > 1) {
+		cols = atoi(argv[1]);
+	}
+	LCUI_Init();
+	root = LCUIWidget_GetRoot();
+	Widget_Resize(root, (float)cols * CELL_SIZE, (float)cols * CELL_SIZE);
+	for (i = 0; i < cols * cols; ++i) {
+		w = LCUIWidget_New(NULL);
+		Widget_SetStyle(w, key_position, SV_ABSOLUTE, style);
+		Widget_Move(w, (float)(i % cols * CELL_SIZE),
+			    (float)(i / cols * CELL_SIZE));
+		Widget_Resize(w, CELL_SIZE, CELL_SIZE);
+		Widget_Append(root, w);
+	}
+	t = LCUI_GetTime();
+	LCUIWidget_Update();
+	Logger_Info("%d cells updated in %ldms\n", cols * cols,
+		    (long)LCUI_GetTimeDelta(t));
+
+	srand(1);
+	t = LCUI_GetTime();
+	for (i = 0; i < HIT_TESTS; ++i) {
+		x = rand() % (cols * CELL_SIZE);
+		y = rand() % (cols * CELL_SIZE);
+		if (Widget_At(root, x, y)) {
+			++hits;
+		}
+	}
+	Logger_Info("%d hit tests in %ldms, %lu hits\n", HIT_TESTS,
+		    (long)LCUI_GetTimeDelta(t), (unsigned long)hits);
+
+	/* the pointer sweeps across the grid, each move hovers a new cell */
+	ev.type = LCUI_MOUSEMOVE;
+	t = LCUI_GetTime();
+	for (i = 0; i < FRAMES; ++i) {
+		for (j = 0; j < MOVES_PER_FRAME; ++j) {
+			ev.motion.x = (i * MOVES_PER_FRAME + j) * CELL_SIZE /
+				      2 % (cols * CELL_SIZE);
+			ev.motion.y = i * CELL_SIZE / 2 % (cols * CELL_SIZE);
+			LCUI_TriggerEvent(&ev, NULL);
+		}
+		LCUIWidget_Update();
+	}
+	Logger_Info("%d frames with %d mouse moves in %ldms\n", FRAMES,
+		    FRAMES * MOVES_PER_FRAME, (long)LCUI_GetTimeDelta(t));
+	LCUI_Destroy();
+	return 0;
+}
@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/gui/widget.h>
+#include <LCUI/settings.h>
+#include "test.h"
+#include "libtest.h"
+
+#define CANVAS_WIDTH 200
+#define CANVAS_HEIGHT 120
+
+static struct {
+	LCUI_Widget container;
+	LCUI_Widget box;
+	LCUI_Widget inner;
+} self;
+
+static void build(void)
+{
+	LCUI_Widget root = LCUIWidget_GetRoot();
+
+	self.container = LCUIWidget_New(NULL);
+	self.box = LCUIWidget_New(NULL);
+	self.inner = LCUIWidget_New(NULL);
+	Widget_SetStyleString(self.container, "width", "200px");
+	Widget_SetStyleString(self.container, "height", "120px");
+	Widget_SetStyleString(self.container, "background-color", "#fff");
+	Widget_SetStyleString(self.box, "position", "absolute");
+	Widget_SetStyleString(self.box, "left", "10px");
+	Widget_SetStyleString(self.box, "top", "10px");
+	Widget_SetStyleString(self.box, "width", "100px");
+	Widget_SetStyleString(self.box, "height", "60px");
+	Widget_SetStyleString(self.box, "border", "2px solid #000");
+	Widget_SetStyleString(self.box, "background-color", "#00f");
+	Widget_SetStyleString(self.box, "will-change", "opacity");
+	Widget_SetStyleString(self.inner, "width", "40px");
+	Widget_SetStyleString(self.inner, "height", "20px");
+	Widget_SetStyleString(self.inner, "margin", "5px");
+	Widget_SetStyleString(self.inner, "background-color", "#f00");
+	Widget_Append(self.box, self.inner);
+	Widget_Append(self.container, self.box);
+	Widget_Append(root, self.container);
+	LCUIWidget_Update();
+}
+
+static void render(LCUI_Graph *canvas)
+{
+	LCUI_PaintContextRec paint;
+	LCUI_Rect rect = { 0, 0, CANVAS_WIDTH, CANVAS_HEIGHT };
+	LCUI_DirtyRegionRec region;
+
+	LCUIWidget_Update();
+	/* collect invalid areas like the display module does */
+	DirtyRegion_Init(&region);
+	Widget_GetInvalidArea(LCUIWidget_GetRoot(), &region);
+	DirtyRegion_Destroy(&region);
+
+	Graph_Init(canvas);
+	Graph_Create(canvas, CANVAS_WIDTH, CANVAS_HEIGHT);
+	Graph_FillRect(canvas, RGB(128, 128, 128), NULL, FALSE);
+	paint.with_alpha = FALSE;
+	paint.rect = rect;
+	Graph_Quote(&paint.canvas, canvas, &rect);
+	Widget_Render(self.container, &paint);
+}
+
+static LCUI_BOOL render_is_hit(void)
+{
+	LCUI_Graph canvas;
+	LCUI_WidgetLayersProfileRec profile;
+
+	LCUIWidget_GetLayersProfile(&profile);
+	render(&canvas);
+	Graph_Free(&canvas);
+	LCUIWidget_GetLayersProfile(&profile);
+	return profile.hit_count == 1 && profile.miss_count == 0;
+}
+
+static void test_layer_cache(void)
+{
+	LCUI_Graph canvas;
+	LCUI_WidgetLayersProfileRec profile;
+
+	LCUIWidget_GetLayersProfile(&profile);
+	render(&canvas);
+	Graph_Free(&canvas);
+	LCUIWidget_GetLayersProfile(&profile);
+	it_i("first render should create the layer", (int)profile.count, 1);
+	it_i("first render should be a miss", (int)profile.miss_count, 1);
+	it_b("memory usage should be counted",
+	     profile.memory_usage >= 104 * 64 * sizeof(LCUI_ARGB), TRUE);
+	it_b("second render should be a hit", render_is_hit(), TRUE);
+
+	Widget_Move(self.box, 20, 20);
+	it_b("moving the widget should keep the layer", render_is_hit(), TRUE);
+	Widget_SetOpacity(self.box, 0.5f);
+	it_b("changing opacity should keep the layer", render_is_hit(), TRUE);
+	Widget_SetStyleString(self.inner, "background-color", "#0f0");
+	render(&canvas);
+	Graph_Free(&canvas);
+	LCUIWidget_GetLayersProfile(&profile);
+	it_i("changing a child should invalidate the layer",
+	     (int)profile.miss_count, 1);
+	it_b("only the area of the child should be repainted",
+	     profile.paint_area > 0 && profile.paint_area < 104 * 64 / 2,
+	     TRUE);
+	it_b("render after repaint should be a hit", render_is_hit(), TRUE);
+	Widget_SetStyleString(self.box, "background-color", "#ff0");
+	it_b("changing background should invalidate the layer",
+	     render_is_hit(), FALSE);
+	Widget_SetOpacity(self.box, 1.0f);
+}
+
+static void test_layer_pixels(void)
+{
+	LCUI_Graph expected, actual;
+
+	render(&actual);
+	Graph_Free(&actual);
+	/* repaint a part of the layer */
+	Widget_SetStyleString(self.inner, "background-color", "#f0f");
+	render(&actual);
+	Widget_SetStyleString(self.box, "will-change", "auto");
+	render(&expected);
+	it_b("layer should be destroyed without will-change",
+	     self.box->layer == NULL, TRUE);
+	it_b("pixels should be identical to the direct rendering",
+	     memcmp(expected.bytes, actual.bytes, expected.mem_size) == 0,
+	     TRUE);
+	Graph_Free(&expected);
+	Graph_Free(&actual);
+}
+
+static void test_layer_settings(void)
+{
+	LCUI_Graph canvas;
+	LCUI_SettingsRec settings;
+	LCUI_WidgetLayersProfileRec profile;
+
+	Widget_SetOpacity(self.box, 0.5f);
+	render(&canvas);
+	Graph_Free(&canvas);
+	it_b("translucent widgets should not retain layers by default",
+	     self.box->layer == NULL, TRUE);
+
+	Settings_Init(&settings);
+	settings.retain_translucent_layers = TRUE;
+	LCUI_ApplySettings(&settings);
+	render(&canvas);
+	Graph_Free(&canvas);
+	it_b("translucent widgets should retain layers if it is enabled",
+	     self.box->layer != NULL, TRUE);
+
+	Widget_SetStyleString(self.inner, "will-change", "opacity");
+	Widget_SetOpacity(self.inner, 0.5f);
+	render(&canvas);
+	Graph_Free(&canvas);
+	it_b("the child should retain a layer", self.inner->layer != NULL,
+	     TRUE);
+	/* the budget fits the layer of the box, not both layers */
+	settings.widget_layer_cache_size = 28;
+	LCUI_ApplySettings(&settings);
+	LCUIWidget_GetLayersProfile(&profile);
+	it_i("the layer mixed least recently should be evicted",
+	     (int)profile.eviction_count, 1);
+	it_b("the memory usage should be within the budget",
+	     profile.memory_usage <= 28 * 1024, TRUE);
+	settings.widget_layer_cache_size = 1;
+	LCUI_ApplySettings(&settings);
+	render(&canvas);
+	Graph_Free(&canvas);
+	LCUIWidget_GetLayersProfile(&profile);
+	it_i("layers larger than the budget should not be retained",
+	     (int)profile.count, 0);
+	LCUI_ResetSettings();
+}
+
+void test_widget_layer(void)
+{
+	LCUI_Init();
+	build();
+	describe("check layer cache", test_layer_cache);
+	describe("check layer pixels", test_layer_pixels);
+	describe("check layer settings", test_layer_settings);
+	LCUI_Destroy();
+}
@@ -6,6 +6,7 @@
 #include <LCUI/gui/widget/textview.h>
 #include <LCUI/gui/css_parser.h>
 #include <LCUI/gui/builder.h>
+#include <LCUI/settings.h>
 #include "test.h"
 #include "libtest.h"
 
@@ -117,10 +118,18 @@ static void check_widget_opactiy(void)
 
 void test_widget_opacity(void)
 {
+	LCUI_SettingsRec settings;
+
 	LCUI_Init();
 
 	build();
 	describe("check widget opacity", check_widget_opactiy);
+	Settings_Init(&settings);
+	settings.premultiplied_alpha = TRUE;
+	LCUI_ApplySettings(&settings);
+	describe("check widget opacity with premultiplied alpha",
+		 check_widget_opactiy);
+	LCUI_ResetSettings();
 	LCUI_Destroy();
 }
 
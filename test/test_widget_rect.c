@@ -14,7 +14,7 @@ void test_widget_rect(void)
 	LCUI_SysEventRec ev;
 	LCUI_Rect *rect;
 	LCUI_Rect expected_rect;
-	LinkedList rects;
+	LCUI_DirtyRegionRec region;
 
 	LCUI_Init();
 	root = LCUIWidget_GetRoot();
@@ -29,9 +29,9 @@ void test_widget_rect(void)
 	Widget_Append(root, parent);
 	LCUIWidget_Update();
 
-	LinkedList_Init(&rects);
-	Widget_GetInvalidArea(root, &rects);
-	LinkedList_Clear(&rects, free);
+	DirtyRegion_Init(&region);
+	Widget_GetInvalidArea(root, &region);
+	DirtyRegion_Clear(&region);
 
 	ev.type = LCUI_MOUSEMOVE;
 	ev.motion.x = 150;
@@ -40,36 +40,36 @@ void test_widget_rect(void)
 	ev.motion.yrel = 0;
 	LCUI_TriggerEvent(&ev, NULL);
 	LCUIWidget_Update();
-	Widget_GetInvalidArea(root, &rects);
+	Widget_GetInvalidArea(root, &region);
 	it_b("app.trigger({ type: 'mousemove', x: 150, y: 150}), "
 	     "root.getInvalidArea().length == 0",
-	     rects.length == 0, TRUE);
+	     region.length == 0, TRUE);
 
 	ev.motion.x = 80;
 	ev.motion.y = 80;
 	LCUI_TriggerEvent(&ev, NULL);
 	LCUIWidget_Update();
-	Widget_GetInvalidArea(root, &rects);
-	rect = rects.head.next->data;
+	Widget_GetInvalidArea(root, &region);
+	rect = &region.rects[0];
 	it_b("app.trigger({ type: 'mousemove', x: 80, y: 80 }), "
 	     "root.getInvalidArea().length == 1",
-	     rects.length == 1, TRUE);
+	     region.length == 1, TRUE);
 
 	expected_rect.x = 0;
 	expected_rect.y = 0;
 	expected_rect.width = 100;
 	expected_rect.height = 100;
 	it_rect("root.getInvalidArea()[0]", rect, &expected_rect);
-	LinkedList_Clear(&rects, free);
+	DirtyRegion_Clear(&region);
 
 	ev.motion.x = 40;
 	ev.motion.y = 40;
 	LCUI_TriggerEvent(&ev, NULL);
 	LCUIWidget_Update();
-	Widget_GetInvalidArea(root, &rects);
+	Widget_GetInvalidArea(root, &region);
 	it_b("app.trigger({ type: 'mousemove', x: 40, y: 40 }), "
 	     "root.getInvalidArea().length == 0",
-	     rects.length == 0, TRUE);
+	     region.length == 0, TRUE);
 
 	ev.type = LCUI_MOUSEDOWN;
 	ev.button.x = 40;
@@ -77,38 +77,38 @@ void test_widget_rect(void)
 	ev.button.button = LCUI_KEY_LEFTBUTTON;
 	LCUI_TriggerEvent(&ev, NULL);
 	LCUIWidget_Update();
-	Widget_GetInvalidArea(root, &rects);
+	Widget_GetInvalidArea(root, &region);
 	it_b("app.trigger({ type: 'mousedown', x: 40, y: 40 }), "
 	     "root.getInvalidArea().length == 1",
-	     rects.length == 1, TRUE);
-	if (rects.length == 1) {
-		rect = rects.head.next->data;
+	     region.length == 1, TRUE);
+	if (region.length == 1) {
+		rect = &region.rects[0];
 		it_rect("root.getInvalidArea()[0]", rect, &expected_rect);
 	}
-	LinkedList_Clear(&rects, free);
+	DirtyRegion_Clear(&region);
 
 	ev.type = LCUI_MOUSEUP;
 	LCUI_TriggerEvent(&ev, NULL);
 	LCUIWidget_Update();
-	Widget_GetInvalidArea(root, &rects);
+	Widget_GetInvalidArea(root, &region);
 	it_b("app.trigger({ type: 'mouseup', x: 40, y: 40 }), "
 	     "root.getInvalidArea().length == 1",
-	     rects.length == 1, TRUE);
-	if (rects.length == 1) {
-		rect = rects.head.next->data;
+	     region.length == 1, TRUE);
+	if (region.length == 1) {
+		rect = &region.rects[0];
 		it_rect("root.getInvalidArea()[0]", rect, &expected_rect);
 	}
-	LinkedList_Clear(&rects, free);
+	DirtyRegion_Clear(&region);
 
 	ev.type = LCUI_MOUSEMOVE;
 	ev.motion.x = 80;
 	ev.motion.y = 80;
 	LCUI_TriggerEvent(&ev, NULL);
 	LCUIWidget_Update();
-	Widget_GetInvalidArea(root, &rects);
+	Widget_GetInvalidArea(root, &region);
 	it_b("app.trigger({ type: 'mousemove', x: 80, y: 80 }), "
 	     "root.getInvalidArea().length == 0",
-	     rects.length == 0, TRUE);
+	     region.length == 0, TRUE);
 
 	ev.motion.x = 150;
 	ev.motion.y = 150;
@@ -116,16 +116,16 @@ void test_widget_rect(void)
 	ev.motion.yrel = 0;
 	LCUI_TriggerEvent(&ev, NULL);
 	LCUIWidget_Update();
-	Widget_GetInvalidArea(root, &rects);
+	Widget_GetInvalidArea(root, &region);
 
 	it_b("app.trigger({ type: 'mousemove', x: 150, y: 150 }), "
 	     "root.getInvalidArea().length == 1",
-	     rects.length == 1, TRUE);
-	if (rects.length == 1) {
-		rect = rects.head.next->data;
+	     region.length == 1, TRUE);
+	if (region.length == 1) {
+		rect = &region.rects[0];
 		it_rect("root.getInvalidArea()[0]", rect, &expected_rect);
 	}
-	LinkedList_Clear(&rects, free);
+	DirtyRegion_Clear(&region);
 
 	expected_rect.x = 21;
 	expected_rect.y = 11;
@@ -133,14 +133,14 @@ void test_widget_rect(void)
 	expected_rect.height = 50;
 	Widget_Destroy(child);
 	LCUIWidget_Update();
-	Widget_GetInvalidArea(root, &rects);
+	Widget_GetInvalidArea(root, &region);
 	it_b("child.destroy(), root.getInvalidArea().length == 1",
-	     rects.length == 1, TRUE);
-	if (rects.length == 1) {
-		rect = rects.head.next->data;
+	     region.length == 1, TRUE);
+	if (region.length == 1) {
+		rect = &region.rects[0];
 		it_rect("root.getInvalidArea()[0]", rect, &expected_rect);
 	}
-	LinkedList_Clear(&rects, free);
+	DirtyRegion_Clear(&region);
 
 	expected_rect.x = 0;
 	expected_rect.y = 0;
@@ -148,14 +148,14 @@ void test_widget_rect(void)
 	expected_rect.height = 100;
 	Widget_Destroy(parent);
 	LCUIWidget_Update();
-	Widget_GetInvalidArea(root, &rects);
+	Widget_GetInvalidArea(root, &region);
 	it_b("parent.destroy(), root.getInvalidArea().length == 1",
-	     rects.length == 1, TRUE);
-	if (rects.length == 1) {
-		rect = rects.head.next->data;
+	     region.length == 1, TRUE);
+	if (region.length == 1) {
+		rect = &region.rects[0];
 		it_rect("root.getInvalidArea()[0]", rect, &expected_rect);
 	}
-	LinkedList_Clear(&rects, free);
+	DirtyRegion_Destroy(&region);
 
 	LCUI_Destroy();
 }
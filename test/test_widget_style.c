@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/gui/widget.h>
+#include <LCUI/gui/css_parser.h>
+#include <LCUI/settings.h>
+#include "test.h"
+#include "libtest.h"
+
+#define GROUPS 12
+#define ITEMS 16
+#define TOTAL (GROUPS * ITEMS + GROUPS)
+#define ROWS 20
+
+/* clang-format off */
+
+static const char *css = CodeToString(
+
+.group {
+	display: block;
+	padding: 4px;
+	border: 1px solid #ccc;
+}
+
+.group:hover {
+	padding: 6px;
+}
+
+.group.wide {
+	width: 400px;
+}
+
+.item {
+	display: inline-block;
+	width: 20px;
+	height: 10px;
+	margin: 1px;
+}
+
+.group .item.odd {
+	width: 24px;
+	background-color: #f00;
+}
+
+.group.wide .item {
+	height: 16px;
+}
+
+.group.wide .item.odd {
+	opacity: 0.5;
+	z-index: 2;
+}
+
+.group .item.hidden {
+	display: none;
+}
+
+.group #item-5 {
+	position: relative;
+	left: 3px;
+}
+
+);
+
+static const char *list_css = CodeToString(
+
+.cell {
+	display: inline-block;
+	width: 10px;
+	height: 10px;
+}
+
+.list .row:hover .cell.name {
+	width: 30px;
+}
+
+.list.compact .row .cell {
+	height: 8px;
+}
+
+);
+
+/* clang-format on */
+
+typedef struct style_snapshot_t {
+	LCUI_CachedStyleSheet inherited_style;
+	LCUI_RectF border;
+	LCUI_RectF content;
+	float opacity;
+	int z_index;
+	int display;
+	int position;
+	LCUI_Color background_color;
+} style_snapshot_t;
+
+static struct {
+	LCUI_Widget widgets[TOTAL];
+	style_snapshot_t expected[TOTAL];
+	style_snapshot_t actual[TOTAL];
+} self;
+
+static void build(void)
+{
+	int i, j, n = 0;
+	char str[32];
+	LCUI_Widget group, item;
+	LCUI_Widget root = LCUIWidget_GetRoot();
+
+	LCUI_LoadCSSString(css, __FILE__);
+	for (i = 0; i < GROUPS; ++i) {
+		group = LCUIWidget_New(NULL);
+		Widget_AddClass(group, "group");
+		if (i % 3 == 0) {
+			Widget_AddClass(group, "wide");
+		}
+		self.widgets[n++] = group;
+		for (j = 0; j < ITEMS; ++j) {
+			item = LCUIWidget_New(NULL);
+			Widget_AddClass(item, "item");
+			if (j % 2) {
+				Widget_AddClass(item, "odd");
+			}
+			sprintf(str, "item-%d", j);
+			Widget_SetId(item, str);
+			Widget_Append(group, item);
+			self.widgets[n++] = item;
+		}
+		Widget_Append(root, group);
+	}
+}
+
+static void set_parallel(LCUI_BOOL enabled)
+{
+	LCUI_SettingsRec settings;
+
+	Settings_Init(&settings);
+	settings.parallel_style_computation = enabled;
+	settings.parallel_rendering_threads = 4;
+	LCUI_ApplySettings(&settings);
+}
+
+static void snapshot(style_snapshot_t *snapshots)
+{
+	int i;
+	LCUI_Widget w;
+	style_snapshot_t *s;
+
+	for (i = 0; i < TOTAL; ++i) {
+		w = self.widgets[i];
+		s = &snapshots[i];
+		s->inherited_style = w->inherited_style;
+		s->border = w->box.border;
+		s->content = w->box.content;
+		s->opacity = w->computed_style.opacity;
+		s->z_index = w->computed_style.z_index;
+		s->display = w->computed_style.display;
+		s->position = w->computed_style.position;
+		s->background_color = w->computed_style.background.color;
+	}
+}
+
+static int compare_snapshots(void)
+{
+	int i;
+	style_snapshot_t *a, *b;
+
+	for (i = 0; i < TOTAL; ++i) {
+		a = &self.expected[i];
+		b = &self.actual[i];
+		if (a->inherited_style != b->inherited_style ||
+		    !LCUIRectF_IsEquals(&a->border, &b->border) ||
+		    !LCUIRectF_IsEquals(&a->content, &b->content) ||
+		    a->opacity != b->opacity || a->z_index != b->z_index ||
+		    a->display != b->display || a->position != b->position ||
+		    a->background_color.value != b->background_color.value) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void update(LCUI_BOOL parallel, style_snapshot_t *snapshots)
+{
+	set_parallel(parallel);
+	LCUIWidget_RefreshStyle();
+	LCUIWidget_Update();
+	snapshot(snapshots);
+}
+
+/* Update styles serially and in parallel, then compare the results */
+static int update_and_compare(LCUI_BOOL parallel_first)
+{
+	if (parallel_first) {
+		update(TRUE, self.actual);
+		update(FALSE, self.expected);
+	} else {
+		update(FALSE, self.expected);
+		update(TRUE, self.actual);
+	}
+	return compare_snapshots();
+}
+
+static void test_parallel_style_computation(void)
+{
+	float x;
+
+	it_i("computed styles should be identical", update_and_compare(FALSE),
+	     -1);
+
+	Widget_AddClass(self.widgets[ITEMS + 1], "wide");
+	Widget_RemoveClass(self.widgets[0], "wide");
+	Widget_AddStatus(self.widgets[2 * (ITEMS + 1)], "hover");
+	it_i("computed styles should be identical after changing classes",
+	     update_and_compare(FALSE), -1);
+
+	/* the style sheet cache is cold, so it is filled by threads */
+	LCUI_LoadCSSString(".item { height: 12px; }", __FILE__);
+	it_i("computed styles should be identical after adding rules",
+	     update_and_compare(TRUE), -1);
+
+	set_parallel(TRUE);
+	Widget_AddClass(self.widgets[1], "odd");
+	LCUIWidget_Update();
+	it_b("odd item of a narrow group should be opaque",
+	     self.widgets[1]->computed_style.opacity == 1.0f, TRUE);
+	it_b("odd item should be resized by the parallel update",
+	     self.widgets[1]->box.border.width == 24.0f, TRUE);
+
+	/* display is computed by threads, the layout should still notice it */
+	x = self.widgets[2]->box.border.x;
+	Widget_AddClass(self.widgets[2], "hidden");
+	LCUIWidget_RefreshStyle();
+	LCUIWidget_Update();
+	it_b("hidden item should be computed by the parallel update",
+	     self.widgets[2]->computed_style.display == SV_NONE, TRUE);
+	it_b("next item should take the place of the hidden item",
+	     self.widgets[3]->box.border.x == x, TRUE);
+	Widget_RemoveClass(self.widgets[2], "hidden");
+	set_parallel(FALSE);
+}
+
+static void test_style_invalidation(void)
+{
+	int i;
+	LCUI_Widget list, row, rows[ROWS], names[ROWS], values[ROWS];
+	LCUI_WidgetStyleChangesProfileRec profile;
+
+	LCUI_LoadCSSString(list_css, __FILE__);
+	list = LCUIWidget_New(NULL);
+	Widget_AddClass(list, "list");
+	for (i = 0; i < ROWS; ++i) {
+		row = LCUIWidget_New(NULL);
+		Widget_AddClass(row, "row");
+		names[i] = LCUIWidget_New(NULL);
+		Widget_AddClass(names[i], "cell name");
+		values[i] = LCUIWidget_New(NULL);
+		Widget_AddClass(values[i], "cell value");
+		Widget_Append(row, names[i]);
+		Widget_Append(row, values[i]);
+		Widget_Append(list, row);
+		rows[i] = row;
+	}
+	Widget_Append(LCUIWidget_GetRoot(), list);
+	LCUIWidget_Update();
+	LCUIWidget_GetStyleChangesProfile(&profile);
+
+	Widget_AddStatus(rows[3], "hover");
+	LCUIWidget_GetStyleChangesProfile(&profile);
+	it_i("hovering a row should refresh one cell",
+	     (int)profile.refresh_count, 1);
+	it_i("hovering a row should skip the other cell",
+	     (int)profile.skip_count, 1);
+	LCUIWidget_Update();
+	it_b("the name cell of the hovered row should be widened",
+	     names[3]->box.border.width == 30.0f, TRUE);
+	it_b("the name cell of other rows should not be widened",
+	     names[4]->box.border.width == 10.0f, TRUE);
+
+	Widget_RemoveStatus(rows[3], "hover");
+	LCUIWidget_Update();
+	it_b("the name cell should be restored after leaving the row",
+	     names[3]->box.border.width == 10.0f, TRUE);
+
+	LCUIWidget_GetStyleChangesProfile(&profile);
+	Widget_AddStatus(list, "hover");
+	Widget_AddStatus(values[0], "hover");
+	LCUIWidget_GetStyleChangesProfile(&profile);
+	it_i("hovering the list should not refresh its children",
+	     (int)profile.changes_count, 0);
+
+	Widget_AddClass(list, "compact");
+	LCUIWidget_GetStyleChangesProfile(&profile);
+	it_i("adding a class to the list should refresh cells only",
+	     (int)profile.refresh_count, ROWS * 2);
+	LCUIWidget_Update();
+	it_b("cells should be updated after adding a class to the list",
+	     values[ROWS - 1]->box.border.height == 8.0f, TRUE);
+	Widget_Destroy(list);
+}
+
+void test_widget_style(void)
+{
+	LCUI_Init();
+	build();
+	LCUIWidget_Update();
+	describe("check parallel style computation",
+		 test_parallel_style_computation);
+	describe("check style invalidation", test_style_invalidation);
+	LCUI_Destroy();
+}
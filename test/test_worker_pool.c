@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <LCUI_Build.h>
+#include <LCUI/LCUI.h>
+#include <LCUI/thread.h>
+#include <LCUI/worker.h>
+#include "test.h"
+#include "libtest.h"
+
+#define PINNED_TASKS 20
+
+static struct {
+	LCUI_Mutex mutex;
+	LCUI_Cond cond;
+	LCUI_BOOL blocked;
+	int generation;
+	char order[8];
+	size_t length;
+	int count;
+	int destroyed;
+	int sequence[PINNED_TASKS];
+	LCUI_Thread threads[PINNED_TASKS];
+	LCUI_Thread callback_thread;
+	LCUI_BOOL callback_after_task;
+} self;
+
+static void Block(void)
+{
+	LCUIMutex_Lock(&self.mutex);
+	self.blocked = TRUE;
+	LCUIMutex_Unlock(&self.mutex);
+}
+
+static void Release(void)
+{
+	LCUIMutex_Lock(&self.mutex);
+	self.blocked = FALSE;
+	self.generation += 1;
+	LCUICond_Broadcast(&self.cond);
+	LCUIMutex_Unlock(&self.mutex);
+}
+
+/* wait until released, even if it is blocked again before waking up */
+static void OnBlock(void *arg1, void *arg2)
+{
+	int generation;
+
+	LCUIMutex_Lock(&self.mutex);
+	generation = self.generation;
+	while (self.blocked && generation == self.generation) {
+		LCUICond_Wait(&self.cond, &self.mutex);
+	}
+	LCUIMutex_Unlock(&self.mutex);
+}
+
+static void OnRecord(void *arg1, void *arg2)
+{
+	LCUIMutex_Lock(&self.mutex);
+	self.order[self.length++] = *(char *)arg1;
+	self.order[self.length] = 0;
+	self.count += 1;
+	LCUIMutex_Unlock(&self.mutex);
+}
+
+static void OnCount(void *arg1, void *arg2)
+{
+	LCUIMutex_Lock(&self.mutex);
+	self.count += 1;
+	LCUIMutex_Unlock(&self.mutex);
+}
+
+static void PostTask(LCUI_WorkerPool pool, LCUI_TaskFunc func, void *arg,
+		     LCUI_TaskPriority priority);
+
+/* post tasks to the queue of the current thread, then block it */
+static void OnSpawn(void *arg1, void *arg2)
+{
+	int i;
+
+	for (i = 0; i < 10; ++i) {
+		PostTask(arg1, OnCount, NULL, LCUI_TASK_PRIORITY_NORMAL);
+	}
+	OnBlock(NULL, NULL);
+}
+
+static void OnPinned(void *arg1, void *arg2)
+{
+	int i = (int)(size_t)arg1;
+
+	LCUIMutex_Lock(&self.mutex);
+	self.sequence[i] = self.count++;
+	self.threads[i] = LCUIThread_SelfID();
+	LCUIMutex_Unlock(&self.mutex);
+}
+
+static void OnDestroyArg(void *arg)
+{
+	LCUIMutex_Lock(&self.mutex);
+	self.destroyed += 1;
+	LCUIMutex_Unlock(&self.mutex);
+}
+
+static void OnCallback(void *arg1, void *arg2)
+{
+	self.callback_thread = LCUIThread_SelfID();
+	self.callback_after_task = self.count == 1;
+}
+
+static LCUI_BOOL WaitCount(int count)
+{
+	int i, current;
+
+	for (i = 0; i < 100; ++i) {
+		LCUIMutex_Lock(&self.mutex);
+		current = self.count;
+		LCUIMutex_Unlock(&self.mutex);
+		if (current >= count) {
+			return TRUE;
+		}
+		LCUI_MSleep(10);
+	}
+	return FALSE;
+}
+
+static void PostTask(LCUI_WorkerPool pool, LCUI_TaskFunc func, void *arg,
+		     LCUI_TaskPriority priority)
+{
+	LCUI_TaskRec task = { 0 };
+
+	task.func = func;
+	task.arg[0] = arg;
+	LCUIWorkerPool_PostTask(pool, &task, priority, NULL);
+}
+
+static void test_task_priority(void)
+{
+	LCUI_WorkerPool pool = LCUIWorkerPool_New(1);
+
+	self.count = 0;
+	self.length = 0;
+	Block();
+	PostTask(pool, OnBlock, NULL, LCUI_TASK_PRIORITY_NORMAL);
+	PostTask(pool, OnRecord, "c", LCUI_TASK_PRIORITY_LOW);
+	PostTask(pool, OnRecord, "b", LCUI_TASK_PRIORITY_NORMAL);
+	PostTask(pool, OnRecord, "a", LCUI_TASK_PRIORITY_HIGH);
+	PostTask(pool, OnRecord, "B", LCUI_TASK_PRIORITY_NORMAL);
+	Release();
+	it_b("all tasks should be done", WaitCount(4), TRUE);
+	it_s("tasks should be run in the order of priority", self.order,
+	     "abBc");
+	LCUIWorkerPool_Destroy(pool);
+}
+
+static void test_task_stealing(void)
+{
+	int i, n, id;
+	LCUI_TaskRec task = { 0 };
+	LCUI_WorkerPool pool = LCUIWorkerPool_New(2);
+
+	it_i("the pool should have 2 threads", LCUIWorkerPool_GetThreads(pool),
+	     2);
+	self.count = 0;
+	Block();
+	task.func = OnSpawn;
+	task.arg[0] = pool;
+	id = LCUIWorkerPool_PostTask(pool, &task, LCUI_TASK_PRIORITY_NORMAL,
+				     NULL);
+	it_b("the tasks queued on the blocked thread should be stolen",
+	     WaitCount(10), TRUE);
+	Release();
+
+	self.count = 0;
+	Block();
+	task.func = OnBlock;
+	task.arg[0] = NULL;
+	id = LCUIWorkerPool_PostTask(pool, &task, LCUI_TASK_PRIORITY_NORMAL,
+				     NULL);
+	task.func = OnCount;
+	for (i = 0, n = 0; i < 10; ++i) {
+		if (LCUIWorkerPool_PostTask(pool, &task,
+					    LCUI_TASK_PRIORITY_NORMAL,
+					    NULL) == id) {
+			++n;
+		}
+	}
+	it_i("the tasks posted from other threads should be spread", n, 5);
+	it_b("the tasks in the inbox of the blocked thread should be stolen",
+	     WaitCount(10), TRUE);
+	Release();
+	task.func = OnBlock;
+	task.arg[0] = NULL;
+
+	self.count = 0;
+	Block();
+	LCUIWorkerPool_PostTaskTo(pool, &task, id);
+	for (i = 0; i < PINNED_TASKS; ++i) {
+		task.func = OnPinned;
+		task.arg[0] = (void *)(size_t)i;
+		LCUIWorkerPool_PostTaskTo(pool, &task, id);
+	}
+	LCUI_MSleep(50);
+	it_i("the pinned tasks should not be stolen", self.count, 0);
+	Release();
+	it_b("the pinned tasks should be done", WaitCount(PINNED_TASKS), TRUE);
+	for (i = 1; i < PINNED_TASKS; ++i) {
+		if (self.sequence[i] != i ||
+		    self.threads[i] != self.threads[0]) {
+			break;
+		}
+	}
+	it_i("the pinned tasks should be run in order on the same thread", i,
+	     PINNED_TASKS);
+	LCUIWorkerPool_Destroy(pool);
+}
+
+static void test_task_callback(void)
+{
+	LCUI_TaskRec task = { 0 };
+	LCUI_TaskRec callback = { 0 };
+
+	LCUI_Init();
+	self.count = 0;
+	self.callback_thread = 0;
+	self.callback_after_task = FALSE;
+	task.func = OnCount;
+	callback.func = OnCallback;
+	LCUI_PostAsyncTaskEx(&task, LCUI_TASK_PRIORITY_LOW, &callback);
+	WaitCount(1);
+	LCUI_ProcessEvents();
+	it_b("the callback should be run on the main thread",
+	     self.callback_thread == LCUIThread_SelfID(), TRUE);
+	it_b("the callback should be run after the task",
+	     self.callback_after_task, TRUE);
+	LCUI_Destroy();
+}
+
+static void test_pool_destroy(void)
+{
+	int i;
+	LCUI_TaskRec task = { 0 };
+	LCUI_WorkerPool pool = LCUIWorkerPool_New(1);
+
+	self.destroyed = 0;
+	Block();
+	PostTask(pool, OnBlock, NULL, LCUI_TASK_PRIORITY_NORMAL);
+	task.func = OnCount;
+	task.arg[0] = &self;
+	task.destroy_arg[0] = OnDestroyArg;
+	for (i = 0; i < 3; ++i) {
+		LCUIWorkerPool_PostTask(pool, &task, LCUI_TASK_PRIORITY_NORMAL,
+					&task);
+	}
+	Release();
+	LCUIWorkerPool_Destroy(pool);
+	it_i("the arguments of all tasks and callbacks should be destroyed",
+	     self.destroyed, 6);
+}
+
+void test_worker_pool(void)
+{
+	LCUIMutex_Init(&self.mutex);
+	LCUICond_Init(&self.cond);
+	describe("check task priority", test_task_priority);
+	describe("check task stealing", test_task_stealing);
+	describe("check task callback", test_task_callback);
+	describe("check pool destroy", test_pool_destroy);
+	LCUIMutex_Destroy(&self.mutex);
+	LCUICond_Destroy(&self.cond);
+}